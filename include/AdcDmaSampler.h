@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include "RudderAngleSensor.h"
+#include "MotorCurrentSensor.h"
+
+/**
+ * Continuous (DMA) conversion of the rudder pot and, optionally, the motor
+ * current sense on ADC1 of the ESP32-S3. The two channels are converted
+ * alternately. A task pinned to a core takes each DMA frame as it
+ * completes and feeds the samples to the sensors, so nobody ever waits
+ * for a conversion.
+ *
+ * Once started, analogRead() must no longer be used on ADC1.
+ */
+class AdcDmaSampler {
+public:
+    // Close to the S3 limit; 40 kHz per channel with the current sense,
+    // into a ratio 32 CIC -> 1.25 kHz of pot readings
+    static const uint32_t DEFAULT_SAMPLE_RATE = 80000;
+    // Conversions per DMA frame, 80 at 80 kHz = one frame per ms
+    static const uint32_t FRAME_SAMPLES = 80;
+
+    // currentPin < 0: pot only
+    AdcDmaSampler(int pin, RudderAngleSensor& sensor,
+                  int currentPin=-1, MotorCurrentSensor* current=nullptr);
+
+    /**
+     * Configure the ADC digital controller and start the reader task.
+     * Return false if the pin is not on ADC1 or the driver refused.
+     */
+    bool begin(uint32_t sampleRate=DEFAULT_SAMPLE_RATE, int core=0);
+
+    /**
+     * Bend the sensor's correction table with the factory (eFuse) ADC
+     * calibration, keeping the end points, so a linear pot reads linear.
+     * Call before begin().
+     */
+    void applyFactoryCalibration(float minAngle, float maxAngle);
+
+    // DMA frames lost because the reader was too slow
+    uint32_t getOverflows() const;
+
+private:
+    static void taskEntry(void* arg);
+    void taskLoop();
+
+    int                 _pin;
+    int                 _channel;
+    RudderAngleSensor&  _sensor;
+    int                 _currentPin;
+    int                 _currentChannel;
+    MotorCurrentSensor* _current;
+    volatile uint32_t  _overflows;
+    TaskHandle_t       _task;
+};
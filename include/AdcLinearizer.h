@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Piecewise-linear correction from (fractional) ADC counts to a physical
+ * value, e.g. the rudder angle. The table has a knot every
+ * 2^(ADC_BITS-SEGMENT_BITS) counts, so the lookup is a shift, one
+ * multiply and one add.
+ *
+ * The default table is the straight line between minValue and maxValue;
+ * setKnot() or a calibration (see AdcDmaSampler) bends it to take out the
+ * ADC nonlinearity.
+ */
+class AdcLinearizer {
+public:
+    static const int ADC_BITS = 12;
+    static const int SEGMENT_BITS = 5;
+    static const int SEGMENTS = 1 << SEGMENT_BITS;
+    static const int KNOTS = SEGMENTS + 1;
+    // ADC counts per segment
+    static const int SEGMENT_SPAN = (1 << ADC_BITS) / SEGMENTS;
+
+    AdcLinearizer(float minValue=-25.0f, float maxValue=25.0f);
+
+    // Straight line: 0 counts -> minValue, ADC full scale -> maxValue
+    void setLinear(float minValue, float maxValue);
+
+    // Value at knot i, i.e. at i*SEGMENT_SPAN counts (clamped to full scale)
+    void setKnot(int i, float value);
+    float getKnot(int i) const;
+
+    // ADC counts of knot i
+    static float knotCounts(int i);
+
+    // Corrected value for a (fractional) count
+    float apply(float counts) const;
+
+private:
+    float _knot[KNOTS];
+    float _slope[SEGMENTS];   // per count
+
+    void updateSlope(int segment);
+};
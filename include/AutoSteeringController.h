@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <cstdint>
+#include "Mailbox.h"
 
 /** Simple autopilot modes. */
 enum  AutoSteeringMode {
@@ -9,30 +11,73 @@ enum  AutoSteeringMode {
     TRACK_WIND_ANGLE
 };
 
+/** Mode change handed from the UI to the heading loop. */
+struct SteeringCommand {
+    AutoSteeringMode mode;
+    float            param;
+};
+
+/**
+ * Heading/course/wind angle PID producing the desired rudder angle.
+ *
+ * setMode() only publishes a SteeringCommand through a lock-free
+ * mailbox; update() applies it. So the UI may change modes from its own
+ * task (or core) while the control task runs update(). Call setMode()
+ * from one task only, everything else from the control task.
+ *
+ * It never steers blind: until setFeedback() is first called, and once
+ * it has not been called for FEEDBACK_TIMEOUT_S of update() time, the
+ * rudder is held centred as in OFF.
+ */
 class AutoSteeringController {
 public:
+    static constexpr float FEEDBACK_TIMEOUT_S = 2.0f;
+
     AutoSteeringController();
     ~AutoSteeringController() = default;
 
-    // Set autopilot mode + param (like desired heading)
+    // Set autopilot mode + param (like desired heading), takes effect on
+    // the next update()
     void setMode(AutoSteeringMode mode, float param=0.0f);
 
+    // Measured value of the tracked quantity (heading, COG or true wind
+    // angle in degrees, depending on the mode), every update() it is
+    // available
+    void setFeedback(float measured);
+    // Feedback fresh enough to steer by
+    bool hasFeedback() const { return _feedbackAge <= FEEDBACK_TIMEOUT_S; }
+
+    // PID gains (e.g. from a tuned gain table)
+    void setGains(float kP, float kI, float kD);
+
     // The main update function
     void update(float dt);
 
     // Return the desired rudder angle
     float getRudderAngle() const;
 
+    // Mode and its setpoint (heading, course or wind angle) as applied by
+    // the last update()
+    AutoSteeringMode getMode() const;
+    float getSetpoint() const;
+
 private:
+    void applyCommand();
     void computeSteering(float dt);
 
+    Mailbox<SteeringCommand> _commandBox;
+    std::uint32_t _appliedVersion;
+
     AutoSteeringMode _mode;
     float _desiredHeading;
     float _desiredCourse;
     float _desiredWindAngle;
     float _rudderAngle;
+    float _measured;
+    float _feedbackAge;         // update() time since setFeedback() [s]
 
     // A small PID or P-control
     float _kP, _kI, _kD;
     float _integral, _lastError;
+    bool  _firstStep;
 };
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "IInputDevice.h"
+#include "SpscQueue.h"
+
+enum class ButtonEventType : std::uint8_t {
+    PRESS,          // down, debounced
+    LONG_PRESS,     // still down after longPressMs
+    REPEAT,         // then every repeatMs while held
+    RELEASE
+};
+
+struct ButtonEvent {
+    ButtonId        button;
+    ButtonEventType type;
+    std::uint32_t   timeMs;
+};
+
+/**
+ * The panel buttons as a queue of events instead of levels to poll.
+ *
+ * sample() gets the raw levels of all buttons, one bit per ButtonId,
+ * from the debounce timer ISR. A level counts once it has held for
+ * debounceMs; contact bounce inside that is never seen. A button held
+ * gives PRESS, LONG_PRESS after longPressMs and REPEAT every repeatMs
+ * after that until the RELEASE.
+ *
+ * The timer only has to run while active(): with nobody touching the
+ * panel there is nothing to sample and nothing in the queue.
+ *
+ * One producer (the ISR) and one consumer (the UI task), like the
+ * SpscQueue underneath. A full queue drops the new event, see dropped().
+ */
+class ButtonEvents {
+public:
+    static const int BUTTON_COUNT = 6;
+    static const std::size_t QUEUE_SIZE = 16;
+
+    ButtonEvents();
+
+    // Default 20, 700 and 150 ms
+    void setTiming(std::uint32_t debounceMs, std::uint32_t longPressMs, std::uint32_t repeatMs);
+
+    // Raw levels, bit (1 << ButtonId) set while pressed. Producer only.
+    void sample(std::uint32_t pressed, std::uint32_t nowMs);
+    // A button down or still settling: keep sampling
+    bool active() const { return _stable != 0 || _raw != _stable; }
+
+    // The oldest event. Consumer only.
+    bool pop(ButtonEvent& out) { return _queue.pop(out); }
+
+    // Debounced level, as of the last sample
+    bool isPressed(ButtonId btn) const { return (_stable >> (int)btn) & 1u; }
+    // Events lost to a full queue
+    std::uint32_t dropped() const { return _queue.dropped(); }
+
+private:
+    void push(int button, ButtonEventType type, std::uint32_t nowMs);
+
+    std::uint32_t _debounceMs;
+    std::uint32_t _longPressMs;
+    std::uint32_t _repeatMs;
+
+    // Written by sample() only; read elsewhere as a snapshot
+    volatile std::uint32_t _raw;        // levels at the last sample
+    volatile std::uint32_t _stable;     // debounced levels
+    std::uint32_t _changedMs[BUTTON_COUNT];     // raw level last changed
+    std::uint32_t _dueMs[BUTTON_COUNT];         // next LONG_PRESS or REPEAT
+    bool          _long[BUTTON_COUNT];          // LONG_PRESS sent
+
+    SpscQueue<ButtonEvent, QUEUE_SIZE> _queue;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Cascaded integrator-comb decimator for oversampled ADC data.
+ *
+ * ORDER integrator and comb stages, decimation by RATIO (differential
+ * delay 1). Runs in wrapping 32 bit integer arithmetic, which is exact as
+ * long as inputBits + ORDER*log2(RATIO) <= 32 (12 bit ADC, order 3,
+ * ratio 32 -> 27 bits).
+ *
+ * The DC gain RATIO^ORDER is divided out by output(), so it returns input
+ * units with the extra resolution of the oversampling as a fraction.
+ * The group delay is ORDER*(RATIO-1)/2 input samples.
+ *
+ * Typical usage:
+ *   CicDecimator<3, 32> cic;
+ *   if(cic.push(raw)) {
+ *       float counts = cic.output();
+ *   }
+ */
+template<int ORDER, int RATIO>
+class CicDecimator {
+    static_assert(ORDER >= 1 && ORDER <= 5, "CIC order out of range");
+    static_assert(RATIO >= 2, "CIC ratio must be at least 2");
+public:
+    CicDecimator() { reset(); }
+
+    void reset() {
+        for(int i=0; i<ORDER; i++) {
+            _integ[i] = 0;
+            _comb[i] = 0;
+        }
+        _phase = 0;
+        _out = 0;
+    }
+
+    /**
+     * Feed one input sample. Return true when a new decimated output is ready.
+     */
+    bool push(std::int32_t sample) {
+        std::uint32_t v = (std::uint32_t)sample;
+        for(int i=0; i<ORDER; i++) {
+            _integ[i] += v;
+            v = _integ[i];
+        }
+        if(++_phase < RATIO) {
+            return false;
+        }
+        _phase = 0;
+
+        for(int i=0; i<ORDER; i++) {
+            std::uint32_t prev = _comb[i];
+            _comb[i] = v;
+            v -= prev;
+        }
+        _out = (std::int32_t)v;
+        return true;
+    }
+
+    // Latest output in input units
+    float output() const { return _out * (1.0f / gain()); }
+
+    // Latest output before dividing by the gain
+    std::int32_t rawOutput() const { return _out; }
+
+    static constexpr std::uint32_t gain() { return ipow(RATIO, ORDER); }
+
+private:
+    static constexpr std::uint32_t ipow(std::uint32_t base, int exp) {
+        return exp == 0 ? 1u : base * ipow(base, exp - 1);
+    }
+
+    std::uint32_t _integ[ORDER];
+    std::uint32_t _comb[ORDER];
+    int           _phase;
+    std::int32_t  _out;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A run of bytes for the panel, all commands or all data: the level of
+ * the DC line while it is sent.
+ */
+struct DisplaySegment {
+    std::uint16_t offset;
+    std::uint16_t length;
+    bool          data;
+};
+
+/**
+ * One update of the panel as the driver would have sent it: the bytes
+ * and where DC changes. Segments start 4 byte aligned, for DMA.
+ */
+struct DisplayFrame {
+    // The ST75256 JLX19296: 192x96, 12 tile rows of 192 bytes
+    static const std::size_t PANEL_BYTES = 192 * 96 / 8;
+    static const std::size_t TILE_ROWS = 96 / 8;
+    // A whole frame, the addressing command before each tile row and
+    // the alignment padding of both
+    static const std::size_t CAPACITY = PANEL_BYTES + TILE_ROWS * 16;
+    static const std::size_t MAX_SEGMENTS = 2 * TILE_ROWS + 8;
+
+    alignas(4) std::uint8_t bytes[CAPACITY];
+    DisplaySegment segments[MAX_SEGMENTS];
+    std::size_t    segmentCount;
+    std::size_t    size;
+    std::uint32_t  sequence;
+    std::uint32_t  timeUs;      // committed, as the producer gave it
+    bool           truncated;   // did not fit, the rest was dropped
+};
+
+/**
+ * Double buffer between the task that renders the display and the one
+ * that sends it, so drawing the next frame overlaps sending this one.
+ *
+ * The renderer records an update into one frame (beginFrame(),
+ * write()..., commit()) while the sender has the other (next(), send
+ * it, release()). beginFrame() fails while both are taken: the renderer
+ * is a whole frame ahead and has to wait, counted in stalls().
+ *
+ * One producer and one consumer; each frame is owned by exactly one
+ * side at a time, handed over with release/acquire.
+ */
+class DisplayFrames {
+public:
+    DisplayFrames();
+
+    // Producer: a frame to record into; false while both are taken
+    bool beginFrame();
+    // Append to the frame, merged into the last segment if the same kind
+    void write(bool data, const std::uint8_t* bytes, std::size_t n);
+    // Hand the frame to the sender, stamped with the time
+    void commit(std::uint32_t timeUs = 0);
+
+    // Consumer: the next committed frame, in order, nullptr if none
+    const DisplayFrame* next();
+    // Done with the frame next() gave
+    void release();
+
+    // beginFrame() calls that found no free frame
+    std::uint32_t stalls() const { return _stalls.load(std::memory_order_relaxed); }
+    // Committed frames that were truncated
+    std::uint32_t truncated() const { return _truncated.load(std::memory_order_relaxed); }
+
+private:
+    enum State : std::uint8_t { FREE, RECORDING, QUEUED, SENDING };
+
+    DisplayFrame _frames[2];
+    std::atomic<std::uint8_t> _state[2];
+    int _recording;             // producer's frame, -1 none
+    int _sending;               // consumer's frame, -1 none
+    std::uint32_t _sequence;    // last committed
+    std::uint32_t _sent;        // last handed to the consumer
+    std::atomic<std::uint32_t> _stalls;
+    std::atomic<std::uint32_t> _truncated;
+};
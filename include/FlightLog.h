@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Binary format of the flight recorder (see FlightRecorder), shared with
+ * the host decoder (tools/logdecode).
+ *
+ * The log is a ring of BLOCK_SIZE blocks, each readable on its own:
+ *
+ *   header  magic "FLR2", sequence, startMs (u32 each), the IMU
+ *           resolution (accel, gyro, mag LSB as float32), payload bytes
+ *           and CRC-16/CCITT of header and payload (u16 each), little
+ *           endian
+ *   payload records, then 0xFF up to the end of the block
+ *
+ * A record is its type byte, the time since the previous record (the
+ * block's startMs for the first) and its fields, all as zigzag varints.
+ * Fields are fixed point (see fieldScale()) and stored as the difference
+ * to the same field of the previous record of that type in the block, so
+ * a slowly changing value costs one byte. An IMU sample takes ~20 bytes
+ * instead of 36.
+ *
+ * With the IMU resolution set, IMU fields are stored as sensor counts
+ * instead: a sample that was counts * LSB in float decodes to the very
+ * same float, so a replay of the log is bit-exact (see ControlReplay).
+ * A sample that is not (a simulated or filtered IMU) is stored as the
+ * bits of its floats, flagged by RAW_FLAG in the type byte.
+ */
+enum class FlightRecordType : std::uint8_t {
+    IMU = 1,     // raw sample: ax ay az [m/s^2], gx gy gz [rad/s], mx my mz [uT]
+    ATTITUDE,    // fused: roll pitch yaw [deg], yaw rate [deg/s]
+    STEERING,    // heading loop: setpoint [deg], rudder order [deg], sea state [deg/s]
+    RUDDER,      // servo loop: target angle, angle [deg], command [-1..1], current [A], fault
+    MODE,        // mode change: AutoSteeringMode, setpoint [deg]
+    FEEDBACK     // heading loop input (SourceArbiter): value [deg], source, quality
+};
+
+/** One entry, as queued by the producers and returned by the decoder. */
+struct FlightRecord {
+    static const int MAX_FIELDS = 9;
+
+    FlightRecordType type;
+    std::uint32_t    timeMs;
+    float            value[MAX_FIELDS];   // fieldCount(type) used
+};
+
+/** Constants and helpers of the format above. */
+class FlightLog {
+public:
+    static const std::size_t   BLOCK_SIZE  = 4096;
+    static const std::size_t   HEADER_SIZE = 28;
+    static const std::uint32_t MAGIC       = 0x32524C46u;   // "FLR2"
+    // type + time + fields, 5 bytes per varint at most
+    static const std::size_t   MAX_RECORD  = 1 + 5 * (1 + FlightRecord::MAX_FIELDS);
+    // Record types are 1..TYPE_SLOTS-1
+    static const int           TYPE_SLOTS  = 7;
+    // In the type byte: IMU fields are float bits (slot 0 of the deltas)
+    static const std::uint8_t  RAW_FLAG    = 0x80;
+
+    // Fields of a record type, 0 for an unknown type
+    static int fieldCount(FlightRecordType type);
+    // Fixed point steps per unit of field i, e.g. 100 for 0.01 deg
+    static float fieldScale(FlightRecordType type, int i);
+    // Field i as the log stores it at fieldScale(), bit for bit what the
+    // decoder returns for it
+    static float quantize(FlightRecordType type, int i, float v);
+    // Names for CSV files and headers
+    static const char* typeName(FlightRecordType type);
+    static const char* fieldName(FlightRecordType type, int i);
+
+    // CRC-16/CCITT-FALSE, crc to continue over more data
+    static std::uint16_t crc16(const std::uint8_t* data, std::size_t len, std::uint16_t crc = 0xFFFF);
+
+    // Sequence number and start of a valid block header, false if there
+    // is none (erased, torn write, not a log block). Needs HEADER_SIZE bytes.
+    static bool readHeader(const std::uint8_t* block, std::uint32_t& sequence, std::uint32_t& startMs);
+};
+
+/**
+ * Packs records into one block. Usage:
+ *   enc.begin(seq, firstRecord.timeMs);
+ *   while(enc.append(r)) ...;       // false: block full, r not added
+ *   storage.write(enc.finish());
+ */
+class FlightLogEncoder {
+public:
+    FlightLogEncoder();
+
+    // Start an empty block
+    void begin(std::uint32_t sequence, std::uint32_t startMs);
+
+    // LSB of the IMU's accel [m/s^2], gyro [rad/s] and mag [uT] readings,
+    // for lossless IMU records; 0 for the fixed point of fieldScale().
+    // Applies from the next begin().
+    void setImuResolution(float accel, float gyro, float mag);
+
+    // Add a record, false if it does not fit (or has an unknown type)
+    bool append(const FlightRecord& r);
+
+    // Fill in the header and the erased tail; the block stays valid for
+    // more append() calls, so a partly filled block can be saved too
+    const std::uint8_t* finish();
+
+    bool          isEmpty() const { return _used == FlightLog::HEADER_SIZE; }
+    std::size_t   size() const { return _used; }
+    std::uint32_t sequence() const { return _sequence; }
+
+private:
+    void putVarint(std::uint32_t v);
+    void putSigned(std::int32_t v);
+
+    std::uint8_t  _block[FlightLog::BLOCK_SIZE];
+    std::size_t   _used;
+    std::uint32_t _sequence;
+    std::uint32_t _startMs;
+    std::uint32_t _lastMs;
+    float         _imuRes[3];       // next block's
+    float         _blockRes[3];     // this block's
+    std::int32_t  _prev[FlightLog::TYPE_SLOTS][FlightRecord::MAX_FIELDS];   // by type, last fixed point values
+};
+
+/** Reads the records back out of one block. */
+class FlightLogDecoder {
+public:
+    FlightLogDecoder();
+
+    // Check the header and CRC; false leaves the decoder empty
+    bool open(const std::uint8_t* block, std::size_t len);
+
+    // Next record, false at the end of the block or on a corrupt record
+    bool next(FlightRecord& out);
+
+    std::uint32_t sequence() const { return _sequence; }
+    std::uint32_t startMs() const { return _startMs; }
+
+    // Step of field i of a record type in this block, e.g. 0.01 deg
+    float resolution(FlightRecordType type, int i) const;
+
+private:
+    bool getVarint(std::uint32_t& v);
+    bool getSigned(std::int32_t& v);
+
+    const std::uint8_t* _data;
+    std::size_t   _pos;
+    std::size_t   _end;
+    std::uint32_t _sequence;
+    std::uint32_t _startMs;
+    std::uint32_t _lastMs;
+    float         _imuRes[3];
+    std::int32_t  _prev[FlightLog::TYPE_SLOTS][FlightRecord::MAX_FIELDS];
+};
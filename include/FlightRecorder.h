@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "FlightLog.h"
+#include "IBlockStorage.h"
+#include "IIMUProvider.h"
+#include "IMUFilterAndCalibration.h"
+#include "SpscQueue.h"
+
+/**
+ * Black box: the last minutes of sensor data and control decisions,
+ * kept on flash in the FlightLog format for the host decoder
+ * (tools/logdecode).
+ *
+ * The control tasks only push records into lock-free queues; a full
+ * queue drops the record and counts it, so logging never blocks or slows
+ * control. Each producing task gets its own channel (one SpscQueue per
+ * producer). service(), from a low priority task, drains the queues,
+ * encodes the records and writes whole blocks, round robin over the
+ * storage, so the oldest data is overwritten first. The block being
+ * filled is saved every FLUSH_MS as well, so a crash loses little.
+ *
+ * Typical usage:
+ *   FlightRecorder rec(storage);
+ *   rec.begin();                            // continue after the newest block
+ *   rec.logImu(CONTROL, millis(), raw);     // control task, channel CONTROL
+ *   rec.logRudder(UI, millis(), ...);       // another task, another channel
+ *   rec.service(millis());                  // logger task
+ */
+class FlightRecorder {
+public:
+    static const std::size_t   CHANNELS   = 2;
+    static const std::size_t   QUEUE_SIZE = 64;      // records per channel
+    static const std::uint32_t FLUSH_MS   = 2000;
+
+    explicit FlightRecorder(IBlockStorage& storage);
+
+    // Find the newest block and continue after it. False if the storage
+    // has no blocks; the recorder then accepts and discards records.
+    bool begin();
+
+    // Store IMU samples as sensor counts of these LSBs, see
+    // FlightLogEncoder::setImuResolution(). Call before begin().
+    void setImuResolution(float accel, float gyro, float mag) { _encoder.setImuResolution(accel, gyro, mag); }
+
+    // Producer side, never blocks. False (and counted) if the queue is full.
+    bool record(std::size_t channel, const FlightRecord& r);
+    bool logImu(std::size_t channel, std::uint32_t timeMs, const IMUData& raw);
+    bool logAttitude(std::size_t channel, std::uint32_t timeMs, const FilteredIMUData& att);
+    bool logSteering(std::size_t channel, std::uint32_t timeMs, float setpoint, float rudderOrder, float seaState);
+    bool logRudder(std::size_t channel, std::uint32_t timeMs, float target, float angle,
+                   float command, float current, int fault);
+    bool logMode(std::size_t channel, std::uint32_t timeMs, int mode, float setpoint);
+    bool logFeedback(std::size_t channel, std::uint32_t timeMs, float value, int source, float quality);
+
+    // Consumer side: encode what is queued, write full (and stale) blocks
+    void service(std::uint32_t nowMs);
+    // Write the block being filled now, e.g. before a reset
+    void flush();
+
+    std::uint32_t recorded() const { return _recorded; }
+    std::uint32_t dropped() const;
+    std::uint32_t blocksWritten() const { return _blocksWritten; }
+    std::uint32_t writeErrors() const { return _writeErrors; }
+
+private:
+    void writeCurrent();
+    void nextBlock(std::uint32_t startMs);
+
+    IBlockStorage&   _storage;
+    SpscQueue<FlightRecord, QUEUE_SIZE> _queues[CHANNELS];
+    FlightLogEncoder _encoder;
+    bool             _ready;
+    std::size_t      _block;           // index being filled
+    std::uint32_t    _sequence;
+    bool             _dirty;           // records since the last write
+    std::uint32_t    _lastWrite;       // [ms]
+    std::uint32_t    _recorded;
+    std::uint32_t    _blocksWritten;
+    std::uint32_t    _writeErrors;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+
+/** PID gains for the heading loop and the rudder position loop. */
+struct GainSet {
+    float maxSeaState;   // use this set up to this sea state (yaw rate std, deg/s)
+    float steerKp, steerKi, steerKd;
+    float rudderKp, rudderKi, rudderKd;
+    bool  economy;       // rudder economy mode (RudderServo) in this sea state
+};
+
+/**
+ * Gains tuned per sea state, as written by the host autotuner
+ * (tools/autotune) and stored as JSON (e.g. /gains.json on LittleFS):
+ *
+ *   { "version": 1,
+ *     "sets": [ { "maxSeaState": 1.5,
+ *                 "steer":  { "kP": 1.5, "kI": 0.02, "kD": 2.0 },
+ *                 "rudder": { "kP": 2.0, "kI": 0.0,  "kD": 0.05 },
+ *                 "economy": true }, ... ] }
+ *
+ * "economy" is optional, false if missing.
+ * Sets are kept sorted by maxSeaState.
+ */
+class GainTable {
+public:
+    static constexpr size_t MAX_SETS = 8;
+
+    GainTable();
+
+    // Parse the JSON text. Return false (and keep the old content) on error.
+    bool loadFromJson(const char* json);
+
+    // Insert one set in order, e.g. built-in defaults or a host tool's
+    // table. Return false if the table is full.
+    bool add(const GainSet& set);
+
+    // Return the set for the given sea state; the last set covers
+    // everything above. Returns nullptr if the table is empty.
+    const GainSet* select(float seaState) const;
+
+    size_t size() const { return _count; }
+    const GainSet& at(size_t i) const { return _sets[i]; }
+
+private:
+    GainSet _sets[MAX_SETS];
+    size_t  _count;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "IInputDevice.h"
+#include "ButtonEvents.h"
+
+/**
+ * The panel buttons on GPIOs, active low with the internal pullups,
+ * feeding ButtonEvents.
+ *
+ * Any edge on a button pin starts a hardware timer that samples all of
+ * them every TICK_US and stops again once every button is released and
+ * settled. Nobody at the panel: no interrupts, no timer, no polling.
+ *
+ * One instance; the ISRs find it through a static pointer.
+ */
+class GpioButtons : public IInputDevice {
+public:
+    static const uint32_t TICK_US = 5000;
+
+    // Pins in ButtonId order, -1 for a button that is not fitted
+    explicit GpioButtons(const int (&pins)[ButtonEvents::BUTTON_COUNT]);
+
+    // Pins, interrupts and the debounce timer timerNum
+    bool begin(uint8_t timerNum=2);
+
+    ButtonEvents& events() { return _events; }
+
+    // From IInputDevice: the debounced level
+    bool isPressed(ButtonId btn) const override { return _events.isPressed(btn); }
+
+    static void IRAM_ATTR onEdge();
+    static void IRAM_ATTR onTimer();
+
+private:
+    uint32_t readPins() const;
+
+    int _pins[ButtonEvents::BUTTON_COUNT];
+    ButtonEvents _events;
+
+    static GpioButtons* s_instance;
+    static hw_timer_t* s_timer;
+    // Timer running; both ISRs sit on the core begin() ran on and do not nest
+    static std::atomic<bool> s_armed;
+};
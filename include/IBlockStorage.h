@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed number of equal sized blocks on non-volatile storage, for the
+ * flight recorder. LittleFSBlockStorage keeps them in one preallocated
+ * file on the target; tests use a RAM array.
+ */
+class IBlockStorage {
+public:
+    virtual ~IBlockStorage() = default;
+
+    virtual std::size_t blockCount() const = 0;
+
+    // Read the first len bytes of block index, false on error
+    virtual bool readBlock(std::size_t index, std::uint8_t* out, std::size_t len) = 0;
+
+    // Overwrite a whole block (FlightLog::BLOCK_SIZE bytes), false on error
+    virtual bool writeBlock(std::size_t index, const std::uint8_t* data) = 0;
+};
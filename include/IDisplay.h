@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * Abstract text display the UI draws on. The platform-specific driver
+ * (U8g2Display on the target) implements it; NullDisplay stands in for
+ * benchmarks and host tests.
+ *
+ * Drawing goes to an off-screen buffer; sendBuffer() shows it. The
+ * buffer keeps what was drawn, so a part of the screen can be redrawn
+ * on its own: clearTiles(), draw, sendTiles(). Tiles are 8x8 pixels,
+ * u8g2's unit for partial updates.
+ */
+class IDisplay {
+public:
+    virtual ~IDisplay() = default;
+
+    // Initialize the driver, return false on failure
+    virtual bool begin() = 0;
+
+    virtual void clearBuffer() = 0;
+
+    // Draw text with its baseline at y (pixels)
+    virtual void drawStr(int x, int y, const char* text) = 0;
+
+    virtual void sendBuffer() = 0;
+
+    // Blank, and send only, the tw x th tiles from tile (tx, ty)
+    virtual void clearTiles(int tx, int ty, int tw, int th) = 0;
+    virtual void sendTiles(int tx, int ty, int tw, int th) = 0;
+};
@@ -10,29 +10,43 @@ struct FilteredIMUData {
     float pitch;
     float roll;
     float yaw;
+    float yawRate;   // deg/s, straight from the gyro
 };
 
 class IMUFilterAndCalibration {
 public:
     IMUFilterAndCalibration(IIMUProvider& imu, ITimeProvider& timeProv);
 
-    // Start or do calibration
+    // Calibrate the gyro alongside: from startCalibration() on, update()
+    // averages the gyro instead of integrating it, doCalibrationStep()
+    // takes the averages as the biases from then on
     void startCalibration();
     void doCalibrationStep();
 
-    // Called periodically
-    void update();
+    // Called periodically; true if a new sample came in
+    bool update();
+    // The same at a time the caller read once, e.g. to record the sample
+    // with the very timestamp the filter integrated it at
+    bool update(std::uint64_t nowMs);
 
     // Get the fused orientation
     FilteredIMUData getFilteredData() const;
 
+    // The sample behind it, as the IMU provided it
+    IMUData getRawData() const;
+
 private:
     IIMUProvider&      _imu;
     ITimeProvider&     _time;
     bool               _calibrating;
     float              _pitch, _roll, _yaw;
+    float              _yawRate;
+    IMUData            _raw;
     std::uint64_t      _lastUpdate;
     // Example offsets
     float _axOff, _ayOff, _azOff;
-    // etc.
+    // Gyro biases [rad/s] and the sums behind them while calibrating
+    float _gxOff, _gyOff, _gzOff;
+    double _gxSum, _gySum, _gzSum;
+    std::uint32_t _calSamples;
 };
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Non-blocking byte source for NmeaInput: a UDP socket, a TCP
+ * connection or, in tests, a replayed capture.
+ */
+class IPacketSource {
+public:
+    virtual ~IPacketSource() = default;
+
+    // Copy up to len received bytes to out, 0 if nothing is waiting. A
+    // datagram longer than len comes out over several calls, in order.
+    virtual std::size_t receive(char* out, std::size_t len) = 0;
+};
@@ -12,4 +12,10 @@ public:
 
     // Return current time in ms since some epoch
     virtual std::uint64_t getMillis() const = 0;
+
+    // Same clock in microseconds. Override where the platform has a
+    // finer clock; the default is only millisecond resolution.
+    virtual std::uint64_t getMicros() const {
+        return getMillis() * 1000ULL;
+    }
 };
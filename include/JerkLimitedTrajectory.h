@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+ * Motion limits of a rudder drive type, all in degrees of rudder.
+ * fullDutyRate is what the drive does at 100 % duty and is used for the
+ * velocity feed-forward; maxRate should stay somewhat below it so the
+ * PID has headroom to correct.
+ */
+struct DriveProfile {
+    float maxRate;        // [deg/s]
+    float maxAccel;       // [deg/s^2]
+    float maxJerk;        // [deg/s^3]
+    float fullDutyRate;   // drive speed at full duty [deg/s]
+
+    DriveProfile()
+    : maxRate(6.0f)
+    , maxAccel(30.0f)
+    , maxJerk(300.0f)
+    , fullDutyRate(8.0f)
+    {}
+
+    DriveProfile(float rate, float accel, float jerk, float fullDuty)
+    : maxRate(rate)
+    , maxAccel(accel)
+    , maxJerk(jerk)
+    , fullDutyRate(fullDuty)
+    {}
+
+    // Electric linear ram (the default)
+    static DriveProfile electricLinear() { return DriveProfile(6.0f, 30.0f, 300.0f, 8.0f); }
+    // Hydraulic pump and ram: faster, but the pump needs time to build up
+    static DriveProfile hydraulic()      { return DriveProfile(10.0f, 20.0f, 100.0f, 12.0f); }
+    // Geared wheel drive with a chain: slow, backlash hates jerks
+    static DriveProfile wheelDrive()     { return DriveProfile(4.0f, 15.0f, 100.0f, 5.0f); }
+};
+
+/**
+ * Online S-curve (jerk-limited) trajectory generator. Each update() moves
+ * the reference one step towards the target without exceeding the rate,
+ * acceleration and jerk limits; a new target can be set at any time and
+ * the motion blends into it from the current state. Constant time per
+ * step, no planning horizon.
+ *
+ * Outer loop: the velocity that still allows a jerk-limited stop at the
+ * target. Inner loop: the acceleration that reaches that velocity with
+ * the acceleration back at zero, reached with bounded jerk.
+ */
+class JerkLimitedTrajectory {
+public:
+    explicit JerkLimitedTrajectory(const DriveProfile& profile = DriveProfile());
+
+    void setProfile(const DriveProfile& profile);
+    const DriveProfile& getProfile() const;
+
+    // Start at rest at position
+    void reset(float position);
+
+    // Advance by dt towards target, return the new reference position
+    float update(float target, float dt);
+
+    float getPosition() const;
+    float getVelocity() const;
+    float getAcceleration() const;
+
+    // At the target and at rest
+    bool isSettled() const;
+
+    // Highest speed from which a jerk-limited stop fits in distance
+    float stoppingVelocity(float distance) const;
+
+private:
+    DriveProfile _profile;
+    float _pos;
+    float _vel;
+    float _acc;
+    float _target;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <LittleFS.h>
+#include "IBlockStorage.h"
+
+/**
+ * IBlockStorage in one LittleFS file of blockCount FlightLog blocks,
+ * allocated (as erased blocks) on the first begin() so the log never
+ * grows and never fails for lack of space later. Call LittleFS.begin()
+ * first.
+ */
+class LittleFSBlockStorage : public IBlockStorage {
+public:
+    LittleFSBlockStorage(const char* path, std::size_t blockCount);
+
+    // Open the file, creating it if missing or of the wrong size
+    bool begin();
+
+    std::size_t blockCount() const override;
+    bool readBlock(std::size_t index, std::uint8_t* out, std::size_t len) override;
+    bool writeBlock(std::size_t index, const std::uint8_t* data) override;
+
+private:
+    bool allocate();
+
+    const char* _path;
+    std::size_t _blocks;
+    File        _file;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+/** Timing of a periodic loop, all times in microseconds. */
+struct LoopJitterStats {
+    static constexpr int BUCKETS = 6;
+    // Upper bounds of the jitter histogram buckets, the last is open
+    static constexpr std::uint32_t BUCKET_LIMIT_US[BUCKETS - 1] = { 5, 20, 50, 100, 500 };
+
+    std::uint32_t cycles;
+    std::uint32_t overruns;       // loop body longer than the period, or a missed cycle
+    std::uint32_t minPeriod;
+    std::uint32_t maxPeriod;
+    float         meanPeriod;
+    std::uint32_t maxJitter;      // largest |period - nominal|
+    float         meanJitter;
+    std::uint32_t maxExec;        // loop body run time
+    float         meanExec;
+    std::uint32_t histogram[BUCKETS];   // cycles per jitter bucket
+};
+
+/**
+ * Instrumentation for a fixed rate loop. Call cycleStart() when the loop
+ * body starts and cycleEnd() when it is done, with a microsecond clock
+ * (micros() on the target). Wrap-around of the 32 bit clock is handled.
+ *
+ * Not thread safe: use it from the loop itself and hand stats() to other
+ * tasks by copy (see Mailbox).
+ */
+class LoopJitter {
+public:
+    explicit LoopJitter(std::uint32_t periodUs);
+
+    void cycleStart(std::uint32_t nowUs);
+    void cycleEnd(std::uint32_t nowUs);
+
+    std::uint32_t getPeriod() const;
+    const LoopJitterStats& stats() const;
+    void reset();
+
+private:
+    std::uint32_t   _period;
+    std::uint32_t   _lastStart;
+    bool            _started;
+    std::uint32_t   _periods;     // samples behind meanPeriod/meanJitter
+    double          _sumPeriod;
+    double          _sumJitter;
+    double          _sumExec;
+    LoopJitterStats _stats;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Explicit (precomputed) MPC solution for the heading loop.
+ *
+ * The QP of a linear first-order Nomoto yaw model with a box constraint
+ * on the rudder is solved offline by tools/mpc_gen. Its solution is
+ * piecewise-affine in the state x = [headingError, yawRate, prevRudder]:
+ * the state space is split into polyhedral regions  A*x <= b  and in
+ * each region the first rudder move is  u0 = K*x + k0.
+ *
+ * The table data lives in src/MPCExplicitTable.cpp, which is generated.
+ * Regenerate it with:  pio run -e mpc_gen -t exec
+ */
+
+static constexpr int MPC_STATE_DIM  = 3;
+static constexpr int MPC_MAX_MOVES  = 4;
+static constexpr int MPC_MAX_ROWS   = 2 * MPC_MAX_MOVES;
+
+/** Parameters the table was generated for. */
+struct MPCModelInfo {
+    float   ts;          // control period [s]
+    float   nomotoK;     // steady state yaw rate per rudder [1/s]
+    float   nomotoT;     // yaw time constant [s]
+    float   rudderMax;   // rudder limit [deg]
+    uint8_t horizon;     // prediction steps
+    uint8_t moves;       // free rudder moves (move blocking)
+};
+
+/** One polyhedral region of the explicit solution. */
+struct MPCRegion {
+    uint8_t rows;                                // used rows of A/b
+    float   A[MPC_MAX_ROWS][MPC_STATE_DIM];
+    float   b[MPC_MAX_ROWS];
+    float   K[MPC_STATE_DIM];                    // u0 = K*x + k0
+    float   k0;
+};
+
+// Generated data, ordered by how often the region was hit while gridding,
+// so the common (unconstrained) case is found first.
+extern const MPCModelInfo MPC_MODEL;
+extern const MPCRegion    MPC_REGIONS[];
+extern const int          MPC_REGION_COUNT;
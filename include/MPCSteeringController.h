@@ -0,0 +1,42 @@
+#pragma once
+#include "AutoSteeringController.h"
+#include "MPCExplicitTable.h"
+
+/**
+ * Model-predictive heading controller, an alternative to the PID in
+ * AutoSteeringController for conditions where yaw should be anticipated
+ * (e.g. downwind surfing).
+ *
+ * The QP is solved offline (see MPCExplicitTable.h), so each update is
+ * a search for the region containing the state plus one dot product.
+ * update() must be called every MPC_MODEL.ts seconds.
+ */
+class MPCSteeringController {
+public:
+    MPCSteeringController();
+    ~MPCSteeringController() = default;
+
+    // Only TRACK_HEADING and TRACK_COURSE are supported, other modes
+    // keep the rudder centred. param is the desired heading/course.
+    void setMode(AutoSteeringMode mode, float param=0.0f);
+
+    // measured: heading (or COG) in degrees, yawRate in deg/s, positive
+    // as the heading grows (to starboard)
+    void update(float measured, float yawRate);
+
+    // Return the desired rudder angle
+    float getRudderAngle() const;
+
+    // Index into MPC_REGIONS used by the last update, -1 if none.
+    int getActiveRegion() const;
+
+    // Evaluate the explicit law for a state, returns the rudder in degrees.
+    // Exposed for tests and benchmarks.
+    static float evaluate(const float x[MPC_STATE_DIM], int* regionOut=nullptr);
+
+private:
+    AutoSteeringMode _mode;
+    float _desired;
+    float _rudderAngle;
+    int   _activeRegion;
+};
@@ -2,21 +2,7 @@
 
 #include <Arduino.h>
 #include <Wire.h>
-
-// In your minimal "MPU9250.h"
-enum class MPU9250AccelRange {
-    ACCEL_RANGE_2G  = 0,
-    ACCEL_RANGE_4G  = 1,
-    ACCEL_RANGE_8G  = 2,
-    ACCEL_RANGE_16G = 3
-};
-
-enum class MPU9250GyroRange {
-    GYRO_RANGE_250DPS  = 0,
-    GYRO_RANGE_500DPS  = 1,
-    GYRO_RANGE_1000DPS = 2,
-    GYRO_RANGE_2000DPS = 3
-};
+#include "MPU9250Decoder.h"
 
 // You might define a method or enum for DLPF:
 static const uint8_t DLPF_BANDWIDTH_20HZ = 4;
@@ -62,23 +48,23 @@ public:
     /**
      * Get the accelerometer in m/s^2 for X, Y, Z
      */
-    float getAccelX_mSs() const { return _accelX; }
-    float getAccelY_mSs() const { return _accelY; }
-    float getAccelZ_mSs() const { return _accelZ; }
+    float getAccelX_mSs() const { return _data.accelX; }
+    float getAccelY_mSs() const { return _data.accelY; }
+    float getAccelZ_mSs() const { return _data.accelZ; }
 
     /**
      * Get the gyroscope in rad/s for X, Y, Z
      */
-    float getGyroX_rads() const { return _gyroX; }
-    float getGyroY_rads() const { return _gyroY; }
-    float getGyroZ_rads() const { return _gyroZ; }
+    float getGyroX_rads() const { return _data.gyroX; }
+    float getGyroY_rads() const { return _data.gyroY; }
+    float getGyroZ_rads() const { return _data.gyroZ; }
 
     /**
      * Get the magnetometer in microtesla (uT) for X, Y, Z
      */
-    float getMagX_uT() const { return _magX; }
-    float getMagY_uT() const { return _magY; }
-    float getMagZ_uT() const { return _magZ; }
+    float getMagX_uT() const { return _data.magX; }
+    float getMagY_uT() const { return _data.magY; }
+    float getMagZ_uT() const { return _data.magZ; }
 
     /**
      * (Optional) set digital low-pass filter bandwidth or sample rate
@@ -116,9 +102,7 @@ private:
     uint8_t           _srd;
 
     // scaled data
-    float _accelX, _accelY, _accelZ;
-    float _gyroX,  _gyroY,  _gyroZ;
-    float _magX,   _magY,   _magZ;
+    MPU9250Reading _data;
 
     // conversion factors
     float _accelScale;
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+
+enum class MPU9250AccelRange {
+    ACCEL_RANGE_2G  = 0,
+    ACCEL_RANGE_4G  = 1,
+    ACCEL_RANGE_8G  = 2,
+    ACCEL_RANGE_16G = 3
+};
+
+enum class MPU9250GyroRange {
+    GYRO_RANGE_250DPS  = 0,
+    GYRO_RANGE_500DPS  = 1,
+    GYRO_RANGE_1000DPS = 2,
+    GYRO_RANGE_2000DPS = 3
+};
+
+/** Scaled accel (m/s^2), gyro (rad/s) and mag (uT) readings. */
+struct MPU9250Reading {
+    float accelX, accelY, accelZ;
+    float gyroX,  gyroY,  gyroZ;
+    float magX,   magY,   magZ;
+};
+
+/**
+ * Register decoding of the MPU9250 and its AK8963 magnetometer, kept
+ * apart from the I2C code in MPU9250 so it builds and runs on the host.
+ */
+class MPU9250Decoder {
+public:
+    // Bytes from ACCEL_XOUT_H to GYRO_ZOUT_L (temperature included)
+    static const int ACCEL_GYRO_BYTES = 14;
+    // Bytes from AK8963 HXL to ST2
+    static const int MAG_BYTES = 7;
+    // Assumed magnetometer sensitivity [uT/LSB]
+    static constexpr float MAG_SCALE = 0.6f;
+
+    // Register value for ACCEL_CONFIG / GYRO_CONFIG
+    static std::uint8_t accelConfig(MPU9250AccelRange range);
+    static std::uint8_t gyroConfig(MPU9250GyroRange range);
+
+    // LSB to m/s^2 and rad/s
+    static float accelScale(MPU9250AccelRange range);
+    static float gyroScale(MPU9250GyroRange range);
+
+    // Big-endian accel/gyro frame into out.accel* and out.gyro*
+    static void decodeAccelGyro(const std::uint8_t raw[ACCEL_GYRO_BYTES],
+                                float accelScale, float gyroScale, MPU9250Reading& out);
+
+    // Little-endian magnetometer frame into out.mag*.
+    // Return false (out unchanged) on a magnetic sensor overflow (ST2 HOFL).
+    static bool decodeMag(const std::uint8_t raw[MAG_BYTES], MPU9250Reading& out);
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Lock-free "latest value" mailbox between one writer and any number of
+ * readers (seqlock). The writer never blocks; a reader that races with a
+ * write retries the copy, so it always gets a consistent value.
+ *
+ * Meant for small, trivially copyable structs handed between a task and
+ * a higher priority loop, e.g. the heading loop writing the rudder target
+ * for the 1 kHz servo task:
+ *   Mailbox<RudderCommand> box;
+ *   box.write(cmd);              // heading loop
+ *   RudderCommand c;
+ *   if(box.read(c)) { ... }      // servo task
+ *
+ * Only one task may call write().
+ */
+template<typename T>
+class Mailbox {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Mailbox needs a trivially copyable type");
+public:
+    Mailbox()
+        : _seq(0)
+        , _value()
+    {}
+
+    explicit Mailbox(const T& initial)
+        : _seq(0)
+        , _value(initial)
+    {}
+
+    ~Mailbox() = default;
+
+    /**
+     * Publish a new value. Never blocks.
+     */
+    void write(const T& value) {
+        std::uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);   // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        _value = value;
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Copy the latest value into out.
+     * Return false if nothing was written yet (out is then the initial value).
+     */
+    bool read(T& out) const {
+        std::uint32_t before, after;
+        do {
+            before = _seq.load(std::memory_order_acquire);
+            while(before & 1u) {
+                before = _seq.load(std::memory_order_acquire);
+            }
+            out = _value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _seq.load(std::memory_order_relaxed);
+        } while(before != after);
+        return before != 0;
+    }
+
+    /**
+     * Number of writes so far. Readers can compare it to see if a new
+     * value arrived since their last read().
+     */
+    std::uint32_t version() const {
+        return _seq.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    std::atomic<std::uint32_t> _seq;
+    T _value;
+};
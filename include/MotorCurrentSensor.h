@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "CicDecimator.h"
+#include "Mailbox.h"
+
+/**
+ * Motor current from the H-bridge current sense output, sampled together
+ * with the rudder pot (see AdcDmaSampler). A short CIC keeps the delay
+ * low enough for the overcurrent cutoff: 8 samples at 40 kHz.
+ *
+ * The sense output is assumed unipolar and linear:
+ *   amps = (counts - zeroCounts) * ampsPerCount
+ */
+class MotorCurrentSensor {
+public:
+    static const int CIC_ORDER = 2;
+    static const int CIC_RATIO = 8;
+
+    // BTS7960 IS pin, 8500:1 into 1 kOhm, 12 bit over ~3.1 V
+    MotorCurrentSensor(float ampsPerCount=0.0064f, float zeroCounts=0.0f);
+
+    void setScale(float ampsPerCount, float zeroCounts);
+
+    // Convert one raw reading, for analogRead() use
+    float toAmps(float counts) const;
+
+    // Feed raw 12 bit ADC samples. Only one task may call this.
+    void addSamples(const std::uint16_t* raw, std::size_t count);
+
+    // Latest decimated current [A], O(1)
+    float getCurrent() const;
+
+    void reset();
+
+private:
+    CicDecimator<CIC_ORDER, CIC_RATIO> _cic;
+    float _ampsPerCount;
+    float _zeroCounts;
+    int   _outputs;
+    Mailbox<float> _latest;
+};
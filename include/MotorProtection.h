@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+
+/** Why the drive is (partly) blocked. */
+enum class MotorFault : std::uint8_t {
+    NONE,
+    OVERCURRENT,   // current above the hard limit, drive off for a while
+    STALL,         // current but no motion, e.g. on a stop or fouled; one direction blocked
+    THERMAL        // I2t model too hot, drive off until it cooled down
+};
+
+/**
+ * Limits of the drive. Defaults fit a 12 V linear drive with a ~20 A
+ * locked rotor current behind a BTS7960 style H-bridge.
+ */
+struct MotorProtectionConfig {
+    float overcurrentLimit;   // hard limit [A]
+    int   overcurrentSamples; // consecutive samples above the limit to trip
+    float overcurrentHold;    // drive off after a trip [s]
+    float stallCurrent;       // current that counts as pushing [A]
+    float stallMotion;        // less rudder travel than this... [deg]
+    float stallTime;          // ...for this long is a stall [s]
+    float stallRetry;         // try the blocked direction again after [s]
+    float ratedCurrent;       // continuous rating [A]
+    float thermalTau;         // winding time constant [s]
+    float thermalTrip;        // trip at this multiple of the rated heating
+    float thermalReset;       // drive allowed again below this
+
+    MotorProtectionConfig()
+    : overcurrentLimit(25.0f)
+    , overcurrentSamples(2)
+    , overcurrentHold(0.5f)
+    , stallCurrent(8.0f)
+    , stallMotion(0.3f)
+    , stallTime(0.2f)
+    , stallRetry(2.0f)
+    , ratedCurrent(5.0f)
+    , thermalTau(30.0f)
+    , thermalTrip(1.5f)
+    , thermalReset(1.0f)
+    {}
+};
+
+/**
+ * Protection for the rudder drive, run in the servo loop on every cycle:
+ *  - overcurrent: cut after overcurrentSamples readings above the limit
+ *    (2 ms at 1 kHz), retry after overcurrentHold
+ *  - stall: pushing without moving blocks that direction, the other
+ *    direction stays available so the rudder can be driven off a stop
+ *  - I2t: first-order thermal model normalized to the rated current
+ *    (1.0 = steady state at rated current)
+ *
+ * Platform agnostic; the servo loop feeds it the measured current and
+ * rudder angle and drives whatever limit() returns.
+ */
+class MotorProtection {
+public:
+    explicit MotorProtection(const MotorProtectionConfig& cfg = MotorProtectionConfig());
+
+    void setConfig(const MotorProtectionConfig& cfg);
+    const MotorProtectionConfig& getConfig() const;
+
+    /**
+     * command: requested motor command [-1..1], current: measured motor
+     * current [A], angle: rudder angle [deg], dt: since the last call [s].
+     * Return the command that may be driven (0 if blocked).
+     */
+    float limit(float command, float current, float angle, float dt);
+
+    // Most severe active fault
+    MotorFault getFault() const;
+    // Direction blocked by a stall (+1/-1), 0 if none
+    int getBlockedDirection() const;
+    // Thermal state, multiple of the rated heating
+    float getThermalLoad() const;
+    // Trips since reset()
+    std::uint32_t getTripCount() const;
+
+    void reset();
+
+private:
+    MotorProtectionConfig _cfg;
+
+    int   _overSamples;
+    float _overcurrentTimer;   // >0 while holding off
+    float _stallTimer;
+    float _stallAnchor;        // angle where pushing started
+    int   _stallDirection;
+    float _blockedTimer;
+    int   _blockedDirection;
+    float _blockedAngle;
+    float _thermal;
+    bool  _thermalTripped;
+    std::uint32_t _trips;
+};
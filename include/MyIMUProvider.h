@@ -2,7 +2,7 @@
 
 #include <Arduino.h>
 #include "IIMUProvider.h"
-#include "RingBuffer.h"
+#include "SpscQueue.h"
 
 /**
  * A platform-specific class that implements IIMUProvider,
@@ -33,9 +33,10 @@ private:
     // The function that actually reads sensor in the ISR
     void readSensorInISR();
 
-    // Our ring buffer
+    // Samples from the ISR to the fusion task. Lock-free, as the ISR
+    // can fire while the task is popping.
     static constexpr int RB_CAPACITY = 16;
-    RingBuffer<IMUData, RB_CAPACITY> _ring;
+    SpscQueue<IMUData, RB_CAPACITY> _ring;
 
     uint8_t  _i2cAddr;       // e.g. 0x68 or 0x69
     int      _drPin;         // data-ready pin
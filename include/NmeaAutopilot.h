@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "AutoSteeringController.h"
+#include "NmeaParser.h"
+#include "NmeaWriter.h"
+
+/** What the autopilot publishes, as of one NmeaAutopilot::update(). */
+struct AutopilotTelemetry {
+    AutoSteeringMode mode;
+    float setpoint;         // of the mode [deg]
+    float heading;          // magnetic [deg]
+    float windAngle;        // true, steered by in wind mode [deg], NAN if none
+    float rudderAngle;      // [deg], positive to starboard
+};
+
+/**
+ * The autopilot on NMEA0183: telemetry out, remote commands in.
+ *
+ * Out, each at its own period (0 turns it off):
+ *   $APHDG  heading                 $APHDG,181.5,,,,*hh
+ *   $APRSA  rudder angle            $APRSA,-3.2,A,,V*hh
+ *   $APAPB  heading to steer (APB with the navigation fields empty,
+ *           status V while OFF)     $APAPB,A,A,,,N,V,V,,,,,,185.0,M,*hh
+ *   $PXAPS  mode and setpoint, heading and rudder
+ *                                   $PXAPS,H,185.0,181.5,-3.2*hh
+ * update() formats the due sentences back to back into one buffer and
+ * hands them to the output in one call (one datagram).
+ *
+ * In, $PXAPC,<mode>,<setpoint>: mode O off, H heading, C course, W wind
+ * angle (true, -180..180), setpoint in degrees. An empty setpoint keeps
+ * the present one, or engages on the present heading for H and the
+ * present wind angle for W. handle() maps it onto
+ * AutoSteeringController::setMode(), so call it from the task that
+ * owns setMode().
+ */
+class NmeaAutopilot {
+public:
+    enum Sentence {
+        HDG,
+        RSA,
+        APB,
+        STATUS,
+        SENTENCE_COUNT
+    };
+
+    typedef void (*Output)(const char* data, std::size_t len, void* ctx);
+
+    explicit NmeaAutopilot(AutoSteeringController& steer);
+
+    void setOutput(Output output, void* ctx) { _output = output; _ctx = ctx; }
+
+    // Period of a sentence [ms], 0 for never. Default: STATUS and HDG 1 s,
+    // RSA 500 ms, APB off.
+    void setPeriod(Sentence sentence, std::uint32_t ms);
+
+    // Publish what is due
+    void update(std::uint32_t nowMs, const AutopilotTelemetry& t);
+
+    // Apply a remote command; false if s is none or cannot be applied.
+    // The command as given to setMode() goes to applied.
+    bool handle(const NmeaSentence& s, SteeringCommand& applied);
+
+    // One sentence into out (MAX_LENGTH + 1 bytes), its length
+    static std::size_t format(Sentence sentence, const AutopilotTelemetry& t, char* out, std::size_t size);
+
+    std::uint32_t sent() const { return _sent; }
+    std::uint32_t commands() const { return _commands; }
+    std::uint32_t rejected() const { return _rejected; }
+
+private:
+    AutoSteeringController& _steer;
+    Output        _output;
+    void*         _ctx;
+    std::uint32_t _period[SENTENCE_COUNT];
+    std::uint32_t _due[SENTENCE_COUNT];
+    bool          _started;
+    AutopilotTelemetry _last;
+    char          _buf[SENTENCE_COUNT * NmeaWriter::MAX_LENGTH + 1];
+    std::uint32_t _sent;
+    std::uint32_t _commands;
+    std::uint32_t _rejected;
+};
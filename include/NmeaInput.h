@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "IPacketSource.h"
+#include "NmeaParser.h"
+#include "SpscQueue.h"
+
+/** Counters of one NMEA source, see NmeaInput::stats(). */
+struct NmeaSourceStats {
+    std::uint32_t bytes;            // received
+    std::uint32_t dropped;          // bytes lost to a full ring
+    std::uint32_t sentences;        // decoded
+    std::uint32_t ignored;          // valid, not decoded (e.g. GSV)
+    std::uint32_t checksumErrors;
+    std::uint32_t malformed;
+    float         rate;             // decoded sentences per second
+};
+
+/**
+ * NMEA0183 from the network, split over two tasks:
+ *
+ *   network task  poll() reads every source (or a receive callback
+ *                 calls push()) into chunks of a ring
+ *   parser task   service() takes the chunks and feeds them to the
+ *                 source's own NmeaParser, which calls the handler
+ *
+ * The ring is a SpscQueue, so the two may run on different cores. When
+ * it is full the bytes are read anyway and dropped, so a stalled parser
+ * does not back up the socket, and counted against the source; its
+ * parser then starts over at the next '$' rather than join the pieces
+ * on either side of the gap into one sentence. Every
+ * source has its own parser: a sentence split across datagrams or TCP
+ * segments of one source is not torn by another source in between.
+ *
+ * Sources are added before the tasks start.
+ */
+class NmeaInput {
+public:
+    static const std::size_t   MAX_SOURCES    = 4;
+    static const std::size_t   CHUNK_SIZE     = 256;
+    static const std::size_t   RING_SIZE      = 16;      // chunks
+    static const std::uint32_t RATE_WINDOW_MS = 2000;
+
+    typedef void (*Handler)(std::size_t source, const NmeaSentence& sentence, void* ctx);
+
+    NmeaInput();
+
+    // Index of the new source, -1 if there are MAX_SOURCES already.
+    // src may be nullptr for a source that only push()es.
+    int addSource(IPacketSource* src, const char* name);
+
+    void setHandler(Handler handler, void* ctx) { _handler = handler; _ctx = ctx; }
+
+    // Network side: read each source until it is empty, at most
+    // RING_SIZE chunks per source and call. Datagrams and segments are
+    // packed into full chunks.
+    void poll();
+    // Network side, for sources that deliver by callback. False if (part
+    // of) the bytes were dropped.
+    bool push(std::size_t source, const char* data, std::size_t len);
+
+    // Parser side: decode everything queued
+    void service(std::uint32_t nowMs);
+
+    std::size_t sourceCount() const { return _count; }
+    const char* sourceName(std::size_t source) const;
+    NmeaSourceStats stats(std::size_t source) const;
+
+private:
+    struct Chunk {
+        std::uint8_t  source;
+        bool          gap;              // bytes of this source were dropped before it
+        std::uint16_t len;
+        char          data[CHUNK_SIZE];
+    };
+
+    struct Source {
+        NmeaInput*     owner;
+        std::size_t    index;
+        IPacketSource* src;
+        const char*    name;
+        NmeaParser     parser;
+        std::atomic<std::uint32_t> bytes;
+        std::atomic<std::uint32_t> dropped;
+        bool           gap;             // network side: dropped since the last chunk
+        std::uint32_t  windowStart;     // sentences at the start of the rate window
+        float          rate;
+    };
+
+    static void onSentence(const NmeaSentence& sentence, void* ctx);
+    bool enqueue(std::size_t source, const char* data, std::size_t len);
+
+    SpscQueue<Chunk, RING_SIZE> _ring;
+    Source        _sources[MAX_SOURCES];
+    std::size_t   _count;
+    Chunk         _reading;             // network side scratch
+    Chunk         _parsing;             // parser side scratch
+    std::uint32_t _windowMs;
+    bool          _windowStarted;
+    Handler       _handler;
+    void*         _ctx;
+};
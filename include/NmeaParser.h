@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Instrument data decoded from NMEA0183 sentences. A field that is empty
+ * in the sentence (the instrument does not know) is NAN. Speeds are in
+ * knots, angles in degrees.
+ */
+
+// Recommended minimum: position, COG and SOG from the GPS
+struct NmeaRMC {
+    std::uint32_t timeMs;      // UTC time of day [ms]
+    std::uint8_t  day, month;
+    std::uint16_t year;        // 0 if no date
+    bool          valid;       // status A; V is a fix the GPS does not trust
+    double        latitude;    // [deg], north positive
+    double        longitude;   // [deg], east positive
+    float         sog;         // speed over ground [kn]
+    float         cog;         // course over ground [deg true]
+    float         variation;   // magnetic variation [deg], east positive
+};
+
+// Course and speed over ground
+struct NmeaVTG {
+    float cogTrue;             // [deg true]
+    float cogMagnetic;         // [deg magnetic]
+    float sog;                 // [kn]
+};
+
+// Heading from a compass, with its deviation and the variation
+struct NmeaHDG {
+    float heading;             // magnetic sensor heading [deg]
+    float deviation;           // [deg], east positive
+    float variation;           // [deg], east positive
+};
+
+// Wind speed and angle
+struct NmeaMWV {
+    float angle;               // off the bow, clockwise [deg, 0..360)
+    bool  relative;            // apparent (R) rather than true (T) wind
+    bool  valid;               // status A
+    float speed;               // [kn], converted from the sentence's unit
+};
+
+// Heading and speed through the water
+struct NmeaVHW {
+    float headingTrue;         // [deg true]
+    float headingMagnetic;     // [deg magnetic]
+    float speed;               // [kn]
+};
+
+// Cross track error from the navigator
+struct NmeaXTE {
+    bool  valid;               // both status fields A
+    float error;               // [nm], positive: steer right to get back on track
+};
+
+// Remote control of this autopilot, proprietary $PXAPC (see NmeaAutopilot)
+struct NmeaPilotCommand {
+    char  mode;                // O off, H heading, C course, W wind angle
+    float setpoint;            // [deg], NAN: keep the present one
+};
+
+enum class NmeaType : std::uint8_t {
+    RMC,
+    VTG,
+    HDG,
+    MWV,
+    VHW,
+    XTE,
+    PILOT
+};
+
+/** One decoded sentence. */
+struct NmeaSentence {
+    NmeaType type;
+    char     talker[3];        // e.g. "GP", "HC", "WI"; "P" if proprietary
+    union {
+        NmeaRMC rmc;
+        NmeaVTG vtg;
+        NmeaHDG hdg;
+        NmeaMWV mwv;
+        NmeaVHW vhw;
+        NmeaXTE xte;
+        NmeaPilotCommand pilot;
+    };
+};
+
+/**
+ * Streaming NMEA0183 parser: feed() takes the bytes as they come off a
+ * UART or socket, in chunks of any size, so a sentence may be split
+ * across calls. Every sentence with a valid checksum of a supported type
+ * goes to the handler, decoded into an NmeaSentence on the stack.
+ *
+ * No heap and no strings: a sentence is collected into a fixed buffer of
+ * MAX_SENTENCE bytes (the standard's 82 less $ and CR LF), its checksum
+ * computed on the way in and its fields split by offset. Anything that
+ * does not look like a sentence is dropped up to the next '$' and
+ * counted. Sentences without a checksum are rejected.
+ *
+ * Call from one task only.
+ */
+class NmeaParser {
+public:
+    static const std::size_t MAX_SENTENCE = 79;   // address, fields and *hh
+    static const int         MAX_FIELDS   = 24;
+
+    typedef void (*Handler)(const NmeaSentence& sentence, void* ctx);
+
+    NmeaParser();
+
+    void setHandler(Handler handler, void* ctx) { _handler = handler; _ctx = ctx; }
+
+    void feed(const char* data, std::size_t len);
+
+    // Forget a partly received sentence, e.g. after a reconnect
+    void reset();
+
+    // Sentences decoded and handed to the handler
+    std::uint32_t decoded() const { return _decoded; }
+    // Valid sentences of a type that is not decoded (e.g. GSV)
+    std::uint32_t ignored() const { return _ignored; }
+    std::uint32_t checksumErrors() const { return _checksumErrors; }
+    // Too long, bad characters, no checksum or missing fields
+    std::uint32_t malformed() const { return _malformed; }
+
+private:
+    enum class State : std::uint8_t {
+        IDLE,       // waiting for '$'
+        BODY,       // address and fields, up to '*'
+        CHECK_HI,
+        CHECK_LO
+    };
+
+    void byte(char c);
+    void dispatch();
+    bool decode(NmeaType type, NmeaSentence& out) const;
+
+    char          _buf[MAX_SENTENCE];
+    std::size_t   _len;
+    std::uint8_t  _start[MAX_FIELDS];   // offset of each field in _buf
+    int           _fields;
+    State         _state;
+    std::uint8_t  _sum;                 // XOR of the body
+    std::uint8_t  _check;               // as received
+
+    Handler       _handler;
+    void*         _ctx;
+    std::uint32_t _decoded;
+    std::uint32_t _ignored;
+    std::uint32_t _checksumErrors;
+    std::uint32_t _malformed;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Formats one NMEA0183 sentence into a caller's buffer, field by field,
+ * without printf: numbers are written as fixed point with a given
+ * number of decimals, the checksum is computed on the way. Usage:
+ *   NmeaWriter w(buf, sizeof(buf));
+ *   w.begin("APHDG");
+ *   w.field(heading, 1);
+ *   w.empty();
+ *   len = w.finish();      // "$APHDG,181.5,*hh\r\n", 0 if it did not fit
+ *
+ * The sentence is NUL terminated, so a buffer of MAX_LENGTH + 1 takes
+ * any. One that does not fit the buffer or the standard's 82
+ * characters comes out as length 0.
+ */
+class NmeaWriter {
+public:
+    static const std::size_t MAX_LENGTH = 82;    // $ to CR LF
+
+    NmeaWriter(char* buf, std::size_t size);
+
+    // Start a sentence at the start of the buffer: talker and sentence,
+    // e.g. "APHDG", or P and the proprietary address
+    void begin(const char* address);
+
+    // A number with decimals digits after the point, rounded; an empty
+    // field if NAN or too large
+    void field(float value, int decimals);
+    // One letter, e.g. a unit, empty for '\0'
+    void field(char letter);
+    void field(const char* text);
+    void empty();
+
+    // Checksum, CR LF and NUL: the sentence's length, 0 if it did not fit
+    std::size_t finish();
+
+private:
+    void put(char c);
+
+    char*         _buf;
+    std::size_t   _size;
+    std::size_t   _len;
+    std::uint8_t  _sum;
+    bool          _overflow;
+};
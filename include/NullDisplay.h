@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "IDisplay.h"
+
+/**
+ * IDisplay that draws nothing, so UIView::render() can be timed without
+ * the driver. It counts what it was given so the work is not optimized
+ * away and tests can check something was drawn, and the bytes a
+ * monochrome panel of the given size would have been sent.
+ */
+class NullDisplay : public IDisplay {
+public:
+    explicit NullDisplay(int width = 192, int height = 96)
+        : strings(0)
+        , chars(0)
+        , frames(0)
+        , updates(0)
+        , bytes(0)
+        , _width(width)
+        , _height(height)
+    {}
+
+    bool begin() override { return true; }
+
+    void clearBuffer() override {}
+
+    void drawStr(int, int, const char* text) override {
+        strings++;
+        for(const char* p = text; *p; p++) {
+            chars++;
+        }
+    }
+
+    void sendBuffer() override {
+        frames++;
+        bytes += (std::uint32_t)(_width * _height / 8);
+    }
+
+    void clearTiles(int, int, int, int) override {}
+
+    // 8 bytes a tile
+    void sendTiles(int, int, int tw, int th) override {
+        updates++;
+        bytes += (std::uint32_t)(tw * th * 8);
+    }
+
+    std::uint32_t strings;
+    std::uint32_t chars;
+    std::uint32_t frames;       // whole buffer
+    std::uint32_t updates;      // tile areas
+    std::uint32_t bytes;        // display data sent
+
+private:
+    int _width;
+    int _height;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ARDUINO
+#include "hal/cpu_hal.h"
+#else
+#include <chrono>
+#endif
+
+/**
+ * Timing statistics of one code site: call count, min/mean/max and a
+ * log2 histogram, all in profiler ticks (CPU cycles on the target,
+ * nanoseconds on the host, see Profiler::ticksPerMicrosecond()).
+ *
+ * A site registers itself with Profiler when constructed, normally as a
+ * function-local static through PROFILE_SCOPE. Nothing is allocated.
+ * Only one task may record into a site; a report from another task may
+ * see the counters a sample apart. Profiler::resetAll() does not touch
+ * the counters, it starts a new generation: a site from an older one
+ * reads as empty, and the recording task clears it at its next record.
+ */
+class ProfileSite {
+public:
+    // Bucket k counts durations in [2^k, 2^(k+1)) ticks, bucket 0 also 0
+    static const int BUCKETS = 32;
+
+    explicit ProfileSite(const char* name);
+
+    void record(std::uint32_t ticks) {
+        std::uint32_t generation = s_generation.load(std::memory_order_acquire);
+        if(generation != _generation) {
+            reset();
+            _generation = generation;
+        }
+        _count++;
+        _total += ticks;
+        if(ticks < _min) _min = ticks;
+        if(ticks > _max) _max = ticks;
+        _histogram[bucketOf(ticks)]++;
+    }
+
+    // Only from the task that records, see Profiler::resetAll() otherwise
+    void reset();
+
+    const char*   name() const { return _name; }
+    std::uint32_t count() const { return stale() ? 0 : _count; }
+    std::uint32_t min() const { return count() ? _min : 0; }
+    std::uint32_t max() const { return stale() ? 0 : _max; }
+    std::uint64_t total() const { return stale() ? 0 : _total; }
+    float         mean() const { return count() ? float(_total) / _count : 0.0f; }
+    std::uint32_t bucket(int k) const { return stale() ? 0 : _histogram[k]; }
+
+    static int bucketOf(std::uint32_t ticks) {
+        return ticks ? 31 - __builtin_clz(ticks) : 0;
+    }
+
+private:
+    friend class Profiler;
+
+    // Recorded before the last Profiler::resetAll()
+    bool stale() const {
+        return _generation != s_generation.load(std::memory_order_acquire);
+    }
+
+    static std::atomic<std::uint32_t> s_generation;
+
+    const char*   _name;
+    std::uint32_t _generation;
+    std::uint32_t _count;
+    std::uint32_t _min;
+    std::uint32_t _max;
+    std::uint64_t _total;
+    std::uint32_t _histogram[BUCKETS];
+};
+
+typedef void (*ProfileLineFn)(const char* line, void* context);
+
+/**
+ * Registry of all ProfileSites and the tick source.
+ *
+ * The target counts CPU cycles (CCOUNT). Each core has its own counter,
+ * so a timed scope must not migrate between cores; tasks pinned with
+ * TaskLayout never do.
+ */
+class Profiler {
+public:
+    static const std::size_t MAX_SITES = 32;
+
+    static inline std::uint32_t ticks() {
+#ifdef ARDUINO
+        return cpu_hal_get_cycle_count();
+#else
+        using namespace std::chrono;
+        return (std::uint32_t)duration_cast<nanoseconds>(
+            steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // CPU MHz on the target, 1000 on the host
+    static float ticksPerMicrosecond();
+
+    static std::size_t siteCount();
+    static ProfileSite* site(std::size_t i);
+    // nullptr if no site of that name was registered
+    static ProfileSite* find(const char* name);
+    // Sites constructed after the registry was full (not reported)
+    static std::size_t droppedSites();
+
+    // Safe from any task: each site is cleared by the task recording into
+    // it, at its next record, and reads as empty until then
+    static void resetAll();
+
+    /**
+     * Format one line per site (plus a header) and hand each to fn, e.g.
+     * Serial.println on the target or puts on the host:
+     *   imu.update   1200 x  min 11.25  mean 12.03  max 40.50 us | 2^11:1150 2^12:48 2^13:2
+     * The histogram lists the non-empty log2 buckets in ticks.
+     */
+    static void report(ProfileLineFn fn, void* context);
+
+    // Format one site into buf, return false if it did not fit
+    static bool formatSite(const ProfileSite& s, char* buf, std::size_t len);
+
+private:
+    friend class ProfileSite;
+    static void add(ProfileSite* s);
+};
+
+/** Records the lifetime of its scope into a ProfileSite. */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ProfileSite& site)
+        : _site(site)
+        , _start(Profiler::ticks())
+    {}
+
+    ~ScopedTimer() {
+        _site.record(Profiler::ticks() - _start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    ProfileSite&  _site;
+    std::uint32_t _start;
+};
+
+/**
+ * Time the rest of the enclosing scope:
+ *   { PROFILE_SCOPE("steer.update"); autoSteer.update(dt); }
+ * Compiles to nothing unless ENABLE_PROFILING is defined.
+ */
+#ifdef ENABLE_PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+    static ProfileSite PROFILE_CONCAT(_profileSite, __LINE__)(name); \
+    ScopedTimer PROFILE_CONCAT(_profileTimer, __LINE__)(PROFILE_CONCAT(_profileSite, __LINE__))
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "CicDecimator.h"
+#include "AdcLinearizer.h"
+#include "Mailbox.h"
+
+/** One decimated rudder pot reading. */
+struct RudderAngleSample {
+    float         counts;    // decimated ADC counts, fractional
+    float         angle;     // corrected angle [deg]
+    std::uint32_t sequence;  // number of decimated outputs so far
+};
+
+/**
+ * Rudder angle from an oversampled pot: the ADC stream (e.g. from
+ * AdcDmaSampler) goes through a CIC decimator and the AdcLinearizer, and
+ * the latest result is published through a Mailbox.
+ *
+ * addSamples() runs in the acquisition task, getAngle() in the servo loop;
+ * the reader never waits for a conversion.
+ */
+class RudderAngleSensor {
+public:
+    static const int CIC_ORDER = 3;
+    static const int CIC_RATIO = 32;
+
+    RudderAngleSensor();
+
+    // Correction table from ADC counts to degrees (default -25..25 linear)
+    AdcLinearizer& linearizer() { return _linearizer; }
+
+    // Feed raw 12 bit ADC samples. Only one task may call this.
+    void addSamples(const std::uint16_t* raw, std::size_t count);
+
+    // Latest corrected angle [deg], O(1)
+    float getAngle() const;
+
+    // Latest full sample, false if no output yet
+    bool getSample(RudderAngleSample& out) const;
+
+    void reset();
+
+private:
+    CicDecimator<CIC_ORDER, CIC_RATIO> _cic;
+    AdcLinearizer _linearizer;
+    int           _outputs;    // counts the start-up outputs
+    std::uint32_t _sequence;
+    Mailbox<RudderAngleSample> _latest;
+};
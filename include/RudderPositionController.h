@@ -1,45 +1,150 @@
 #pragma once
 
 #include <Arduino.h>
+#include "RudderServo.h"
+#include "Mailbox.h"
+#include "LoopJitter.h"
+#include "RudderAngleSensor.h"
+#include "AdcDmaSampler.h"
+#include "MotorCurrentSensor.h"
+#include "MotorProtection.h"
+
+/** Setpoint and settings handed to the servo loop. */
+struct RudderCommand {
+    float targetAngle;   // [deg]
+    float seaState;      // yaw rate std dev [deg/s]
+    float kp, ki, kd;
+    bool  economy;
+    bool  shaped;            // jerk-limited moves
+    DriveProfile profile;
+};
+
+/** Latest state published by the servo loop. */
+struct RudderStatus {
+    float         target;    // target angle of the latest command [deg]
+    float         angle;     // measured rudder angle [deg]
+    float         command;   // last motor command [-1..1], after protection
+    float         current;   // motor current [A]
+    float         thermal;   // I2t load, 1.0 = rated
+    MotorFault    fault;
+    std::uint32_t trips;
+    bool          economy;   // economy mode applied
+    ServoActivity activity;
+};
 
 /**
  * Class that runs a local PID to keep the rudder at a desired angle,
  * using an analog pot for feedback, and two PWM pins for forward/reverse.
+ * The control law itself lives in RudderServo.
+ *
+ * After startTask() the loop runs from its own hardware timer in a task
+ * pinned to one core. The setters below only publish a RudderCommand
+ * through a lock-free mailbox, so the heading loop never blocks the servo
+ * and vice versa. Call the setters from one task only.
  */
 class RudderPositionController {
 public:
-    RudderPositionController(int pinMotorA, int pinMotorB, int analogPin);
+    static const uint32_t DEFAULT_RATE_HZ = 1000;
+
+    // currentPin: H-bridge current sense, -1 if not fitted (no protection)
+    RudderPositionController(int pinMotorA, int pinMotorB, int analogPin, int currentPin=-1);
 
     // Setup PWM for the motor pins, etc.
     bool begin();
 
-    // Update closed-loop control. Call ~50-100Hz.
+    /**
+     * Switch the pot from single analogRead() calls to continuous DMA
+     * sampling, oversampled and decimated (see RudderAngleSensor). The
+     * loop then reads the latest value without waiting on the ADC.
+     * Call after begin(). Return false (and keep analogRead) on failure.
+     */
+    bool beginContinuousSampling();
+
+    /**
+     * Run the servo loop at rateHz from hardware timer timerNum, in a
+     * task pinned to core. Return false if the timer or task could not
+     * be created.
+     */
+    bool startTask(uint32_t rateHz=DEFAULT_RATE_HZ, int core=0, uint8_t timerNum=1);
+
+    // One control step with dt from micros(). Only for use without
+    // startTask(), e.g. in tests.
     void update();
 
     // External code sets target angle (in degrees).
     void setTargetAngle(float angleDeg);
 
+    // Set PID gains (e.g. from a tuned gain table)
+    void setGains(float kp, float ki, float kd);
+
+    // Energy saving mode, see RudderServo / EconomyConfig
+    void setEconomyMode(bool enabled);
+    // Sea state (yaw rate std dev, deg/s) from SeaStateEstimator
+    void setSeaState(float seaState);
+
+    // S-curve moves within the limits of the fitted drive
+    void setDriveProfile(const DriveProfile& profile);
+    void setTrajectoryEnabled(bool enabled);
+
+    // Motor on-time, starts and reversals since boot
+    ServoActivity getActivity() const;
+
     // Read the actual angle from pot (used internally).
     float getCurrentAngle() const;
 
+    // Servo loop timing, refreshed once per second by the task
+    LoopJitterStats getJitter() const;
+
+    // Latest angle, current and protection state from the servo loop
+    RudderStatus getStatus() const;
+
+    // Drive limits; call before startTask()
+    void setProtectionConfig(const MotorProtectionConfig& cfg);
+
 private:
+    static void IRAM_ATTR onTimer();
+    static void taskEntry(void* arg);
+    void taskLoop();
+
+    // Apply the latest command, read the pot, drive the motor
+    void step(float dt);
+
     // Reads analog pot, converts to [-25..25] deg or whatever range.
     float readRudderSensor();
 
-    // Drive H-bridge with sign for direction.
-    void driveMotor(float output);
+    // Motor current in A, 0 without a current sense
+    float readMotorCurrent();
+
+    static constexpr float POT_MIN_ANGLE = -25.0f;
+    static constexpr float POT_MAX_ANGLE = 25.0f;
+
+    // Drive H-bridge, command in [-1..1] with sign for direction.
+    void driveMotor(float command);
 
 private:
     int _pinMotorA;
     int _pinMotorB;
     int _analogPin;
+    int _currentPin;
+
+    RudderServo     _servo;
+    MotorProtection _protection;
+
+    RudderAngleSensor  _sensor;
+    MotorCurrentSensor _currentSensor;
+    AdcDmaSampler      _sampler;
+    bool               _continuous;
 
-    float _currentAngle;
-    float _targetAngle;
+    // writer side copy, owned by the caller of the setters
+    RudderCommand _command;
+    Mailbox<RudderCommand>   _commandBox;
+    Mailbox<RudderStatus>    _statusBox;
+    Mailbox<LoopJitterStats> _jitterBox;
 
-    // PID terms
-    float _kp, _ki, _kd;
-    float _integral, _lastError;
+    uint32_t   _rateHz;
+    LoopJitter _jitter;
+    uint32_t   _lastUpdate;
 
-    unsigned long _lastUpdate;
+    static hw_timer_t*  s_timer;
+    static TaskHandle_t s_task;
 };
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include "JerkLimitedTrajectory.h"
+
+/**
+ * Settings of the energy-saving mode. The deadband follows the sea state
+ * (yaw rate std dev in deg/s, see SeaStateEstimator) and applies both to
+ * target changes and to the position error; the drive command is rate
+ * limited and may not reverse without a pause.
+ */
+struct EconomyConfig {
+    float deadbandMin;         // position deadband in flat water [deg]
+    float deadbandPerSeaState; // extra deadband per deg/s of sea state [deg]
+    float deadbandMax;         // [deg]
+    float holdRatio;           // once moving, stop at deadband*holdRatio
+    float commandSlew;         // max command ramp [full scale per second]
+    float reverseDelay;        // rest time before changing direction [s]
+
+    EconomyConfig()
+    : deadbandMin(1.0f)
+    , deadbandPerSeaState(2.0f)
+    , deadbandMax(3.0f)
+    , holdRatio(0.5f)
+    , commandSlew(10.0f)
+    , reverseDelay(0.3f)
+    {}
+};
+
+/** Drive usage counters, accumulated by RudderServo::update(). */
+struct ServoActivity {
+    float         elapsed;      // [s]
+    float         motorOnTime;  // [s]
+    std::uint32_t motorStarts;  // stopped -> running, or direct reversal
+    std::uint32_t reversals;    // direction changes
+
+    float reversalsPerMinute() const { return elapsed > 0.f ? reversals * 60.f / elapsed : 0.f; }
+    float startsPerMinute() const { return elapsed > 0.f ? motorStarts * 60.f / elapsed : 0.f; }
+    // fraction of time the motor is powered
+    float dutyCycle() const { return elapsed > 0.f ? motorOnTime / elapsed : 0.f; }
+};
+
+/**
+ * Platform-agnostic rudder position loop (PID), optionally following a
+ * jerk-limited trajectory to each new target.
+ * RudderPositionController wraps it with the ADC and H-bridge, the
+ * simulator and host tools use it directly.
+ */
+class RudderServo {
+public:
+    RudderServo();
+    ~RudderServo() = default;
+
+    void setGains(float kp, float ki, float kd);
+
+    // Target angle in degrees
+    void setTargetAngle(float angleDeg);
+    float getTargetAngle() const;
+
+    // Economy mode trades some accuracy for far fewer motor starts
+    void setEconomyMode(bool enabled);
+    void setEconomyConfig(const EconomyConfig& cfg);
+    bool isEconomyMode() const;
+
+    // Shape target changes into jerk-limited moves within the profile,
+    // with velocity feed-forward, instead of stepping the PID target
+    void setTrajectoryEnabled(bool enabled);
+    bool isTrajectoryEnabled() const;
+    void setDriveProfile(const DriveProfile& profile);
+    // Where the trajectory is now (the target if disabled)
+    float getReference() const;
+
+    // Current sea state (yaw rate std dev, deg/s), used by economy mode
+    void setSeaState(float seaState);
+    // Deadband currently applied in economy mode [deg]
+    float getDeadband() const;
+
+    /**
+     * Run one control step with the measured rudder angle (degrees).
+     * Return the motor command in [-1..1], sign is direction, 0 = stop.
+     */
+    float update(float measuredAngle, float dt);
+
+    // Last command returned by update()
+    float getOutput() const;
+
+    // Clear integrator and derivative history
+    void reset();
+
+    // Clear only the integrator, e.g. while the drive is blocked so it
+    // does not wind up against a stop
+    void clearIntegral();
+
+    const ServoActivity& getActivity() const;
+    void resetActivity();
+
+private:
+    float pid(float target, float measuredAngle, float dt, float feedForward);
+    float economyShape(float output, float error, float dt);
+    void  countActivity(float output, float dt);
+
+    float _targetAngle;
+    float _heldTarget;     // target actually followed in economy mode
+    float _reference;      // set point the PID sees
+
+    JerkLimitedTrajectory _trajectory;
+    bool  _shaped;
+    bool  _trajectoryPrimed;
+
+    // PID terms
+    float _kp, _ki, _kd;
+    float _integral, _lastError;
+
+    float _output;
+
+    bool          _economy;
+    EconomyConfig _eco;
+    float         _seaState;
+    bool          _moving;
+    float         _stoppedTime;
+    int           _lastDirection;   // sign of the last non-zero command
+
+    ServoActivity _activity;
+};
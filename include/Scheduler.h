@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ITimeProvider.h"
+
+typedef void (*TaskFunction)(void* context);
+
+/**
+ * One entry of the static task table. All times in microseconds.
+ * Lower priority numbers break ties between equal periods; otherwise
+ * the order is rate-monotonic (shorter period runs first).
+ */
+struct SchedTask {
+    const char*   name;
+    TaskFunction  run;
+    void*         context;
+    std::uint32_t period;
+    std::uint32_t deadline;   // after release, 0 = period
+    std::uint8_t  priority;
+    std::uint32_t offset;     // first release after begin()
+};
+
+/** Execution statistics of one task, microseconds. */
+struct TaskStats {
+    std::uint32_t runs;
+    std::uint32_t overruns;    // finished after its deadline
+    std::uint32_t skipped;     // releases dropped because it fell a period behind
+    std::uint32_t minExec;
+    std::uint32_t maxExec;
+    std::uint64_t totalExec;
+    std::uint32_t maxLateness; // start after release
+
+    float meanExec() const { return runs ? float(totalExec) / runs : 0.0f; }
+};
+
+/**
+ * Cooperative, non-preemptive rate-monotonic scheduler over a static
+ * task table. runOnce() starts the most urgent released task and runs it
+ * to completion; nothing is allocated and the table is never copied.
+ *
+ * Time comes from an ITimeProvider, so on the host a simulated clock
+ * makes every run deterministic.
+ *
+ * Typical usage:
+ *   static SchedTask tasks[] = {
+ *       { "imu",     imuTask,     nullptr, 10000,  0, 0, 0 },
+ *       { "heading", headingTask, nullptr, 100000, 0, 0, 0 },
+ *   };
+ *   static TaskStats stats[2];
+ *   Scheduler sched(time, tasks, stats, 2);
+ *   sched.begin();
+ *   for(;;) { if(!sched.runOnce()) sleep(sched.idleTime()); }
+ */
+class Scheduler {
+public:
+    static const std::size_t MAX_TASKS = 16;
+
+    // tasks and stats are arrays of count entries owned by the caller
+    Scheduler(const ITimeProvider& time, const SchedTask* tasks, TaskStats* stats,
+              std::size_t count);
+
+    // Validate the table and release every task at now + offset.
+    // Return false on an empty/oversized table or a zero period.
+    bool begin();
+
+    // Run the most urgent released task. Return false if none was due.
+    bool runOnce();
+
+    // Time until the next release, 0 if something is due now
+    std::uint64_t idleTime() const;
+
+    std::size_t size() const;
+    const SchedTask& task(std::size_t i) const;
+    const TaskStats& stats(std::size_t i) const;
+    void resetStats();
+
+    // Sum of worst-case execution time / period over all tasks
+    float utilization() const;
+    // Liu & Layland bound n(2^(1/n)-1) on the measured worst cases;
+    // true means the set is guaranteed to meet its deadlines if preemptive.
+    // Non-preemptive, also the longest task must fit into the shortest deadline.
+    bool isSchedulable() const;
+
+private:
+    std::uint32_t deadlineOf(std::size_t i) const;
+
+    const ITimeProvider& _time;
+    const SchedTask*     _tasks;
+    TaskStats*           _stats;
+    std::size_t          _count;
+    // dispatch order (rate-monotonic), index into _tasks
+    std::uint8_t         _order[MAX_TASKS];
+    std::uint64_t        _release[MAX_TASKS];
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * Estimates the sea state as the standard deviation of the yaw rate
+ * (deg/s) using exponentially weighted mean and variance. The slow mean
+ * removes deliberate turns, what is left is mostly wave induced.
+ *
+ * This is the same measure GainTable and the economy mode of
+ * RudderServo are keyed by.
+ */
+class SeaStateEstimator {
+public:
+    // timeConstant: averaging window in seconds
+    explicit SeaStateEstimator(float timeConstant=60.0f);
+
+    // Feed one gyro yaw-rate sample (deg/s) taken dt seconds after the last
+    void addSample(float yawRate, float dt);
+
+    // Yaw rate standard deviation in deg/s
+    float getSeaState() const;
+
+    void reset();
+
+private:
+    float _tau;
+    float _mean;
+    float _variance;
+    bool  _primed;
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Mailbox.h"
+
+/** How a source is trusted, see SourceArbiter::addSource(). */
+struct ArbiterSourceConfig {
+    const char*   name;
+    std::uint8_t  priority;     // lower is preferred; equal priorities are fused
+    std::uint32_t timeoutMs;    // stale after this long without a sample
+    float         minRate;      // [Hz] slower is unhealthy, 0: do not check
+    float         minQuality;   // a sample's quality below this is unhealthy
+    std::uint32_t stuckMs;      // the same value this long is unhealthy, 0: do not check
+};
+
+/** State of one source as of the last SourceArbiter::update(). */
+struct ArbiterSourceHealth {
+    bool          healthy;
+    bool          stuck;        // publishing, but the value does not move
+    std::uint32_t ageMs;        // since its last sample, UINT32_MAX if none
+    float         rate;         // [Hz] measured, 0 until known
+    float         quality;      // of its last sample
+    float         value;
+};
+
+/** The arbiter's output, also published for other tasks. */
+struct ArbitratedAngle {
+    float         value;        // [deg, 0..360)
+    std::int8_t   source;       // the best source in use, -1 if none is healthy
+    std::uint8_t  fused;        // sources averaged into value
+    float         quality;      // of the source, or the mean of the fused ones
+    std::uint32_t switches;     // changes of the priority level in use
+};
+
+/**
+ * Picks one angle (heading, course, wind angle) out of several sources
+ * of it, e.g. the IMU, a fluxgate compass on NMEA and the GPS COG.
+ *
+ *   producers  publish() a sample with its quality (0..1), each source
+ *              from its own task, through a Mailbox: wait-free
+ *   consumer   update() in the control loop checks every source's age,
+ *              rate and quality, picks the value and publishes it
+ *
+ * A sensor that hangs often goes on sending its last reading: a source
+ * whose value has not changed at all for stuckMs is unhealthy too.
+ *
+ * Of the healthy sources those of the best priority are used; several
+ * of the same priority are fused, a quality weighted circular mean.
+ * Failover to a worse priority is immediate once the sources in use are
+ * unhealthy, so its latency is at most the source's timeoutMs plus one
+ * update() period. A better priority only takes over again after it has
+ * been healthy for recoveryMs, so a flaky source does not flap.
+ *
+ * Sources rarely agree exactly (deviation, leeway, COG vs heading), so
+ * at a switch the output moves over to the new sources within blendMs
+ * instead of stepping; the heading loop's derivative would kick the
+ * rudder otherwise.
+ *
+ * Sources are added before the tasks start.
+ */
+class SourceArbiter {
+public:
+    static const std::size_t MAX_SOURCES = 4;
+
+    SourceArbiter();
+
+    // Index of the new source, -1 if there are MAX_SOURCES already
+    int addSource(const ArbiterSourceConfig& config);
+
+    // Hysteresis and blending of switches [ms]. Default 5000 and 2000.
+    void setRecoveryMs(std::uint32_t ms) { _recoveryMs = ms; }
+    void setBlendMs(std::uint32_t ms) { _blendMs = ms; }
+
+    // Producer side: one task per source
+    void publish(std::size_t source, float value, float quality, std::uint32_t nowMs);
+
+    // Consumer side, one task: arbitrate. False if no source is healthy
+    // (out then holds the last value, source -1).
+    bool update(std::uint32_t nowMs, ArbitratedAngle& out);
+
+    // Any task: the result of the last update()
+    bool latest(ArbitratedAngle& out) const { return _result.read(out); }
+
+    std::size_t sourceCount() const { return _count; }
+    const char* sourceName(std::size_t source) const;
+    // Consumer side
+    ArbiterSourceHealth health(std::size_t source) const;
+
+private:
+    struct Sample {
+        float         value;
+        float         quality;
+        std::uint32_t timeMs;
+    };
+
+    struct Source {
+        ArbiterSourceConfig config;
+        Mailbox<Sample> box;
+        // consumer side
+        Sample        last;
+        bool          seen;
+        std::uint32_t version;          // of box at the last update()
+        std::uint32_t ageMs;
+        bool          windowStarted;
+        std::uint32_t windowStart;      // rate window
+        std::uint32_t windowCount;
+        float         rate;
+        std::uint32_t changedMs;        // time of the sample the value last changed at
+        bool          stuck;
+        bool          healthy;
+        std::uint32_t healthySince;
+    };
+
+    bool isHealthy(Source& s, std::uint32_t nowMs);
+
+    Source        _sources[MAX_SOURCES];
+    std::size_t   _count;
+    std::uint32_t _recoveryMs;
+    std::uint32_t _blendMs;
+
+    int           _level;               // priority in use, -1 none
+    float         _output;
+    float         _offset;              // output - sources at the last switch
+    std::uint32_t _switchMs;
+    std::uint32_t _switches;
+    Mailbox<ArbitratedAngle> _result;
+};
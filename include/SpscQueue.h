@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lock-free FIFO between exactly one producer and one consumer, e.g. an
+ * ISR pushing sensor samples and the fusion task popping them, or two
+ * tasks on different cores.
+ *
+ * Unlike RingBuffer a full queue rejects the new item instead of
+ * overwriting the oldest one, because only the consumer may move the
+ * tail. Rejected pushes are counted in dropped().
+ *
+ * N must be a power of two.
+ *
+ * Typical usage:
+ *   SpscQueue<IMUData, 16> queue;
+ *   queue.push(sample);          // producer
+ *   IMUData s;
+ *   while(queue.pop(s)) { ... }  // consumer
+ */
+template<typename T, std::size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+public:
+    SpscQueue()
+        : _head(0)
+        , _tail(0)
+        , _dropped(0)
+    {}
+
+    ~SpscQueue() = default;
+
+    constexpr std::size_t capacity() const { return N; }
+
+    /**
+     * Append an item. Producer only.
+     * Return false (and count a drop) if the queue is full.
+     */
+    bool push(const T& item) {
+        std::uint32_t head = _head.load(std::memory_order_relaxed);
+        if(head - _tail.load(std::memory_order_acquire) >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _buffer[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Take the oldest item. Consumer only.
+     * Return false if the queue is empty.
+     */
+    bool pop(T& out) {
+        std::uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = _buffer[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Items waiting. Exact for the consumer, a snapshot for anyone else.
+     */
+    std::size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const { return size() == 0; }
+
+    // Pushes rejected because the queue was full
+    std::uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    T _buffer[N];
+    // Free running counters, wrap-around is harmless with N a power of two
+    std::atomic<std::uint32_t> _head;   // written by the producer
+    std::atomic<std::uint32_t> _tail;   // written by the consumer
+    std::atomic<std::uint32_t> _dropped;
+};
@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Scheduler.h"
+#include "Mailbox.h"
+#include "ITimeProvider.h"
+
+/** Which side of the split a task table belongs to. */
+enum class TaskGroup : std::uint8_t {
+    CONTROL,   // sensing, fusion, heading and rudder control
+    UI         // input, display, logging, network
+};
+
+/**
+ * Where the two groups run. On the ESP32-S3 the WiFi/BT stack lives on
+ * core 0, so by default the UI group (which will also own the network)
+ * shares core 0 and control gets core 1 to itself, together with the
+ * 1 kHz rudder servo task.
+ *
+ * dualCore = false puts both tables into one scheduler on controlCore,
+ * i.e. the old single loop(), for comparison.
+ */
+struct TaskLayoutConfig {
+    bool          dualCore;
+    int           controlCore;
+    int           uiCore;
+    std::uint8_t  controlPriority;   // FreeRTOS priorities
+    std::uint8_t  uiPriority;
+    std::uint32_t controlStack;      // bytes
+    std::uint32_t uiStack;
+
+    TaskLayoutConfig()
+    : dualCore(true)
+    , controlCore(1)
+    , uiCore(0)
+    , controlPriority(10)
+    , uiPriority(1)
+    , controlStack(8192)
+    , uiStack(8192)
+    {}
+
+    static TaskLayoutConfig singleCore() {
+        TaskLayoutConfig cfg;
+        cfg.dualCore = false;
+        return cfg;
+    }
+};
+
+/**
+ * Copy of one scheduler's statistics, published by its worker so other
+ * tasks (e.g. logging on the UI core) never touch the live counters.
+ */
+struct SchedulerSnapshot {
+    std::size_t count;
+    const char* names[Scheduler::MAX_TASKS];
+    TaskStats   stats[Scheduler::MAX_TASKS];
+    float       utilization;
+    bool        schedulable;
+};
+
+/**
+ * Runs a control and a UI task table, each under its own Scheduler in
+ * its own worker: a FreeRTOS task pinned to a core on the target, a
+ * std::thread on the host.
+ *
+ * The two groups must not share state directly; hand data across with
+ * Mailbox (latest value) or SpscQueue (events), as AutoSteeringController
+ * and RudderPositionController do.
+ *
+ * Typical usage:
+ *   static TaskLayout layout(time, TaskLayoutConfig(),
+ *                            CONTROL_TASKS, 3, UI_TASKS, 3);
+ *   layout.start();
+ */
+class TaskLayout {
+public:
+    // Statistics are republished this often [us]
+    static const std::uint32_t SNAPSHOT_PERIOD_US = 1000000;
+
+    // The task tables are owned by the caller and must outlive the layout
+    TaskLayout(const ITimeProvider& time, const TaskLayoutConfig& cfg,
+               const SchedTask* controlTasks, std::size_t controlCount,
+               const SchedTask* uiTasks, std::size_t uiCount);
+    ~TaskLayout();
+
+    // Validate the tables and start the workers.
+    // Return false on an invalid table or if a worker could not start.
+    bool start();
+
+    // Ask the workers to finish and wait for them (host tests mostly)
+    void stop();
+
+    bool isRunning() const;
+    const TaskLayoutConfig& config() const;
+
+    // Latest statistics of a group's scheduler (all tasks are in CONTROL
+    // when single core). Return false if none were published yet.
+    bool readStats(TaskGroup group, SchedulerSnapshot& out) const;
+
+    // Ask both workers to clear their statistics
+    void resetStats();
+
+private:
+    struct Worker {
+        TaskLayout*                layout;
+        Scheduler*                 scheduler;
+        Mailbox<SchedulerSnapshot> snapshot;
+        std::atomic<bool>          resetRequest;
+        std::atomic<bool>          done;
+        void*                      handle;     // TaskHandle_t or std::thread*
+    };
+
+    bool startWorker(Worker& w, const char* name, int core, std::uint8_t priority,
+                     std::uint32_t stack);
+    void joinWorker(Worker& w);
+    static void entry(void* arg);
+    static void run(Worker& w);
+    static void publish(Worker& w);
+    static void sleepMicros(std::uint64_t us);
+
+    const ITimeProvider& _time;
+    TaskLayoutConfig     _cfg;
+    // Both tables back to back when single core
+    SchedTask            _merged[Scheduler::MAX_TASKS];
+    std::size_t          _mergedCount;
+    TaskStats            _controlStats[Scheduler::MAX_TASKS];
+    TaskStats            _uiStats[Scheduler::MAX_TASKS];
+    Scheduler            _controlScheduler;
+    Scheduler            _uiScheduler;
+    Worker               _control;
+    Worker               _ui;
+    std::atomic<bool>    _running;
+};
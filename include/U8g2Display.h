@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include "IDisplay.h"
+#include "DisplayFrames.h"
+#include "Mailbox.h"
+
+struct u8x8_struct;
+
+// What the sender task measured, for the console and the log
+struct DisplayStats {
+    std::uint32_t frames;       // updates sent
+    std::uint32_t bytes;
+    std::uint32_t lastFrameUs;  // commit to the last byte on the wire
+    std::uint32_t maxFrameUs;
+    std::uint64_t frameUs;      // summed, for the mean
+    std::uint64_t busyUs;       // the bus busy with our frames
+    std::uint32_t stalls;       // renders that waited for a free frame
+    std::uint32_t truncated;
+};
+
+/**
+ * IDisplay on a u8g2 driven ST75256 JLX19296 panel (192x96, 4-wire
+ * hardware SPI).
+ *
+ * u8g2 draws into its full frame buffer as before, but its byte
+ * callback does not send: sendBuffer() and sendTiles() record what the
+ * driver would send into a DisplayFrames double buffer and return. A
+ * sender task on its own takes each frame and queues it to the SPI
+ * master as DMA transactions, DC switched between them in the
+ * pre-transfer callback, and sleeps until they are done. Drawing the
+ * next frame overlaps sending this one; the renderer only waits when
+ * it gets a whole frame ahead.
+ *
+ * The init sequence in begin() is sent at once instead, polling, for
+ * its delays. One instance; the u8g2 callbacks find it through a static.
+ */
+class U8g2Display : public IDisplay {
+public:
+    static const int SPI_CLOCK_HZ = 8000000;
+
+    U8g2Display(int sck, int mosi, int cs, int dc, int reset);
+    ~U8g2Display() override;
+
+    // Panel and bus; the sender task on core. On failure nothing is
+    // left behind: no task, the bus free, begin() may be tried again.
+    bool begin() override;
+    void setCore(int core) { _core = core; }
+
+    void clearBuffer() override;
+    void drawStr(int x, int y, const char* text) override;
+    void sendBuffer() override;
+    void clearTiles(int tx, int ty, int tw, int th) override;
+    void sendTiles(int tx, int ty, int tw, int th) override;
+
+    // Latest sender statistics; false before the first frame
+    bool readStats(DisplayStats& out) const { return _statsBox.read(out); }
+
+private:
+    // u8g2's byte and gpio/delay callbacks
+    static std::uint8_t onByte(u8x8_struct* u8x8, std::uint8_t msg, std::uint8_t arg, void* ptr);
+    static std::uint8_t onGpio(u8x8_struct* u8x8, std::uint8_t msg, std::uint8_t arg, void* ptr);
+
+    static void taskEntry(void* arg);
+    void taskLoop();
+    void transmit(const DisplayFrame& f);
+    void beginFrame();
+    void commitFrame();
+    // Undo begin() as far as it got
+    void release();
+
+    int _sck, _mosi, _cs, _dc, _reset;
+    int _core;
+
+    // U8G2*, spi_device_handle_t and TaskHandle_t, kept opaque so the
+    // header does not pull in U8g2lib.h and the IDF
+    void* _u8g2;
+    void* _spi;
+    void* _task;
+
+    bool _direct;               // send at once (begin)
+    bool _dcLevel;
+    DisplayFrames _frames;
+
+    DisplayStats _stats;        // sender task only
+    Mailbox<DisplayStats> _statsBox;
+
+    static U8g2Display* s_instance;
+};
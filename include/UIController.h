@@ -1,36 +1,44 @@
 #pragma once
-#include <string>
 #include "UIModel.h"
-#include "IInputDevice.h"
+#include "ButtonEvents.h"
 
 // We assume we have an autopilot "AutoSteeringController" that is also
 // mostly platform-agnostic
 #include "AutoSteeringController.h"
 
 /**
- * The UIController uses the IInputDevice to check button states,
+ * The UIController takes the button events off ButtonEvents,
  * then modifies the UIModel and calls the autopilot logic.
+ *
+ * AUTO and MODE act on the press; the setpoint buttons step once on
+ * the press and again on every auto repeat while held.
  */
 class UIController {
 public:
+    // The true wind angle sailed now [deg]; false if there is none
+    typedef bool (*WindAngleSource)(float& angle, void* ctx);
+
     UIController(UIModel& model,
                  AutoSteeringController& autoSteer,
-                 const IInputDevice& input);
+                 ButtonEvents& buttons);
     ~UIController() = default;
 
-    // Called periodically
+    // Wind mode engages on this angle; without it the mode is skipped
+    void setWindAngleSource(WindAngleSource source, void* ctx) { _windAngle = source; _windCtx = ctx; }
+
+    // Called periodically: handles the events queued since
     void update();
     void begin();
 
+    void handle(const ButtonEvent& e);
+
 private:
-    void readButtons();
     void cycleSteeringMode();
     void updateAutoSteerSetpoint();
 
     UIModel& _model;
     AutoSteeringController& _autoSteer;
-    const IInputDevice& _input;
-
-    bool _lastAuto;
-    bool _lastMode;
+    ButtonEvents& _buttons;
+    WindAngleSource _windAngle;
+    void* _windCtx;
 };
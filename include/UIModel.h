@@ -1,5 +1,6 @@
 #pragma once
-#include <string>
+#include <cstdint>
+#include "AutoSteeringController.h"
 
 /** Simple enum to represent autopilot states. */
 enum class UIAutoMode {
@@ -13,21 +14,51 @@ enum class UIAutoMode {
  */
 struct UIState {
     UIAutoMode autoMode;          // e.g. STANDBY or AUTO
-    std::string currentSteeringMode;  // e.g. "OFF", "TRACK_HEADING", etc.
+    AutoSteeringMode currentSteeringMode;  // e.g. OFF, TRACK_HEADING
     float headingSetpoint;        // numeric setpoint
     float stepSizeSmall;          // small increment
     float stepSizeLarge;          // large increment
 };
 
+/** The fields the view draws, as bits for UIModel::changedSince(). */
+enum UIField : std::uint32_t {
+    UI_AUTO_MODE     = 1u << 0,
+    UI_STEERING_MODE = 1u << 1,
+    UI_SETPOINT      = 1u << 2,
+    UI_ALL           = (1u << 3) - 1
+};
+
+/**
+ * The UI state with change tracking: every setter that really changes
+ * a field bumps version() and stamps the field with it, so a reader
+ * that remembers the version it last saw can ask which fields changed
+ * since without the model knowing who reads it.
+ *
+ * The modes are enums; the names the view shows come from constant
+ * tables, so neither updating nor drawing the model allocates.
+ */
 class UIModel {
 public:
+    static constexpr int STEERING_MODE_COUNT = 4;
+    static constexpr const char* AUTO_MODE_NAMES[2] = { "STANDBY", "AUTO" };
+    static constexpr const char* STEERING_MODE_NAMES[STEERING_MODE_COUNT] = {
+        "OFF", "TRACK_HEADING", "TRACK_COURSE", "TRACK_WIND_ANGLE"
+    };
+
+    static constexpr const char* autoModeName(UIAutoMode mode) {
+        return AUTO_MODE_NAMES[mode == UIAutoMode::AUTO ? 1 : 0];
+    }
+    static constexpr const char* steeringModeName(AutoSteeringMode mode) {
+        return (unsigned)mode < (unsigned)STEERING_MODE_COUNT ? STEERING_MODE_NAMES[mode] : "?";
+    }
+
     UIModel();
     ~UIModel() = default;
 
     const UIState& getState() const;
 
     void setAutoMode(UIAutoMode mode);
-    void setSteeringMode(const std::string& modeName);
+    void setSteeringMode(AutoSteeringMode mode);
     void setHeadingSetpoint(float val);
 
     void incrementSetpointSmall();
@@ -35,6 +66,17 @@ public:
     void incrementSetpointLarge();
     void decrementSetpointLarge();
 
+    // Bumped by every change, never 0
+    std::uint32_t version() const { return _version; }
+    // UIField bits of the fields changed after version
+    std::uint32_t changedSince(std::uint32_t version) const;
+
 private:
+    void touch(int field);
+
+    static const int FIELD_COUNT = 3;
+
     UIState _state;
+    std::uint32_t _version;
+    std::uint32_t _changed[FIELD_COUNT];    // version of the last change
 };
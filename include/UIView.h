@@ -1,28 +1,46 @@
 #pragma once
-#include <string>
+#include <cstdint>
 #include "UIModel.h"
+#include "IDisplay.h"
 
 /**
- * A platform-agnostic "View" interface for a 128x256 display. 
- * We assume an underlying driver library (e.g. u8g2),
- * but we do NOT #include Arduino.h or other Arduino specifics here.
+ * A platform-agnostic "View" for the 192x96 panel (U8g2Display's
+ * ST75256 JLX19296).
+ * It draws through IDisplay (U8g2Display on the target), so it does
+ * NOT #include Arduino.h or the driver library.
+ *
+ * Only what changed is drawn: render() asks the model which fields
+ * changed since the frame it last drew, and redraws and sends just the
+ * tile rows of those lines. Nothing changed, nothing is sent. The first
+ * frame, and the one after invalidate(), is drawn and sent whole.
+ *
+ * Lines are formatted into a buffer on the stack, without printf: a
+ * render allocates nothing.
  */
 class UIView {
 public:
-    UIView();
-    ~UIView();
+    static const int WIDTH  = 192;
+    static const int HEIGHT = 96;
+
+    explicit UIView(IDisplay& display);
+    ~UIView() = default;
 
     // Initialize the display driver
     bool begin();
 
     // Render the UI state
     void render(const UIModel& model);
+    // Draw the whole screen again on the next render()
+    void invalidate() { _valid = false; }
+
+    // render() calls that found nothing to draw
+    std::uint32_t skipped() const { return _skipped; }
 
 private:
-    std::string autoModeToStr(UIAutoMode mode) const;
+    void drawLine(int line, const UIModel& model);
 
-    // Opaque pointer or reference to your chosen display driver
-    // We won't reference Arduino calls here. We'll assume the .cpp
-    // handles the library. 
-    void* _u8g2; // We can cast to the real type in the .cpp
+    IDisplay& _display;
+    bool _valid;                // the screen shows model version _version
+    std::uint32_t _version;
+    std::uint32_t _skipped;
 };
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "IPacketSource.h"
+
+/**
+ * NMEA0183 datagrams broadcast on the boat's network (e.g. port 10110
+ * from a multiplexer). Binds the port once the station is connected and
+ * again after it reconnects.
+ */
+class UdpPacketSource : public IPacketSource {
+public:
+    explicit UdpPacketSource(std::uint16_t port);
+
+    std::size_t receive(char* out, std::size_t len) override;
+
+private:
+    std::uint16_t _port;
+    bool          _bound;
+    std::size_t   _pending;     // unread bytes of the current datagram
+    WiFiUDP       _udp;
+};
+
+/**
+ * Sends datagrams to a host or the broadcast address while the station
+ * is connected, dropped otherwise.
+ */
+class UdpPacketSink {
+public:
+    UdpPacketSink(const char* host, std::uint16_t port);
+
+    // False if not connected or not sent
+    bool send(const char* data, std::size_t len);
+
+private:
+    const char*   _host;
+    std::uint16_t _port;
+    WiFiUDP       _udp;
+};
+
+/**
+ * NMEA0183 stream from a TCP server. Connects while the station is
+ * connected, every RETRY_MS at most: connect() blocks for up to
+ * CONNECT_TIMEOUT_MS, so keep it off the control core.
+ */
+class TcpPacketSource : public IPacketSource {
+public:
+    static const std::uint32_t RETRY_MS           = 5000;
+    static const std::int32_t  CONNECT_TIMEOUT_MS = 200;
+
+    TcpPacketSource(const char* host, std::uint16_t port);
+
+    std::size_t receive(char* out, std::size_t len) override;
+
+    bool isConnected() { return _client.connected(); }
+
+private:
+    const char*   _host;
+    std::uint16_t _port;
+    bool          _tried;
+    std::uint32_t _lastTryMs;
+    WiFiClient    _client;
+};
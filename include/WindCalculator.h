@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * True wind from the masthead instrument, filtered for steering.
+ *
+ * trueWind() resolves one apparent reading. The anemometer heels with
+ * the mast and only sees the athwartship component times cos(heel), so
+ * that is divided back out; then the boat's own speed through the water
+ * is taken off the forward component.
+ *
+ * update() turns the true wind angle into the true wind direction
+ * (heading + angle, so the boat's own yawing stays out of the filters)
+ * and feeds the wind vector into two exponential filters:
+ *   fast  fastTau, rides out the instrument swinging in the waves
+ *   slow  slowTau, the persistent wind, what the pilot steers by
+ * Puffs and lulls, and the veers that come with them, are over well
+ * within slowTau and only show in gustFactor(). A shift counts as
+ * persistent once the fast direction has stayed more than shiftDeg to
+ * the same side of the slow one for shiftHoldS; the slow filter then
+ * jumps to it instead of taking slowTau to follow.
+ *
+ * Angles off the bow are -180..180, positive for wind from starboard
+ * (MWV's 0..360 clockwise after wrapping); directions and headings
+ * 0..360. Speeds in any one unit, knots off NMEA.
+ */
+class WindCalculator {
+public:
+    explicit WindCalculator(float fastTau=3.f, float slowTau=60.f);
+
+    // Default 10 deg held for 20 s
+    void setShiftDetection(float shiftDeg, float holdS);
+
+    // Apparent (awa, aws) to true wind (twa, tws); heel [deg] either way
+    static void trueWind(float awa, float aws, float boatSpeed, float heel,
+                         float& twa, float& tws);
+
+    // One apparent reading, dt seconds after the last
+    void update(float awa, float aws, float boatSpeed, float heel, float heading, float dt);
+    void reset();
+
+    // False until the first update()
+    bool valid() const { return _primed; }
+
+    // The persistent true wind angle at the given (present) heading
+    float steeringAngle(float heading) const;
+    // The short horizon one
+    float trueAngle(float heading) const;
+
+    // Persistent true wind direction [deg, 0..360)
+    float trueDirection() const;
+    // Short horizon true wind speed
+    float trueSpeed() const { return _fastSpeed; }
+    // Short over long horizon speed: >1 in a puff, <1 in a lull
+    float gustFactor() const;
+    // Persistent shifts followed
+    std::uint32_t shifts() const { return _shifts; }
+
+private:
+    float _fastTau;
+    float _slowTau;
+    float _shiftDeg;
+    float _shiftHold;
+
+    bool  _primed;
+    float _fastX, _fastY;       // true wind vector, north and east
+    float _slowX, _slowY;
+    float _fastSpeed;
+    float _slowSpeed;
+    int   _shiftSide;           // -1, 0, 1: fast left of, at, right of slow
+    float _shiftTime;           // [s] on that side
+    std::uint32_t _shifts;
+};
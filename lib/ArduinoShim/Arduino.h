@@ -0,0 +1,142 @@
+#pragma once
+/**
+ * Host stand-in for the parts of the arduino-esp32 core (and the
+ * FreeRTOS / esp_timer calls it exposes) that the firmware uses, for
+ * env:native. Time is virtual and the pins are wired to the models in
+ * SimWorld, see SimKernel.h for how tasks and interrupts run.
+ *
+ * Only what src/ needs is here; add to it as the firmware grows.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define IRAM_ATTR
+
+#define LOW            0x0
+#define HIGH           0x1
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define PULLUP         0x04
+#define INPUT_PULLUP   0x05
+#define PULLDOWN       0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING         0x01
+#define FALLING        0x02
+#define CHANGE         0x03
+
+#ifndef BIT
+#define BIT(nr)        (1UL << (nr))
+#endif
+
+// ---- esp_err.h ----
+typedef int esp_err_t;
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_NOT_SUPPORTED   0x106
+#define ESP_ERR_TIMEOUT         0x107
+
+// ---- FreeRTOS ----
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+typedef void*        TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE               ((BaseType_t)0)
+#define pdTRUE                ((BaseType_t)1)
+#define pdFAIL                pdFALSE
+#define pdPASS                pdTRUE
+#define portMAX_DELAY         ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS    ((TickType_t)1)
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(ms))
+#define configMAX_PRIORITIES  25
+#define tskNO_AFFINITY        0x7FFFFFFF
+// The kernel switches tasks as soon as the ISR returns
+#define portYIELD_FROM_ISR()  do {} while(0)
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle);
+void       vTaskDelete(TaskHandle_t task);
+void       vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+uint32_t   ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void       vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+
+// ---- Arduino core ----
+unsigned long millis();
+unsigned long micros();
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+int64_t  esp_timer_get_time();
+uint32_t getCpuFrequencyMhz();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int  digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+uint16_t analogRead(uint8_t pin);
+// ADC1 is GPIO 1..10 (channels 0..9), ADC2 GPIO 11..20 (10..19), -1 else
+int8_t digitalPinToAnalogChannel(uint8_t pin);
+#define digitalPinToInterrupt(p) ((p) < 64 ? (p) : -1)
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolutionBits);
+void     ledcAttachPin(uint8_t pin, uint8_t channel);
+void     ledcWrite(uint8_t channel, uint32_t duty);
+
+// Hardware timers, counting at 80 MHz / divider
+struct hw_timer_t;
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void        timerEnd(hw_timer_t* timer);
+void        timerAttachInterrupt(hw_timer_t* timer, void (*isr)(void), bool edge);
+void        timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoReload);
+void        timerAlarmEnable(hw_timer_t* timer);
+void        timerAlarmDisable(hw_timer_t* timer);
+
+/** UART0 on stdout/stdin. */
+class HardwareSerial {
+public:
+    void   begin(unsigned long baud);
+    void   end() {}
+    int    available();
+    int    read();
+    size_t write(uint8_t c);
+    size_t print(const char* s);
+    size_t print(long v);
+    size_t println();
+    size_t println(const char* s);
+    size_t println(long v);
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    void   flush();
+    operator bool() const { return true; }
+
+private:
+    int  _peek = -1;      // byte taken from stdin by available()
+    bool _eof = false;
+};
+
+extern HardwareSerial Serial;
+
+// Implemented by the sketch
+void setup();
+void loop();
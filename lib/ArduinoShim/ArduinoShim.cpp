@@ -0,0 +1,684 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <U8g2lib.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <driver/spi_master.h>
+#include <deque>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include "SimKernel.h"
+#include "SimWorld.h"
+
+using sim::Kernel;
+using sim::World;
+
+// Virtual CPU time of the calls that touch the clock or the hardware [us]
+static const uint64_t CLOCK_READ_US  = 1;
+static const uint64_t ANALOG_READ_US = 10;
+static const uint64_t LEDC_WRITE_US  = 1;
+static const uint64_t I2C_BYTE_US    = 23;   // 9 bits at 400 kHz
+
+// ---- FreeRTOS ----
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t,
+                                   void* param, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t)
+{
+    void* t=Kernel::instance().createTask(fn, name, param, priority);
+    if(handle) {
+        *handle=t;
+    }
+    return t ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    Kernel::instance().deleteTask(task);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    Kernel::instance().delayTicks(ticks);
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)(Kernel::instance().now()/Kernel::TICK_US);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+    uint64_t timeout=(ticksToWait==portMAX_DELAY) ? Kernel::FOREVER : ticksToWait;
+    return Kernel::instance().notifyTake(clearOnExit!=pdFALSE, timeout);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    Kernel::instance().notifyGive(task, nullptr);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+    bool woken=false;
+    Kernel::instance().notifyGive(task, &woken);
+    if(higherPriorityTaskWoken && woken) {
+        *higherPriorityTaskWoken=pdTRUE;
+    }
+}
+
+// ---- Time ----
+
+unsigned long millis()
+{
+    Kernel::instance().charge(CLOCK_READ_US);
+    // 32 bit like on the chip, so wrap-around behaves the same
+    return (uint32_t)(Kernel::instance().now()/1000);
+}
+
+unsigned long micros()
+{
+    Kernel::instance().charge(CLOCK_READ_US);
+    return (uint32_t)Kernel::instance().now();
+}
+
+int64_t esp_timer_get_time()
+{
+    Kernel::instance().charge(CLOCK_READ_US);
+    return (int64_t)Kernel::instance().now();
+}
+
+void delay(uint32_t ms)
+{
+    Kernel::instance().delayTicks(ms/portTICK_PERIOD_MS);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    Kernel::instance().charge(us);
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return 240;
+}
+
+// ---- Pins ----
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    World::instance().pinMode(pin, (mode&PULLUP)!=0);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return World::instance().digitalRead(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t level)
+{
+    World::instance().digitalWrite(pin, level);
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    Kernel::instance().charge(ANALOG_READ_US);
+    return (uint16_t)World::instance().analogRead(pin);
+}
+
+int8_t digitalPinToAnalogChannel(uint8_t pin)
+{
+    return (pin>=1 && pin<=20) ? (int8_t)(pin-1) : -1;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int)
+{
+    // Every edge the model raises is delivered, whatever the mode
+    Kernel::instance().attachPinIsr(pin, isr);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    Kernel::instance().detachPinIsr(pin);
+}
+
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolutionBits)
+{
+    World::instance().ledcSetup(channel, freq, resolutionBits);
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    World::instance().ledcAttachPin(pin, channel);
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    Kernel::instance().charge(LEDC_WRITE_US);
+    World::instance().ledcWrite(channel, duty);
+}
+
+// ---- Hardware timers ----
+
+struct hw_timer_t {
+    int      index;
+    uint16_t divider;
+};
+
+static hw_timer_t s_timers[4];
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool)
+{
+    if(num>=4) {
+        return nullptr;
+    }
+    int index=Kernel::instance().timerBegin();
+    if(index<0) {
+        return nullptr;
+    }
+    s_timers[num].index=index;
+    s_timers[num].divider=divider ? divider : 1;
+    return &s_timers[num];
+}
+
+void timerEnd(hw_timer_t* timer)
+{
+    timerAlarmDisable(timer);
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*isr)(void), bool)
+{
+    if(timer) {
+        Kernel::instance().timerSetIsr(timer->index, isr);
+    }
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoReload)
+{
+    if(timer) {
+        // 80 MHz APB clock through the divider
+        Kernel::instance().timerSetAlarm(timer->index, alarmValue*timer->divider/80, autoReload);
+    }
+}
+
+void timerAlarmEnable(hw_timer_t* timer)
+{
+    if(timer) {
+        Kernel::instance().timerEnable(timer->index, true);
+    }
+}
+
+void timerAlarmDisable(hw_timer_t* timer)
+{
+    if(timer) {
+        Kernel::instance().timerEnable(timer->index, false);
+    }
+}
+
+// ---- Serial ----
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long)
+{
+}
+
+int HardwareSerial::available()
+{
+    // Never block, the console task polls. A closed stdin stays empty.
+    if(_peek<0 && !_eof) {
+        struct pollfd p = { STDIN_FILENO, POLLIN, 0 };
+        if(poll(&p, 1, 0)>0 && (p.revents&(POLLIN|POLLHUP))) {
+            unsigned char c;
+            if(::read(STDIN_FILENO, &c, 1)==1) {
+                _peek=c;
+            } else {
+                _eof=true;
+            }
+        }
+    }
+    return _peek>=0 ? 1 : 0;
+}
+
+int HardwareSerial::read()
+{
+    if(!available()) {
+        return -1;
+    }
+    int c=_peek;
+    _peek=-1;
+    return c;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return std::fputc(c, stdout)==EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::print(const char* s)
+{
+    return std::fputs(s, stdout)<0 ? 0 : std::strlen(s);
+}
+
+size_t HardwareSerial::print(long v)
+{
+    return printf("%ld", v);
+}
+
+size_t HardwareSerial::println()
+{
+    return print("\n");
+}
+
+size_t HardwareSerial::println(const char* s)
+{
+    return print(s)+println();
+}
+
+size_t HardwareSerial::println(long v)
+{
+    return print(v)+println();
+}
+
+size_t HardwareSerial::printf(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n=std::vfprintf(stdout, fmt, args);
+    va_end(args);
+    return n>0 ? (size_t)n : 0;
+}
+
+void HardwareSerial::flush()
+{
+    std::fflush(stdout);
+}
+
+// ---- Wire ----
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+ : _address(0),
+   _txLen(0),
+   _rxLen(0),
+   _rxPos(0)
+{
+}
+
+bool TwoWire::begin(int, int, uint32_t)
+{
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _address=address;
+    _txLen=0;
+}
+
+uint8_t TwoWire::endTransmission(bool)
+{
+    Kernel::instance().charge(I2C_BYTE_US*(1+_txLen));
+    sim::I2cDevice* dev=World::instance().i2cDevice(_address);
+    if(!dev) {
+        return 2;
+    }
+    dev->write(_tx, _txLen);
+    _txLen=0;
+    return 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if(_txLen>=BUFFER_LENGTH) {
+        return 0;
+    }
+    _tx[_txLen++]=data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len)
+{
+    size_t n=0;
+    while(n<len && write(data[n])) {
+        n++;
+    }
+    return n;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool)
+{
+    _rxLen=0;
+    _rxPos=0;
+    size_t want=(quantity<BUFFER_LENGTH) ? quantity : BUFFER_LENGTH;
+    Kernel::instance().charge(I2C_BYTE_US*(1+want));
+    sim::I2cDevice* dev=World::instance().i2cDevice(address);
+    if(!dev) {
+        return 0;
+    }
+    _rxLen=dev->read(_rx, want);
+    return (uint8_t)_rxLen;
+}
+
+int TwoWire::available()
+{
+    return (int)(_rxLen-_rxPos);
+}
+
+int TwoWire::read()
+{
+    return (_rxPos<_rxLen) ? _rx[_rxPos++] : -1;
+}
+
+// ---- WiFi ----
+
+WiFiClass WiFi;
+
+// ---- LittleFS ----
+
+LittleFSFS LittleFS;
+
+File::File(FILE* f)
+ : _file(f, [](FILE* p) { if(p) std::fclose(p); })
+{
+    if(!f) {
+        _file.reset();
+    }
+}
+
+int File::available()
+{
+    if(!_file) {
+        return 0;
+    }
+    long pos=std::ftell(_file.get());
+    return (int)(size()-(size_t)pos);
+}
+
+int File::read()
+{
+    return _file ? std::fgetc(_file.get()) : -1;
+}
+
+size_t File::read(uint8_t* buf, size_t len)
+{
+    return _file ? std::fread(buf, 1, len, _file.get()) : 0;
+}
+
+size_t File::readBytes(char* buf, size_t len)
+{
+    return read((uint8_t*)buf, len);
+}
+
+size_t File::write(const uint8_t* buf, size_t len)
+{
+    return _file ? std::fwrite(buf, 1, len, _file.get()) : 0;
+}
+
+bool File::seek(uint32_t pos)
+{
+    return _file && std::fseek(_file.get(), (long)pos, SEEK_SET)==0;
+}
+
+void File::flush()
+{
+    if(_file) {
+        std::fflush(_file.get());
+    }
+}
+
+size_t File::size()
+{
+    if(!_file) {
+        return 0;
+    }
+    FILE* f=_file.get();
+    long pos=std::ftell(f);
+    std::fseek(f, 0, SEEK_END);
+    long end=std::ftell(f);
+    std::fseek(f, pos, SEEK_SET);
+    return end>0 ? (size_t)end : 0;
+}
+
+void File::close()
+{
+    _file.reset();
+}
+
+bool LittleFSFS::begin(bool, const char*, uint8_t, const char*)
+{
+    return access(_root.c_str(), R_OK)==0;
+}
+
+std::string LittleFSFS::hostPath(const char* path) const
+{
+    return _root+(path[0]=='/' ? "" : "/")+path;
+}
+
+File LittleFSFS::open(const char* path, const char* mode)
+{
+    return File(std::fopen(hostPath(path).c_str(), mode));
+}
+
+bool LittleFSFS::exists(const char* path)
+{
+    return access(hostPath(path).c_str(), F_OK)==0;
+}
+
+// ---- SPI ----
+
+struct spi_device_t {
+    bool used;
+    int clockHz;
+    int queueSize;
+    transaction_cb_t preCb;
+    transaction_cb_t postCb;
+    std::deque<spi_transaction_t*> queued;
+    uint64_t busyUntil;
+};
+
+static spi_device_t s_spiDevices[4];
+static bool s_spiBus=false;
+
+static uint64_t spiWireUs(const spi_device_t* dev, const spi_transaction_t* t)
+{
+    return ((uint64_t)t->length*1000000ULL+dev->clockHz-1)/dev->clockHz;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t* config, spi_dma_chan_t)
+{
+    if(!config || s_spiBus) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_spiBus=true;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t)
+{
+    // as the IDF: not while devices are on it
+    for(const spi_device_t& dev : s_spiDevices) {
+        if(dev.used) return ESP_ERR_INVALID_STATE;
+    }
+    if(!s_spiBus) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_spiBus=false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle)
+{
+    if(!s_spiBus || !config || config->clock_speed_hz<=0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    spi_device_t* free=nullptr;
+    for(spi_device_t& d : s_spiDevices) {
+        if(!d.used) {
+            free=&d;
+            break;
+        }
+    }
+    if(!free) {
+        return ESP_ERR_NO_MEM;
+    }
+    spi_device_t& dev=*free;
+    dev.used=true;
+    dev.clockHz=config->clock_speed_hz;
+    dev.queueSize=config->queue_size>0 ? config->queue_size : 1;
+    dev.preCb=config->pre_cb;
+    dev.postCb=config->post_cb;
+    dev.busyUntil=0;
+    *handle=&dev;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t dev)
+{
+    if(!dev || !dev->used) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    dev->used=false;
+    dev->queued.clear();
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t dev, spi_transaction_t* trans, TickType_t)
+{
+    if((int)dev->queued.size()>=dev->queueSize) {
+        return ESP_ERR_TIMEOUT;
+    }
+    // back to back on the wire, from now if the bus is idle
+    uint64_t now=Kernel::instance().now();
+    if(dev->busyUntil<now) {
+        dev->busyUntil=now;
+    }
+    dev->busyUntil+=spiWireUs(dev, trans);
+    dev->queued.push_back(trans);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t dev, spi_transaction_t** trans, TickType_t)
+{
+    if(dev->queued.empty()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    spi_transaction_t* t=dev->queued.front();
+    dev->queued.pop_front();
+    if(dev->preCb) dev->preCb(t);
+    // the last one queued ends at busyUntil, the others before
+    uint64_t end=dev->busyUntil;
+    for(spi_transaction_t* q : dev->queued) {
+        end-=spiWireUs(dev, q);
+    }
+    if(end>Kernel::instance().now()) {
+        Kernel::instance().sleepUntil(end);
+    }
+    if(dev->postCb) dev->postCb(t);
+    *trans=t;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t dev, spi_transaction_t* trans)
+{
+    if(dev->preCb) dev->preCb(trans);
+    Kernel::instance().charge(spiWireUs(dev, trans));
+    if(dev->postCb) dev->postCb(trans);
+    return ESP_OK;
+}
+
+// ---- u8g2 ----
+
+const u8g2_cb_t u8g2_cb_r0 = {};
+const uint8_t u8g2_font_6x10_tr[] = { 0 };
+
+uint16_t U8G2::drawStr(int, int, const char* s)
+{
+    strings++;
+    return (uint16_t)(6*std::strlen(s));
+}
+
+void u8g2_Setup_st75256_jlx19296_f(u8g2_t* u8g2, const u8g2_cb_t*,
+                                   u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb)
+{
+    u8g2->u8x8.byte_cb=byte_cb;
+    u8g2->u8x8.gpio_and_delay_cb=gpio_and_delay_cb;
+    u8g2->u8x8.tile_width=24;
+    u8g2->u8x8.tile_height=12;
+}
+
+static void u8x8Send(u8x8_t* u8x8, bool data, const uint8_t* bytes, int n)
+{
+    u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_SET_DC, data ? 1 : 0, nullptr);
+    // the real driver sends at most 31 tiles a call
+    while(n>0) {
+        int chunk=n>248 ? 248 : n;
+        u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_SEND, (uint8_t)chunk, (void*)bytes);
+        bytes+=chunk;
+        n-=chunk;
+    }
+}
+
+// Column and page address, then the tiles' data, as the ST75256 wants it
+static void u8x8DrawTiles(u8x8_t* u8x8, int tx, int ty, int tw, int th)
+{
+    static const uint8_t row[248]={ 0 };
+    for(int y=ty; y<ty+th; y++) {
+        uint8_t cmd[]={ 0x75, (uint8_t)y, (uint8_t)(u8x8->tile_height-1),
+                        0x15, (uint8_t)(tx*8), (uint8_t)(tx*8+tw*8-1), 0x5c };
+        u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_START_TRANSFER, 0, nullptr);
+        u8x8Send(u8x8, false, cmd, sizeof(cmd));
+        for(int n=tw*8; n>0; n-=248) {
+            u8x8Send(u8x8, true, row, n>248 ? 248 : n);
+        }
+        u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_END_TRANSFER, 0, nullptr);
+    }
+}
+
+bool U8G2::begin()
+{
+    u8x8_t* u8x8=&u8g2.u8x8;
+    if(!u8x8->byte_cb) {
+        return true;
+    }
+    u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_GPIO_AND_DELAY_INIT, 0, nullptr);
+    u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_INIT, 0, nullptr);
+    u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_GPIO_RESET, 0, nullptr);
+    u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_DELAY_MILLI, 10, nullptr);
+    u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_GPIO_RESET, 1, nullptr);
+    // ext. command set, sleep out, display on
+    static const uint8_t init[]={ 0x30, 0x94, 0xaf };
+    u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_START_TRANSFER, 0, nullptr);
+    u8x8Send(u8x8, false, init, sizeof(init));
+    u8x8->byte_cb(u8x8, U8X8_MSG_BYTE_END_TRANSFER, 0, nullptr);
+    return true;
+}
+
+void U8G2::sendBuffer()
+{
+    frames++;
+    if(u8g2.u8x8.byte_cb) {
+        u8x8DrawTiles(&u8g2.u8x8, 0, 0, u8g2.u8x8.tile_width, u8g2.u8x8.tile_height);
+    }
+}
+
+void U8G2::updateDisplayArea(int tx, int ty, int tw, int th)
+{
+    updates++;
+    if(u8g2.u8x8.byte_cb) {
+        u8x8DrawTiles(&u8g2.u8x8, tx, ty, tw, th);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <stdio.h>
+#include <string>
+
+/** A file on the host, shared between copies like the Arduino File. */
+class File {
+public:
+    File() {}
+    explicit File(FILE* f);
+
+    operator bool() const { return (bool)_file; }
+
+    int    available();
+    int    read();
+    size_t read(uint8_t* buf, size_t len);
+    size_t readBytes(char* buf, size_t len);
+    size_t write(const uint8_t* buf, size_t len);
+    bool   seek(uint32_t pos);
+    void   flush();
+    size_t size();
+    void   close();
+
+private:
+    std::shared_ptr<FILE> _file;
+};
+
+/**
+ * LittleFS backed by a host directory, "data" by default (the folder
+ * `pio run -t uploadfs` would flash), see SimMain.cpp --fs.
+ */
+class LittleFSFS {
+public:
+    bool begin(bool formatOnFail=false, const char* basePath="/littlefs",
+               uint8_t maxOpenFiles=10, const char* partitionLabel="spiffs");
+    void end() {}
+    File open(const char* path, const char* mode="r");
+    bool exists(const char* path);
+
+    // Host directory standing in for the partition
+    void setRoot(const char* dir) { _root=dir; }
+
+private:
+    std::string hostPath(const char* path) const;
+
+    std::string _root = "data";
+};
+
+extern LittleFSFS LittleFS;
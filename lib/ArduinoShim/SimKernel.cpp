@@ -0,0 +1,497 @@
+#include "SimKernel.h"
+#include <thread>
+
+namespace sim {
+
+static thread_local void* t_self = nullptr;
+static thread_local bool  t_inIsr = false;
+
+Kernel& Kernel::instance()
+{
+    static Kernel kernel;
+    return kernel;
+}
+
+Kernel::Kernel()
+ : _now(0),
+   _end(FOREVER),
+   _seq(0),
+   _switches(0),
+   _sliceStart(0),
+   _finished(false),
+   _current(nullptr)
+{
+    for(int i=0; i<MAX_TIMERS; i++) {
+        _timers[i]=Timer{ false, false, false, nullptr, 0, 0 };
+    }
+    for(int i=0; i<MAX_PINS; i++) {
+        _pinIsr[i]=nullptr;
+    }
+}
+
+// ISRs and events run with the lock already held by their thread
+Kernel::Lock Kernel::guard()
+{
+    return t_inIsr ? Lock(_mutex, std::defer_lock) : Lock(_mutex);
+}
+
+std::uint64_t Kernel::now()
+{
+    Lock lock=guard();
+    return _now;
+}
+
+bool Kernel::inIsr() const
+{
+    return t_inIsr;
+}
+
+std::uint64_t Kernel::switches()
+{
+    Lock lock=guard();
+    return _switches;
+}
+
+Kernel::Task* Kernel::self() const
+{
+    return static_cast<Task*>(t_self);
+}
+
+void Kernel::charge(std::uint64_t us)
+{
+    if(t_inIsr) {
+        return;
+    }
+    Lock lock(_mutex);
+    if(!self()) {
+        // Not a task (static constructors, the main thread): no events
+        _now+=us;
+        return;
+    }
+    advanceTo(lock, _now+us);
+}
+
+// ---- Tasks ----
+
+void* Kernel::createTask(TaskFn fn, const char* name, void* arg, unsigned priority)
+{
+    Lock lock(_mutex);
+    if(_tasks.size()>=(std::size_t)MAX_TASKS) {
+        return nullptr;
+    }
+    Task* t=new Task;
+    t->name=name ? name : "";
+    t->fn=fn;
+    t->arg=arg;
+    t->priority=priority;
+    t->notifications=0;
+    makeReady(t);
+    _tasks.push_back(t);
+    std::thread(threadMain, t).detach();
+
+    // A new task of higher priority runs at once, as in FreeRTOS
+    Task* me=self();
+    if(me && higherReady(me)) {
+        preempt(lock, me);
+    }
+    return t;
+}
+
+void Kernel::sleepUntil(std::uint64_t us)
+{
+    Lock lock(_mutex);
+    Task* t=self();
+    if(!t) {
+        _now=(us>_now) ? us : _now;
+        return;
+    }
+    if(us<=_now) {
+        return;
+    }
+    t->wakeAt=us;
+    block(lock, t);
+}
+
+void Kernel::delayTicks(std::uint32_t ticks)
+{
+    Lock lock(_mutex);
+    Task* t=self();
+    if(!t) {
+        _now+=ticks*TICK_US;
+        return;
+    }
+    if(ticks==0) {
+        // taskYIELD(): let tasks of the same priority run
+        preempt(lock, t);
+        return;
+    }
+    t->wakeAt=(_now/TICK_US+ticks)*TICK_US;
+    block(lock, t);
+}
+
+std::uint32_t Kernel::notifyTake(bool clearOnExit, std::uint64_t timeoutTicks)
+{
+    Lock lock(_mutex);
+    Task* t=self();
+    if(!t) {
+        return 0;
+    }
+    if(t->notifications==0 && timeoutTicks>0) {
+        t->waitNotify=true;
+        t->wakeAt=(timeoutTicks==FOREVER) ? FOREVER : (_now/TICK_US+timeoutTicks)*TICK_US;
+        block(lock, t);
+    }
+    std::uint32_t n=t->notifications;
+    if(n) {
+        t->notifications=clearOnExit ? 0 : n-1;
+    }
+    return n;
+}
+
+void Kernel::notifyGive(void* task, bool* woken)
+{
+    Lock lock=guard();
+    Task* t=static_cast<Task*>(task);
+    if(woken) {
+        *woken=false;
+    }
+    if(!t || t->state==TaskState::DELETED) {
+        return;
+    }
+    t->notifications++;
+    if(t->state==TaskState::BLOCKED && t->waitNotify) {
+        makeReady(t);
+        if(woken) {
+            *woken=!_current || t->priority>_current->priority;
+        }
+    }
+    // From an ISR the switch happens once the handler returns
+    Task* me=self();
+    if(!t_inIsr && me && higherReady(me)) {
+        preempt(lock, me);
+    }
+}
+
+void Kernel::deleteTask(void* task)
+{
+    Lock lock(_mutex);
+    Task* me=self();
+    Task* t=task ? static_cast<Task*>(task) : me;
+    if(!t || t->state==TaskState::DELETED) {
+        return;
+    }
+    t->state=TaskState::DELETED;
+    t->wakeAt=FOREVER;
+    if(t==me) {
+        // The thread stays parked until the process exits
+        dispatch(lock);
+        waitForCpu(lock, t);
+    }
+}
+
+// ---- Interrupts and events ----
+
+int Kernel::timerBegin()
+{
+    Lock lock=guard();
+    for(int i=0; i<MAX_TIMERS; i++) {
+        if(!_timers[i].used) {
+            _timers[i]=Timer{ true, false, false, nullptr, 0, 0 };
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Kernel::timerSetIsr(int timer, IsrFn isr)
+{
+    Lock lock=guard();
+    if(timer>=0 && timer<MAX_TIMERS) {
+        _timers[timer].isr=isr;
+    }
+}
+
+void Kernel::timerSetAlarm(int timer, std::uint64_t periodUs, bool autoReload)
+{
+    Lock lock=guard();
+    if(timer>=0 && timer<MAX_TIMERS) {
+        _timers[timer].period=periodUs>0 ? periodUs : 1;
+        _timers[timer].autoReload=autoReload;
+    }
+}
+
+void Kernel::timerEnable(int timer, bool on)
+{
+    Lock lock=guard();
+    if(timer>=0 && timer<MAX_TIMERS) {
+        _timers[timer].enabled=on;
+        _timers[timer].next=_now+_timers[timer].period;
+    }
+}
+
+void Kernel::attachPinIsr(int pin, IsrFn isr)
+{
+    Lock lock=guard();
+    if(pin>=0 && pin<MAX_PINS) {
+        _pinIsr[pin]=isr;
+    }
+}
+
+void Kernel::detachPinIsr(int pin)
+{
+    attachPinIsr(pin, nullptr);
+}
+
+void Kernel::raisePin(int pin)
+{
+    Lock lock=guard();
+    if(pin>=0 && pin<MAX_PINS && _pinIsr[pin]) {
+        runIsr(_pinIsr[pin]);
+    }
+}
+
+void Kernel::addPeriodic(std::uint64_t periodUs, EventFn fn, void* ctx)
+{
+    Lock lock=guard();
+    _periodic.push_back(Periodic{ periodUs, _now+periodUs, fn, ctx });
+}
+
+// ---- Run ----
+
+void Kernel::run(TaskFn mainTask, unsigned priority, std::uint64_t durationUs)
+{
+    {
+        Lock lock(_mutex);
+        _end=(durationUs==FOREVER) ? FOREVER : _now+durationUs;
+    }
+    createTask(mainTask, "loopTask", nullptr, priority);
+
+    Lock lock(_mutex);
+    dispatch(lock);
+    _finishedCv.wait(lock, [this] { return _finished; });
+}
+
+// ---- Internals, all with the lock held ----
+
+void Kernel::makeReady(Task* t)
+{
+    t->state=TaskState::READY;
+    t->readySeq=_seq++;
+    t->wakeAt=FOREVER;
+    t->waitNotify=false;
+}
+
+Kernel::Task* Kernel::pickReady() const
+{
+    Task* best=nullptr;
+    for(Task* t : _tasks) {
+        if(t->state!=TaskState::READY) {
+            continue;
+        }
+        if(!best || t->priority>best->priority ||
+           (t->priority==best->priority && t->readySeq<best->readySeq)) {
+            best=t;
+        }
+    }
+    return best;
+}
+
+bool Kernel::higherReady(const Task* t) const
+{
+    for(const Task* o : _tasks) {
+        if(o->state==TaskState::READY && o->priority>t->priority) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Kernel::equalReady(const Task* t) const
+{
+    for(const Task* o : _tasks) {
+        if(o!=t && o->state==TaskState::READY && o->priority==t->priority) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Kernel::anyAlive() const
+{
+    for(const Task* t : _tasks) {
+        if(t->state!=TaskState::DELETED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint64_t Kernel::nextEvent() const
+{
+    std::uint64_t next=_end;
+    for(const Task* t : _tasks) {
+        if(t->state==TaskState::BLOCKED && t->wakeAt<next) {
+            next=t->wakeAt;
+        }
+    }
+    for(int i=0; i<MAX_TIMERS; i++) {
+        if(_timers[i].enabled && _timers[i].isr && _timers[i].next<next) {
+            next=_timers[i].next;
+        }
+    }
+    for(const Periodic& p : _periodic) {
+        if(p.next<next) {
+            next=p.next;
+        }
+    }
+    return next;
+}
+
+void Kernel::fireDue()
+{
+    for(Task* t : _tasks) {
+        if(t->state==TaskState::BLOCKED && t->wakeAt<=_now) {
+            // a notify wait that timed out returns 0
+            makeReady(t);
+        }
+    }
+    for(int i=0; i<MAX_TIMERS; i++) {
+        Timer& tm=_timers[i];
+        if(tm.enabled && tm.isr && tm.next<=_now) {
+            if(tm.autoReload) {
+                tm.next+=tm.period;
+            } else {
+                tm.enabled=false;
+            }
+            runIsr(tm.isr);
+        }
+    }
+    for(std::size_t i=0; i<_periodic.size(); i++) {
+        Periodic& p=_periodic[i];
+        if(p.next<=_now) {
+            p.next+=p.period;
+            bool prev=t_inIsr;
+            t_inIsr=true;
+            p.fn(p.ctx);
+            t_inIsr=prev;
+        }
+    }
+}
+
+void Kernel::runIsr(IsrFn isr)
+{
+    bool prev=t_inIsr;
+    t_inIsr=true;
+    isr();
+    t_inIsr=prev;
+}
+
+void Kernel::finish()
+{
+    _finished=true;
+    _current=nullptr;
+    _finishedCv.notify_all();
+}
+
+void Kernel::advanceTo(Lock& lock, std::uint64_t target)
+{
+    Task* t=self();
+    for(;;) {
+        if(_finished) {
+            waitForCpu(lock, t);
+        }
+        std::uint64_t next=nextEvent();
+        if(next>target) {
+            break;
+        }
+        if(next>_now) {
+            _now=next;
+        }
+        if(_now>=_end) {
+            finish();
+            continue;
+        }
+        fireDue();
+        // Interrupts may have readied a more urgent task; tasks of the
+        // same priority share the CPU tick by tick
+        if(higherReady(t) || (_now-_sliceStart>=TICK_US && equalReady(t))) {
+            preempt(lock, t);
+        }
+    }
+    if(target>_now) {
+        _now=target;
+    }
+}
+
+void Kernel::preempt(Lock& lock, Task* t)
+{
+    makeReady(t);
+    dispatch(lock);
+    waitForCpu(lock, t);
+}
+
+void Kernel::block(Lock& lock, Task* t)
+{
+    t->state=TaskState::BLOCKED;
+    dispatch(lock);
+    waitForCpu(lock, t);
+}
+
+void Kernel::dispatch(Lock&)
+{
+    for(;;) {
+        if(_finished) {
+            return;
+        }
+        Task* next=pickReady();
+        if(next) {
+            if(next!=_current) {
+                _switches++;
+                _sliceStart=_now;
+            }
+            _current=next;
+            next->state=TaskState::RUNNING;
+            next->cv.notify_one();
+            return;
+        }
+
+        // Idle: jump to whatever happens next
+        _current=nullptr;
+        if(!anyAlive()) {
+            finish();
+            return;
+        }
+        std::uint64_t at=nextEvent();
+        if(at>_now) {
+            _now=at;
+        }
+        if(_now>=_end) {
+            finish();
+            return;
+        }
+        fireDue();
+    }
+}
+
+void Kernel::waitForCpu(Lock& lock, Task* t)
+{
+    if(!t) {
+        return;
+    }
+    t->cv.wait(lock, [this, t] { return _current==t && !_finished; });
+}
+
+void Kernel::threadMain(Task* t)
+{
+    Kernel& k=instance();
+    t_self=t;
+    {
+        Lock lock(k._mutex);
+        k.waitForCpu(lock, t);
+    }
+    t->fn(t->arg);
+    // FreeRTOS tasks must not return; treat it as vTaskDelete(nullptr)
+    k.deleteTask(nullptr);
+}
+
+} // namespace sim
@@ -0,0 +1,173 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Virtual time and a minimal FreeRTOS for running the firmware as a host
+ * process (env:native).
+ *
+ * Every FreeRTOS task is a std::thread, but only one of them holds the
+ * (single, virtual) CPU at a time: the highest priority ready task, as
+ * on one core of the ESP32. Core arguments are ignored. A task gives up
+ * the CPU when it blocks (vTaskDelay, ulTaskNotifyTake, vTaskDelete) or
+ * when an interrupt readies a task of higher priority.
+ *
+ * Virtual time only moves when code looks at it or waits: every shim
+ * call that reads the clock or touches hardware costs a few
+ * microseconds (see charge()), and when all tasks are blocked the clock
+ * jumps straight to the next wakeup, timer alarm or simulation event.
+ * So the firmware runs as fast as the host can execute it, and a
+ * given binary replays the same way every time.
+ *
+ * Interrupt handlers (hardware timers, pin interrupts, periodic
+ * simulation events) run on whichever thread is inside the kernel at
+ * that virtual time, with the kernel lock held.
+ */
+namespace sim {
+
+typedef void (*IsrFn)();
+typedef void (*TaskFn)(void*);
+typedef void (*EventFn)(void* ctx);
+
+class Kernel {
+public:
+    static const std::uint64_t TICK_US = 1000;   // FreeRTOS tick, 1 kHz
+    static const std::uint64_t FOREVER = ~0ull;
+
+    static Kernel& instance();
+
+    // Virtual microseconds since start
+    std::uint64_t now();
+
+    /**
+     * Spend us of CPU time in the current task: interrupts due in that
+     * time fire and may hand the CPU to a higher priority task.
+     */
+    void charge(std::uint64_t us);
+
+    // ---- Tasks ----
+
+    // Return an opaque handle, nullptr if the task limit is reached
+    void* createTask(TaskFn fn, const char* name, void* arg, unsigned priority);
+    // Block the current task until the given virtual time
+    void sleepUntil(std::uint64_t us);
+    // Block for ticks FreeRTOS ticks, waking on a tick boundary
+    void delayTicks(std::uint32_t ticks);
+    // ulTaskNotifyTake(); timeout in ticks, FOREVER to wait forever
+    std::uint32_t notifyTake(bool clearOnExit, std::uint64_t timeoutTicks);
+    // vTaskNotifyGive(FromISR); woken (may be null) tells whether a
+    // higher priority task than the current one became ready
+    void notifyGive(void* task, bool* woken);
+    // Delete a task, nullptr = the caller (does not return then)
+    void deleteTask(void* task);
+
+    // ---- Interrupts and events ----
+
+    // Hardware timer alarms calling an ISR; timerBegin() returns -1 if
+    // all timers are taken
+    int  timerBegin();
+    void timerSetIsr(int timer, IsrFn isr);
+    void timerSetAlarm(int timer, std::uint64_t periodUs, bool autoReload);
+    void timerEnable(int timer, bool on);
+
+    void attachPinIsr(int pin, IsrFn isr);
+    void detachPinIsr(int pin);
+    // Run the handler attached to pin, from an event or another ISR
+    void raisePin(int pin);
+
+    // Call fn every periodUs from now on, in interrupt context
+    void addPeriodic(std::uint64_t periodUs, EventFn fn, void* ctx);
+
+    // True while an ISR or event runs on the calling thread
+    bool inIsr() const;
+
+    // ---- Run ----
+
+    /**
+     * Start the given task (normally setup()/loop()), run until the
+     * virtual clock reaches durationUs (FOREVER: until every task is
+     * gone) and return. The tasks' threads are left parked; the
+     * caller is expected to exit the process.
+     */
+    void run(TaskFn mainTask, unsigned priority, std::uint64_t durationUs);
+
+    // Task switches so far, for the summary
+    std::uint64_t switches();
+
+private:
+    enum class TaskState { READY, RUNNING, BLOCKED, DELETED };
+
+    struct Task {
+        std::string             name;
+        TaskFn                  fn;
+        void*                   arg;
+        unsigned                priority;
+        TaskState               state;
+        std::uint64_t           wakeAt;      // FOREVER if not sleeping
+        std::uint64_t           readySeq;    // FIFO among equal priorities
+        std::uint32_t           notifications;
+        bool                    waitNotify;
+        std::condition_variable cv;
+    };
+
+    struct Timer {
+        bool          used;
+        bool          enabled;
+        bool          autoReload;
+        IsrFn         isr;
+        std::uint64_t period;
+        std::uint64_t next;
+    };
+
+    struct Periodic {
+        std::uint64_t period;
+        std::uint64_t next;
+        EventFn       fn;
+        void*         ctx;
+    };
+
+    static const int MAX_TASKS  = 16;
+    static const int MAX_TIMERS = 4;
+    static const int MAX_PINS   = 64;
+
+    Kernel();
+
+    typedef std::unique_lock<std::mutex> Lock;
+
+    Lock  guard();
+    Task* self() const;
+    void  makeReady(Task* t);
+    Task* pickReady() const;
+    bool  higherReady(const Task* t) const;
+    bool  equalReady(const Task* t) const;
+    bool  anyAlive() const;
+    std::uint64_t nextEvent() const;
+    void  fireDue();
+    void  runIsr(IsrFn isr);
+    void  finish();
+    void  advanceTo(Lock& lock, std::uint64_t target);
+    void  preempt(Lock& lock, Task* t);
+    void  block(Lock& lock, Task* t);
+    void  dispatch(Lock& lock);
+    void  waitForCpu(Lock& lock, Task* t);
+    static void threadMain(Task* t);
+
+    std::mutex              _mutex;
+    std::condition_variable _finishedCv;
+    std::uint64_t           _now;
+    std::uint64_t           _end;
+    std::uint64_t           _seq;
+    std::uint64_t           _switches;
+    std::uint64_t           _sliceStart;   // when _current got the CPU
+    bool                    _finished;
+    Task*                   _current;
+    std::vector<Task*>      _tasks;
+    Timer                   _timers[MAX_TIMERS];
+    IsrFn                   _pinIsr[MAX_PINS];
+    std::vector<Periodic>   _periodic;
+};
+
+} // namespace sim
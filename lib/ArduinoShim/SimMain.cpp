@@ -0,0 +1,80 @@
+/**
+ * main() of env:native: wires up the simulated hardware and runs the
+ * sketch's setup() and loop() in the Arduino loop task, in virtual time.
+ *
+ * Usage: program [--duration 60] [--seed 1] [--fs data] [--heading 90]
+ *   --duration  simulated seconds, 0 = until every task has ended
+ *   --seed      waves, gusts and sensor noise
+ *   --fs        host directory standing in for LittleFS
+ *   --heading   initial boat heading [deg]
+ * Serial goes to stdout and reads stdin (e.g. echo prof | program).
+ */
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "SimKernel.h"
+#include "SimWorld.h"
+
+// Priority of the arduino-esp32 loop task
+static const unsigned LOOP_TASK_PRIORITY = 1;
+
+static void loopTask(void*)
+{
+    setup();
+    for(;;) {
+        loop();
+    }
+}
+
+static bool parseArgs(int argc, char** argv, double& duration, sim::WorldConfig& cfg)
+{
+    for(int i=1; i<argc; i++) {
+        bool hasValue=(i+1<argc);
+        if(!std::strcmp(argv[i], "--duration") && hasValue) {
+            duration=std::atof(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--seed") && hasValue) {
+            cfg.vessel.seed=(std::uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if(!std::strcmp(argv[i], "--fs") && hasValue) {
+            LittleFS.setRoot(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--heading") && hasValue) {
+            cfg.vessel.initialHeading=(float)std::atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return duration>=0.0;
+}
+
+int main(int argc, char** argv)
+{
+    double duration=60.0;
+    sim::WorldConfig cfg;
+    if(!parseArgs(argc, argv, duration, cfg)) {
+        std::fprintf(stderr, "usage: program [--duration 60] [--seed 1] [--fs data] [--heading 90]\n");
+        return 2;
+    }
+
+    sim::World& world=sim::World::instance();
+    sim::Kernel& kernel=sim::Kernel::instance();
+    world.begin(cfg);
+
+    auto start=std::chrono::steady_clock::now();
+    kernel.run(loopTask, LOOP_TASK_PRIORITY,
+               duration>0.0 ? (std::uint64_t)(duration*1e6) : sim::Kernel::FOREVER);
+    double wall=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    double simulated=kernel.now()*1e-6;
+
+    std::fflush(stdout);
+    std::fprintf(stderr, "[Sim] %.1f s simulated in %.2f s (%.0fx), %llu task switches\n",
+                 simulated, wall, wall>0.0 ? simulated/wall : 0.0,
+                 (unsigned long long)kernel.switches());
+    const VesselState& boat=world.vessel();
+    std::fprintf(stderr, "[Sim] heading %.1f deg, yaw rate %.2f deg/s, roll %.1f deg, rudder %.1f deg, drive %.3f Wh\n",
+                 boat.heading, boat.yawRate, boat.roll, boat.rudder, world.driveEnergyWh());
+    // The task threads are parked inside the kernel, do not unwind them
+    std::fflush(stderr);
+    std::_Exit(0);
+}
@@ -0,0 +1,267 @@
+#include "SimWorld.h"
+#include "SimKernel.h"
+#include <cmath>
+#include <cstring>
+
+namespace sim {
+
+static const float PHYSICS_DT = 0.001f;
+static const float G          = 9.81f;
+static const float RAD2DEG    = 57.29578f;
+
+// MPU9250 / AK8963 registers the firmware uses
+static const std::uint8_t MPU_GYRO_CONFIG  = 0x1B;
+static const std::uint8_t MPU_ACCEL_CONFIG = 0x1C;
+static const std::uint8_t MPU_ACCEL_XOUT_H = 0x3B;
+static const std::uint8_t MPU_WHO_AM_I     = 0x75;
+static const std::uint8_t AK_WIA           = 0x00;
+static const std::uint8_t AK_ST1           = 0x02;
+static const std::uint8_t AK_HXL           = 0x03;
+static const std::uint8_t AK_ST2           = 0x09;
+static const std::uint8_t AK_CNTL          = 0x0A;
+static const std::uint8_t AK_ASA           = 0x10;
+static const std::uint8_t AK_ADDRESS       = 0x0C;
+
+static void putBigEndian(std::uint8_t* p, float value)
+{
+    long v=std::lround(value);
+    if(v>32767) v=32767;
+    if(v<-32768) v=-32768;
+    std::uint16_t u=(std::uint16_t)(std::int16_t)v;
+    p[0]=(std::uint8_t)(u>>8);
+    p[1]=(std::uint8_t)(u&0xFF);
+}
+
+// ---- SimMpu9250 ----
+
+SimMpu9250::SimMpu9250()
+ : _ptr(0)
+{
+    std::memset(_regs, 0, sizeof(_regs));
+    _regs[MPU_WHO_AM_I]=0x71;
+}
+
+void SimMpu9250::write(const std::uint8_t* data, std::size_t len)
+{
+    if(len==0) {
+        return;
+    }
+    _ptr=data[0]&0x7F;
+    for(std::size_t i=1; i<len; i++) {
+        _regs[_ptr]=data[i];
+        _ptr=(_ptr+1)&0x7F;
+    }
+}
+
+std::size_t SimMpu9250::read(std::uint8_t* data, std::size_t len)
+{
+    for(std::size_t i=0; i<len; i++) {
+        data[i]=_regs[_ptr];
+        _ptr=(_ptr+1)&0x7F;
+    }
+    return len;
+}
+
+void SimMpu9250::sample(const float accel[3], const float gyro[3], const float field[3])
+{
+    // FS_SEL bits 4:3 of the config registers
+    const float accelLsb=16384.f/float(1<<((_regs[MPU_ACCEL_CONFIG]>>3)&3));
+    const float gyroLsb=131.f/float(1<<((_regs[MPU_GYRO_CONFIG]>>3)&3));
+    std::uint8_t* p=&_regs[MPU_ACCEL_XOUT_H];
+    for(int k=0; k<3; k++) {
+        putBigEndian(p+2*k, accel[k]*accelLsb);
+    }
+    putBigEndian(p+6, 0.f);   // 21 degC
+    for(int k=0; k<3; k++) {
+        putBigEndian(p+8+2*k, gyro[k]*gyroLsb);
+    }
+
+    // BIT in CNTL1 selects 16 bit output (0.15 uT/LSB), else 14 bit
+    const bool bits16=(_mag.regs[AK_CNTL]&0x10)!=0;
+    const float magLsb=bits16 ? 0.15f : 0.6f;
+    for(int k=0; k<3; k++) {
+        long v=std::lround(field[k]/magLsb);
+        std::uint16_t u=(std::uint16_t)(std::int16_t)v;
+        _mag.regs[AK_HXL+2*k]=(std::uint8_t)(u&0xFF);
+        _mag.regs[AK_HXL+2*k+1]=(std::uint8_t)(u>>8);
+    }
+    _mag.regs[AK_ST1]=0x01;   // DRDY
+    _mag.regs[AK_ST2]=bits16 ? 0x10 : 0x00;
+}
+
+SimMpu9250::Mag::Mag()
+ : ptr(0)
+{
+    std::memset(regs, 0, sizeof(regs));
+    regs[AK_WIA]=0x48;
+    // sensitivity adjustment 1.0
+    regs[AK_ASA]=regs[AK_ASA+1]=regs[AK_ASA+2]=128;
+}
+
+void SimMpu9250::Mag::write(const std::uint8_t* data, std::size_t len)
+{
+    if(len==0) {
+        return;
+    }
+    ptr=data[0]&0x1F;
+    for(std::size_t i=1; i<len; i++) {
+        regs[ptr]=data[i];
+        ptr=(ptr+1)&0x1F;
+    }
+}
+
+std::size_t SimMpu9250::Mag::read(std::uint8_t* data, std::size_t len)
+{
+    for(std::size_t i=0; i<len; i++) {
+        data[i]=regs[ptr];
+        // reading ST2 ends the sample
+        if(ptr==AK_ST2) {
+            regs[AK_ST1]=0;
+        }
+        ptr=(ptr+1)&0x1F;
+    }
+    return len;
+}
+
+// ---- World ----
+
+World& World::instance()
+{
+    static World world;
+    return world;
+}
+
+World::World()
+{
+    for(int i=0; i<MAX_PINS; i++) {
+        _level[i]=0;
+    }
+    for(int c=0; c<LEDC_CHANNELS; c++) {
+        _ledcPin[c]=-1;
+        _ledcBits[c]=8;
+        _ledcDuty[c]=0;
+    }
+}
+
+void World::begin(const WorldConfig& cfg)
+{
+    _cfg=cfg;
+    _vessel=VesselSim(cfg.vessel);
+    // DRDY idles high, it is active low
+    if(cfg.imuDrdyPin>=0 && cfg.imuDrdyPin<MAX_PINS) {
+        _level[cfg.imuDrdyPin]=1;
+    }
+
+    Kernel& k=Kernel::instance();
+    k.addPeriodic((std::uint64_t)(PHYSICS_DT*1e6f), physicsStep, this);
+    if(cfg.imuRateHz>0) {
+        k.addPeriodic(1000000ull/cfg.imuRateHz, imuSample, this);
+    }
+}
+
+void World::pinMode(int pin, bool pullup)
+{
+    if(pin>=0 && pin<MAX_PINS && pullup && pin!=_cfg.imuDrdyPin) {
+        _level[pin]=1;
+    }
+}
+
+int World::digitalRead(int pin) const
+{
+    return (pin>=0 && pin<MAX_PINS) ? _level[pin] : 0;
+}
+
+void World::digitalWrite(int pin, int level)
+{
+    if(pin>=0 && pin<MAX_PINS) {
+        _level[pin]=level ? 1 : 0;
+    }
+}
+
+int World::analogRead(int pin)
+{
+    if(pin==_cfg.potPin) {
+        return _vessel.rudder().readPot();
+    }
+    if(pin==_cfg.currentPin) {
+        float counts=_vessel.rudder().readCurrent()/_cfg.ampsPerCount;
+        if(counts<0.f) counts=0.f;
+        if(counts>4095.f) counts=4095.f;
+        return (int)counts;
+    }
+    return 0;
+}
+
+void World::ledcSetup(int channel, std::uint32_t, int bits)
+{
+    if(channel>=0 && channel<LEDC_CHANNELS) {
+        _ledcBits[channel]=bits;
+    }
+}
+
+void World::ledcAttachPin(int pin, int channel)
+{
+    if(channel>=0 && channel<LEDC_CHANNELS) {
+        _ledcPin[channel]=pin;
+    }
+}
+
+void World::ledcWrite(int channel, std::uint32_t duty)
+{
+    if(channel>=0 && channel<LEDC_CHANNELS) {
+        _ledcDuty[channel]=duty;
+    }
+}
+
+I2cDevice* World::i2cDevice(std::uint8_t addr)
+{
+    if(addr==_cfg.imuAddress) {
+        return &_mpu;
+    }
+    if(addr==AK_ADDRESS) {
+        return &_mpu.magnetometer();
+    }
+    return nullptr;
+}
+
+// H-bridge command in [-1..1]: duty on pin A drives one way, B the other
+float World::driveCommand() const
+{
+    float cmd=0.f;
+    for(int c=0; c<LEDC_CHANNELS; c++) {
+        float full=float((1u<<_ledcBits[c])-1);
+        if(_ledcPin[c]==_cfg.motorPinA) {
+            cmd+=_ledcDuty[c]/full;
+        } else if(_ledcPin[c]==_cfg.motorPinB) {
+            cmd-=_ledcDuty[c]/full;
+        }
+    }
+    return cmd;
+}
+
+void World::physicsStep(void* ctx)
+{
+    World& w=*static_cast<World*>(ctx);
+    w._vessel.step(w.driveCommand(), PHYSICS_DT);
+}
+
+void World::imuSample(void* ctx)
+{
+    World& w=*static_cast<World*>(ctx);
+    IMUData d;
+    w._vessel.readIMU(d);
+    const float accel[3]={ d.ax/G, d.ay/G, d.az/G };
+    const float gyro[3]={ d.gx*RAD2DEG, d.gy*RAD2DEG, d.gz*RAD2DEG };
+    const float field[3]={ d.mx, d.my, d.mz };
+    w._mpu.sample(accel, gyro, field);
+
+    // Pulse the active low data ready line
+    int pin=w._cfg.imuDrdyPin;
+    if(pin>=0 && pin<MAX_PINS) {
+        w._level[pin]=0;
+        Kernel::instance().raisePin(pin);
+        w._level[pin]=1;
+    }
+}
+
+} // namespace sim
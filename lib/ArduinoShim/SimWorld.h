@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "VesselSim.h"
+
+/**
+ * What the native firmware is wired to: a VesselSim boat whose rudder
+ * drive hangs on the LEDC outputs and ADC inputs, and an MPU9250 on I2C
+ * reading the boat's simulated IMU, whose data ready line interrupts at
+ * the sample rate.
+ *
+ * Pin numbers default to the ones in src/main.cpp. The models advance
+ * in a 1 kHz kernel event, independent of what the firmware does.
+ */
+namespace sim {
+
+struct WorldConfig {
+    int   motorPinA;        // H-bridge inputs, LEDC
+    int   motorPinB;
+    int   potPin;           // rudder feedback pot, ADC1
+    int   currentPin;       // H-bridge current sense, ADC1
+    int   imuDrdyPin;       // MPU9250 INT, active low
+    std::uint8_t imuAddress;
+    std::uint32_t imuRateHz;
+    float ampsPerCount;     // current sense scale, as MotorCurrentSensor
+    VesselConfig vessel;
+
+    WorldConfig()
+    : motorPinA(5)
+    , motorPinB(6)
+    , potPin(7)
+    , currentPin(4)
+    , imuDrdyPin(8)
+    , imuAddress(0x69)
+    , imuRateHz(100)
+    , ampsPerCount(0.0064f)
+    {}
+};
+
+/** A device on the simulated I2C bus, register file style. */
+class I2cDevice {
+public:
+    virtual ~I2cDevice() {}
+    // A write transaction: register pointer, then data
+    virtual void write(const std::uint8_t* data, std::size_t len) = 0;
+    // A read transaction from the register pointer on
+    virtual std::size_t read(std::uint8_t* data, std::size_t len) = 0;
+};
+
+/**
+ * MPU9250 with the AK8963 magnetometer in bypass mode: WHO_AM_I, range
+ * configuration and the sample registers, nothing else.
+ */
+class SimMpu9250 : public I2cDevice {
+public:
+    SimMpu9250();
+
+    void write(const std::uint8_t* data, std::size_t len) override;
+    std::size_t read(std::uint8_t* data, std::size_t len) override;
+
+    I2cDevice& magnetometer() { return _mag; }
+
+    // Latch a sample: accel [g], gyro [deg/s], field [uT]
+    void sample(const float accel[3], const float gyro[3], const float field[3]);
+
+private:
+    class Mag : public I2cDevice {
+    public:
+        Mag();
+        void write(const std::uint8_t* data, std::size_t len) override;
+        std::size_t read(std::uint8_t* data, std::size_t len) override;
+        std::uint8_t regs[32];
+        std::uint8_t ptr;
+    };
+
+    std::uint8_t _regs[128];
+    std::uint8_t _ptr;
+    Mag          _mag;
+};
+
+class World {
+public:
+    static World& instance();
+
+    // Register the model events with the kernel; call once before run
+    void begin(const WorldConfig& cfg);
+    const WorldConfig& config() const { return _cfg; }
+
+    // ---- Arduino side ----
+    // Inputs read low unless pulled up
+    void pinMode(int pin, bool pullup);
+    int  digitalRead(int pin) const;
+    void digitalWrite(int pin, int level);
+    int  analogRead(int pin);
+    void ledcSetup(int channel, std::uint32_t freq, int bits);
+    void ledcAttachPin(int pin, int channel);
+    void ledcWrite(int channel, std::uint32_t duty);
+    // nullptr if nothing answers at addr
+    I2cDevice* i2cDevice(std::uint8_t addr);
+
+    // ---- Model state ----
+    const VesselState& vessel() const { return _vessel.state(); }
+    float driveEnergyWh() const { return _vessel.rudder().getEnergyWh(); }
+
+private:
+    static const int MAX_PINS = 64;
+    static const int LEDC_CHANNELS = 8;
+
+    World();
+
+    static void physicsStep(void* ctx);
+    static void imuSample(void* ctx);
+    float driveCommand() const;
+
+    WorldConfig   _cfg;
+    VesselSim     _vessel;
+    SimMpu9250    _mpu;
+    std::uint8_t  _level[MAX_PINS];
+    int           _ledcPin[LEDC_CHANNELS];
+    int           _ledcBits[LEDC_CHANNELS];
+    std::uint32_t _ledcDuty[LEDC_CHANNELS];
+};
+
+} // namespace sim
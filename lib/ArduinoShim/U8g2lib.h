@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Headless u8g2: the calls the firmware makes are accepted and counted,
+ * nothing is drawn. UIView is checked against a recording IDisplay in
+ * test_UIView instead.
+ *
+ * The byte and gpio callbacks of a display set up with
+ * u8g2_Setup_st75256_jlx19296_f() do see traffic: begin() sends an init
+ * sequence, sendBuffer() and updateDisplayArea() each tile row as an
+ * addressing command and the row's data, like the real driver, on the
+ * JLX19296's 192x96 (24x12 tiles).
+ */
+struct u8g2_cb_t {};
+extern const u8g2_cb_t u8g2_cb_r0;
+#define U8G2_R0 (&u8g2_cb_r0)
+#define U8X8_PIN_NONE 255
+
+extern const uint8_t u8g2_font_6x10_tr[];
+
+typedef struct u8x8_struct u8x8_t;
+typedef uint8_t (*u8x8_msg_cb)(u8x8_t* u8x8, uint8_t msg, uint8_t arg_int, void* arg_ptr);
+
+struct u8x8_struct {
+    u8x8_msg_cb byte_cb;
+    u8x8_msg_cb gpio_and_delay_cb;
+    uint8_t     tile_width;
+    uint8_t     tile_height;
+};
+
+typedef struct u8g2_struct {
+    u8x8_t u8x8;
+} u8g2_t;
+
+#define U8X8_MSG_BYTE_SEND              23
+#define U8X8_MSG_BYTE_START_TRANSFER    24
+#define U8X8_MSG_BYTE_END_TRANSFER      25
+#define U8X8_MSG_BYTE_SET_DC            32
+#define U8X8_MSG_BYTE_INIT              40
+#define U8X8_MSG_GPIO_AND_DELAY_INIT    40
+#define U8X8_MSG_DELAY_MILLI            41
+#define U8X8_MSG_DELAY_10MICRO          42
+#define U8X8_MSG_DELAY_100NANO          43
+#define U8X8_MSG_DELAY_NANO             44
+#define U8X8_PIN_RESET                  11
+#define U8X8_MSG_GPIO(x)                (64+(x))
+#define U8X8_MSG_GPIO_RESET             U8X8_MSG_GPIO(U8X8_PIN_RESET)
+
+void u8g2_Setup_st75256_jlx19296_f(u8g2_t* u8g2, const u8g2_cb_t* rotation,
+                                   u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb);
+
+class U8G2 {
+public:
+    U8G2() : u8g2() {}
+    virtual ~U8G2() {}
+
+    u8g2_t* getU8g2() { return &u8g2; }
+    u8x8_t* getU8x8() { return &u8g2.u8x8; }
+
+    bool begin();
+    void setFont(const uint8_t* font) { (void)font; }
+    void clearBuffer() {}
+    uint16_t drawStr(int x, int y, const char* s);
+    void sendBuffer();
+    void setDrawColor(uint8_t color) { (void)color; }
+    void drawBox(int x, int y, int w, int h) { (void)x; (void)y; (void)w; (void)h; }
+    void updateDisplayArea(int tx, int ty, int tw, int th);
+
+    uint32_t frames = 0;
+    uint32_t updates = 0;
+    uint32_t strings = 0;
+
+protected:
+    u8g2_t u8g2;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * No network in the simulation: the station never connects and a
+ * client never reaches its host, so the firmware's network input just
+ * stays idle.
+ */
+enum wl_status_t {
+    WL_IDLE_STATUS=0,
+    WL_CONNECTED=3,
+    WL_DISCONNECTED=6
+};
+
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* passphrase=nullptr)
+    {
+        (void)ssid;
+        (void)passphrase;
+        return WL_DISCONNECTED;
+    }
+    bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+    wl_status_t status() { return WL_DISCONNECTED; }
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient {
+public:
+    int connect(const char* host, uint16_t port, int32_t timeoutMs)
+    {
+        (void)host;
+        (void)port;
+        (void)timeoutMs;
+        return 0;
+    }
+    uint8_t connected() { return 0; }
+    int available() { return 0; }
+    int read(uint8_t* buf, size_t size) { (void)buf; (void)size; return -1; }
+    void stop() {}
+};
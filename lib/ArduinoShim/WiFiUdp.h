@@ -0,0 +1,15 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/** UDP socket that never receives or sends anything, see WiFi.h. */
+class WiFiUDP {
+public:
+    uint8_t begin(uint16_t port) { (void)port; return 1; }
+    void stop() {}
+    int parsePacket() { return 0; }
+    int read(uint8_t* buf, size_t len) { (void)buf; (void)len; return 0; }
+    int beginPacket(const char* host, uint16_t port) { (void)host; (void)port; return 0; }
+    size_t write(const uint8_t* buf, size_t size) { (void)buf; return size; }
+    int endPacket() { return 0; }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * I2C master on the simulated bus (SimWorld::i2cDevice). Each byte on
+ * the wire costs virtual time as at 400 kHz.
+ */
+class TwoWire {
+public:
+    static const size_t BUFFER_LENGTH = 128;
+
+    TwoWire();
+
+    bool    begin(int sda=-1, int scl=-1, uint32_t frequency=0);
+    void    setClock(uint32_t frequency) { (void)frequency; }
+    void    beginTransmission(uint8_t address);
+    // 0 ok, 2 address not acknowledged (Arduino codes)
+    uint8_t endTransmission(bool sendStop=true);
+    size_t  write(uint8_t data);
+    size_t  write(const uint8_t* data, size_t len);
+    // Number of bytes read, 0 if nothing answered
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop=true);
+    int     available();
+    int     read();
+
+private:
+    uint8_t _address;
+    uint8_t _tx[BUFFER_LENGTH];
+    size_t  _txLen;
+    uint8_t _rx[BUFFER_LENGTH];
+    size_t  _rxLen;
+    size_t  _rxPos;
+};
+
+extern TwoWire Wire;
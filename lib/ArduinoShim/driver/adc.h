@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * The IDF ADC digital controller (continuous DMA) is not simulated:
+ * adc_digi_initialize() fails, so AdcDmaSampler::begin() returns false
+ * and the rudder loop keeps using analogRead().
+ */
+#define SOC_ADC_CHANNEL_NUM(unit)   10
+#define SOC_ADC_DIGI_MAX_BITWIDTH   12
+#define ADC_MAX_DELAY               UINT32_MAX
+
+typedef enum { ADC_UNIT_1 = 1, ADC_UNIT_2 = 2 } adc_unit_t;
+typedef enum { ADC_ATTEN_DB_0 = 0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_11 } adc_atten_t;
+typedef enum { ADC_WIDTH_BIT_9 = 0, ADC_WIDTH_BIT_10, ADC_WIDTH_BIT_11, ADC_WIDTH_BIT_12 } adc_bits_width_t;
+typedef enum { ADC_CONV_SINGLE_UNIT_1 = 1, ADC_CONV_SINGLE_UNIT_2, ADC_CONV_BOTH_UNIT,
+               ADC_CONV_ALTER_UNIT } adc_digi_convert_mode_t;
+typedef enum { ADC_DIGI_OUTPUT_FORMAT_TYPE1, ADC_DIGI_OUTPUT_FORMAT_TYPE2 } adc_digi_output_format_t;
+
+typedef struct {
+    uint32_t max_store_buf_size;
+    uint32_t conv_num_each_intr;
+    uint32_t adc1_chan_mask;
+    uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+    uint8_t atten;
+    uint8_t channel;
+    uint8_t unit;
+    uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+    bool                       conv_limit_en;
+    uint32_t                   conv_limit_num;
+    uint32_t                   pattern_num;
+    adc_digi_pattern_config_t* adc_pattern;
+    uint32_t                   sample_freq_hz;
+    adc_digi_convert_mode_t    conv_mode;
+    adc_digi_output_format_t   format;
+} adc_digi_configuration_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t data:      12;
+            uint32_t reserved12: 1;
+            uint32_t channel:    4;
+            uint32_t unit:       1;
+            uint32_t reserved17: 15;
+        } type2;
+        uint32_t val;
+    };
+} adc_digi_output_data_t;
+
+static inline esp_err_t adc_digi_initialize(const adc_digi_init_config_t*) { return ESP_ERR_NOT_SUPPORTED; }
+static inline esp_err_t adc_digi_deinitialize() { return ESP_OK; }
+static inline esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t*) { return ESP_ERR_NOT_SUPPORTED; }
+static inline esp_err_t adc_digi_start() { return ESP_ERR_INVALID_STATE; }
+static inline esp_err_t adc_digi_stop() { return ESP_ERR_INVALID_STATE; }
+static inline esp_err_t adc_digi_read_bytes(uint8_t*, uint32_t, uint32_t* outLength, uint32_t)
+{
+    *outLength = 0;
+    return ESP_ERR_INVALID_STATE;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "driver/adc.h"
+
+/**
+ * An ideal ADC: 0..4095 maps linearly onto 0..3100 mV at 11 dB, so the
+ * factory calibration leaves the pot mapping linear.
+ */
+typedef enum { ESP_ADC_CAL_VAL_EFUSE_VREF, ESP_ADC_CAL_VAL_EFUSE_TP,
+               ESP_ADC_CAL_VAL_DEFAULT_VREF } esp_adc_cal_value_t;
+
+typedef struct {
+    adc_unit_t       adc_num;
+    adc_atten_t      atten;
+    adc_bits_width_t bit_width;
+    uint32_t         coeff_a;
+    uint32_t         coeff_b;
+    uint32_t         vref;
+} esp_adc_cal_characteristics_t;
+
+static inline esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t atten,
+                                                           adc_bits_width_t width, uint32_t vref,
+                                                           esp_adc_cal_characteristics_t* chars)
+{
+    chars->adc_num = unit;
+    chars->atten = atten;
+    chars->bit_width = width;
+    chars->coeff_a = 3100;
+    chars->coeff_b = 0;
+    chars->vref = vref;
+    return ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+static inline uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t* chars)
+{
+    return raw * chars->coeff_a / 4095 + chars->coeff_b;
+}
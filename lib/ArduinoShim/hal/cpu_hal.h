@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+
+/**
+ * CCOUNT of a 240 MHz core (getCpuFrequencyMhz()), derived from the
+ * host's steady clock, so Profiler reports real host microseconds
+ * while the firmware itself runs in virtual time.
+ */
+static inline uint32_t cpu_hal_get_cycle_count()
+{
+    using namespace std::chrono;
+    return (uint32_t)(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count()
+                      * 240 / 1000);
+}
@@ -0,0 +1,114 @@
+#include "PassageSim.h"
+#include "AutoSteeringController.h"
+#include "RudderServo.h"
+#include "SeaStateEstimator.h"
+#include "VesselSim.h"
+#include <cmath>
+
+static const float SIM_DT        = 0.01f;  // physics and rudder servo, 100 Hz
+static const int   HEADING_EVERY = 10;     // heading loop at 10 Hz
+static const float GYRO_NOISE    = 0.05f;  // [deg/s]
+static const float DEG2RAD       = 0.017453293f;
+static const float RAD2DEG       = 57.29578f;
+static const float WAVES_OFF_BOW = 135.f;  // quartering sea, the worst for yaw [deg]
+
+// The boat of a passage: PassageConfig describes the disturbance as a
+// rudder-equivalent wave moment at the encounter period and a constant
+// weather helm, so the vessel lies still in the wave field (its speed is
+// in nomotoK) with no wind, and the wave yaw gain is chosen so the wave
+// moment has the std dev of a sine of amplitude waveDisturbance.
+static VesselConfig passageVessel(const PassageConfig& cfg) {
+    VesselConfig v;
+    v.nomotoK        = cfg.nomotoK;
+    v.nomotoT        = cfg.nomotoT;
+    v.speed          = 0.f;
+    v.weatherHelm    = cfg.weatherHelm;
+    v.initialHeading = cfg.desiredHeading;
+    v.rudder.rudderRate  = cfg.rudderRate;
+    v.rudder.motorTau    = cfg.motorTau;
+    v.rudder.rudderLimit = cfg.rudderLimit;
+    v.rudder.drivePower  = cfg.drivePower;
+    v.waves.peakPeriod   = cfg.wavePeriod;
+    v.waves.direction    = cfg.desiredHeading + WAVES_OFF_BOW;
+    v.wind.speed         = 0.f;
+    v.imu.gyroNoise      = GYRO_NOISE * DEG2RAD;
+    v.imu.gyroBias       = 0.f;
+    v.seed = cfg.seed;
+
+    float slopeStd = WaveSpectrum(v.waves).slopeStd();
+    v.waveYaw = (slopeStd > 0.f) ? cfg.waveDisturbance / (std::sqrt(2.f) * slopeStd) : 0.f;
+    return v;
+}
+
+static float wrap180(float a) {
+    while(a > 180.f)   a -= 360.f;
+    while(a <= -180.f) a += 360.f;
+    return a;
+}
+
+PassageMetrics PassageSim::run(const PassageConfig& cfg, const GainSet& gains) {
+    _rng.reseed(cfg.seed);
+
+    AutoSteeringController steer;
+    steer.setGains(gains.steerKp, gains.steerKi, gains.steerKd);
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, cfg.desiredHeading);
+
+    RudderServo servo;
+    servo.setGains(gains.rudderKp, gains.rudderKi, gains.rudderKd);
+    servo.setEconomyMode(cfg.economy);
+
+    SeaStateEstimator seaState;
+
+    VesselSim vessel(passageVessel(cfg));
+    const VesselState& s = vessel.state();
+    IMUData imu;
+
+    float rudder    = 0.f;
+    float waveRate  = 0.f;   // yaw rate the waves alone would cause
+
+    double sqErr = 0.0, sumRate = 0.0, sqRate = 0.0;
+    PassageMetrics m = {};
+
+    const int steps = int(cfg.duration / SIM_DT);
+    for(int k=0; k<steps; k++) {
+        // Heading loop
+        if(k % HEADING_EVERY == 0) {
+            steer.setFeedback(s.heading + cfg.headingNoise * _rng.gaussian());
+            steer.update(SIM_DT * HEADING_EVERY);
+            servo.setTargetAngle(steer.getRudderAngle());
+            servo.setSeaState(seaState.getSeaState());
+        }
+
+        // Rudder servo on a noisy pot reading
+        float cmd = servo.update(rudder + cfg.potNoise * _rng.gaussian(), SIM_DT);
+
+        vessel.step(cmd, SIM_DT);
+        m.rudderTravel += std::fabs(s.rudder - rudder);
+        rudder = s.rudder;
+
+        waveRate += (cfg.nomotoK * s.waveYaw - waveRate) * (SIM_DT / cfg.nomotoT);
+        // The gyro reads -z for a turn to starboard; only the spread matters
+        vessel.readIMU(imu);
+        seaState.addSample(-imu.gz * RAD2DEG, SIM_DT);
+
+        float err = std::fabs(wrap180(s.heading - cfg.desiredHeading));
+        sqErr += double(err) * err;
+        if(err > m.maxHeadingError) m.maxHeadingError = err;
+        sumRate += waveRate;
+        sqRate  += double(waveRate) * waveRate;
+    }
+
+    m.energyWh = vessel.rudder().getEnergyWh();
+    const ServoActivity& act = servo.getActivity();
+    m.motorOnTime = act.motorOnTime;
+    m.motorStarts = act.motorStarts;
+    m.reversals   = act.reversals;
+
+    if(steps > 0) {
+        m.rmsHeadingError = float(std::sqrt(sqErr / steps));
+        double mean = sumRate / steps;
+        m.yawRateStd = float(std::sqrt(std::fmax(0.0, sqRate / steps - mean*mean)));
+        m.rudderTravel /= (cfg.duration / 60.f);
+    }
+    return m;
+}
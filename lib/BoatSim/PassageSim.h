@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include "GainTable.h"
+#include "SimRandom.h"
+
+/**
+ * Parameters of one simulated passage. Defaults describe a ~10 m
+ * sailing yacht with an electric linear drive in moderate seas.
+ */
+struct PassageConfig {
+    float duration;         // [s]
+    float nomotoK;          // steady state yaw rate per rudder [1/s]
+    float nomotoT;          // yaw time constant [s]
+    float waveDisturbance;  // wave yaw moment as rudder equivalent, amplitude [deg]
+    float wavePeriod;       // peak encounter period [s]
+    float weatherHelm;      // constant yaw moment as rudder equivalent [deg]
+    float rudderRate;       // rudder speed at full duty [deg/s]
+    float motorTau;         // drive time constant [s]
+    float rudderLimit;      // mechanical stop [deg]
+    float potNoise;         // rudder feedback noise, std dev [deg]
+    float headingNoise;     // heading sensor noise, std dev [deg]
+    float drivePower;       // electrical power at full duty [W]
+    float desiredHeading;   // [deg]
+    bool  economy;          // run the rudder servo in economy mode
+    std::uint32_t seed;
+
+    PassageConfig()
+    : duration(300.f)
+    , nomotoK(0.3f)
+    , nomotoT(3.0f)
+    , waveDisturbance(4.f)
+    , wavePeriod(6.f)
+    , weatherHelm(2.f)
+    , rudderRate(8.f)
+    , motorTau(0.1f)
+    , rudderLimit(35.f)
+    , potNoise(0.2f)
+    , headingNoise(0.5f)
+    , drivePower(60.f)
+    , desiredHeading(90.f)
+    , economy(false)
+    , seed(1)
+    {}
+};
+
+/** What a passage cost us. */
+struct PassageMetrics {
+    float rmsHeadingError;  // [deg]
+    float maxHeadingError;  // [deg]
+    float rudderTravel;     // accumulated rudder movement [deg/min]
+    float energyWh;         // drive energy [Wh]
+    float motorOnTime;      // [s]
+    std::uint32_t motorStarts;
+    std::uint32_t reversals;
+    float yawRateStd;       // wave induced yaw rate, std dev [deg/s]; the
+                            // sea-state measure GainTable is keyed by
+};
+
+/**
+ * Closed-loop passage: AutoSteeringController (10 Hz) commanding a
+ * RudderServo (100 Hz) that drives the rudder of a VesselSim in a
+ * quartering JONSWAP sea. The servo gets the sea state from a
+ * SeaStateEstimator on the simulated gyro.
+ *
+ * An instance holds no state between runs, so one instance per worker
+ * thread can run any number of passages.
+ */
+class PassageSim {
+public:
+    PassageMetrics run(const PassageConfig& cfg, const GainSet& gains);
+
+private:
+    SimRandom _rng;
+};
@@ -0,0 +1,90 @@
+#include "RudderPlant.h"
+#include <cmath>
+
+RudderPlant::RudderPlant(const RudderPlantConfig& cfg, std::uint32_t seed)
+: _cfg(cfg)
+, _rng(seed)
+{
+    reset();
+}
+
+void RudderPlant::reset(float angle) {
+    _drive = angle;
+    _angle = angle;
+    _rate = 0.f;
+    _current = 0.f;
+    _jammed = false;
+    _energyWh = 0.f;
+}
+
+void RudderPlant::step(float command, float dt) {
+    if(command > 1.f)  command = 1.f;
+    if(command < -1.f) command = -1.f;
+
+    _rate += (command * _cfg.rudderRate - _rate) * (dt / _cfg.motorTau);
+    if(_jammed) _rate = 0.f;
+    _drive += _rate * dt;
+
+    // The rudder follows the drive once the backlash is taken up
+    float half = 0.5f * _cfg.backlash;
+    if(_drive > _angle + half) _angle = _drive - half;
+    if(_drive < _angle - half) _angle = _drive + half;
+
+    if(_angle > _cfg.rudderLimit) {
+        _angle = _cfg.rudderLimit;
+        _drive = _angle + half;
+        _rate = 0.f;
+    }
+    if(_angle < -_cfg.rudderLimit) {
+        _angle = -_cfg.rudderLimit;
+        _drive = _angle - half;
+        _rate = 0.f;
+    }
+
+    // Back EMF: full speed leaves only the running current
+    float current = _cfg.stallCurrent * command
+                  - (_cfg.stallCurrent - _cfg.runCurrent) * _rate / _cfg.rudderRate;
+    _current = std::fabs(current);
+
+    _energyWh += std::fabs(command) * _cfg.drivePower * dt / 3600.f;
+}
+
+float RudderPlant::getCurrent() const {
+    return _current;
+}
+
+float RudderPlant::readCurrent() {
+    float c = _current + _cfg.currentNoise * _rng.gaussian();
+    return (c > 0.f) ? c : 0.f;
+}
+
+void RudderPlant::setJammed(bool jammed) {
+    _jammed = jammed;
+}
+
+float RudderPlant::getAngle() const {
+    return _angle;
+}
+
+float RudderPlant::getRate() const {
+    return _rate;
+}
+
+int RudderPlant::readPot() {
+    float span = _cfg.potMaxAngle - _cfg.potMinAngle;
+    float counts = (_angle - _cfg.potMinAngle) / span * _cfg.adcMax
+                 + _cfg.potNoise * _rng.gaussian();
+    int c = int(std::lround(counts));
+    if(c < 0) c = 0;
+    if(c > _cfg.adcMax) c = _cfg.adcMax;
+    return c;
+}
+
+float RudderPlant::potToAngle(int counts) const {
+    float fraction = float(counts) / float(_cfg.adcMax);
+    return _cfg.potMinAngle + fraction * (_cfg.potMaxAngle - _cfg.potMinAngle);
+}
+
+float RudderPlant::getEnergyWh() const {
+    return _energyWh;
+}
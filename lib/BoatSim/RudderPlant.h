@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include "SimRandom.h"
+
+/**
+ * Rudder drive and feedback pot. Defaults match the firmware mapping in
+ * RudderPositionController (12 bit ADC, -25..+25 deg over full scale) and
+ * an electric linear drive.
+ */
+struct RudderPlantConfig {
+    float rudderRate;     // rudder speed at full duty [deg/s]
+    float motorTau;       // drive time constant [s]
+    float rudderLimit;    // mechanical stop [deg]
+    float backlash;       // dead travel on reversal [deg]
+    float potMinAngle;    // angle at ADC 0 [deg]
+    float potMaxAngle;    // angle at ADC full scale [deg]
+    int   adcMax;         // ADC full scale [counts]
+    float potNoise;       // feedback noise, std dev [counts]
+    float drivePower;     // electrical power at full duty [W]
+    float stallCurrent;   // locked rotor current at full duty [A]
+    float runCurrent;     // current at full duty and full speed under rudder load [A]
+    float currentNoise;   // current sense noise, std dev [A]
+
+    RudderPlantConfig()
+    : rudderRate(8.f)
+    , motorTau(0.1f)
+    , rudderLimit(35.f)
+    , backlash(0.f)
+    , potMinAngle(-25.f)
+    , potMaxAngle(25.f)
+    , adcMax(4095)
+    , potNoise(2.f)
+    , drivePower(60.f)
+    , stallCurrent(20.f)
+    , runCurrent(4.f)
+    , currentNoise(0.2f)
+    {}
+};
+
+/**
+ * Motor + gearing + pot of the rudder drive, for running RudderServo (or
+ * the whole RudderPositionController loop) on the host.
+ *
+ * step() integrates a first-order motor with hard stops; the rudder lags
+ * the drive by the backlash. readPot() returns what analogRead() would.
+ * The motor current falls linearly from the locked rotor current with
+ * speed (back EMF), so it peaks on start-up and when the rudder is
+ * stopped by the end stops or a jam.
+ */
+class RudderPlant {
+public:
+    explicit RudderPlant(const RudderPlantConfig& cfg = RudderPlantConfig(),
+                         std::uint32_t seed = 1);
+
+    void reset(float angle = 0.f);
+
+    // Advance by dt seconds with the H-bridge command in [-1..1]
+    void step(float command, float dt);
+
+    // True rudder angle [deg]
+    float getAngle() const;
+    // Drive speed [deg/s]
+    float getRate() const;
+    // Pot reading in ADC counts, quantized and noisy
+    int readPot();
+    // Angle the firmware computes from a pot reading
+    float potToAngle(int counts) const;
+
+    // Motor current [A], unsigned like the H-bridge current sense
+    float getCurrent() const;
+    // Current sense reading with noise [A]
+    float readCurrent();
+
+    // A jammed rudder (fouled lines, weed) does not move either way
+    void setJammed(bool jammed);
+
+    float getEnergyWh() const;
+
+    const RudderPlantConfig& config() const { return _cfg; }
+
+private:
+    RudderPlantConfig _cfg;
+    SimRandom _rng;
+    float _drive;      // position of the drive side of the backlash [deg]
+    float _angle;
+    float _rate;
+    float _current;
+    bool  _jammed;
+    float _energyWh;
+};
@@ -0,0 +1,178 @@
+#include "ScenarioSim.h"
+#include "AutoSteeringController.h"
+#include "IMUFilterAndCalibration.h"
+#include "MotorCurrentSensor.h"
+#include "MotorProtection.h"
+#include "RudderAngleSensor.h"
+#include "RudderServo.h"
+#include "SeaStateEstimator.h"
+#include "SimHeading.h"
+#include <cmath>
+
+static const float SIM_DT        = 0.01f;  // physics, IMU and rudder servo, 100 Hz
+static const int   HEADING_EVERY = 10;     // heading loop at 10 Hz
+static const int   POT_SAMPLES   = RudderAngleSensor::CIC_RATIO;      // one decimated output per step
+static const int   CURRENT_SAMPLES = MotorCurrentSensor::CIC_RATIO;
+static const float AMPS_PER_COUNT = 0.0064f;
+static const float DEG2RAD       = 0.017453293f;
+static const std::uint32_t FAULT_SEED_SALT = 0x4641u;
+
+static float wrap180(float a) {
+    while(a > 180.f)   a -= 360.f;
+    while(a <= -180.f) a += 360.f;
+    return a;
+}
+
+namespace {
+
+/** Milliseconds of simulated time for IMUFilterAndCalibration. */
+class SimClock : public ITimeProvider {
+public:
+    std::uint64_t ms = 0;
+    std::uint64_t getMillis() const override { return ms; }
+};
+
+/**
+ * The vessel's IMU as the firmware sees it: calibration leftovers, a
+ * magnetic disturbance and lost samples. Keeps the last good sample for
+ * the compass.
+ */
+class FaultyIMU : public IIMUProvider {
+public:
+    FaultyIMU(VesselSim& vessel, const SensorFaults& faults, std::uint32_t seed)
+    : _vessel(vessel), _faults(faults), _rng(seed) {
+        _vessel.trueIMU(last);
+    }
+
+    bool getIMUData(IMUData& out) override {
+        if(_faults.imuDropout > 0.f && _rng.uniform() < _faults.imuDropout) {
+            return false;
+        }
+        _vessel.readIMU(out);
+        out.gz += _faults.gyroBias * DEG2RAD;
+        out.mx += _faults.magOffsetX;
+        out.my += _faults.magOffsetY;
+        if(_faults.magDisturbanceAt >= 0.f && _vessel.state().time >= _faults.magDisturbanceAt) {
+            out.my += _faults.magDisturbance;
+        }
+        last = out;
+        return true;
+    }
+
+    IMUData last;
+
+private:
+    VesselSim&   _vessel;
+    SensorFaults _faults;
+    SimRandom    _rng;
+};
+
+std::uint16_t toCounts(float counts, int adcMax) {
+    if(counts < 0.f) counts = 0.f;
+    if(counts > float(adcMax)) counts = float(adcMax);
+    return (std::uint16_t)std::lround(counts);
+}
+
+} // namespace
+
+ScenarioMetrics ScenarioSim::run(const ScenarioConfig& cfg, const GainTable& gains) {
+    const SensorFaults& f = cfg.faults;
+    VesselSim vessel(cfg.vessel);
+    RudderPlant& drive = vessel.rudder();
+    const RudderPlantConfig& pot = drive.config();
+    const float countsPerDeg = pot.adcMax / (pot.potMaxAngle - pot.potMinAngle);
+
+    FaultyIMU imu(vessel, f, cfg.seed ^ FAULT_SEED_SALT);
+    SimClock clock;
+    IMUFilterAndCalibration filter(imu, clock);
+    SeaStateEstimator seaState;
+    HeadingFilter headingFilter;
+
+    AutoSteeringController steer;
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, cfg.desiredHeading);
+    RudderServo servo;
+    servo.setEconomyMode(cfg.economy);
+    RudderAngleSensor angleSensor;
+    MotorCurrentSensor currentSensor(AMPS_PER_COUNT);
+    MotorProtection protection;
+    const GainSet* active = nullptr;
+
+    bool  jammed  = false;
+    float offCourseSince = -1.f;
+    double sqErr = 0.0;
+    ScenarioMetrics m = {};
+    std::uint16_t raw[POT_SAMPLES];
+
+    const int steps = int(cfg.duration / SIM_DT);
+    for(int k=0; k<steps; k++) {
+        const float t = k * SIM_DT;
+        clock.ms = (std::uint64_t)k * 10u;
+
+        // IMU task
+        filter.update();
+        // z up: the IMU's yaw rate is positive turning to port
+        float heading = headingFilter.update(-filter.getFilteredData().yawRate,
+                                             compassHeading(imu.last), SIM_DT);
+
+        // Heading task
+        if(k % HEADING_EVERY == 0) {
+            seaState.addSample(filter.getFilteredData().yawRate, SIM_DT * HEADING_EVERY);
+            const GainSet* g = gains.select(seaState.getSeaState());
+            if(g && g != active) {
+                active = g;
+                steer.setGains(g->steerKp, g->steerKi, g->steerKd);
+                servo.setGains(g->rudderKp, g->rudderKi, g->rudderKd);
+                servo.setEconomyMode(cfg.economy || g->economy);
+            }
+            steer.setFeedback(heading);
+            steer.update(SIM_DT * HEADING_EVERY);
+            servo.setSeaState(seaState.getSeaState());
+            servo.setTargetAngle(steer.getRudderAngle());
+        }
+
+        // Servo loop: oversampled pot and current sense, then protection
+        bool jam = f.rudderJamAt >= 0.f && t >= f.rudderJamAt && t < f.rudderJamAt + f.rudderJamFor;
+        if(jam != jammed) {
+            drive.setJammed(jam);
+            jammed = jam;
+        }
+        for(int i=0; i<POT_SAMPLES; i++) {
+            float angle = pot.potMinAngle + drive.readPot() / countsPerDeg;
+            float sensed = angle * f.potScale + f.potOffset;
+            raw[i] = toCounts((sensed - pot.potMinAngle) * countsPerDeg, pot.adcMax);
+        }
+        angleSensor.addSamples(raw, POT_SAMPLES);
+        for(int i=0; i<CURRENT_SAMPLES; i++) {
+            raw[i] = toCounts(drive.readCurrent() / AMPS_PER_COUNT, pot.adcMax);
+        }
+        currentSensor.addSamples(raw, CURRENT_SAMPLES);
+
+        float measured = angleSensor.getAngle();
+        float command = protection.limit(servo.update(measured, SIM_DT),
+                                         currentSensor.getCurrent(), measured, SIM_DT);
+        vessel.step(command, SIM_DT);
+
+        // Score on the true heading
+        float err = std::fabs(wrap180(vessel.state().heading - cfg.desiredHeading));
+        sqErr += double(err) * err;
+        if(err > m.maxHeadingError) m.maxHeadingError = err;
+        if(err > FAIL_ERROR) {
+            if(offCourseSince < 0.f) offCourseSince = t;
+            if(!m.failed && t - offCourseSince >= FAIL_TIME) {
+                m.failed = true;
+                m.failedAt = t;
+            }
+        } else {
+            offCourseSince = -1.f;
+        }
+    }
+
+    if(steps > 0) {
+        m.rmsHeadingError = float(std::sqrt(sqErr / steps));
+    }
+    m.energyWh = drive.getEnergyWh();
+    m.seaState = seaState.getSeaState();
+    m.motorStarts = servo.getActivity().motorStarts;
+    m.protectionTrips = protection.getTripCount();
+    return m;
+}
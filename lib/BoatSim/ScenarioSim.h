@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include "GainTable.h"
+#include "VesselSim.h"
+
+/**
+ * What goes wrong with the sensors in one scenario: calibration left
+ * overs that are there from the start, and faults that come and go.
+ * A negative time means the fault does not occur.
+ */
+struct SensorFaults {
+    float magOffsetX;        // hard iron left after calibration [uT]
+    float magOffsetY;
+    float gyroBias;          // yaw gyro bias left after calibration [deg/s]
+    float potOffset;         // rudder pot zero error [deg]
+    float potScale;          // rudder pot gain, 1 = exact
+    float imuDropout;        // probability an IMU sample is lost
+    float magDisturbanceAt;  // a magnet (speaker, tool box) appears [s]
+    float magDisturbance;    // ...and shifts the field sideways [uT]
+    float rudderJamAt;       // the rudder jams [s]
+    float rudderJamFor;      // ...for this long [s]
+
+    SensorFaults()
+    : magOffsetX(0.f)
+    , magOffsetY(0.f)
+    , gyroBias(0.f)
+    , potOffset(0.f)
+    , potScale(1.f)
+    , imuDropout(0.f)
+    , magDisturbanceAt(-1.f)
+    , magDisturbance(0.f)
+    , rudderJamAt(-1.f)
+    , rudderJamFor(0.f)
+    {}
+};
+
+/** One closed-loop scenario: a boat, a sea, a course and its faults. */
+struct ScenarioConfig {
+    float duration;         // [s]
+    float desiredHeading;   // [deg]
+    bool  economy;          // run the rudder servo in economy mode
+    VesselConfig vessel;    // its seed drives waves, gusts and sensor noise
+    SensorFaults faults;
+    std::uint32_t seed;     // fault timing (dropouts)
+
+    ScenarioConfig()
+    : duration(300.f)
+    , desiredHeading(90.f)
+    , economy(false)
+    , seed(1)
+    {}
+};
+
+/** How the autopilot did. */
+struct ScenarioMetrics {
+    float rmsHeadingError;   // [deg]
+    float maxHeadingError;   // [deg]
+    float energyWh;          // drive energy [Wh]
+    float seaState;          // final SeaStateEstimator output [deg/s]
+    std::uint32_t motorStarts;
+    std::uint32_t protectionTrips;
+    bool  failed;            // off course for too long, see ScenarioSim
+    float failedAt;          // [s], if failed
+};
+
+/**
+ * The firmware's sensing and control stack on a VesselSim, closed loop:
+ *
+ *   IMU (with faults) -> IMUFilterAndCalibration -> SeaStateEstimator
+ *   IMU gyro, magnetometer -> tilt compensated compass, gyro heading filter
+ *   heading           -> AutoSteeringController (10 Hz)
+ *   pot (with faults) -> RudderAngleSensor -> RudderServo -> MotorProtection
+ *                     -> rudder drive (100 Hz)
+ *
+ * The gains come from the GainTable entry for the current sea state, as
+ * in the firmware; an empty table leaves the controllers' own gains.
+ * A scenario fails once the true heading has been more than
+ * FAIL_ERROR off for FAIL_TIME.
+ *
+ * An instance holds no state between runs, so one instance per worker
+ * thread can run any number of scenarios.
+ */
+class ScenarioSim {
+public:
+    static constexpr float FAIL_ERROR = 30.f;   // [deg]
+    static constexpr float FAIL_TIME  = 20.f;   // [s]
+
+    ScenarioMetrics run(const ScenarioConfig& cfg, const GainTable& gains);
+};
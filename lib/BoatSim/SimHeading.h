@@ -0,0 +1,52 @@
+#pragma once
+#include <cmath>
+#include "IIMUProvider.h"
+
+/**
+ * Heading from the simulated IMU, as an autopilot's heading sensor
+ * works it out: a heel compensated compass, and the gyro pulled towards
+ * it. IMUFilterAndCalibration only provides the yaw rate and the raw
+ * sample, so closed-loop simulations and tests steer by this.
+ */
+
+// Compass heading [deg, 0..360) with the heel taken out, roll from the
+// accelerometer
+inline float compassHeading(const IMUData& d) {
+    float roll = std::atan2(d.ay, d.az);
+    float port = std::cos(roll) * d.my - std::sin(roll) * d.mz;
+    float h = std::atan2(port, d.mx) * 57.29578f;
+    return (h < 0.f) ? h + 360.f : h;
+}
+
+/**
+ * Gyro heading pulled towards the compass: the compass alone is too
+ * noisy to differentiate. The first compass heading starts it.
+ */
+class HeadingFilter {
+public:
+    // Trusts the gyro for tau seconds
+    explicit HeadingFilter(float tau = 2.f) : _tau(tau) {}
+
+    // yawRate [deg/s] positive to starboard, i.e. the negated IMU z rate
+    float update(float yawRate, float compass, float dt) {
+        if(!_started) {
+            _heading = compass;
+            _started = true;
+        }
+        _heading += yawRate * dt;
+        float err = compass - _heading;
+        while(err > 180.f)   err -= 360.f;
+        while(err <= -180.f) err += 360.f;
+        _heading += err * (dt / _tau);
+        if(_heading < 0.f)    _heading += 360.f;
+        if(_heading >= 360.f) _heading -= 360.f;
+        return _heading;
+    }
+
+    float heading() const { return _heading; }
+
+private:
+    float _tau;
+    bool  _started = false;
+    float _heading = 0.f;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+/**
+ * Small deterministic RNG for simulations (xorshift64*).
+ * Same seed -> same sequence on every platform, so a simulated
+ * passage can be reproduced from its seed alone.
+ */
+class SimRandom {
+public:
+    explicit SimRandom(std::uint64_t seed=1) { reseed(seed); }
+
+    void reseed(std::uint64_t seed) {
+        // splitmix64 step so that nearby seeds give unrelated streams
+        std::uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        _state = (z ^ (z >> 31)) | 1ULL;
+        _haveSpare = false;
+    }
+
+    std::uint32_t next() {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return (std::uint32_t)((_state * 0x2545F4914F6CDD1DULL) >> 32);
+    }
+
+    // Uniform in [0..1)
+    float uniform() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform in [lo..hi)
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * uniform();
+    }
+
+    // Standard normal (Marsaglia polar method)
+    float gaussian() {
+        if(_haveSpare) {
+            _haveSpare = false;
+            return _spare;
+        }
+        float u, v, s;
+        do {
+            u = uniform() * 2.0f - 1.0f;
+            v = uniform() * 2.0f - 1.0f;
+            s = u*u + v*v;
+        } while(s >= 1.0f || s == 0.0f);
+        float m = std::sqrt(-2.0f * std::log(s) / s);
+        _spare = v * m;
+        _haveSpare = true;
+        return u * m;
+    }
+
+private:
+    std::uint64_t _state;
+    float         _spare;
+    bool          _haveSpare;
+};
@@ -0,0 +1,154 @@
+#include "VesselSim.h"
+#include <cmath>
+
+static const float G        = 9.81f;
+static const float TWO_PI_F = 6.2831853f;
+static const float DEG2RAD  = 0.017453293f;
+static const float RAD2DEG  = 57.29578f;
+
+// Separate streams for the waves, the gusts and the IMU noise, so reading
+// the IMU more or less often does not change the boat's path
+static const std::uint32_t WAVE_SEED_SALT = 0x5741u;
+static const std::uint32_t IMU_SEED_SALT  = 0x494Du;
+
+static float wrap360(float a) {
+    if(a >= 360.f) a -= 360.f;
+    if(a < 0.f)    a += 360.f;
+    return a;
+}
+
+VesselSim::VesselSim(const VesselConfig& cfg)
+: _cfg(cfg)
+, _rudder(cfg.rudder, cfg.seed)
+, _waves(cfg.waves, cfg.seed ^ WAVE_SEED_SALT)
+, _rng(cfg.seed)
+, _imuRng(cfg.seed ^ IMU_SEED_SALT)
+{
+    reset();
+}
+
+void VesselSim::reset() {
+    _rudder = RudderPlant(_cfg.rudder, _cfg.seed);
+    _waves  = WaveSpectrum(_cfg.waves, _cfg.seed ^ WAVE_SEED_SALT);
+    _rng.reseed(_cfg.seed);
+    _imuRng.reseed(_cfg.seed ^ IMU_SEED_SALT);
+
+    _state = VesselState();
+    _state.heading   = wrap360(_cfg.initialHeading);
+    _state.windSpeed = _cfg.wind.speed;
+    _state.windDirection = _cfg.wind.direction;
+    _gust = 0.f;
+    _veer = 0.f;
+    for(int k=0; k<3; k++) {
+        _gyroBias[k] = _cfg.imu.gyroBias * _imuRng.gaussian();
+    }
+}
+
+void VesselSim::step(float command, float dt) {
+    _rudder.step(command, dt);
+    advance(_rudder.getAngle(), dt);
+}
+
+void VesselSim::stepWithRudder(float angle, float dt) {
+    advance(angle, dt);
+}
+
+void VesselSim::advance(float rudderAngle, float dt) {
+    VesselState& s = _state;
+    const VesselConfig& c = _cfg;
+    s.time  += dt;
+    s.rudder = rudderAngle;
+
+    // Gusts: first-order Gauss-Markov on the wind speed
+    if(c.wind.gustTime > 0.f) {
+        float sigma = c.wind.gustiness * c.wind.speed;
+        _gust += -_gust * (dt / c.wind.gustTime)
+               + sigma * std::sqrt(2.f * dt / c.wind.gustTime) * _rng.gaussian();
+    }
+    s.windSpeed = std::fmax(0.f, c.wind.speed + _gust);
+    // ...and on its direction, drawn only if asked for so that the
+    // gusts of existing configurations stay the same
+    if(c.wind.gustTime > 0.f && c.wind.veer > 0.f) {
+        _veer += -_veer * (dt / c.wind.gustTime)
+               + c.wind.veer * std::sqrt(2.f * dt / c.wind.gustTime) * _rng.gaussian();
+    }
+    float shift = (c.wind.shift != 0.f && s.time >= c.wind.shiftAt) ? c.wind.shift : 0.f;
+    s.windDirection = wrap360(c.wind.direction + shift + _veer);
+
+    // Apparent wind: the air's velocity relative to the boat, forward
+    // and starboard components
+    float windAngle = (s.windDirection - s.heading) * DEG2RAD;
+    float airFwd = -s.windSpeed * std::cos(windAngle) - c.speed;
+    float airStb = -s.windSpeed * std::sin(windAngle);
+    s.apparentWind  = std::sqrt(airFwd*airFwd + airStb*airStb);
+    s.apparentAngle = std::atan2(-airStb, -airFwd) * RAD2DEG;
+    float crossWind2 = -airStb * s.apparentWind;   // Va^2 * sin(apparent angle)
+
+    // Waves
+    _waves.advance(dt, c.speed, s.heading);
+    float slope = _waves.slope();
+    float waveAngle = (c.waves.direction - s.heading) * DEG2RAD;
+    s.waveYaw = c.waveYaw * slope * std::sin(2.f * waveAngle);
+    s.windYaw = c.windYaw * crossWind2;
+
+    // Yaw
+    float delta = rudderAngle + c.weatherHelm + s.waveYaw + s.windYaw;
+    s.yawRate += (c.nomotoK * delta - s.yawRate) * (dt / c.nomotoT);
+    s.heading  = wrap360(s.heading + s.yawRate * dt);
+
+    // Roll towards the heel the moments ask for. The wind from starboard
+    // heels to port, a turn to starboard heels outward, to port.
+    float centripetal = c.speed * s.yawRate * DEG2RAD;
+    float heel = c.waveRoll * slope * std::sin(waveAngle) * RAD2DEG
+               - c.windHeel * crossWind2
+               - c.turnHeel * centripetal;
+    float wn = TWO_PI_F / c.rollPeriod;
+    float rollAccel = wn*wn * (heel - s.roll) - 2.f * c.rollDamping * wn * s.rollRate;
+    s.rollRate += rollAccel * dt;
+    s.roll     += s.rollRate * dt;
+
+    // Sway: blown to leeward
+    s.swayAccel = (-c.leeway * crossWind2 - s.sway) / c.swayTau;
+    s.sway += s.swayAccel * dt;
+}
+
+void VesselSim::trueIMU(IMUData& out) const {
+    const VesselState& s = _state;
+    float phi = s.roll * DEG2RAD;
+    float sp = std::sin(phi), cp = std::cos(phi);
+    float r = s.yawRate * DEG2RAD;   // clockwise from above, i.e. -z
+
+    // Specific force: gravity reaction through the heel, minus the
+    // lateral acceleration (to starboard) of the hull
+    float lateral = s.swayAccel + _cfg.speed * r;
+    out.ax = 0.f;
+    out.ay = G * sp - lateral * cp;
+    out.az = G * cp + lateral * sp;
+
+    out.gx = s.rollRate * DEG2RAD;
+    out.gy = -r * sp;
+    out.gz = -r * cp;
+
+    // Earth field in the level frame (forward, port, up), then heeled
+    float psi = s.heading * DEG2RAD;
+    float fwd  = _cfg.imu.fieldHorizontal * std::cos(psi);
+    float port = _cfg.imu.fieldHorizontal * std::sin(psi);
+    float up   = -_cfg.imu.fieldVertical;
+    out.mx = fwd;
+    out.my = cp * port + sp * up;
+    out.mz = -sp * port + cp * up;
+}
+
+void VesselSim::readIMU(IMUData& out) {
+    trueIMU(out);
+    const ImuNoiseConfig& n = _cfg.imu;
+    out.ax += n.accelNoise * _imuRng.gaussian();
+    out.ay += n.accelNoise * _imuRng.gaussian();
+    out.az += n.accelNoise * _imuRng.gaussian();
+    out.gx += _gyroBias[0] + n.gyroNoise * _imuRng.gaussian();
+    out.gy += _gyroBias[1] + n.gyroNoise * _imuRng.gaussian();
+    out.gz += _gyroBias[2] + n.gyroNoise * _imuRng.gaussian();
+    out.mx += n.magNoise * _imuRng.gaussian();
+    out.my += n.magNoise * _imuRng.gaussian();
+    out.mz += n.magNoise * _imuRng.gaussian();
+}
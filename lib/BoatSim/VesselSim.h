@@ -0,0 +1,185 @@
+#pragma once
+#include <cstdint>
+#include "IIMUProvider.h"
+#include "RudderPlant.h"
+#include "SimRandom.h"
+#include "WaveSpectrum.h"
+
+/** True wind with gusts. */
+struct WindConfig {
+    float speed;         // mean true wind speed [m/s]
+    float direction;     // wind comes from [deg true]
+    float gustiness;     // gust std dev relative to the mean speed
+    float gustTime;      // gust correlation time [s]
+    float veer;          // direction std dev in the gusts [deg], same correlation time
+    float shift;         // persistent shift [deg], positive veering...
+    float shiftAt;       // ...from this time on [s]
+
+    WindConfig()
+    : speed(6.f)
+    , direction(45.f)
+    , gustiness(0.15f)
+    , gustTime(15.f)
+    , veer(0.f)
+    , shift(0.f)
+    , shiftAt(0.f)
+    {}
+};
+
+/**
+ * What the IMU adds to the truth, in IMUData units, and the earth field
+ * it measures (northern Europe).
+ */
+struct ImuNoiseConfig {
+    float gyroNoise;        // std dev per sample [rad/s]
+    float gyroBias;         // std dev of the constant per-axis bias [rad/s]
+    float accelNoise;       // std dev per sample [m/s^2]
+    float magNoise;         // std dev per sample [uT]
+    float fieldHorizontal;  // towards magnetic north [uT]
+    float fieldVertical;    // downwards [uT]
+
+    ImuNoiseConfig()
+    : gyroNoise(0.001f)
+    , gyroBias(0.002f)
+    , accelNoise(0.05f)
+    , magNoise(0.3f)
+    , fieldHorizontal(17.f)
+    , fieldVertical(47.f)
+    {}
+};
+
+/**
+ * A boat to steer. Defaults describe the ~10 m sailing yacht of
+ * PassageConfig with an electric linear drive, reaching at 6 kn.
+ */
+struct VesselConfig {
+    float nomotoK;          // steady state yaw rate per rudder [1/s]
+    float nomotoT;          // yaw time constant [s]
+    float speed;            // through the water [m/s]
+    float rollPeriod;       // natural roll period [s]
+    float rollDamping;      // roll damping ratio
+    float waveYaw;          // yaw moment per wave slope, rudder equivalent [deg/rad]
+    float waveRoll;         // equilibrium roll per wave slope in beam seas [rad/rad]
+    float windYaw;          // weather helm per (m/s)^2 cross wind, rudder equivalent [deg]
+    float windHeel;         // heel per (m/s)^2 cross wind [deg]
+    float leeway;           // leeway per (m/s)^2 cross wind [m/s]
+    float swayTau;          // sway time constant [s]
+    float turnHeel;         // outward heel per centripetal acceleration [deg/(m/s^2)]
+    float weatherHelm;      // constant yaw moment, rudder equivalent [deg]
+    float initialHeading;   // [deg]
+    RudderPlantConfig rudder;
+    WaveConfig        waves;
+    WindConfig        wind;
+    ImuNoiseConfig    imu;
+    std::uint32_t     seed;
+
+    VesselConfig()
+    : nomotoK(0.3f)
+    , nomotoT(3.0f)
+    , speed(3.f)
+    , rollPeriod(4.f)
+    , rollDamping(0.1f)
+    , waveYaw(40.f)
+    , waveRoll(1.f)
+    , windYaw(0.06f)
+    , windHeel(0.2f)
+    , leeway(0.004f)
+    , swayTau(5.f)
+    , turnHeel(5.f)
+    , weatherHelm(0.f)
+    , initialHeading(90.f)
+    , seed(1)
+    {}
+};
+
+/** Truth of the simulated boat, updated by every step. */
+struct VesselState {
+    float time;            // since reset [s]
+    float heading;         // [deg true, 0..360)
+    float yawRate;         // [deg/s], positive to starboard
+    float roll;            // [deg], positive starboard side down
+    float rollRate;        // [deg/s]
+    float sway;            // [m/s], positive to starboard
+    float swayAccel;       // [m/s^2]
+    float rudder;          // [deg]
+    float waveYaw;         // wave yaw moment, rudder equivalent [deg]
+    float windYaw;         // wind yaw moment, rudder equivalent [deg]
+    float windSpeed;       // true wind with gusts [m/s]
+    float windDirection;   // true wind comes from, with veers and shift [deg]
+    float apparentWind;    // [m/s]
+    float apparentAngle;   // off the bow [deg], positive from starboard
+};
+
+/**
+ * Closed-loop plant for the autopilot on the host: the RudderPlant drive
+ * steering a boat in waves and wind, read back through a simulated IMU.
+ *
+ * Three degrees of freedom, each a low order model:
+ *   yaw   T r' + r = K (rudder + weather helm + wave + wind moments)
+ *   roll  second order at the natural roll period, driven towards the
+ *         heel the waves, the wind and the turn ask for
+ *   sway  first order leeway from the cross wind
+ * The wave yaw moment goes with sin(2 * relative wave angle), largest
+ * in quartering seas, the wave roll with sin(relative wave angle).
+ * Wind moments go with the apparent cross wind squared.
+ *
+ * readIMU() returns what an IMU mounted level at the pivot point reads,
+ * in IMUData units: x forward, y to port, z up, so a level boat reads
+ * az = +g and turning to starboard reads gz < 0. The compass heading is
+ * atan2(my, mx) when level.
+ *
+ * Everything runs from the seed; a step is a few dozen sin() calls, so
+ * an hour of sailing at 100 Hz takes a few tens of milliseconds.
+ */
+class VesselSim {
+public:
+    explicit VesselSim(const VesselConfig& cfg = VesselConfig());
+
+    // Back to the initial heading, level and not turning, same waves and
+    // gusts as a fresh instance
+    void reset();
+
+    // Advance by dt seconds with the H-bridge command in [-1..1]
+    void step(float command, float dt);
+    // Advance by dt seconds with the rudder held at angle [deg], drive bypassed
+    void stepWithRudder(float angle, float dt);
+
+    const VesselState& state() const { return _state; }
+
+    // Noise-free IMU reading
+    void trueIMU(IMUData& out) const;
+    // IMU reading with bias and noise
+    void readIMU(IMUData& out);
+
+    RudderPlant& rudder() { return _rudder; }
+    const RudderPlant& rudder() const { return _rudder; }
+    const WaveSpectrum& waves() const { return _waves; }
+    const VesselConfig& config() const { return _cfg; }
+
+private:
+    void advance(float rudderAngle, float dt);
+
+    VesselConfig _cfg;
+    RudderPlant  _rudder;
+    WaveSpectrum _waves;
+    SimRandom    _rng;            // gusts
+    SimRandom    _imuRng;
+    VesselState  _state;
+    float        _gust;           // [m/s]
+    float        _veer;           // [deg]
+    float        _gyroBias[3];    // [rad/s]
+};
+
+/** IIMUProvider on a VesselSim, for firmware code under test. */
+class SimIMUProvider : public IIMUProvider {
+public:
+    explicit SimIMUProvider(VesselSim& vessel) : _vessel(vessel) {}
+
+    bool getIMUData(IMUData& outData) override {
+        _vessel.readIMU(outData);
+        return true;
+    }
+
+private:
+    VesselSim& _vessel;
+};
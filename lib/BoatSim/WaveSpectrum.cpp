@@ -0,0 +1,85 @@
+#include "WaveSpectrum.h"
+#include <cmath>
+
+static const float G        = 9.81f;
+static const float TWO_PI_F = 6.2831853f;
+static const float DEG2RAD  = 0.017453293f;
+
+static const float LOW_CUTOFF  = 0.6f;   // band limits relative to the peak frequency
+static const float HIGH_CUTOFF = 3.0f;
+
+// JONSWAP shape without the alpha scale: Hs is set by normalizing instead
+static float jonswap(float w, float wp, float gamma) {
+    float sigma = (w <= wp) ? 0.07f : 0.09f;
+    float d = (w - wp) / (sigma * wp);
+    float r = std::exp(-0.5f * d * d);
+    float x = wp / w;
+    return std::pow(w, -5.f) * std::exp(-1.25f * x*x*x*x) * std::pow(gamma, r);
+}
+
+WaveSpectrum::WaveSpectrum(const WaveConfig& cfg, std::uint32_t seed)
+: _cfg(cfg)
+, _slopeStd(0.f)
+{
+    SimRandom rng(seed);
+    const float wp = TWO_PI_F / cfg.peakPeriod;
+    const float ratio = std::pow(HIGH_CUTOFF / LOW_CUTOFF, 1.f / COMPONENTS);
+
+    float lo = LOW_CUTOFF * wp;
+    float m0 = 0.f;
+    for(int i=0; i<COMPONENTS; i++) {
+        float hi = lo * ratio;
+        float w  = std::sqrt(lo * hi);
+        _omega[i] = w;
+        _amp[i]   = std::sqrt(2.f * jonswap(w, wp, cfg.peakEnhancement) * (hi - lo));
+        _k[i]     = w * w / G;       // deep water
+        _phase[i] = rng.uniform(0.f, TWO_PI_F);
+        m0 += 0.5f * _amp[i] * _amp[i];
+        lo = hi;
+    }
+
+    float scale = (m0 > 0.f) ? cfg.significantHeight / (4.f * std::sqrt(m0)) : 0.f;
+    float slopeVar = 0.f;
+    for(int i=0; i<COMPONENTS; i++) {
+        _amp[i] *= scale;
+        float s = _k[i] * _amp[i];
+        slopeVar += 0.5f * s * s;
+    }
+    _slopeStd = std::sqrt(slopeVar);
+}
+
+void WaveSpectrum::advance(float dt, float speed, float heading) {
+    // Waves travel away from where they come from. Heading into them
+    // (relative angle 0) meets them faster: we = w + k*U*cos(angle).
+    float speedIntoWaves = speed * std::cos((_cfg.direction - heading) * DEG2RAD);
+    for(int i=0; i<COMPONENTS; i++) {
+        float we = _omega[i] + _k[i] * speedIntoWaves;
+        _phase[i] += we * dt;
+        if(_phase[i] >= TWO_PI_F) _phase[i] -= TWO_PI_F;
+        if(_phase[i] < 0.f)       _phase[i] += TWO_PI_F;
+    }
+}
+
+float WaveSpectrum::elevation() const {
+    float sum = 0.f;
+    for(int i=0; i<COMPONENTS; i++) {
+        sum += _amp[i] * std::cos(_phase[i]);
+    }
+    return sum;
+}
+
+float WaveSpectrum::slope() const {
+    float sum = 0.f;
+    for(int i=0; i<COMPONENTS; i++) {
+        sum += _k[i] * _amp[i] * std::sin(_phase[i]);
+    }
+    return sum;
+}
+
+float WaveSpectrum::significantHeight() const {
+    float m0 = 0.f;
+    for(int i=0; i<COMPONENTS; i++) {
+        m0 += 0.5f * _amp[i] * _amp[i];
+    }
+    return 4.f * std::sqrt(m0);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include "SimRandom.h"
+
+/**
+ * Irregular sea state. Defaults are a moderate sea: 1.5 m significant
+ * height with a 6 s peak period, a fetch-limited (JONSWAP) spectrum.
+ */
+struct WaveConfig {
+    float significantHeight;  // Hs, 4 * sqrt(m0) [m]
+    float peakPeriod;         // Tp [s]
+    float peakEnhancement;    // JONSWAP gamma, 1 = Pierson-Moskowitz
+    float direction;          // waves come from [deg true]
+
+    WaveConfig()
+    : significantHeight(1.5f)
+    , peakPeriod(6.f)
+    , peakEnhancement(3.3f)
+    , direction(0.f)
+    {}
+};
+
+/**
+ * Long-crested JONSWAP sea as a sum of sinusoids.
+ *
+ * The spectrum is cut into COMPONENTS bands between 0.6 and 3 times the
+ * peak frequency. The band edges are spaced geometrically, so the sum
+ * does not repeat within any passage we simulate. Each band gets the
+ * amplitude sqrt(2 S(w) dw) and a random phase; the amplitudes are
+ * scaled so the sum has exactly the configured Hs.
+ *
+ * The phases advance at the encounter frequency, which depends on the
+ * boat's speed and heading, so advance() takes both. What the hull
+ * feels is the wave slope; slope() is the sum of k*a*sin(phase) and
+ * slopeStd() its standard deviation.
+ */
+class WaveSpectrum {
+public:
+    static constexpr int COMPONENTS = 16;
+
+    explicit WaveSpectrum(const WaveConfig& cfg = WaveConfig(), std::uint32_t seed = 1);
+
+    // Advance by dt seconds for a boat at speed [m/s] on heading [deg]
+    void advance(float dt, float speed, float heading);
+
+    // Surface elevation at the boat [m]
+    float elevation() const;
+    // Surface slope at the boat along the wave direction [rad]
+    float slope() const;
+    // Std dev of slope() [rad]
+    float slopeStd() const { return _slopeStd; }
+    // 4 * sqrt(sum of component variances) [m]
+    float significantHeight() const;
+
+    // Band i: frequency [rad/s] and amplitude [m]
+    float omega(int i) const { return _omega[i]; }
+    float amplitude(int i) const { return _amp[i]; }
+
+    const WaveConfig& config() const { return _cfg; }
+
+private:
+    WaveConfig _cfg;
+    float _omega[COMPONENTS];
+    float _amp[COMPONENTS];
+    float _k[COMPONENTS];       // wave number [rad/m]
+    float _phase[COMPONENTS];
+    float _slopeStd;
+};
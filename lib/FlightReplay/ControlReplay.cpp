@@ -0,0 +1,144 @@
+#include "ControlReplay.h"
+#include <cmath>
+#include <memory>
+#include "AutoSteeringController.h"
+#include "IMUFilterAndCalibration.h"
+#include "ReplayProviders.h"
+#include "SeaStateEstimator.h"
+
+static const float HEADING_DT = 0.1f;    // headingTask period [s]
+
+namespace {
+
+/** What one boot of the autopilot runs, fresh for every boot. */
+struct ControlStack {
+    ReplayClock             clock;
+    ReplayIMUProvider       imu;
+    IMUFilterAndCalibration filter;
+    SeaStateEstimator       seaState;
+    AutoSteeringController  steer;
+    const GainSet*          active;
+
+    ControlStack()
+    : imu(clock)
+    , filter(imu, clock)
+    , active(nullptr)
+    {}
+};
+
+void compare(ReplayDiff& d, const FlightRecord& recorded, const FlightRecord& replayed,
+             int field, float tolerance, std::uint32_t boot) {
+    // rounded as the recorder did, so an exact replay is off by 0
+    float value = FlightLog::quantize(recorded.type, field, replayed.value[field]);
+    float err = std::fabs(value - recorded.value[field]);
+    float step = 1.f / FlightLog::fieldScale(recorded.type, field);
+    d.compared++;
+    if(err > d.maxError || !(err == err)) {
+        d.maxError = err;
+    }
+    if(!(err <= tolerance * step)) {
+        if(d.mismatches == 0) {
+            d.firstMismatchMs = recorded.timeMs;
+            d.firstMismatchBoot = boot;
+        }
+        d.mismatches++;
+    }
+}
+
+} // namespace
+
+ControlReplay::ControlReplay(const GainTable& gains, float tolerance)
+: _gains(gains)
+, _tolerance(tolerance)
+{
+}
+
+ReplayResult ControlReplay::run(FlightLogReader& log) {
+    ReplayResult res = {};
+    log.rewind();
+
+    std::unique_ptr<ControlStack> s(new ControlStack());
+    std::uint32_t boot = 0;
+    std::uint32_t bootStart = 0, lastMs = 0;
+    bool started = false;
+    FlightRecord r, out;
+
+    while(log.next(r)) {
+        if(log.boot() != boot) {
+            res.recordedSeconds += (lastMs - bootStart) * 0.001;
+            s.reset(new ControlStack());
+            boot = log.boot();
+            started = false;
+        }
+        if(!started) {
+            bootStart = r.timeMs;
+            started = true;
+        }
+        lastMs = r.timeMs;
+        res.records++;
+
+        switch(r.type) {
+            case FlightRecordType::IMU:
+                s->imu.present(r);
+                s->filter.update(r.timeMs);
+                res.imuSamples++;
+                break;
+
+            case FlightRecordType::ATTITUDE: {
+                FilteredIMUData att = s->filter.getFilteredData();
+                out = r;
+                out.value[0] = att.roll;
+                out.value[1] = att.pitch;
+                out.value[2] = att.yaw;
+                out.value[3] = att.yawRate;
+                for(int i=0; i<4; i++) {
+                    compare(res.attitude, r, out, i, _tolerance, boot);
+                }
+                if(_callback) _callback(r, out, _ctx);
+                break;
+            }
+
+            case FlightRecordType::MODE:
+                s->steer.setMode((AutoSteeringMode)(int)r.value[0], r.value[1]);
+                break;
+
+            case FlightRecordType::FEEDBACK:
+                // heading, COG or wind angle from the arbiter, which also
+                // hears NMEA: taken as recorded, like the IMU
+                if(r.value[1] >= 0.f) {
+                    s->steer.setFeedback(r.value[0]);
+                }
+                break;
+
+            case FlightRecordType::STEERING: {
+                s->clock.set(r.timeMs);
+                s->seaState.addSample(s->filter.getFilteredData().yawRate, HEADING_DT);
+                const GainSet* g = _gains.select(s->seaState.getSeaState());
+                if(g && g != s->active) {
+                    s->active = g;
+                    s->steer.setGains(g->steerKp, g->steerKi, g->steerKd);
+                }
+                s->steer.update(HEADING_DT);
+                out = r;
+                out.value[0] = s->steer.getSetpoint();
+                out.value[1] = s->steer.getRudderAngle();
+                out.value[2] = s->seaState.getSeaState();
+                for(int i=0; i<3; i++) {
+                    compare(res.steering, r, out, i, _tolerance, boot);
+                }
+                res.headingSteps++;
+                if(_callback) _callback(r, out, _ctx);
+                break;
+            }
+
+            default:
+                // RUDDER: the servo loop needs the pot, which is not recorded
+                break;
+        }
+    }
+    if(started) {
+        res.recordedSeconds += (lastMs - bootStart) * 0.001;
+    }
+    res.boots = res.records ? boot + 1 : 0;
+    return res;
+}
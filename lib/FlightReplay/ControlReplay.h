@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "FlightLogReader.h"
+#include "GainTable.h"
+
+/** How far the replayed outputs are from the recorded ones, per output. */
+struct ReplayDiff {
+    std::size_t compared;
+    std::size_t mismatches;   // off by more than the tolerance
+    float       maxError;     // largest difference [unit of the output]
+    std::uint32_t firstMismatchMs;
+    std::uint32_t firstMismatchBoot;
+};
+
+/** Totals of one replay. */
+struct ReplayResult {
+    std::size_t   records;
+    std::size_t   imuSamples;
+    std::size_t   headingSteps;
+    std::uint32_t boots;
+    double        recordedSeconds;   // sum over all boots
+    ReplayDiff    attitude;          // roll, pitch, yaw, yaw rate
+    ReplayDiff    steering;          // rudder order and sea state
+};
+
+/**
+ * Re-runs the firmware's control path on a recorded log, at host speed,
+ * and diffs its outputs against the ones recorded on the boat:
+ *
+ *   IMU record      -> IMUFilterAndCalibration::update()  (imuTask)
+ *   ATTITUDE record <- compared with getFilteredData()
+ *   MODE record     -> AutoSteeringController::setMode()   (the UI)
+ *   FEEDBACK record -> AutoSteeringController::setFeedback() (the arbiter)
+ *   STEERING record -> SeaStateEstimator, GainTable, AutoSteeringController
+ *                      as in headingTask, compared with its outputs
+ *
+ * Mirrors imuTask() and headingTask() in main.cpp; keep the two in step.
+ * With the IMU resolution set on the recorder the log holds the IMU
+ * samples bit for bit, so the same code on the same log reproduces the
+ * boat's outputs exactly: each replayed output is rounded to the log's
+ * fixed point and a value counts as a mismatch when it is off by more
+ * than `tolerance` steps, 0 by default. Every boot starts over with
+ * fresh state.
+ */
+class ControlReplay {
+public:
+    // Optional per-step output, e.g. CSV for diffing two builds
+    typedef void (*StepCallback)(const FlightRecord& recorded, const FlightRecord& replayed, void* ctx);
+
+    explicit ControlReplay(const GainTable& gains, float tolerance = 0.f);
+
+    void setCallback(StepCallback cb, void* ctx) { _callback = cb; _ctx = ctx; }
+
+    ReplayResult run(FlightLogReader& log);
+
+private:
+    const GainTable& _gains;
+    float            _tolerance;
+    StepCallback     _callback = nullptr;
+    void*            _ctx = nullptr;
+};
@@ -0,0 +1,126 @@
+#include "FlightLogReader.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A block starting this much before the previous one ended is a new boot;
+// smaller steps back come from the two producer channels interleaving
+static const std::uint32_t REBOOT_MS = 1000;
+
+FlightLogReader::FlightLogReader()
+: _data(nullptr)
+, _size(0)
+, _map(nullptr)
+, _bad(0)
+, _nextBlock(0)
+, _inBlock(false)
+, _boot(0)
+, _lastMs(0)
+, _any(false)
+{
+}
+
+FlightLogReader::~FlightLogReader() {
+    close();
+}
+
+bool FlightLogReader::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if(st.st_size > 0) {
+        void* p = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        // One pass front to back
+        madvise(p, (std::size_t)st.st_size, MADV_SEQUENTIAL);
+        _map  = p;
+        _data = (const std::uint8_t*)p;
+        _size = (std::size_t)st.st_size;
+    }
+    ::close(fd);
+    index();
+    return true;
+}
+
+bool FlightLogReader::openMemory(const std::uint8_t* data, std::size_t len) {
+    close();
+    _data = data;
+    _size = len;
+    index();
+    return true;
+}
+
+void FlightLogReader::close() {
+    if(_map) {
+        munmap(_map, _size);
+        _map = nullptr;
+    }
+    _data = nullptr;
+    _size = 0;
+    _blocks.clear();
+    _bad = 0;
+    rewind();
+}
+
+void FlightLogReader::index() {
+    struct Entry {
+        std::uint32_t sequence;
+        std::size_t   offset;
+    };
+    std::vector<Entry> found;
+    FlightLogDecoder check;
+    for(std::size_t off=0; off + FlightLog::BLOCK_SIZE <= _size; off += FlightLog::BLOCK_SIZE) {
+        if(check.open(_data + off, FlightLog::BLOCK_SIZE)) {
+            found.push_back({ check.sequence(), off });
+        } else if(_data[off] != 0xFF) {
+            _bad++;
+        }
+    }
+    // Sequence numbers may wrap; the ring holds far fewer than 2^31 blocks
+    std::sort(found.begin(), found.end(), [](const Entry& a, const Entry& b) {
+        return (std::int32_t)(a.sequence - b.sequence) < 0;
+    });
+    _blocks.reserve(found.size());
+    for(const Entry& e : found) {
+        _blocks.push_back(e.offset);
+    }
+    rewind();
+}
+
+void FlightLogReader::rewind() {
+    _nextBlock = 0;
+    _inBlock = false;
+    _boot = 0;
+    _lastMs = 0;
+    _any = false;
+}
+
+bool FlightLogReader::next(FlightRecord& out) {
+    for(;;) {
+        if(_inBlock && _decoder.next(out)) {
+            if(_any && out.timeMs + REBOOT_MS < _lastMs) {
+                _boot++;
+            }
+            _any = true;
+            _lastMs = out.timeMs;
+            return true;
+        }
+        if(_nextBlock >= _blocks.size()) {
+            _inBlock = false;
+            return false;
+        }
+        _inBlock = _decoder.open(_data + _blocks[_nextBlock++], FlightLog::BLOCK_SIZE);
+    }
+}
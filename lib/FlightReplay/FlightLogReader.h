@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FlightLog.h"
+
+/**
+ * A flight recorder file (see FlightRecorder) memory-mapped on the host,
+ * read back record by record in recording order: the valid blocks sorted
+ * by sequence number, erased and corrupt ones skipped.
+ *
+ * Times restart from zero on every boot of the autopilot; boot() counts
+ * the restarts seen so far, so a replay can start over with fresh state.
+ */
+class FlightLogReader {
+public:
+    FlightLogReader();
+    ~FlightLogReader();
+
+    FlightLogReader(const FlightLogReader&) = delete;
+    FlightLogReader& operator=(const FlightLogReader&) = delete;
+
+    // Map a file read-only, false if it cannot be opened
+    bool open(const char* path);
+    // Read from memory the caller keeps alive, e.g. in tests
+    bool openMemory(const std::uint8_t* data, std::size_t len);
+    void close();
+
+    // Back to the first record
+    void rewind();
+
+    // Next record in recording order, false at the end
+    bool next(FlightRecord& out);
+
+    // Restarts of the autopilot before the last record returned
+    std::uint32_t boot() const { return _boot; }
+
+    std::size_t blockCount() const { return _blocks.size(); }
+    std::size_t badBlocks() const { return _bad; }
+    std::size_t bytes() const { return _size; }
+
+private:
+    void index();
+
+    const std::uint8_t* _data;
+    std::size_t         _size;
+    void*               _map;        // mmap()ed region, if any
+    std::vector<std::size_t> _blocks;   // offsets in recording order
+    std::size_t         _bad;
+    std::size_t         _nextBlock;
+    FlightLogDecoder    _decoder;
+    bool                _inBlock;
+    std::uint32_t       _boot;
+    std::uint32_t       _lastMs;
+    bool                _any;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include "FlightLog.h"
+#include "IIMUProvider.h"
+#include "ITimeProvider.h"
+
+/**
+ * The clock of a replay: the original timestamp of the record being
+ * replayed, so code under test sees the same dt as on the boat.
+ */
+class ReplayClock : public ITimeProvider {
+public:
+    void set(std::uint32_t timeMs) { _ms = timeMs; }
+
+    std::uint64_t getMillis() const override { return _ms; }
+
+private:
+    std::uint32_t _ms = 0;
+};
+
+/**
+ * IIMUProvider serving recorded IMU samples: present() hands it the next
+ * IMU record of the log (and sets the clock to its time), the following
+ * getIMUData() returns it, once, as the sensor driver would.
+ */
+class ReplayIMUProvider : public IIMUProvider {
+public:
+    explicit ReplayIMUProvider(ReplayClock& clock) : _clock(clock) {}
+
+    void present(const FlightRecord& imu) {
+        _sample.ax = imu.value[0];
+        _sample.ay = imu.value[1];
+        _sample.az = imu.value[2];
+        _sample.gx = imu.value[3];
+        _sample.gy = imu.value[4];
+        _sample.gz = imu.value[5];
+        _sample.mx = imu.value[6];
+        _sample.my = imu.value[7];
+        _sample.mz = imu.value[8];
+        _clock.set(imu.timeMs);
+        _fresh = true;
+    }
+
+    bool getIMUData(IMUData& outData) override {
+        if(!_fresh) {
+            return false;
+        }
+        outData = _sample;
+        _fresh = false;
+        return true;
+    }
+
+private:
+    ReplayClock& _clock;
+    IMUData      _sample;
+    bool         _fresh = false;
+};
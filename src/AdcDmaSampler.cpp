@@ -0,0 +1,151 @@
+#include "AdcDmaSampler.h"
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+// TYPE2 output: 4 bytes per conversion
+static const uint32_t BYTES_PER_SAMPLE = sizeof(adc_digi_output_data_t);
+
+AdcDmaSampler::AdcDmaSampler(int pin, RudderAngleSensor& sensor,
+                             int currentPin, MotorCurrentSensor* current)
+ : _pin(pin),
+   _channel(-1),
+   _sensor(sensor),
+   _currentPin(currentPin),
+   _currentChannel(-1),
+   _current(current),
+   _overflows(0),
+   _task(nullptr)
+{
+}
+
+bool AdcDmaSampler::begin(uint32_t sampleRate, int core)
+{
+    // ADC2 is shared with WiFi and has no DMA mode on the S3
+    _channel=digitalPinToAnalogChannel(_pin);
+    if(_channel<0 || _channel>=SOC_ADC_CHANNEL_NUM(0)) {
+        Serial.println("[ADC] Rudder pot is not on ADC1.");
+        return false;
+    }
+    if(_current && _currentPin>=0) {
+        _currentChannel=digitalPinToAnalogChannel(_currentPin);
+        if(_currentChannel<0 || _currentChannel>=SOC_ADC_CHANNEL_NUM(0)) {
+            Serial.println("[ADC] Current sense is not on ADC1.");
+            return false;
+        }
+    }
+    uint32_t channels=(_currentChannel>=0) ? 2 : 1;
+
+    adc_digi_init_config_t init;
+    memset(&init, 0, sizeof(init));
+    init.max_store_buf_size=4*FRAME_SAMPLES*BYTES_PER_SAMPLE;
+    init.conv_num_each_intr=FRAME_SAMPLES*BYTES_PER_SAMPLE;
+    init.adc1_chan_mask=BIT(_channel);
+    if(_currentChannel>=0) {
+        init.adc1_chan_mask|=BIT(_currentChannel);
+    }
+    init.adc2_chan_mask=0;
+    if(adc_digi_initialize(&init)!=ESP_OK) {
+        Serial.println("[ADC] DMA init failed.");
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern[2];
+    memset(pattern, 0, sizeof(pattern));
+    const int channel[2]={ _channel, _currentChannel };
+    for(uint32_t i=0; i<channels; i++) {
+        pattern[i].atten=ADC_ATTEN_DB_11;
+        pattern[i].channel=channel[i];
+        pattern[i].unit=0;   // ADC1
+        pattern[i].bit_width=SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_digi_configuration_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.conv_limit_en=false;
+    cfg.pattern_num=channels;
+    cfg.adc_pattern=pattern;
+    cfg.sample_freq_hz=sampleRate;
+    cfg.conv_mode=ADC_CONV_SINGLE_UNIT_1;
+    cfg.format=ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if(adc_digi_controller_configure(&cfg)!=ESP_OK) {
+        adc_digi_deinitialize();
+        Serial.println("[ADC] DMA configure failed.");
+        return false;
+    }
+
+    // Just below the servo task, on the same core so frames and servo
+    // cycles interleave instead of racing
+    if(xTaskCreatePinnedToCore(taskEntry, "adc_dma", 4096, this,
+                               configMAX_PRIORITIES-2, &_task, core)!=pdPASS) {
+        adc_digi_deinitialize();
+        return false;
+    }
+    adc_digi_start();
+
+    Serial.printf("[ADC] Rudder pot on ADC1 ch %d, current on ch %d, %u Hz.\n",
+                  _channel, _currentChannel, (unsigned)sampleRate);
+    return true;
+}
+
+void AdcDmaSampler::applyFactoryCalibration(float minAngle, float maxAngle)
+{
+    esp_adc_cal_characteristics_t chars;
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &chars);
+
+    // Millivolts are linear in pot position; map them onto the angle
+    // range between the readings at both ends
+    float mvLow=esp_adc_cal_raw_to_voltage(0, &chars);
+    float mvHigh=esp_adc_cal_raw_to_voltage(4095, &chars);
+    AdcLinearizer& lin=_sensor.linearizer();
+    for(int i=0; i<AdcLinearizer::KNOTS; i++) {
+        float mv=esp_adc_cal_raw_to_voltage(uint32_t(AdcLinearizer::knotCounts(i)), &chars);
+        float fraction=(mv-mvLow)/(mvHigh-mvLow);
+        lin.setKnot(i, minAngle+fraction*(maxAngle-minAngle));
+    }
+}
+
+uint32_t AdcDmaSampler::getOverflows() const
+{
+    return _overflows;
+}
+
+void AdcDmaSampler::taskEntry(void* arg)
+{
+    static_cast<AdcDmaSampler*>(arg)->taskLoop();
+}
+
+void AdcDmaSampler::taskLoop()
+{
+    static uint8_t  frame[FRAME_SAMPLES*BYTES_PER_SAMPLE];
+    static uint16_t samples[FRAME_SAMPLES];
+    static uint16_t currents[FRAME_SAMPLES];
+
+    for(;;) {
+        uint32_t length=0;
+        esp_err_t err=adc_digi_read_bytes(frame, sizeof(frame), &length, ADC_MAX_DELAY);
+        if(err==ESP_ERR_INVALID_STATE) {
+            // driver buffer ran full, the data is still good
+            _overflows++;
+        } else if(err!=ESP_OK) {
+            continue;
+        }
+
+        size_t n=0, nc=0;
+        for(uint32_t i=0; i+BYTES_PER_SAMPLE<=length; i+=BYTES_PER_SAMPLE) {
+            const adc_digi_output_data_t* d=(const adc_digi_output_data_t*)&frame[i];
+            if(d->type2.unit!=0) {
+                continue;
+            }
+            if(d->type2.channel==(uint32_t)_channel) {
+                samples[n++]=d->type2.data;
+            } else if(d->type2.channel==(uint32_t)_currentChannel) {
+                currents[nc++]=d->type2.data;
+            }
+        }
+        // current first, protection cares more about latency
+        if(_current && nc>0) {
+            _current->addSamples(currents, nc);
+        }
+        _sensor.addSamples(samples, n);
+    }
+}
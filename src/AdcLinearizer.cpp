@@ -0,0 +1,54 @@
+#include "AdcLinearizer.h"
+
+static const float ADC_FULL_SCALE = float((1 << AdcLinearizer::ADC_BITS) - 1);
+
+AdcLinearizer::AdcLinearizer(float minValue, float maxValue)
+{
+    setLinear(minValue, maxValue);
+}
+
+void AdcLinearizer::setLinear(float minValue, float maxValue)
+{
+    for(int i=0; i<KNOTS; i++) {
+        _knot[i]=minValue+(maxValue-minValue)*knotCounts(i)/ADC_FULL_SCALE;
+    }
+    for(int s=0; s<SEGMENTS; s++) {
+        updateSlope(s);
+    }
+}
+
+float AdcLinearizer::knotCounts(int i)
+{
+    // The last knot sits on full scale (4095), not one past it
+    float counts=float(i*SEGMENT_SPAN);
+    return (counts>ADC_FULL_SCALE) ? ADC_FULL_SCALE : counts;
+}
+
+void AdcLinearizer::setKnot(int i, float value)
+{
+    if(i<0 || i>=KNOTS) {
+        return;
+    }
+    _knot[i]=value;
+    if(i>0) updateSlope(i-1);
+    if(i<SEGMENTS) updateSlope(i);
+}
+
+float AdcLinearizer::getKnot(int i) const
+{
+    return (i>=0 && i<KNOTS) ? _knot[i] : 0.0f;
+}
+
+void AdcLinearizer::updateSlope(int s)
+{
+    _slope[s]=(_knot[s+1]-_knot[s])/(knotCounts(s+1)-knotCounts(s));
+}
+
+float AdcLinearizer::apply(float counts) const
+{
+    if(counts<0.0f) counts=0.0f;
+    if(counts>ADC_FULL_SCALE) counts=ADC_FULL_SCALE;
+    int s=int(counts)>>(ADC_BITS-SEGMENT_BITS);
+    if(s>=SEGMENTS) s=SEGMENTS-1;
+    return _knot[s]+_slope[s]*(counts-float(s*SEGMENT_SPAN));
+}
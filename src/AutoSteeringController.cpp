@@ -1,24 +1,47 @@
 #include "AutoSteeringController.h"
 #include <cmath>
 
+constexpr float AutoSteeringController::FEEDBACK_TIMEOUT_S;
+
 AutoSteeringController::AutoSteeringController()
-: _mode(AutoSteeringMode::OFF)
+: _appliedVersion(0)
+, _mode(AutoSteeringMode::OFF)
 , _desiredHeading(0.f)
 , _desiredCourse(0.f)
 , _desiredWindAngle(0.f)
 , _rudderAngle(0.f)
+, _measured(0.f)
+, _feedbackAge(FEEDBACK_TIMEOUT_S + 1.f)
 , _kP(1.f)
 , _kI(0.f)
 , _kD(0.f)
 , _integral(0.f)
 , _lastError(0.f)
+, _firstStep(true)
 {
 }
 
 void AutoSteeringController::setMode(AutoSteeringMode mode, float param) {
+    _commandBox.write(SteeringCommand{mode, param});
+}
+
+void AutoSteeringController::applyCommand() {
+    // A write racing with this read only makes the next update() apply
+    // the same command again
+    std::uint32_t version = _commandBox.version();
+    if(version == _appliedVersion) {
+        return;
+    }
+    SteeringCommand cmd;
+    _commandBox.read(cmd);
+    _appliedVersion = version;
+
+    AutoSteeringMode mode = cmd.mode;
+    float param = cmd.param;
     _mode = mode;
     _integral = 0.f;
     _lastError= 0.f;
+    _firstStep= true;
     switch(mode) {
         case AutoSteeringMode::OFF:
             break;
@@ -34,47 +57,85 @@ void AutoSteeringController::setMode(AutoSteeringMode mode, float param) {
     }
 }
 
+void AutoSteeringController::setFeedback(float measured) {
+    _measured = measured;
+    _feedbackAge = 0.f;
+}
+
+void AutoSteeringController::setGains(float kP, float kI, float kD) {
+    _kP = kP;
+    _kI = kI;
+    _kD = kD;
+}
+
 void AutoSteeringController::update(float dt) {
+    applyCommand();
     computeSteering(dt);
+    if(_feedbackAge <= FEEDBACK_TIMEOUT_S) _feedbackAge += dt;
 }
 
 float AutoSteeringController::getRudderAngle() const {
     return _rudderAngle;
 }
 
+AutoSteeringMode AutoSteeringController::getMode() const {
+    return _mode;
+}
+
+float AutoSteeringController::getSetpoint() const {
+    switch(_mode) {
+        case AutoSteeringMode::TRACK_HEADING:    return _desiredHeading;
+        case AutoSteeringMode::TRACK_COURSE:     return _desiredCourse;
+        case AutoSteeringMode::TRACK_WIND_ANGLE: return _desiredWindAngle;
+        default:                                 return 0.f;
+    }
+}
+
 void AutoSteeringController::computeSteering(float dt) {
     if(_mode == AutoSteeringMode::OFF) {
         _rudderAngle = 0.f;
         return;
     }
+    if(!hasFeedback()) {
+        // start over like after a mode change once it is back
+        _rudderAngle = 0.f;
+        _integral = 0.f;
+        _firstStep = true;
+        return;
+    }
 
-    // placeholder for heading logic
     float error = 0.f;
     switch(_mode) {
         case AutoSteeringMode::TRACK_HEADING:
-            // Suppose we have an external function that gives us the actual heading?
-            // We might pass it in. For demonstration, assume "actualHeading=somewhere"
-            // We'll just do a placeholder:
-            error = _desiredHeading - 0.f; // TOTALLY FAKE
+            error = _desiredHeading - _measured;
             break;
         case AutoSteeringMode::TRACK_COURSE:
-            error = _desiredCourse - 0.f; 
+            error = _desiredCourse - _measured;
             break;
         case AutoSteeringMode::TRACK_WIND_ANGLE:
-            error = _desiredWindAngle - 0.f; 
+            // bearing away to starboard brings a starboard wind forward:
+            // the angle goes the other way from the heading
+            error = _measured - _desiredWindAngle;
             break;
         default:
             _rudderAngle=0.f;
             return;
     }
+    // shortest way round
+    while(error > 180.f)   error -= 360.f;
+    while(error <= -180.f) error += 360.f;
 
     _integral += error*dt;
-    float derivative = (error - _lastError)/dt;
+    // no derivative kick on the first step after a mode change
+    float derivative = _firstStep ? 0.f : (error - _lastError)/dt;
+    _firstStep = false;
     float output = _kP*error + _kI*_integral + _kD*derivative;
     _lastError=error;
 
-    // clamp e.g. [-30..30] deg
-    if(output>30.f) output=30.f;
-    if(output<-30.f)output=-30.f;
+    // clamp e.g. [-30..30] deg, and stop integrating while saturated
+    if(output>30.f || output<-30.f) {
+        if(error*output > 0.f) _integral -= error*dt;
+        output = (output>0.f) ? 30.f : -30.f;
+    }
     _rudderAngle = output;
 }
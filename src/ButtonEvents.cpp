@@ -0,0 +1,61 @@
+#include "ButtonEvents.h"
+
+ButtonEvents::ButtonEvents()
+: _debounceMs(20)
+, _longPressMs(700)
+, _repeatMs(150)
+, _raw(0)
+, _stable(0)
+{
+    for(int i=0; i<BUTTON_COUNT; i++) {
+        _changedMs[i] = 0;
+        _dueMs[i] = 0;
+        _long[i] = false;
+    }
+}
+
+void ButtonEvents::setTiming(std::uint32_t debounceMs, std::uint32_t longPressMs, std::uint32_t repeatMs) {
+    _debounceMs = debounceMs;
+    _longPressMs = longPressMs;
+    _repeatMs = repeatMs > 0 ? repeatMs : 1;
+}
+
+void ButtonEvents::push(int button, ButtonEventType type, std::uint32_t nowMs) {
+    ButtonEvent e = { (ButtonId)button, type, nowMs };
+    _queue.push(e);
+}
+
+void ButtonEvents::sample(std::uint32_t pressed, std::uint32_t nowMs) {
+    pressed &= (1u << BUTTON_COUNT) - 1;
+    std::uint32_t raw = _raw;
+    std::uint32_t stable = _stable;
+    for(int i=0; i<BUTTON_COUNT; i++) {
+        std::uint32_t bit = 1u << i;
+        if((pressed ^ raw) & bit) {
+            _changedMs[i] = nowMs;
+        }
+        if(((pressed ^ stable) & bit) && nowMs - _changedMs[i] >= _debounceMs) {
+            stable ^= bit;
+            if(stable & bit) {
+                _dueMs[i] = nowMs + _longPressMs;
+                _long[i] = false;
+                push(i, ButtonEventType::PRESS, nowMs);
+            } else {
+                push(i, ButtonEventType::RELEASE, nowMs);
+            }
+            continue;
+        }
+        // held: due times wrap with the clock like everything else
+        if((stable & bit) && (std::int32_t)(nowMs - _dueMs[i]) >= 0) {
+            push(i, _long[i] ? ButtonEventType::REPEAT : ButtonEventType::LONG_PRESS, nowMs);
+            _long[i] = true;
+            _dueMs[i] += _repeatMs;
+            // a late sample does not burst the repeats it missed
+            if((std::int32_t)(nowMs - _dueMs[i]) >= 0) {
+                _dueMs[i] = nowMs + _repeatMs;
+            }
+        }
+    }
+    _raw = pressed;
+    _stable = stable;
+}
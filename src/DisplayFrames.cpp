@@ -0,0 +1,111 @@
+#include "DisplayFrames.h"
+#include <cstring>
+
+DisplayFrames::DisplayFrames()
+: _recording(-1)
+, _sending(-1)
+, _sequence(0)
+, _sent(0)
+, _stalls(0)
+, _truncated(0)
+{
+    for(int i=0; i<2; i++) {
+        _state[i].store(FREE, std::memory_order_relaxed);
+        _frames[i].segmentCount = 0;
+        _frames[i].size = 0;
+        _frames[i].sequence = 0;
+        _frames[i].timeUs = 0;
+        _frames[i].truncated = false;
+    }
+}
+
+bool DisplayFrames::beginFrame() {
+    if(_recording >= 0) {
+        return true;
+    }
+    for(int i=0; i<2; i++) {
+        if(_state[i].load(std::memory_order_acquire) == FREE) {
+            DisplayFrame& f = _frames[i];
+            f.segmentCount = 0;
+            f.size = 0;
+            f.truncated = false;
+            _state[i].store(RECORDING, std::memory_order_relaxed);
+            _recording = i;
+            return true;
+        }
+    }
+    _stalls.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void DisplayFrames::write(bool data, const std::uint8_t* bytes, std::size_t n) {
+    if(_recording < 0 || n == 0) {
+        return;
+    }
+    DisplayFrame& f = _frames[_recording];
+    DisplaySegment* last = f.segmentCount ? &f.segments[f.segmentCount - 1] : nullptr;
+    bool append = last && last->data == data && last->offset + last->length == f.size;
+    std::size_t at = append ? f.size : (f.size + 3) & ~(std::size_t)3;
+    if(!append && f.segmentCount >= DisplayFrame::MAX_SEGMENTS) {
+        f.truncated = true;
+        return;
+    }
+    if(at + n > DisplayFrame::CAPACITY) {
+        f.truncated = true;
+        if(at >= DisplayFrame::CAPACITY) return;
+        n = DisplayFrame::CAPACITY - at;
+    }
+    std::memcpy(f.bytes + at, bytes, n);
+    if(append) {
+        last->length = (std::uint16_t)(last->length + n);
+    } else {
+        DisplaySegment s = { (std::uint16_t)at, (std::uint16_t)n, data };
+        f.segments[f.segmentCount++] = s;
+    }
+    f.size = at + n;
+}
+
+void DisplayFrames::commit(std::uint32_t timeUs) {
+    if(_recording < 0) {
+        return;
+    }
+    DisplayFrame& f = _frames[_recording];
+    f.sequence = ++_sequence;
+    f.timeUs = timeUs;
+    if(f.truncated) {
+        _truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    _state[_recording].store(QUEUED, std::memory_order_release);
+    _recording = -1;
+}
+
+const DisplayFrame* DisplayFrames::next() {
+    if(_sending >= 0) {
+        return &_frames[_sending];
+    }
+    // Frames go out in commit order. Looking for the oldest queued one
+    // could race with the producer committing one frame after it was
+    // looked at and then another, so look for the one after the last sent.
+    int pick = -1;
+    for(int i=0; i<2; i++) {
+        if(_state[i].load(std::memory_order_acquire) == QUEUED
+           && _frames[i].sequence == _sent + 1) {
+            pick = i;
+        }
+    }
+    if(pick < 0) {
+        return nullptr;
+    }
+    _sent = _frames[pick].sequence;
+    _state[pick].store(SENDING, std::memory_order_relaxed);
+    _sending = pick;
+    return &_frames[pick];
+}
+
+void DisplayFrames::release() {
+    if(_sending < 0) {
+        return;
+    }
+    _state[_sending].store(FREE, std::memory_order_release);
+    _sending = -1;
+}
@@ -0,0 +1,358 @@
+#include "FlightLog.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct TypeInfo {
+    const char* name;
+    int         count;
+    float       scale[FlightRecord::MAX_FIELDS];
+    const char* field[FlightRecord::MAX_FIELDS];
+};
+
+// Indexed by FlightRecordType. Scales: 1 mm/s^2, 0.1 mrad/s, 0.01 uT,
+// 0.01 deg, 0.001 of full drive, 10 mA
+const TypeInfo TYPES[FlightLog::TYPE_SLOTS] = {
+    { "", 0, {}, {} },
+    { "imu", 9,
+      { 1000.f, 1000.f, 1000.f, 10000.f, 10000.f, 10000.f, 100.f, 100.f, 100.f },
+      { "ax", "ay", "az", "gx", "gy", "gz", "mx", "my", "mz" } },
+    { "attitude", 4,
+      { 100.f, 100.f, 100.f, 100.f },
+      { "roll", "pitch", "yaw", "yaw_rate" } },
+    { "steering", 3,
+      { 100.f, 100.f, 100.f },
+      { "setpoint", "rudder_order", "sea_state" } },
+    { "rudder", 5,
+      { 100.f, 100.f, 1000.f, 100.f, 1.f },
+      { "target", "angle", "command", "current", "fault" } },
+    { "mode", 2,
+      { 1.f, 100.f },
+      { "mode", "setpoint" } },
+    { "feedback", 3,
+      { 100.f, 1.f, 1000.f },
+      { "value", "source", "quality" } },
+};
+
+const TypeInfo* info(FlightRecordType type) {
+    int t = (int)type;
+    if(t <= 0 || t >= FlightLog::TYPE_SLOTS) {
+        return nullptr;
+    }
+    return &TYPES[t];
+}
+
+void putU32(std::uint8_t* p, std::uint32_t v) {
+    p[0] = (std::uint8_t)v;
+    p[1] = (std::uint8_t)(v >> 8);
+    p[2] = (std::uint8_t)(v >> 16);
+    p[3] = (std::uint8_t)(v >> 24);
+}
+
+std::uint32_t getU32(const std::uint8_t* p) {
+    return (std::uint32_t)p[0] | ((std::uint32_t)p[1] << 8) |
+           ((std::uint32_t)p[2] << 16) | ((std::uint32_t)p[3] << 24);
+}
+
+std::uint16_t getU16(const std::uint8_t* p) {
+    return (std::uint16_t)(p[0] | (p[1] << 8));
+}
+
+void putFloat(std::uint8_t* p, float v) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    putU32(p, bits);
+}
+
+float getFloat(const std::uint8_t* p) {
+    std::uint32_t bits = getU32(p);
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Header layout
+const std::size_t OFF_SEQUENCE = 4;
+const std::size_t OFF_START    = 8;
+const std::size_t OFF_IMU_RES  = 12;    // 3 x float
+const std::size_t OFF_PAYLOAD  = 24;
+const std::size_t OFF_CRC      = 26;
+
+// Header after the magic (less the CRC itself), then the payload
+std::uint16_t blockCrc(const std::uint8_t* block, std::size_t payload) {
+    std::uint16_t crc = FlightLog::crc16(block + OFF_SEQUENCE, OFF_CRC - OFF_SEQUENCE);
+    return FlightLog::crc16(block + FlightLog::HEADER_SIZE, payload, crc);
+}
+
+// IMU fields in sensor counts when the block has a resolution for them
+float imuResolution(FlightRecordType type, int i, const float res[3]) {
+    return (type == FlightRecordType::IMU && res[i / 3] > 0.f) ? res[i / 3] : 0.f;
+}
+
+std::int32_t floatBits(float v) {
+    std::int32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(std::int32_t bits) {
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Saturating, so a wild value is clipped rather than wrapped
+std::int32_t saturate(float f) {
+    if(!(f == f)) return 0;    // NaN
+    if(f >  2.0e9f) return  2000000000;
+    if(f < -2.0e9f) return -2000000000;
+    return (std::int32_t)std::lround(f);
+}
+
+std::int32_t toFixed(float v, float scale) {
+    return saturate(v * scale);
+}
+
+// True unless an IMU record with a resolution has a value that is not
+// counts * LSB, which then goes as float bits to stay lossless
+bool isWholeCounts(const FlightRecord& r, const float res[3]) {
+    for(int i=0; i<FlightRecord::MAX_FIELDS; i++) {
+        float step = imuResolution(r.type, i, res);
+        if(step > 0.f && (float)saturate(r.value[i] / step) * step != r.value[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int FlightLog::fieldCount(FlightRecordType type) {
+    const TypeInfo* t = info(type);
+    return t ? t->count : 0;
+}
+
+float FlightLog::fieldScale(FlightRecordType type, int i) {
+    const TypeInfo* t = info(type);
+    return (t && i >= 0 && i < t->count) ? t->scale[i] : 1.f;
+}
+
+float FlightLog::quantize(FlightRecordType type, int i, float v) {
+    float scale = fieldScale(type, i);
+    return toFixed(v, scale) / scale;
+}
+
+const char* FlightLog::typeName(FlightRecordType type) {
+    const TypeInfo* t = info(type);
+    return t ? t->name : "unknown";
+}
+
+const char* FlightLog::fieldName(FlightRecordType type, int i) {
+    const TypeInfo* t = info(type);
+    return (t && i >= 0 && i < t->count) ? t->field[i] : "";
+}
+
+std::uint16_t FlightLog::crc16(const std::uint8_t* data, std::size_t len, std::uint16_t crc) {
+    for(std::size_t i=0; i<len; i++) {
+        crc ^= (std::uint16_t)(data[i] << 8);
+        for(int b=0; b<8; b++) {
+            crc = (crc & 0x8000) ? (std::uint16_t)((crc << 1) ^ 0x1021) : (std::uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool FlightLog::readHeader(const std::uint8_t* block, std::uint32_t& sequence, std::uint32_t& startMs) {
+    if(getU32(block) != MAGIC) {
+        return false;
+    }
+    std::uint16_t payload = getU16(block + OFF_PAYLOAD);
+    if(payload > BLOCK_SIZE - HEADER_SIZE) {
+        return false;
+    }
+    sequence = getU32(block + OFF_SEQUENCE);
+    startMs  = getU32(block + OFF_START);
+    return true;
+}
+
+// ---- Encoder ----
+
+FlightLogEncoder::FlightLogEncoder()
+{
+    setImuResolution(0.f, 0.f, 0.f);
+    begin(0, 0);
+}
+
+void FlightLogEncoder::setImuResolution(float accel, float gyro, float mag) {
+    _imuRes[0] = accel;
+    _imuRes[1] = gyro;
+    _imuRes[2] = mag;
+}
+
+void FlightLogEncoder::begin(std::uint32_t sequence, std::uint32_t startMs) {
+    _used     = FlightLog::HEADER_SIZE;
+    _sequence = sequence;
+    _startMs  = startMs;
+    _lastMs   = startMs;
+    for(int i=0; i<3; i++) {
+        _blockRes[i] = _imuRes[i];
+    }
+    std::memset(_prev, 0, sizeof(_prev));
+}
+
+void FlightLogEncoder::putVarint(std::uint32_t v) {
+    while(v >= 0x80) {
+        _block[_used++] = (std::uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    _block[_used++] = (std::uint8_t)v;
+}
+
+void FlightLogEncoder::putSigned(std::int32_t v) {
+    // zigzag: small magnitudes of either sign stay short
+    putVarint(((std::uint32_t)v << 1) ^ (std::uint32_t)(v >> 31));
+}
+
+bool FlightLogEncoder::append(const FlightRecord& r) {
+    const TypeInfo* t = info(r.type);
+    if(!t || _used + FlightLog::MAX_RECORD > FlightLog::BLOCK_SIZE) {
+        return false;
+    }
+    bool raw = !isWholeCounts(r, _blockRes);
+    _block[_used++] = (std::uint8_t)((std::uint8_t)r.type | (raw ? FlightLog::RAW_FLAG : 0));
+    // producers on two cores: time may step back a little
+    putSigned((std::int32_t)(r.timeMs - _lastMs));
+    _lastMs = r.timeMs;
+    std::int32_t* prev = _prev[raw ? 0 : (int)r.type];
+    for(int i=0; i<t->count; i++) {
+        float res = imuResolution(r.type, i, _blockRes);
+        std::int32_t q = raw ? floatBits(r.value[i])
+                       : res > 0.f ? saturate(r.value[i] / res) : toFixed(r.value[i], t->scale[i]);
+        putSigned((std::int32_t)((std::uint32_t)q - (std::uint32_t)prev[i]));
+        prev[i] = q;
+    }
+    return true;
+}
+
+const std::uint8_t* FlightLogEncoder::finish() {
+    std::size_t payload = _used - FlightLog::HEADER_SIZE;
+    putU32(_block, FlightLog::MAGIC);
+    putU32(_block + OFF_SEQUENCE, _sequence);
+    putU32(_block + OFF_START, _startMs);
+    for(int i=0; i<3; i++) {
+        putFloat(_block + OFF_IMU_RES + 4 * i, _blockRes[i]);
+    }
+    _block[OFF_PAYLOAD]     = (std::uint8_t)payload;
+    _block[OFF_PAYLOAD + 1] = (std::uint8_t)(payload >> 8);
+    std::uint16_t crc = blockCrc(_block, payload);
+    _block[OFF_CRC]     = (std::uint8_t)crc;
+    _block[OFF_CRC + 1] = (std::uint8_t)(crc >> 8);
+    // as erased flash
+    std::memset(_block + _used, 0xFF, FlightLog::BLOCK_SIZE - _used);
+    return _block;
+}
+
+// ---- Decoder ----
+
+FlightLogDecoder::FlightLogDecoder()
+: _data(nullptr)
+, _pos(0)
+, _end(0)
+, _sequence(0)
+, _startMs(0)
+, _lastMs(0)
+{
+    for(int i=0; i<3; i++) {
+        _imuRes[i] = 0.f;
+    }
+    std::memset(_prev, 0, sizeof(_prev));
+}
+
+bool FlightLogDecoder::open(const std::uint8_t* block, std::size_t len) {
+    _data = nullptr;
+    _pos = _end = 0;
+    std::uint32_t seq, start;
+    if(len < FlightLog::HEADER_SIZE || !FlightLog::readHeader(block, seq, start)) {
+        return false;
+    }
+    std::size_t payload = getU16(block + OFF_PAYLOAD);
+    if(FlightLog::HEADER_SIZE + payload > len || blockCrc(block, payload) != getU16(block + OFF_CRC)) {
+        return false;
+    }
+    for(int i=0; i<3; i++) {
+        _imuRes[i] = getFloat(block + OFF_IMU_RES + 4 * i);
+    }
+    _data     = block;
+    _pos      = FlightLog::HEADER_SIZE;
+    _end      = FlightLog::HEADER_SIZE + payload;
+    _sequence = seq;
+    _startMs  = start;
+    _lastMs   = start;
+    std::memset(_prev, 0, sizeof(_prev));
+    return true;
+}
+
+bool FlightLogDecoder::getVarint(std::uint32_t& v) {
+    v = 0;
+    for(int shift=0; shift<35; shift+=7) {
+        if(_pos >= _end) {
+            return false;
+        }
+        std::uint8_t b = _data[_pos++];
+        v |= (std::uint32_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FlightLogDecoder::getSigned(std::int32_t& v) {
+    std::uint32_t z;
+    if(!getVarint(z)) {
+        return false;
+    }
+    v = (std::int32_t)((z >> 1) ^ (0u - (z & 1)));
+    return true;
+}
+
+bool FlightLogDecoder::next(FlightRecord& out) {
+    if(!_data || _pos >= _end) {
+        return false;
+    }
+    std::uint8_t code = _data[_pos++];
+    bool raw = (code & FlightLog::RAW_FLAG) != 0;
+    FlightRecordType type = (FlightRecordType)(code & ~FlightLog::RAW_FLAG);
+    const TypeInfo* t = info(type);
+    std::int32_t dt;
+    if(!t || (raw && type != FlightRecordType::IMU) || !getSigned(dt)) {
+        _pos = _end;
+        return false;
+    }
+    _lastMs += (std::uint32_t)dt;
+    out.type = type;
+    out.timeMs = _lastMs;
+    std::int32_t* prev = _prev[raw ? 0 : (int)type];
+    for(int i=0; i<FlightRecord::MAX_FIELDS; i++) {
+        out.value[i] = 0.f;
+    }
+    for(int i=0; i<t->count; i++) {
+        std::int32_t d;
+        if(!getSigned(d)) {
+            _pos = _end;
+            return false;
+        }
+        prev[i] = (std::int32_t)((std::uint32_t)prev[i] + (std::uint32_t)d);
+        float res = imuResolution(type, i, _imuRes);
+        // counts * LSB in float, as the sensor driver computed it
+        out.value[i] = raw ? bitsFloat(prev[i])
+                     : res > 0.f ? (float)prev[i] * res : prev[i] / t->scale[i];
+    }
+    return true;
+}
+
+float FlightLogDecoder::resolution(FlightRecordType type, int i) const {
+    float res = imuResolution(type, i, _imuRes);
+    return res > 0.f ? res : 1.f / FlightLog::fieldScale(type, i);
+}
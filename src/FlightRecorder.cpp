@@ -0,0 +1,171 @@
+#include "FlightRecorder.h"
+
+FlightRecorder::FlightRecorder(IBlockStorage& storage)
+: _storage(storage)
+, _ready(false)
+, _block(0)
+, _sequence(0)
+, _dirty(false)
+, _lastWrite(0)
+, _recorded(0)
+, _blocksWritten(0)
+, _writeErrors(0)
+{
+}
+
+bool FlightRecorder::begin() {
+    std::size_t count = _storage.blockCount();
+    if(count == 0) {
+        _ready = false;
+        return false;
+    }
+    // Newest valid block; erased or torn ones don't count
+    bool found = false;
+    std::uint32_t newest = 0;
+    std::size_t newestIndex = 0;
+    std::uint8_t header[FlightLog::HEADER_SIZE];
+    for(std::size_t i=0; i<count; i++) {
+        std::uint32_t seq, start;
+        if(!_storage.readBlock(i, header, sizeof(header)) ||
+           !FlightLog::readHeader(header, seq, start)) {
+            continue;
+        }
+        if(!found || (std::int32_t)(seq - newest) > 0) {
+            found = true;
+            newest = seq;
+            newestIndex = i;
+        }
+    }
+    _block    = found ? (newestIndex + 1) % count : 0;
+    _sequence = found ? newest + 1 : 0;
+    _encoder.begin(_sequence, 0);
+    _dirty = false;
+    _ready = true;
+    return true;
+}
+
+bool FlightRecorder::record(std::size_t channel, const FlightRecord& r) {
+    if(channel >= CHANNELS) {
+        return false;
+    }
+    return _queues[channel].push(r);
+}
+
+bool FlightRecorder::logImu(std::size_t channel, std::uint32_t timeMs, const IMUData& raw) {
+    FlightRecord r;
+    r.type = FlightRecordType::IMU;
+    r.timeMs = timeMs;
+    r.value[0] = raw.ax; r.value[1] = raw.ay; r.value[2] = raw.az;
+    r.value[3] = raw.gx; r.value[4] = raw.gy; r.value[5] = raw.gz;
+    r.value[6] = raw.mx; r.value[7] = raw.my; r.value[8] = raw.mz;
+    return record(channel, r);
+}
+
+bool FlightRecorder::logAttitude(std::size_t channel, std::uint32_t timeMs, const FilteredIMUData& att) {
+    FlightRecord r;
+    r.type = FlightRecordType::ATTITUDE;
+    r.timeMs = timeMs;
+    r.value[0] = att.roll;
+    r.value[1] = att.pitch;
+    r.value[2] = att.yaw;
+    r.value[3] = att.yawRate;
+    return record(channel, r);
+}
+
+bool FlightRecorder::logSteering(std::size_t channel, std::uint32_t timeMs,
+                                 float setpoint, float rudderOrder, float seaState) {
+    FlightRecord r;
+    r.type = FlightRecordType::STEERING;
+    r.timeMs = timeMs;
+    r.value[0] = setpoint;
+    r.value[1] = rudderOrder;
+    r.value[2] = seaState;
+    return record(channel, r);
+}
+
+bool FlightRecorder::logRudder(std::size_t channel, std::uint32_t timeMs, float target, float angle,
+                               float command, float current, int fault) {
+    FlightRecord r;
+    r.type = FlightRecordType::RUDDER;
+    r.timeMs = timeMs;
+    r.value[0] = target;
+    r.value[1] = angle;
+    r.value[2] = command;
+    r.value[3] = current;
+    r.value[4] = (float)fault;
+    return record(channel, r);
+}
+
+bool FlightRecorder::logMode(std::size_t channel, std::uint32_t timeMs, int mode, float setpoint) {
+    FlightRecord r;
+    r.type = FlightRecordType::MODE;
+    r.timeMs = timeMs;
+    r.value[0] = (float)mode;
+    r.value[1] = setpoint;
+    return record(channel, r);
+}
+
+bool FlightRecorder::logFeedback(std::size_t channel, std::uint32_t timeMs, float value, int source, float quality) {
+    FlightRecord r;
+    r.type = FlightRecordType::FEEDBACK;
+    r.timeMs = timeMs;
+    r.value[0] = value;
+    r.value[1] = (float)source;
+    r.value[2] = quality;
+    return record(channel, r);
+}
+
+void FlightRecorder::service(std::uint32_t nowMs) {
+    FlightRecord r;
+    for(std::size_t c=0; c<CHANNELS; c++) {
+        while(_queues[c].pop(r)) {
+            if(!_ready) {
+                continue;
+            }
+            if(_encoder.isEmpty()) {
+                _encoder.begin(_sequence, r.timeMs);
+            }
+            if(!_encoder.append(r)) {
+                // Block full: save it, start the next one with this record
+                writeCurrent();
+                nextBlock(r.timeMs);
+                _encoder.append(r);
+            }
+            _dirty = true;
+            _recorded++;
+        }
+    }
+    if(_ready && _dirty && nowMs - _lastWrite >= FLUSH_MS) {
+        writeCurrent();
+        _lastWrite = nowMs;
+    }
+}
+
+void FlightRecorder::flush() {
+    if(_ready && _dirty) {
+        writeCurrent();
+    }
+}
+
+std::uint32_t FlightRecorder::dropped() const {
+    std::uint32_t n = 0;
+    for(std::size_t c=0; c<CHANNELS; c++) {
+        n += _queues[c].dropped();
+    }
+    return n;
+}
+
+void FlightRecorder::writeCurrent() {
+    if(_storage.writeBlock(_block, _encoder.finish())) {
+        _blocksWritten++;
+    } else {
+        _writeErrors++;
+    }
+    _dirty = false;
+}
+
+void FlightRecorder::nextBlock(std::uint32_t startMs) {
+    _block = (_block + 1) % _storage.blockCount();
+    _sequence++;
+    _encoder.begin(_sequence, startMs);
+}
@@ -0,0 +1,84 @@
+#include "GainTable.h"
+#include <ArduinoJson.h>
+
+// Room for MAX_SETS entries of { maxSeaState, steer{3}, rudder{3}, score, economy }
+// plus the (deduplicated) key strings
+static const size_t JSON_CAPACITY =
+    JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(GainTable::MAX_SETS) +
+    GainTable::MAX_SETS * (JSON_OBJECT_SIZE(5) + 2 * JSON_OBJECT_SIZE(3)) + 128;
+
+GainTable::GainTable()
+: _count(0)
+{
+}
+
+bool GainTable::loadFromJson(const char* json) {
+    if(!json) return false;
+
+    StaticJsonDocument<JSON_CAPACITY> doc;
+    DeserializationError err = deserializeJson(doc, json);
+    if(err) {
+        return false;
+    }
+
+    JsonArray sets = doc["sets"].as<JsonArray>();
+    if(sets.isNull() || sets.size() == 0 || sets.size() > MAX_SETS) {
+        return false;
+    }
+
+    GainSet parsed[MAX_SETS];
+    size_t n = 0;
+    for(JsonObject s : sets) {
+        JsonObject steer  = s["steer"];
+        JsonObject rudder = s["rudder"];
+        if(steer.isNull() || rudder.isNull()) {
+            return false;
+        }
+        GainSet g;
+        g.maxSeaState = s["maxSeaState"] | 1e9f;
+        g.steerKp  = steer["kP"]  | 1.0f;
+        g.steerKi  = steer["kI"]  | 0.0f;
+        g.steerKd  = steer["kD"]  | 0.0f;
+        g.rudderKp = rudder["kP"] | 1.0f;
+        g.rudderKi = rudder["kI"] | 0.0f;
+        g.rudderKd = rudder["kD"] | 0.0f;
+        g.economy  = s["economy"] | false;
+
+        // insertion sort by maxSeaState
+        size_t pos = n;
+        while(pos > 0 && parsed[pos-1].maxSeaState > g.maxSeaState) {
+            parsed[pos] = parsed[pos-1];
+            pos--;
+        }
+        parsed[pos] = g;
+        n++;
+    }
+
+    for(size_t i=0; i<n; i++) {
+        _sets[i] = parsed[i];
+    }
+    _count = n;
+    return true;
+}
+
+bool GainTable::add(const GainSet& set) {
+    if(_count >= MAX_SETS) return false;
+    size_t pos = _count;
+    while(pos > 0 && _sets[pos-1].maxSeaState > set.maxSeaState) {
+        _sets[pos] = _sets[pos-1];
+        pos--;
+    }
+    _sets[pos] = set;
+    _count++;
+    return true;
+}
+
+const GainSet* GainTable::select(float seaState) const {
+    if(_count == 0) return nullptr;
+    for(size_t i=0; i<_count; i++) {
+        if(seaState <= _sets[i].maxSeaState) {
+            return &_sets[i];
+        }
+    }
+    return &_sets[_count-1];
+}
@@ -0,0 +1,63 @@
+#include "GpioButtons.h"
+
+GpioButtons* GpioButtons::s_instance = nullptr;
+hw_timer_t* GpioButtons::s_timer = nullptr;
+std::atomic<bool> GpioButtons::s_armed(false);
+
+GpioButtons::GpioButtons(const int (&pins)[ButtonEvents::BUTTON_COUNT]) {
+    for(int i=0; i<ButtonEvents::BUTTON_COUNT; i++) {
+        _pins[i] = pins[i];
+    }
+}
+
+bool GpioButtons::begin(uint8_t timerNum) {
+    if(s_instance) {
+        return false;
+    }
+    // 1 MHz timer clock, armed by the first edge
+    s_timer = timerBegin(timerNum, 80, true);
+    if(!s_timer) {
+        Serial.println("[Buttons] Could not start debounce timer.");
+        return false;
+    }
+    timerAttachInterrupt(s_timer, &onTimer, true);
+    timerAlarmWrite(s_timer, TICK_US, true);
+    s_instance = this;
+
+    for(int i=0; i<ButtonEvents::BUTTON_COUNT; i++) {
+        if(_pins[i] < 0) continue;
+        pinMode(_pins[i], INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(_pins[i]), onEdge, CHANGE);
+    }
+    // held down at boot: no edge to wait for
+    if(readPins()) {
+        onEdge();
+    }
+    return true;
+}
+
+uint32_t GpioButtons::readPins() const {
+    uint32_t pressed = 0;
+    for(int i=0; i<ButtonEvents::BUTTON_COUNT; i++) {
+        if(_pins[i] >= 0 && digitalRead(_pins[i]) == LOW) {
+            pressed |= 1u << i;
+        }
+    }
+    return pressed;
+}
+
+void IRAM_ATTR GpioButtons::onEdge() {
+    // bounces after the first edge find the timer running already
+    if(!s_armed.exchange(true)) {
+        timerAlarmEnable(s_timer);
+    }
+}
+
+void IRAM_ATTR GpioButtons::onTimer() {
+    GpioButtons* self = s_instance;
+    self->_events.sample(self->readPins(), millis());
+    if(!self->_events.active()) {
+        timerAlarmDisable(s_timer);
+        s_armed = false;
+    }
+}
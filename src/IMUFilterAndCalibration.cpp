@@ -8,47 +8,75 @@ IMUFilterAndCalibration::IMUFilterAndCalibration(IIMUProvider& imu, ITimeProvide
 , _pitch(0.f)
 , _roll(0.f)
 , _yaw(0.f)
+, _yawRate(0.f)
 , _lastUpdate(0)
 , _axOff(0.f)
 , _ayOff(0.f)
 , _azOff(0.f)
+, _gxOff(0.f)
+, _gyOff(0.f)
+, _gzOff(0.f)
+, _gxSum(0.0)
+, _gySum(0.0)
+, _gzSum(0.0)
+, _calSamples(0)
 {
 }
 
 void IMUFilterAndCalibration::startCalibration() {
     _calibrating = true;
+    _gxSum = _gySum = _gzSum = 0.0;
+    _calSamples = 0;
 }
 
 void IMUFilterAndCalibration::doCalibrationStep() {
     if(!_calibrating) return;
-    // Example: gather offsets
-    _axOff = 0.f; // as needed
+    if(_calSamples > 0) {
+        _gxOff = float(_gxSum / _calSamples);
+        _gyOff = float(_gySum / _calSamples);
+        _gzOff = float(_gzSum / _calSamples);
+    }
     _calibrating = false;
 }
 
-void IMUFilterAndCalibration::update() {
+bool IMUFilterAndCalibration::update() {
+    return update(_time.getMillis());
+}
+
+bool IMUFilterAndCalibration::update(std::uint64_t nowMs) {
     // check if new data
     IMUData raw;
     if(!_imu.getIMUData(raw)) {
-        return; // no new data
+        return false; // no new data
     }
+    _raw = raw;
 
     // get dt
-    std::uint64_t now = _time.getMillis();
-    float dt = (now - _lastUpdate)*0.001f; // ms -> sec
+    float dt = (nowMs - _lastUpdate)*0.001f; // ms -> sec
     if(dt < 0.0001f) dt=0.0001f;
-    _lastUpdate = now;
+    _lastUpdate = nowMs;
+
+    if(_calibrating) {
+        // alongside: whatever the gyro reads is its bias
+        _gxSum += raw.gx;
+        _gySum += raw.gy;
+        _gzSum += raw.gz;
+        _calSamples++;
+        return true;
+    }
 
     // apply offsets
     float ax = raw.ax - _axOff; // etc.
     // naive integration: pitch += gyroX * dt, etc.
     // or do advanced filter
 
-    float gxDeg = raw.gx * 57.2958f; // rad/s -> deg/s
+    float gxDeg = (raw.gx - _gxOff) * 57.2958f; // rad/s -> deg/s
     _roll  += gxDeg * dt;  // placeholder
+    _yawRate = (raw.gz - _gzOff) * 57.2958f;
     // similarly for _pitch, _yaw
 
     // clamp or whatever
+    return true;
 }
 
 FilteredIMUData IMUFilterAndCalibration::getFilteredData() const {
@@ -56,5 +84,10 @@ FilteredIMUData IMUFilterAndCalibration::getFilteredData() const {
     out.pitch = _pitch;
     out.roll  = _roll;
     out.yaw   = _yaw;
+    out.yawRate = _yawRate;
     return out;
 }
+
+IMUData IMUFilterAndCalibration::getRawData() const {
+    return _raw;
+}
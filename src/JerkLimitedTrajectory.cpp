@@ -0,0 +1,121 @@
+#include "JerkLimitedTrajectory.h"
+#include <cmath>
+
+// Close enough to snap onto the target [deg, deg/s]
+static const float SETTLE_POS = 1e-3f;
+static const float SETTLE_VEL = 1e-2f;
+
+static float clampAbs(float v, float limit) {
+    if(v>limit) return limit;
+    if(v<-limit) return -limit;
+    return v;
+}
+
+static float signOf(float v) {
+    return (v>0.0f) ? 1.0f : ((v<0.0f) ? -1.0f : 0.0f);
+}
+
+JerkLimitedTrajectory::JerkLimitedTrajectory(const DriveProfile& profile)
+ : _profile(profile)
+{
+    reset(0.0f);
+}
+
+void JerkLimitedTrajectory::setProfile(const DriveProfile& profile)
+{
+    _profile=profile;
+}
+
+const DriveProfile& JerkLimitedTrajectory::getProfile() const
+{
+    return _profile;
+}
+
+void JerkLimitedTrajectory::reset(float position)
+{
+    _pos=position;
+    _vel=0.0f;
+    _acc=0.0f;
+    _target=position;
+}
+
+float JerkLimitedTrajectory::stoppingVelocity(float distance) const
+{
+    if(distance<=0.0f) {
+        return 0.0f;
+    }
+    const float a=_profile.maxAccel;
+    const float j=_profile.maxJerk;
+    // Stop from v with zero initial acceleration:
+    //   v <= a^2/j (triangular accel): d = v*sqrt(v/j)
+    //   otherwise (trapezoidal):       d = v/2 * (v/a + a/j)
+    float vCorner=a*a/j;
+    float dCorner=vCorner*std::sqrt(vCorner/j);
+    if(distance<=dCorner) {
+        return std::cbrt(distance*distance*j);
+    }
+    float p=a*a/j;
+    return 0.5f*(-p+std::sqrt(p*p+8.0f*distance*a));
+}
+
+float JerkLimitedTrajectory::update(float target, float dt)
+{
+    _target=target;
+    if(dt<=0.0f) {
+        return _pos;
+    }
+    const float vMax=_profile.maxRate;
+    const float aMax=_profile.maxAccel;
+    const float jMax=_profile.maxJerk;
+
+    // Where we end up if the acceleration is ramped to zero right now;
+    // plan the stop from there so a decelerating ramp is not overshot
+    float tRamp=std::fabs(_acc)/jMax;
+    float coast=tRamp*(_vel+_acc*tRamp/3.0f);
+    float error=target-(_pos+coast);
+
+    float vDes=signOf(error)*stoppingVelocity(std::fabs(error));
+    vDes=clampAbs(vDes, vMax);
+
+    // Acceleration that arrives at vDes with zero acceleration:
+    // ramping a down to 0 changes v by a^2/(2j)
+    float dv=vDes-_vel;
+    float aDes=signOf(dv)*std::sqrt(2.0f*jMax*std::fabs(dv));
+    aDes=clampAbs(aDes, aMax);
+
+    float aPrev=_acc;
+    _acc+=clampAbs(aDes-_acc, jMax*dt);
+
+    float vOld=_vel;
+    _vel=clampAbs(_vel+_acc*dt, vMax);
+    _pos+=0.5f*(vOld+_vel)*dt;
+
+    // the last step of the ramp may not jump the acceleration either
+    if(std::fabs(target-_pos)<SETTLE_POS && std::fabs(_vel)<SETTLE_VEL
+       && std::fabs(aPrev)<=jMax*dt) {
+        _pos=target;
+        _vel=0.0f;
+        _acc=0.0f;
+    }
+    return _pos;
+}
+
+float JerkLimitedTrajectory::getPosition() const
+{
+    return _pos;
+}
+
+float JerkLimitedTrajectory::getVelocity() const
+{
+    return _vel;
+}
+
+float JerkLimitedTrajectory::getAcceleration() const
+{
+    return _acc;
+}
+
+bool JerkLimitedTrajectory::isSettled() const
+{
+    return _pos==_target && _vel==0.0f;
+}
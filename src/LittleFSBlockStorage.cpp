@@ -0,0 +1,68 @@
+#include "LittleFSBlockStorage.h"
+#include <cstring>
+#include "FlightLog.h"
+
+LittleFSBlockStorage::LittleFSBlockStorage(const char* path, std::size_t blockCount)
+: _path(path)
+, _blocks(blockCount)
+{
+}
+
+bool LittleFSBlockStorage::begin() {
+    const std::size_t bytes = _blocks * FlightLog::BLOCK_SIZE;
+    if(LittleFS.exists(_path)) {
+        _file = LittleFS.open(_path, "r+");
+    }
+    if(!_file || _file.size() != bytes) {
+        _file.close();
+        if(!allocate()) {
+            return false;
+        }
+        _file = LittleFS.open(_path, "r+");
+    }
+    return (bool)_file;
+}
+
+bool LittleFSBlockStorage::allocate() {
+    File f = LittleFS.open(_path, "w");
+    if(!f) {
+        return false;
+    }
+    static std::uint8_t erased[256];
+    std::memset(erased, 0xFF, sizeof(erased));
+    const std::size_t bytes = _blocks * FlightLog::BLOCK_SIZE;
+    for(std::size_t done=0; done<bytes; done+=sizeof(erased)) {
+        if(f.write(erased, sizeof(erased)) != sizeof(erased)) {
+            f.close();
+            return false;
+        }
+    }
+    f.close();
+    return true;
+}
+
+std::size_t LittleFSBlockStorage::blockCount() const {
+    return _file ? _blocks : 0;
+}
+
+bool LittleFSBlockStorage::readBlock(std::size_t index, std::uint8_t* out, std::size_t len) {
+    if(!_file || index >= _blocks || len > FlightLog::BLOCK_SIZE) {
+        return false;
+    }
+    if(!_file.seek((uint32_t)(index * FlightLog::BLOCK_SIZE))) {
+        return false;
+    }
+    return _file.read(out, len) == len;
+}
+
+bool LittleFSBlockStorage::writeBlock(std::size_t index, const std::uint8_t* data) {
+    if(!_file || index >= _blocks) {
+        return false;
+    }
+    if(!_file.seek((uint32_t)(index * FlightLog::BLOCK_SIZE))) {
+        return false;
+    }
+    bool ok = _file.write(data, FlightLog::BLOCK_SIZE) == FlightLog::BLOCK_SIZE;
+    _file.flush();
+    return ok;
+}
@@ -0,0 +1,70 @@
+#include "LoopJitter.h"
+
+constexpr std::uint32_t LoopJitterStats::BUCKET_LIMIT_US[LoopJitterStats::BUCKETS - 1];
+
+LoopJitter::LoopJitter(std::uint32_t periodUs)
+ : _period(periodUs)
+{
+    reset();
+}
+
+void LoopJitter::reset()
+{
+    _lastStart=0;
+    _started=false;
+    _periods=0;
+    _sumPeriod=0.0;
+    _sumJitter=0.0;
+    _sumExec=0.0;
+    _stats=LoopJitterStats();
+    _stats.minPeriod=UINT32_MAX;
+}
+
+void LoopJitter::cycleStart(std::uint32_t nowUs)
+{
+    if(_started) {
+        std::uint32_t period=nowUs-_lastStart;   // unsigned: wrap safe
+        std::uint32_t jitter=(period>_period) ? period-_period : _period-period;
+
+        _periods++;
+        _sumPeriod+=period;
+        _sumJitter+=jitter;
+        if(period<_stats.minPeriod) _stats.minPeriod=period;
+        if(period>_stats.maxPeriod) _stats.maxPeriod=period;
+        if(jitter>_stats.maxJitter) _stats.maxJitter=jitter;
+        _stats.meanPeriod=float(_sumPeriod/_periods);
+        _stats.meanJitter=float(_sumJitter/_periods);
+
+        // a late start that swallowed a whole tick is a missed cycle
+        if(period>=2*_period) _stats.overruns++;
+
+        int b=0;
+        while(b<LoopJitterStats::BUCKETS-1 && jitter>=LoopJitterStats::BUCKET_LIMIT_US[b]) b++;
+        _stats.histogram[b]++;
+    }
+    _lastStart=nowUs;
+    _started=true;
+}
+
+void LoopJitter::cycleEnd(std::uint32_t nowUs)
+{
+    if(!_started) {
+        return;
+    }
+    std::uint32_t exec=nowUs-_lastStart;
+    _stats.cycles++;
+    _sumExec+=exec;
+    _stats.meanExec=float(_sumExec/_stats.cycles);
+    if(exec>_stats.maxExec) _stats.maxExec=exec;
+    if(exec>_period) _stats.overruns++;
+}
+
+std::uint32_t LoopJitter::getPeriod() const
+{
+    return _period;
+}
+
+const LoopJitterStats& LoopJitter::stats() const
+{
+    return _stats;
+}
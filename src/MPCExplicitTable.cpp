@@ -0,0 +1,165 @@
+// Generated by tools/mpc_gen -- do not edit by hand.
+// Regenerate with: pio run -e mpc_gen -t exec
+// Weights: Q_E=1 Q_R=2 Q_E_F=20 R_U=0.002 R_DU=0.05, blocks: 1 3 36
+#include "MPCExplicitTable.h"
+
+const MPCModelInfo MPC_MODEL = { 0.100000f, 0.300000f, 3.000000f, 30.000000f, 40, 3 };
+
+const MPCRegion MPC_REGIONS[] = {
+    // active set: - - -  (79039 grid hits)
+    { 3,
+      {
+        { -9.5445483e-01f, -2.0878643e+00f, 5.0000000e-02f },
+        { -2.7009315e+00f, -5.9767166e+00f, -0.0000000e+00f },
+        { -1.4705462e+01f, -3.4452788e+01f, -0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -1.4251681e+01f, -3.7397951e+01f, -2.5414254e+02f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f }, -3.0000000e+01f },
+    // active set: + + +  (79039 grid hits)
+    { 3,
+      {
+        { 9.5445483e-01f, 2.0878643e+00f, -5.0000000e-02f },
+        { 2.7009315e+00f, 5.9767166e+00f, 0.0000000e+00f },
+        { 1.4705462e+01f, 3.4452788e+01f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -1.4251681e+01f, -3.7397951e+01f, -2.5414254e+02f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f }, 3.0000000e+01f },
+    // active set: f f f  (7491 grid hits)
+    { 6,
+      {
+        { -4.3950822e+00f, -7.9081652e+00f, 5.1251064e-01f },
+        { 4.3950822e+00f, 7.9081652e+00f, -5.1251064e-01f },
+        { -5.9370427e+00f, -1.1005247e+01f, 1.2371399e-01f },
+        { 5.9370427e+00f, 1.1005247e+01f, -1.2371399e-01f },
+        { -1.0472662e+00f, -2.9559896e+00f, -4.1043061e-02f },
+        { 1.0472662e+00f, 2.9559896e+00f, 4.1043061e-02f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { 3.0000000e+01f, 3.0000000e+01f, 3.0000000e+01f, 3.0000000e+01f, 3.0000000e+01f, 3.0000000e+01f, 0.0000000e+00f, 0.0000000e+00f, },
+      { -4.3950822e+00f, -7.9081652e+00f, 5.1251064e-01f }, 0.0000000e+00f },
+    // active set: - - f  (6748 grid hits)
+    { 4,
+      {
+        { -2.5120403e-01f, -4.4024855e-01f, 5.0000000e-02f },
+        { -7.3564333e-01f, -1.3723282e+00f, -0.0000000e+00f },
+        { -2.0508964e+00f, -4.8049561e+00f, -0.0000000e+00f },
+        { 2.0508964e+00f, 4.8049561e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -2.0979689e+00f, -3.4334729e+00f, 2.4556025e+01f, 3.5443975e+01f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f }, -3.0000000e+01f },
+    // active set: + + f  (6748 grid hits)
+    { 4,
+      {
+        { 2.5120403e-01f, 4.4024855e-01f, -5.0000000e-02f },
+        { 7.3564333e-01f, 1.3723282e+00f, 0.0000000e+00f },
+        { -2.0508964e+00f, -4.8049561e+00f, -0.0000000e+00f },
+        { 2.0508964e+00f, 4.8049561e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -2.0979689e+00f, -3.4334729e+00f, 3.5443975e+01f, 2.4556025e+01f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f }, 3.0000000e+01f },
+    // active set: f - f  (2558 grid hits)
+    { 5,
+      {
+        { -2.3620574e+00f, -4.1396324e+00f, 4.7014719e-01f },
+        { 2.3620574e+00f, 4.1396324e+00f, -4.7014719e-01f },
+        { -8.2166327e-01f, -1.5230828e+00f, 1.7121527e-02f },
+        { -1.9379371e+00f, -4.6069889e+00f, -2.2483577e-02f },
+        { 1.9379371e+00f, 4.6069889e+00f, 2.2483577e-02f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { 4.0272916e+01f, 1.9727084e+01f, -4.1518815e+00f, 2.5499422e+01f, 3.4500578e+01f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { -2.3620574e+00f, -4.1396324e+00f, 4.7014719e-01f }, -1.0272916e+01f },
+    // active set: f + f  (2558 grid hits)
+    { 5,
+      {
+        { -2.3620574e+00f, -4.1396324e+00f, 4.7014719e-01f },
+        { 2.3620574e+00f, 4.1396324e+00f, -4.7014719e-01f },
+        { 8.2166327e-01f, 1.5230828e+00f, -1.7121527e-02f },
+        { -1.9379371e+00f, -4.6069889e+00f, -2.2483577e-02f },
+        { 1.9379371e+00f, 4.6069889e+00f, 2.2483577e-02f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { 1.9727084e+01f, 4.0272916e+01f, -4.1518815e+00f, 3.4500578e+01f, 2.5499422e+01f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { -2.3620574e+00f, -4.1396324e+00f, 4.7014719e-01f }, 1.0272916e+01f },
+    // active set: - f f  (128 grid hits)
+    { 5,
+      {
+        { -4.2877960e-01f, -7.7151230e-01f, 5.0000000e-02f },
+        { -4.8761220e+00f, -9.0963100e+00f, 0.0000000e+00f },
+        { 4.8761220e+00f, 9.0963100e+00f, -0.0000000e+00f },
+        { -1.3992348e+00f, -3.5892941e+00f, -0.0000000e+00f },
+        { 1.3992348e+00f, 3.5892941e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -2.9267685e+00f, 3.7241644e+01f, 2.2758356e+01f, 2.7597529e+01f, 3.2402471e+01f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f }, -3.0000000e+01f },
+    // active set: + f f  (128 grid hits)
+    { 5,
+      {
+        { 4.2877960e-01f, 7.7151230e-01f, -5.0000000e-02f },
+        { -4.8761220e+00f, -9.0963100e+00f, 0.0000000e+00f },
+        { 4.8761220e+00f, 9.0963100e+00f, -0.0000000e+00f },
+        { -1.3992348e+00f, -3.5892941e+00f, -0.0000000e+00f },
+        { 1.3992348e+00f, 3.5892941e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -2.9267685e+00f, 2.2758356e+01f, 3.7241644e+01f, 3.2402471e+01f, 2.7597529e+01f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f }, 3.0000000e+01f },
+    // active set: f - -  (44 grid hits)
+    { 4,
+      {
+        { -7.7757296e+00f, -1.7009363e+01f, 4.0733880e-01f },
+        { 7.7757296e+00f, 1.7009363e+01f, -4.0733880e-01f },
+        { -2.6277708e+00f, -5.8166780e+00f, -3.8325892e-03f },
+        { -1.2039170e+01f, -2.8620290e+01f, -1.3967616e-01f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { -5.6105250e+01f, 1.1610525e+02f, -3.6305534e+01f, -2.1433014e+02f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { -7.7757296e+00f, -1.7009363e+01f, 4.0733880e-01f }, 8.6105250e+01f },
+    // active set: f + +  (44 grid hits)
+    { 4,
+      {
+        { -7.7757296e+00f, -1.7009363e+01f, 4.0733880e-01f },
+        { 7.7757296e+00f, 1.7009363e+01f, -4.0733880e-01f },
+        { 2.6277708e+00f, 5.8166780e+00f, 3.8325892e-03f },
+        { 1.2039170e+01f, 2.8620290e+01f, 1.3967616e-01f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+        { 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f },
+      },
+      { 1.1610525e+02f, -5.6105250e+01f, -3.6305534e+01f, -2.1433014e+02f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, 0.0000000e+00f, },
+      { -7.7757296e+00f, -1.7009363e+01f, 4.0733880e-01f }, -8.6105250e+01f },
+};
+
+const int MPC_REGION_COUNT = 11;
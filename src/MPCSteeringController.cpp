@@ -0,0 +1,78 @@
+#include "MPCSteeringController.h"
+
+// Tolerance for points on a region boundary (float table vs. double solver)
+static const float REGION_TOL = 1e-3f;
+
+MPCSteeringController::MPCSteeringController()
+: _mode(AutoSteeringMode::OFF)
+, _desired(0.f)
+, _rudderAngle(0.f)
+, _activeRegion(-1)
+{
+}
+
+void MPCSteeringController::setMode(AutoSteeringMode mode, float param) {
+    _mode = mode;
+    _desired = param;
+    if(mode != AutoSteeringMode::TRACK_HEADING && mode != AutoSteeringMode::TRACK_COURSE) {
+        _rudderAngle = 0.f;
+        _activeRegion = -1;
+    }
+}
+
+void MPCSteeringController::update(float measured, float yawRate) {
+    if(_mode != AutoSteeringMode::TRACK_HEADING && _mode != AutoSteeringMode::TRACK_COURSE) {
+        _rudderAngle = 0.f;
+        return;
+    }
+
+    // Heading error wrapped into [-180..180)
+    float error = measured - _desired;
+    while(error >= 180.f) error -= 360.f;
+    while(error < -180.f) error += 360.f;
+
+    float x[MPC_STATE_DIM] = { error, yawRate, _rudderAngle };
+    _rudderAngle = evaluate(x, &_activeRegion);
+}
+
+float MPCSteeringController::getRudderAngle() const {
+    return _rudderAngle;
+}
+
+int MPCSteeringController::getActiveRegion() const {
+    return _activeRegion;
+}
+
+float MPCSteeringController::evaluate(const float x[MPC_STATE_DIM], int* regionOut) {
+    // The regions partition the whole state space, so normally the first
+    // hit is the answer. Keep the least violated region as a fallback for
+    // points that fall in a numerical gap between neighbours.
+    int   best = -1;
+    float bestViolation = 0.f;
+    for(int i=0; i<MPC_REGION_COUNT; i++) {
+        const MPCRegion& reg = MPC_REGIONS[i];
+        float violation = 0.f;
+        for(int r=0; r<reg.rows; r++) {
+            float v = reg.A[r][0]*x[0] + reg.A[r][1]*x[1] + reg.A[r][2]*x[2] - reg.b[r];
+            if(v > violation) violation = v;
+        }
+        if(violation <= REGION_TOL) {
+            best = i;
+            break;
+        }
+        if(best < 0 || violation < bestViolation) {
+            best = i;
+            bestViolation = violation;
+        }
+    }
+    if(regionOut) *regionOut = best;
+    if(best < 0) return 0.f;
+
+    const MPCRegion& reg = MPC_REGIONS[best];
+    float u = reg.K[0]*x[0] + reg.K[1]*x[1] + reg.K[2]*x[2] + reg.k0;
+
+    // clamp to the rudder limit the table was built for
+    if(u > MPC_MODEL.rudderMax) u = MPC_MODEL.rudderMax;
+    if(u < -MPC_MODEL.rudderMax) u = -MPC_MODEL.rudderMax;
+    return u;
+}
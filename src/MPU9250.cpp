@@ -29,9 +29,7 @@ MPU9250::MPU9250(TwoWire& wire, uint8_t address)
    _gyroRange(MPU9250GyroRange::GYRO_RANGE_250DPS),
    _dlpfMode(0), // default
    _srd(0),
-   _accelX(0),_accelY(0),_accelZ(0),
-   _gyroX(0), _gyroY(0), _gyroZ(0),
-   _magX(0),  _magY(0),  _magZ(0),
+   _data(),
    _accelScale(1.0f), _gyroScale(1.0f)
 {
 }
@@ -73,28 +71,16 @@ int MPU9250::begin()
 void MPU9250::setAccelRange(MPU9250AccelRange range)
 {
     _accelRange=range;
-    uint8_t value=0;
-    switch(range){
-        case MPU9250AccelRange::ACCEL_RANGE_2G:  value=0x00; _accelScale=2.0f/32768.0f*9.81f;  break;
-        case MPU9250AccelRange::ACCEL_RANGE_4G:  value=0x08; _accelScale=4.0f/32768.0f*9.81f;  break;
-        case MPU9250AccelRange::ACCEL_RANGE_8G:  value=0x10; _accelScale=8.0f/32768.0f*9.81f;  break;
-        case MPU9250AccelRange::ACCEL_RANGE_16G: value=0x18; _accelScale=16.0f/32768.0f*9.81f; break;
-    }
-    writeByte(ACCEL_CONFIG, value);
+    _accelScale=MPU9250Decoder::accelScale(range);
+    writeByte(ACCEL_CONFIG, MPU9250Decoder::accelConfig(range));
     delay(10);
 }
 
 void MPU9250::setGyroRange(MPU9250GyroRange range)
 {
     _gyroRange=range;
-    uint8_t value=0;
-    switch(range){
-        case MPU9250GyroRange::GYRO_RANGE_250DPS:   value=0x00; _gyroScale=250.0f/32768.0f*(3.14159f/180.0f); break;
-        case MPU9250GyroRange::GYRO_RANGE_500DPS:   value=0x08; _gyroScale=500.0f/32768.0f*(3.14159f/180.0f); break;
-        case MPU9250GyroRange::GYRO_RANGE_1000DPS:  value=0x10; _gyroScale=1000.0f/32768.0f*(3.14159f/180.0f);break;
-        case MPU9250GyroRange::GYRO_RANGE_2000DPS:  value=0x18; _gyroScale=2000.0f/32768.0f*(3.14159f/180.0f);break;
-    }
-    writeByte(GYRO_CONFIG, value);
+    _gyroScale=MPU9250Decoder::gyroScale(range);
+    writeByte(GYRO_CONFIG, MPU9250Decoder::gyroConfig(range));
     delay(10);
 }
 
@@ -102,24 +88,9 @@ void MPU9250::readSensor()
 {
     // 1) read 14 bytes for accel+gyro 
     // ACCEL_XOUT_H ... GYRO_ZOUT_L
-    uint8_t raw[14];
-    readBytes(ACCEL_XOUT_H, 14, raw);
-
-    int16_t ax = (int16_t)((raw[0]<<8)|raw[1]);
-    int16_t ay = (int16_t)((raw[2]<<8)|raw[3]);
-    int16_t az = (int16_t)((raw[4]<<8)|raw[5]);
-
-    int16_t gx = (int16_t)((raw[8]<<8)|raw[9]);
-    int16_t gy = (int16_t)((raw[10]<<8)|raw[11]);
-    int16_t gz = (int16_t)((raw[12]<<8)|raw[13]);
-
-    _accelX = ax*_accelScale;
-    _accelY = ay*_accelScale;
-    _accelZ = az*_accelScale;
-
-    _gyroX  = gx*_gyroScale;
-    _gyroY  = gy*_gyroScale;
-    _gyroZ  = gz*_gyroScale;
+    uint8_t raw[MPU9250Decoder::ACCEL_GYRO_BYTES];
+    readBytes(ACCEL_XOUT_H, MPU9250Decoder::ACCEL_GYRO_BYTES, raw);
+    MPU9250Decoder::decodeAccelGyro(raw, _accelScale, _gyroScale, _data);
 
     // 2) read magnetometer
     readMagData();
@@ -160,21 +131,12 @@ void MPU9250::readMagData()
     _wire.requestFrom((uint8_t)AK8963_ADDRESS, (uint8_t)7);
     if(_wire.available()<7) return;
 
-    uint8_t magRaw[7];
-    for(int i=0;i<7;i++){
+    uint8_t magRaw[MPU9250Decoder::MAG_BYTES];
+    for(int i=0;i<MPU9250Decoder::MAG_BYTES;i++){
         magRaw[i]=_wire.read();
     }
-    int16_t mx = (int16_t)((magRaw[1]<<8) | magRaw[0]);
-    int16_t my = (int16_t)((magRaw[3]<<8) | magRaw[2]);
-    int16_t mz = (int16_t)((magRaw[5]<<8) | magRaw[4]);
-    // ST2=magRaw[6], might contain overflow bits
-
-    // scale: sensitivity ~0.6 uT/LSB for 16-bit at 0.15 uT/LSB, 
-    // but exact depends on your setup. We'll assume ~0.6
-    float magScale = 0.6f; // microtesla per LSB (example)
-    _magX = mx*magScale;
-    _magY = my*magScale;
-    _magZ = mz*magScale;
+    // keeps the last reading on overflow
+    MPU9250Decoder::decodeMag(magRaw, _data);
 }
 
 uint8_t MPU9250::readByte(uint8_t reg)
@@ -0,0 +1,64 @@
+#include "MPU9250Decoder.h"
+
+static const float G = 9.81f;
+static const float DEG_TO_RAD_F = 3.14159f / 180.0f;
+
+// ST2 bit: magnetic sensor overflow
+static const std::uint8_t AK8963_HOFL = 0x08;
+
+std::uint8_t MPU9250Decoder::accelConfig(MPU9250AccelRange range)
+{
+    return (std::uint8_t)((int)range << 3);
+}
+
+std::uint8_t MPU9250Decoder::gyroConfig(MPU9250GyroRange range)
+{
+    return (std::uint8_t)((int)range << 3);
+}
+
+float MPU9250Decoder::accelScale(MPU9250AccelRange range)
+{
+    // 2, 4, 8 or 16 g full scale
+    return float(2 << (int)range) / 32768.0f * G;
+}
+
+float MPU9250Decoder::gyroScale(MPU9250GyroRange range)
+{
+    // 250, 500, 1000 or 2000 deg/s full scale
+    return float(250 << (int)range) / 32768.0f * DEG_TO_RAD_F;
+}
+
+void MPU9250Decoder::decodeAccelGyro(const std::uint8_t raw[ACCEL_GYRO_BYTES],
+                                     float accelScale, float gyroScale, MPU9250Reading& out)
+{
+    std::int16_t ax = (std::int16_t)((raw[0]<<8)|raw[1]);
+    std::int16_t ay = (std::int16_t)((raw[2]<<8)|raw[3]);
+    std::int16_t az = (std::int16_t)((raw[4]<<8)|raw[5]);
+    // raw[6..7] is the temperature
+    std::int16_t gx = (std::int16_t)((raw[8]<<8)|raw[9]);
+    std::int16_t gy = (std::int16_t)((raw[10]<<8)|raw[11]);
+    std::int16_t gz = (std::int16_t)((raw[12]<<8)|raw[13]);
+
+    out.accelX = ax*accelScale;
+    out.accelY = ay*accelScale;
+    out.accelZ = az*accelScale;
+
+    out.gyroX  = gx*gyroScale;
+    out.gyroY  = gy*gyroScale;
+    out.gyroZ  = gz*gyroScale;
+}
+
+bool MPU9250Decoder::decodeMag(const std::uint8_t raw[MAG_BYTES], MPU9250Reading& out)
+{
+    if(raw[6] & AK8963_HOFL) {
+        return false;
+    }
+    std::int16_t mx = (std::int16_t)((raw[1]<<8) | raw[0]);
+    std::int16_t my = (std::int16_t)((raw[3]<<8) | raw[2]);
+    std::int16_t mz = (std::int16_t)((raw[5]<<8) | raw[4]);
+
+    out.magX = mx*MAG_SCALE;
+    out.magY = my*MAG_SCALE;
+    out.magZ = mz*MAG_SCALE;
+    return true;
+}
@@ -0,0 +1,47 @@
+#include "MotorCurrentSensor.h"
+
+MotorCurrentSensor::MotorCurrentSensor(float ampsPerCount, float zeroCounts)
+ : _ampsPerCount(ampsPerCount),
+   _zeroCounts(zeroCounts),
+   _outputs(0)
+{
+}
+
+void MotorCurrentSensor::setScale(float ampsPerCount, float zeroCounts)
+{
+    _ampsPerCount=ampsPerCount;
+    _zeroCounts=zeroCounts;
+}
+
+float MotorCurrentSensor::toAmps(float counts) const
+{
+    float amps=(counts-_zeroCounts)*_ampsPerCount;
+    return (amps>0.0f) ? amps : 0.0f;
+}
+
+void MotorCurrentSensor::addSamples(const std::uint16_t* raw, std::size_t count)
+{
+    for(std::size_t i=0; i<count; i++) {
+        if(!_cic.push(raw[i])) {
+            continue;
+        }
+        if(_outputs<CIC_ORDER-1) {
+            _outputs++;
+            continue;
+        }
+        _latest.write(toAmps(_cic.output()));
+    }
+}
+
+float MotorCurrentSensor::getCurrent() const
+{
+    float amps;
+    _latest.read(amps);
+    return amps;
+}
+
+void MotorCurrentSensor::reset()
+{
+    _cic.reset();
+    _outputs=0;
+}
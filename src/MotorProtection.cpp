@@ -0,0 +1,125 @@
+#include "MotorProtection.h"
+#include <cmath>
+
+static int signOf(float v) {
+    return (v > 0.0f) ? 1 : ((v < 0.0f) ? -1 : 0);
+}
+
+MotorProtection::MotorProtection(const MotorProtectionConfig& cfg)
+ : _cfg(cfg)
+{
+    reset();
+}
+
+void MotorProtection::setConfig(const MotorProtectionConfig& cfg)
+{
+    _cfg=cfg;
+}
+
+const MotorProtectionConfig& MotorProtection::getConfig() const
+{
+    return _cfg;
+}
+
+void MotorProtection::reset()
+{
+    _overSamples=0;
+    _overcurrentTimer=0.0f;
+    _stallTimer=0.0f;
+    _stallAnchor=0.0f;
+    _stallDirection=0;
+    _blockedTimer=0.0f;
+    _blockedDirection=0;
+    _blockedAngle=0.0f;
+    _thermal=0.0f;
+    _thermalTripped=false;
+    _trips=0;
+}
+
+float MotorProtection::limit(float command, float current, float angle, float dt)
+{
+    current=std::fabs(current);
+    int dir=signOf(command);
+
+    // I2t: heating follows (I/Irated)^2 with the winding time constant
+    float load=(current*current)/(_cfg.ratedCurrent*_cfg.ratedCurrent);
+    _thermal+=(load-_thermal)*(dt/_cfg.thermalTau);
+    if(!_thermalTripped && _thermal>=_cfg.thermalTrip) {
+        _thermalTripped=true;
+        _trips++;
+    } else if(_thermalTripped && _thermal<_cfg.thermalReset) {
+        _thermalTripped=false;
+    }
+
+    // Overcurrent: a couple of samples in a row, to ride out ADC spikes
+    if(_overcurrentTimer>0.0f) {
+        _overcurrentTimer-=dt;
+    }
+    if(current>_cfg.overcurrentLimit) {
+        if(++_overSamples>=_cfg.overcurrentSamples && _overcurrentTimer<=0.0f) {
+            _overcurrentTimer=_cfg.overcurrentHold;
+            _trips++;
+        }
+    } else {
+        _overSamples=0;
+    }
+
+    // Stall: pushing hard without the rudder moving
+    if(_blockedDirection!=0) {
+        _blockedTimer-=dt;
+        // driven away from where it got stuck, or time for a retry
+        bool movedAway=(angle-_blockedAngle)*_blockedDirection < -_cfg.stallMotion;
+        if(movedAway || _blockedTimer<=0.0f) {
+            _blockedDirection=0;
+        }
+    }
+    if(dir!=0 && current>_cfg.stallCurrent) {
+        if(dir!=_stallDirection || std::fabs(angle-_stallAnchor)>_cfg.stallMotion) {
+            _stallDirection=dir;
+            _stallAnchor=angle;
+            _stallTimer=0.0f;
+        }
+        _stallTimer+=dt;
+        if(_stallTimer>=_cfg.stallTime && _blockedDirection==0) {
+            _blockedDirection=dir;
+            _blockedAngle=angle;
+            _blockedTimer=_cfg.stallRetry;
+            _stallTimer=0.0f;
+            _trips++;
+        }
+    } else {
+        _stallDirection=0;
+        _stallTimer=0.0f;
+    }
+
+    if(_thermalTripped || _overcurrentTimer>0.0f) {
+        return 0.0f;
+    }
+    if(dir!=0 && dir==_blockedDirection) {
+        return 0.0f;
+    }
+    return command;
+}
+
+MotorFault MotorProtection::getFault() const
+{
+    if(_overcurrentTimer>0.0f) return MotorFault::OVERCURRENT;
+    if(_thermalTripped)        return MotorFault::THERMAL;
+    if(_blockedDirection!=0)   return MotorFault::STALL;
+    return MotorFault::NONE;
+}
+
+int MotorProtection::getBlockedDirection() const
+{
+    return _blockedDirection;
+}
+
+float MotorProtection::getThermalLoad() const
+{
+    return _thermal;
+}
+
+std::uint32_t MotorProtection::getTripCount() const
+{
+    return _trips;
+}
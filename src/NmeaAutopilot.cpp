@@ -0,0 +1,173 @@
+#include "NmeaAutopilot.h"
+#include <cmath>
+
+namespace {
+
+const char MODE_LETTERS[] = { 'O', 'H', 'C', 'W' };    // by AutoSteeringMode
+
+float wrap360(float deg) {
+    deg = std::fmod(deg, 360.f);
+    return deg < 0.f ? deg + 360.f : deg;
+}
+
+} // namespace
+
+NmeaAutopilot::NmeaAutopilot(AutoSteeringController& steer)
+: _steer(steer)
+, _output(nullptr)
+, _ctx(nullptr)
+, _started(false)
+, _sent(0)
+, _commands(0)
+, _rejected(0)
+{
+    _period[HDG] = 1000;
+    _period[RSA] = 500;
+    _period[APB] = 0;
+    _period[STATUS] = 1000;
+    for(int i=0; i<SENTENCE_COUNT; i++) {
+        _due[i] = 0;
+    }
+    _last.mode = AutoSteeringMode::OFF;
+    _last.setpoint = 0.f;
+    _last.heading = NAN;
+    _last.windAngle = NAN;
+    _last.rudderAngle = NAN;
+}
+
+void NmeaAutopilot::setPeriod(Sentence sentence, std::uint32_t ms) {
+    if(sentence < SENTENCE_COUNT) {
+        _period[sentence] = ms;
+    }
+}
+
+std::size_t NmeaAutopilot::format(Sentence sentence, const AutopilotTelemetry& t,
+                                  char* out, std::size_t size) {
+    NmeaWriter w(out, size);
+    switch(sentence) {
+        case HDG:
+            w.begin("APHDG");
+            w.field(t.heading, 1);
+            w.empty();
+            w.empty();
+            w.empty();
+            w.empty();
+            break;
+        case RSA:
+            // starboard (or single) rudder, no port rudder sensor
+            w.begin("APRSA");
+            w.field(t.rudderAngle, 1);
+            w.field(std::isnan(t.rudderAngle) ? 'V' : 'A');
+            w.empty();
+            w.field('V');
+            break;
+        case APB: {
+            bool on = t.mode != AutoSteeringMode::OFF;
+            w.begin("APAPB");
+            w.field(on ? 'A' : 'V');
+            w.field(on ? 'A' : 'V');
+            w.empty();          // XTE, direction, unit
+            w.empty();
+            w.field('N');
+            w.field('V');       // arrival circle, perpendicular
+            w.field('V');
+            w.empty();          // bearings and waypoint
+            w.empty();
+            w.empty();
+            w.empty();
+            w.empty();
+            if(t.mode == AutoSteeringMode::TRACK_HEADING) {
+                w.field(t.setpoint, 1);
+                w.field('M');
+            } else {
+                w.empty();
+                w.empty();
+            }
+            w.empty();          // mode indicator
+            break;
+        }
+        case STATUS:
+            w.begin("PXAPS");
+            w.field(MODE_LETTERS[(int)t.mode & 3]);
+            w.field(t.setpoint, 1);
+            w.field(t.heading, 1);
+            w.field(t.rudderAngle, 1);
+            break;
+        default:
+            return 0;
+    }
+    return w.finish();
+}
+
+void NmeaAutopilot::update(std::uint32_t nowMs, const AutopilotTelemetry& t) {
+    _last = t;
+    if(!_started) {
+        _started = true;
+        for(int i=0; i<SENTENCE_COUNT; i++) {
+            _due[i] = nowMs;
+        }
+    }
+    std::size_t len = 0;
+    for(int i=0; i<SENTENCE_COUNT; i++) {
+        if(_period[i] == 0 || (std::int32_t)(nowMs - _due[i]) < 0) {
+            continue;
+        }
+        _due[i] += _period[i];
+        // fell behind (or the period changed): no burst to catch up
+        if((std::int32_t)(nowMs - _due[i]) >= 0) {
+            _due[i] = nowMs + _period[i];
+        }
+        std::size_t n = format((Sentence)i, t, _buf + len, sizeof(_buf) - len);
+        if(n > 0) {
+            len += n;
+            _sent++;
+        }
+    }
+    if(len > 0 && _output) {
+        _output(_buf, len, _ctx);
+    }
+}
+
+bool NmeaAutopilot::handle(const NmeaSentence& s, SteeringCommand& applied) {
+    if(s.type != NmeaType::PILOT) {
+        return false;
+    }
+    float sp = s.pilot.setpoint;
+    bool keep = std::isnan(sp);
+    switch(s.pilot.mode) {
+        case 'O':
+            applied.mode = AutoSteeringMode::OFF;
+            break;
+        case 'H':
+            applied.mode = AutoSteeringMode::TRACK_HEADING;
+            if(keep) {
+                sp = (_last.mode == AutoSteeringMode::TRACK_HEADING) ? _last.setpoint : _last.heading;
+            }
+            sp = wrap360(sp);
+            break;
+        case 'C':
+            applied.mode = AutoSteeringMode::TRACK_COURSE;
+            if(keep && _last.mode == AutoSteeringMode::TRACK_COURSE) sp = _last.setpoint;
+            sp = wrap360(sp);
+            break;
+        case 'W':
+            // true wind angle, -180..180, negative to port
+            applied.mode = AutoSteeringMode::TRACK_WIND_ANGLE;
+            if(keep) {
+                sp = (_last.mode == AutoSteeringMode::TRACK_WIND_ANGLE) ? _last.setpoint : _last.windAngle;
+            }
+            if(sp > 180.f || sp < -180.f) sp = NAN;
+            break;
+        default:
+            _rejected++;
+            return false;
+    }
+    if(applied.mode != AutoSteeringMode::OFF && std::isnan(sp)) {
+        _rejected++;
+        return false;
+    }
+    applied.param = (applied.mode == AutoSteeringMode::OFF) ? 0.f : sp;
+    _steer.setMode(applied.mode, applied.param);
+    _commands++;
+    return true;
+}
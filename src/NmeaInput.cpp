@@ -0,0 +1,142 @@
+#include "NmeaInput.h"
+#include <cstring>
+
+NmeaInput::NmeaInput()
+: _count(0)
+, _windowMs(0)
+, _windowStarted(false)
+, _handler(nullptr)
+, _ctx(nullptr)
+{
+    for(std::size_t i=0; i<MAX_SOURCES; i++) {
+        Source& s = _sources[i];
+        s.owner = this;
+        s.index = i;
+        s.src = nullptr;
+        s.name = "";
+        s.bytes.store(0);
+        s.dropped.store(0);
+        s.gap = false;
+        s.windowStart = 0;
+        s.rate = 0.f;
+        s.parser.setHandler(onSentence, &s);
+    }
+}
+
+int NmeaInput::addSource(IPacketSource* src, const char* name) {
+    if(_count >= MAX_SOURCES) {
+        return -1;
+    }
+    _sources[_count].src = src;
+    _sources[_count].name = name;
+    return (int)_count++;
+}
+
+const char* NmeaInput::sourceName(std::size_t source) const {
+    return source < _count ? _sources[source].name : "";
+}
+
+bool NmeaInput::enqueue(std::size_t source, const char* data, std::size_t len) {
+    Source& s = _sources[source];
+    s.bytes.fetch_add((std::uint32_t)len, std::memory_order_relaxed);
+    _reading.source = (std::uint8_t)source;
+    _reading.gap = s.gap;
+    _reading.len = (std::uint16_t)len;
+    if(data != _reading.data) {
+        std::memcpy(_reading.data, data, len);
+    }
+    if(!_ring.push(_reading)) {
+        s.dropped.fetch_add((std::uint32_t)len, std::memory_order_relaxed);
+        s.gap = true;
+        return false;
+    }
+    s.gap = false;
+    return true;
+}
+
+void NmeaInput::poll() {
+    for(std::size_t i=0; i<_count; i++) {
+        IPacketSource* src = _sources[i].src;
+        if(!src) continue;
+        // bounded, so a flooding source cannot starve the others
+        for(std::size_t n=0; n<RING_SIZE; n++) {
+            // fill the chunk: datagrams and segments are often a
+            // sentence or less, a chunk each would fill the ring
+            std::size_t len = 0;
+            while(len < CHUNK_SIZE) {
+                std::size_t got = src->receive(_reading.data + len, CHUNK_SIZE - len);
+                if(got == 0) break;
+                len += got;
+            }
+            if(len == 0) break;
+            enqueue(i, _reading.data, len);
+            if(len < CHUNK_SIZE) break;
+        }
+    }
+}
+
+bool NmeaInput::push(std::size_t source, const char* data, std::size_t len) {
+    if(source >= _count) {
+        return false;
+    }
+    bool ok = true;
+    while(len > 0) {
+        std::size_t n = len < CHUNK_SIZE ? len : CHUNK_SIZE;
+        ok = enqueue(source, data, n) && ok;
+        data += n;
+        len -= n;
+    }
+    return ok;
+}
+
+void NmeaInput::service(std::uint32_t nowMs) {
+    while(_ring.pop(_parsing)) {
+        if(_parsing.source < _count) {
+            NmeaParser& parser = _sources[_parsing.source].parser;
+            if(_parsing.gap) {
+                parser.reset();
+            }
+            parser.feed(_parsing.data, _parsing.len);
+        }
+    }
+
+    if(!_windowStarted) {
+        _windowStarted = true;
+        _windowMs = nowMs;
+        return;
+    }
+    std::uint32_t elapsed = nowMs - _windowMs;
+    if(elapsed < RATE_WINDOW_MS) {
+        return;
+    }
+    for(std::size_t i=0; i<_count; i++) {
+        Source& s = _sources[i];
+        std::uint32_t decoded = s.parser.decoded();
+        s.rate = (decoded - s.windowStart) * 1000.f / elapsed;
+        s.windowStart = decoded;
+    }
+    _windowMs = nowMs;
+}
+
+NmeaSourceStats NmeaInput::stats(std::size_t source) const {
+    NmeaSourceStats st = {};
+    if(source >= _count) {
+        return st;
+    }
+    const Source& s = _sources[source];
+    st.bytes          = s.bytes.load(std::memory_order_relaxed);
+    st.dropped        = s.dropped.load(std::memory_order_relaxed);
+    st.sentences      = s.parser.decoded();
+    st.ignored        = s.parser.ignored();
+    st.checksumErrors = s.parser.checksumErrors();
+    st.malformed      = s.parser.malformed();
+    st.rate           = s.rate;
+    return st;
+}
+
+void NmeaInput::onSentence(const NmeaSentence& sentence, void* ctx) {
+    Source& s = *static_cast<Source*>(ctx);
+    if(s.owner->_handler) {
+        s.owner->_handler(s.index, sentence, s.owner->_ctx);
+    }
+}
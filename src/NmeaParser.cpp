@@ -0,0 +1,398 @@
+#include "NmeaParser.h"
+#include <cmath>
+#include <cstring>
+
+static const float KMH_TO_KN = 1.f / 1.852f;
+static const float MS_TO_KN  = 3600.f / 1852.f;
+static const float MPH_TO_KN = 1609.344f / 1852.f;
+
+namespace {
+
+const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                         1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+/** The fields of one sentence, split by offset in the parser's buffer. */
+struct Fields {
+    const char*         buf;
+    std::size_t         len;
+    const std::uint8_t* start;
+    int                 count;
+
+    // Field i, empty past the last one
+    const char* at(int i, std::size_t& n) const {
+        if(i >= count) {
+            n = 0;
+            return buf;
+        }
+        std::size_t end = (i + 1 < count) ? start[i + 1] - 1u : len;
+        n = end - start[i];
+        return buf + start[i];
+    }
+
+    char letter(int i) const {
+        std::size_t n;
+        const char* p = at(i, n);
+        return n == 1 ? p[0] : '\0';
+    }
+};
+
+/**
+ * [-]digits[.digits] as mantissa and decimals; digits beyond maxDigits
+ * are past the precision of the result and dropped. False if the field
+ * is not a number.
+ */
+bool parseDecimal(const char* p, std::size_t n, int maxDigits,
+                  std::uint64_t& mantissa, int& decimals, bool& negative) {
+    std::size_t i = 0;
+    negative = false;
+    if(n > 0 && (p[0] == '-' || p[0] == '+')) {
+        negative = (p[0] == '-');
+        i = 1;
+    }
+    mantissa = 0;
+    decimals = -1;
+    int digits = 0;
+    for(; i<n; i++) {
+        char c = p[i];
+        if(c == '.') {
+            if(decimals >= 0) return false;
+            decimals = 0;
+            continue;
+        }
+        if(c < '0' || c > '9') return false;
+        if(digits >= maxDigits) {
+            if(decimals < 0) return false;    // integer part too long
+            continue;
+        }
+        mantissa = mantissa * 10u + (std::uint64_t)(c - '0');
+        digits++;
+        if(decimals >= 0) decimals++;
+    }
+    if(decimals < 0) decimals = 0;
+    return digits > 0;
+}
+
+// Number field, NAN if empty; false if malformed
+bool number(const Fields& f, int i, float& out) {
+    std::size_t n;
+    const char* p = f.at(i, n);
+    out = NAN;
+    if(n == 0) return true;
+    std::uint64_t m;
+    int dec;
+    bool neg;
+    if(!parseDecimal(p, n, 9, m, dec, neg)) return false;
+    float v = (float)(std::uint32_t)m / (float)POW10[dec];
+    out = neg ? -v : v;
+    return true;
+}
+
+// Number with a unit or side letter: the value if the letter matches
+// (or is empty), NAN for another letter
+bool numberIf(const Fields& f, int i, char unit, float& out) {
+    if(!number(f, i, out)) return false;
+    char u = f.letter(i + 1);
+    if(u != unit && u != '\0') out = NAN;
+    return true;
+}
+
+// Angle with E/W, east positive
+bool eastWest(const Fields& f, int i, float& out) {
+    if(!number(f, i, out)) return false;
+    char side = f.letter(i + 1);
+    if(side == 'W') out = -out;
+    else if(side != 'E') out = NAN;
+    return true;
+}
+
+// (d)ddmm.mmmm and its hemisphere, degrees positive north and east
+bool latLon(const Fields& f, int i, char positive, char negative, double& out) {
+    std::size_t n;
+    const char* p = f.at(i, n);
+    out = NAN;
+    if(n == 0) return true;
+    std::uint64_t m;
+    int dec;
+    bool neg;
+    if(!parseDecimal(p, n, 15, m, dec, neg) || neg) return false;
+    double minutes = (double)m / POW10[dec];
+    double degrees = std::floor(minutes / 100.0);
+    minutes -= degrees * 100.0;
+    out = degrees + minutes / 60.0;
+    char side = f.letter(i + 1);
+    if(side == negative) out = -out;
+    else if(side != positive) out = NAN;
+    return true;
+}
+
+int twoDigits(const char* p) {
+    if(p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9') return -1;
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+// hhmmss[.sss] as ms of the day
+bool timeOfDay(const Fields& f, int i, std::uint32_t& ms) {
+    std::size_t n;
+    const char* p = f.at(i, n);
+    ms = 0;
+    if(n == 0) return true;
+    if(n < 6) return false;
+    int h = twoDigits(p), m = twoDigits(p + 2), s = twoDigits(p + 4);
+    if(h < 0 || m < 0 || s < 0) return false;
+    std::uint32_t frac = 0;
+    if(n > 6) {
+        if(p[6] != '.') return false;
+        std::uint32_t scale = 100;
+        for(std::size_t k=7; k<n; k++) {
+            if(p[k] < '0' || p[k] > '9') return false;
+            frac += (std::uint32_t)(p[k] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    ms = ((std::uint32_t)h * 3600u + (std::uint32_t)m * 60u + (std::uint32_t)s) * 1000u + frac;
+    return true;
+}
+
+bool decodeRMC(const Fields& f, NmeaRMC& out) {
+    bool ok = timeOfDay(f, 1, out.timeMs);
+    out.valid = f.letter(2) == 'A';
+    ok = ok && latLon(f, 3, 'N', 'S', out.latitude) && latLon(f, 5, 'E', 'W', out.longitude);
+    ok = ok && number(f, 7, out.sog) && number(f, 8, out.cog) && eastWest(f, 10, out.variation);
+    out.day = out.month = 0;
+    out.year = 0;
+    std::size_t n;
+    const char* date = f.at(9, n);
+    if(n == 6) {
+        int d = twoDigits(date), m = twoDigits(date + 2), y = twoDigits(date + 4);
+        if(d < 0 || m < 0 || y < 0) return false;
+        out.day = (std::uint8_t)d;
+        out.month = (std::uint8_t)m;
+        out.year = (std::uint16_t)(y < 80 ? 2000 + y : 1900 + y);   // two digits only
+    } else if(n != 0) {
+        return false;
+    }
+    return ok;
+}
+
+bool decodeVTG(const Fields& f, NmeaVTG& out) {
+    float kmh;
+    bool ok = numberIf(f, 1, 'T', out.cogTrue) && numberIf(f, 3, 'M', out.cogMagnetic)
+           && numberIf(f, 5, 'N', out.sog) && numberIf(f, 7, 'K', kmh);
+    if(ok && std::isnan(out.sog)) {
+        out.sog = kmh * KMH_TO_KN;
+    }
+    return ok;
+}
+
+bool decodeHDG(const Fields& f, NmeaHDG& out) {
+    return number(f, 1, out.heading) && eastWest(f, 2, out.deviation) && eastWest(f, 4, out.variation);
+}
+
+bool decodeMWV(const Fields& f, NmeaMWV& out) {
+    if(!number(f, 1, out.angle) || !number(f, 3, out.speed)) return false;
+    char ref = f.letter(2);
+    out.relative = (ref == 'R');
+    out.valid = f.letter(5) == 'A' && (ref == 'R' || ref == 'T');
+    switch(f.letter(4)) {
+        case 'N': break;
+        case 'M': out.speed *= MS_TO_KN; break;
+        case 'K': out.speed *= KMH_TO_KN; break;
+        case 'S': out.speed *= MPH_TO_KN; break;
+        default:  out.speed = NAN; break;
+    }
+    return true;
+}
+
+bool decodeVHW(const Fields& f, NmeaVHW& out) {
+    float kmh;
+    bool ok = numberIf(f, 1, 'T', out.headingTrue) && numberIf(f, 3, 'M', out.headingMagnetic)
+           && numberIf(f, 5, 'N', out.speed) && numberIf(f, 7, 'K', kmh);
+    if(ok && std::isnan(out.speed)) {
+        out.speed = kmh * KMH_TO_KN;
+    }
+    return ok;
+}
+
+bool decodeXTE(const Fields& f, NmeaXTE& out) {
+    if(!number(f, 3, out.error)) return false;
+    char dir = f.letter(4);
+    if(dir == 'L') out.error = -out.error;
+    else if(dir != 'R') out.error = NAN;
+    // mode N (NMEA 2.3) is data not valid
+    out.valid = f.letter(1) == 'A' && f.letter(2) == 'A' && f.letter(6) != 'N' && !std::isnan(out.error);
+    return true;
+}
+
+bool decodePilot(const Fields& f, NmeaPilotCommand& out) {
+    out.mode = f.letter(1);
+    if(out.mode != 'O' && out.mode != 'H' && out.mode != 'C' && out.mode != 'W') return false;
+    return number(f, 2, out.setpoint);
+}
+
+struct SentenceInfo {
+    char     name[5];
+    NmeaType type;
+    int      minFields;   // including the address
+};
+
+const SentenceInfo SENTENCES[] = {
+    { "RMC", NmeaType::RMC, 12 },
+    { "VTG", NmeaType::VTG,  9 },
+    { "HDG", NmeaType::HDG,  6 },
+    { "MWV", NmeaType::MWV,  6 },
+    { "VHW", NmeaType::VHW,  9 },
+    { "XTE", NmeaType::XTE,  6 },
+};
+
+// Proprietary: manufacturer mnemonic and sentence after the P
+const SentenceInfo PROPRIETARY[] = {
+    { "XAPC", NmeaType::PILOT, 2 },
+};
+
+int hexDigit(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+} // namespace
+
+NmeaParser::NmeaParser()
+: _len(0)
+, _fields(0)
+, _state(State::IDLE)
+, _sum(0)
+, _check(0)
+, _handler(nullptr)
+, _ctx(nullptr)
+, _decoded(0)
+, _ignored(0)
+, _checksumErrors(0)
+, _malformed(0)
+{
+}
+
+void NmeaParser::reset() {
+    _state = State::IDLE;
+}
+
+void NmeaParser::feed(const char* data, std::size_t len) {
+    for(std::size_t i=0; i<len; i++) {
+        byte(data[i]);
+    }
+}
+
+void NmeaParser::byte(char c) {
+    if(c == '$') {
+        if(_state != State::IDLE) {
+            _malformed++;    // the previous one never ended
+        }
+        _len = 0;
+        _fields = 1;
+        _start[0] = 0;
+        _sum = 0;
+        _state = State::BODY;
+        return;
+    }
+    switch(_state) {
+        case State::IDLE:
+            return;    // line ends, noise, AIS (!)
+
+        case State::BODY:
+            if(c == '*') {
+                _state = State::CHECK_HI;
+                return;
+            }
+            // a line end here is a sentence without checksum
+            if(c < 0x20 || c > 0x7E || _len + 3 >= MAX_SENTENCE) {
+                _malformed++;
+                _state = State::IDLE;
+                return;
+            }
+            if(c == ',') {
+                if(_fields >= MAX_FIELDS) {
+                    _malformed++;
+                    _state = State::IDLE;
+                    return;
+                }
+                _start[_fields++] = (std::uint8_t)(_len + 1);
+            }
+            _sum ^= (std::uint8_t)c;
+            _buf[_len++] = c;
+            return;
+
+        case State::CHECK_HI:
+        case State::CHECK_LO: {
+            int d = hexDigit(c);
+            if(d < 0) {
+                _malformed++;
+                _state = State::IDLE;
+                return;
+            }
+            if(_state == State::CHECK_HI) {
+                _check = (std::uint8_t)(d << 4);
+                _state = State::CHECK_LO;
+                return;
+            }
+            _check |= (std::uint8_t)d;
+            _state = State::IDLE;
+            if(_check != _sum) {
+                _checksumErrors++;
+                return;
+            }
+            dispatch();
+            return;
+        }
+    }
+}
+
+void NmeaParser::dispatch() {
+    // Address: talker and sentence, e.g. GPRMC; P and the manufacturer's
+    // mnemonic and sentence if proprietary, e.g. PXAPC
+    std::size_t addr = (_fields > 1) ? _start[1] - 1u : _len;
+    if(addr != 5) {
+        _ignored++;
+        return;
+    }
+    bool proprietary = (_buf[0] == 'P');
+    const SentenceInfo* table = proprietary ? PROPRIETARY : SENTENCES;
+    std::size_t count = proprietary ? sizeof(PROPRIETARY) / sizeof(PROPRIETARY[0])
+                                    : sizeof(SENTENCES) / sizeof(SENTENCES[0]);
+    const char* name = proprietary ? _buf + 1 : _buf + 2;
+    for(std::size_t i=0; i<count; i++) {
+        const SentenceInfo& info = table[i];
+        if(std::strncmp(name, info.name, proprietary ? 4 : 3) != 0) {
+            continue;
+        }
+        NmeaSentence s;
+        s.type = info.type;
+        s.talker[0] = _buf[0];
+        s.talker[1] = proprietary ? '\0' : _buf[1];
+        s.talker[2] = '\0';
+        if(_fields < info.minFields || !decode(info.type, s)) {
+            _malformed++;
+            return;
+        }
+        _decoded++;
+        if(_handler) {
+            _handler(s, _ctx);
+        }
+        return;
+    }
+    _ignored++;
+}
+
+bool NmeaParser::decode(NmeaType type, NmeaSentence& out) const {
+    Fields f = { _buf, _len, _start, _fields };
+    switch(type) {
+        case NmeaType::RMC: return decodeRMC(f, out.rmc);
+        case NmeaType::VTG: return decodeVTG(f, out.vtg);
+        case NmeaType::HDG: return decodeHDG(f, out.hdg);
+        case NmeaType::MWV: return decodeMWV(f, out.mwv);
+        case NmeaType::VHW: return decodeVHW(f, out.vhw);
+        case NmeaType::XTE: return decodeXTE(f, out.xte);
+        case NmeaType::PILOT: return decodePilot(f, out.pilot);
+    }
+    return false;
+}
@@ -0,0 +1,95 @@
+#include "NmeaWriter.h"
+#include <cmath>
+
+namespace {
+
+const float POW10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f };
+
+const char HEX[] = "0123456789ABCDEF";
+
+} // namespace
+
+NmeaWriter::NmeaWriter(char* buf, std::size_t size)
+: _buf(buf)
+, _size(size < MAX_LENGTH + 1 ? size : MAX_LENGTH + 1)
+, _len(0)
+, _sum(0)
+, _overflow(false)
+{
+}
+
+void NmeaWriter::put(char c) {
+    // room for *hh CR LF and the terminator stays free
+    if(_len + 1 + 6 > _size) {
+        _overflow = true;
+        return;
+    }
+    _buf[_len++] = c;
+    _sum ^= (std::uint8_t)c;
+}
+
+void NmeaWriter::begin(const char* address) {
+    _len = 0;
+    _overflow = false;
+    // '$' is not in the checksum, but needs the same room
+    put('$');
+    _sum = 0;
+    while(*address) {
+        put(*address++);
+    }
+}
+
+void NmeaWriter::field(float value, int decimals) {
+    put(',');
+    if(decimals < 0) decimals = 0;
+    if(decimals > 6) decimals = 6;
+    float scaled = std::fabs(value) * POW10[decimals] + 0.5f;
+    // NAN fails the comparison
+    if(!(scaled < 4294967040.f)) {
+        return;
+    }
+    std::uint32_t v = (std::uint32_t)scaled;
+    if(value < 0.f && v != 0) {
+        put('-');
+    }
+    // digits come out backwards
+    char digits[16];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while(v != 0 || n <= decimals);
+    while(n > 0) {
+        if(n == decimals) put('.');
+        put(digits[--n]);
+    }
+}
+
+void NmeaWriter::field(char letter) {
+    put(',');
+    if(letter) put(letter);
+}
+
+void NmeaWriter::field(const char* text) {
+    put(',');
+    while(*text) {
+        put(*text++);
+    }
+}
+
+void NmeaWriter::empty() {
+    put(',');
+}
+
+std::size_t NmeaWriter::finish() {
+    if(_overflow || _len + 6 > _size) {
+        return 0;
+    }
+    _buf[_len++] = '*';
+    _buf[_len++] = HEX[_sum >> 4];
+    _buf[_len++] = HEX[_sum & 0x0F];
+    _buf[_len++] = '\r';
+    _buf[_len++] = '\n';
+    _buf[_len] = '\0';
+    return _len;
+}
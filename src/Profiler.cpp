@@ -0,0 +1,124 @@
+#include "Profiler.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static ProfileSite*             s_sites[Profiler::MAX_SITES];
+static std::atomic<std::size_t> s_siteCount(0);
+static std::atomic<std::size_t> s_dropped(0);
+
+std::atomic<std::uint32_t> ProfileSite::s_generation(0);
+
+ProfileSite::ProfileSite(const char* name)
+ : _name(name)
+ , _generation(s_generation.load())
+{
+    reset();
+    Profiler::add(this);
+}
+
+void ProfileSite::reset()
+{
+    _count=0;
+    _min=UINT32_MAX;
+    _max=0;
+    _total=0;
+    for(int k=0; k<BUCKETS; k++) {
+        _histogram[k]=0;
+    }
+}
+
+void Profiler::add(ProfileSite* s)
+{
+    // Sites may be constructed on both cores at once
+    std::size_t i=s_siteCount.load();
+    do {
+        if(i>=MAX_SITES) {
+            s_dropped++;
+            return;
+        }
+    } while(!s_siteCount.compare_exchange_weak(i, i+1));
+    s_sites[i]=s;
+}
+
+float Profiler::ticksPerMicrosecond()
+{
+#ifdef ARDUINO
+    return (float)getCpuFrequencyMhz();
+#else
+    return 1000.0f;
+#endif
+}
+
+std::size_t Profiler::siteCount()
+{
+    return s_siteCount.load();
+}
+
+ProfileSite* Profiler::site(std::size_t i)
+{
+    return (i<siteCount()) ? s_sites[i] : nullptr;
+}
+
+ProfileSite* Profiler::find(const char* name)
+{
+    for(std::size_t i=0; i<siteCount(); i++) {
+        if(s_sites[i] && !std::strcmp(s_sites[i]->name(), name)) {
+            return s_sites[i];
+        }
+    }
+    return nullptr;
+}
+
+std::size_t Profiler::droppedSites()
+{
+    return s_dropped.load();
+}
+
+void Profiler::resetAll()
+{
+    // The counters belong to the recording tasks, possibly on the other
+    // core: they clear them themselves when they see the new generation
+    ProfileSite::s_generation.fetch_add(1, std::memory_order_release);
+}
+
+bool Profiler::formatSite(const ProfileSite& s, char* buf, std::size_t len)
+{
+    const float perUs=ticksPerMicrosecond();
+    int n=std::snprintf(buf, len, "%-16s %8u x  min %.2f  mean %.2f  max %.2f us |",
+                        s.name(), (unsigned)s.count(), s.min()/perUs, s.mean()/perUs,
+                        s.max()/perUs);
+    if(n<0 || (std::size_t)n>=len) {
+        return false;
+    }
+    for(int k=0; k<ProfileSite::BUCKETS; k++) {
+        if(!s.bucket(k)) {
+            continue;
+        }
+        int m=std::snprintf(buf+n, len-n, " 2^%d:%u", k, (unsigned)s.bucket(k));
+        if(m<0 || (std::size_t)(n+m)>=len) {
+            return false;
+        }
+        n+=m;
+    }
+    return true;
+}
+
+void Profiler::report(ProfileLineFn fn, void* context)
+{
+    char line[256];
+    std::snprintf(line, sizeof(line), "[Prof] %u sites, %.0f ticks/us, histogram in log2 ticks",
+                  (unsigned)siteCount(), ticksPerMicrosecond());
+    fn(line, context);
+    for(std::size_t i=0; i<siteCount(); i++) {
+        if(s_sites[i]) {
+            // An overlong histogram is cut, the figures come first
+            formatSite(*s_sites[i], line, sizeof(line));
+            fn(line, context);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#include "RudderAngleSensor.h"
+
+RudderAngleSensor::RudderAngleSensor()
+ : _outputs(0),
+   _sequence(0)
+{
+}
+
+void RudderAngleSensor::addSamples(const std::uint16_t* raw, std::size_t count)
+{
+    for(std::size_t i=0; i<count; i++) {
+        if(!_cic.push(raw[i])) {
+            continue;
+        }
+        // The first outputs still contain the filter start-up
+        if(_outputs<CIC_ORDER-1) {
+            _outputs++;
+            continue;
+        }
+        // A DMA frame usually spans several outputs; the servo only ever
+        // wants the newest, so earlier ones are simply overwritten
+        RudderAngleSample s;
+        s.counts=_cic.output();
+        s.angle=_linearizer.apply(s.counts);
+        s.sequence=++_sequence;
+        _latest.write(s);
+    }
+}
+
+float RudderAngleSensor::getAngle() const
+{
+    RudderAngleSample s;
+    _latest.read(s);
+    return s.angle;
+}
+
+bool RudderAngleSensor::getSample(RudderAngleSample& out) const
+{
+    return _latest.read(out);
+}
+
+void RudderAngleSensor::reset()
+{
+    _cic.reset();
+    _outputs=0;
+}
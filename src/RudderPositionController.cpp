@@ -1,13 +1,19 @@
 #include "RudderPositionController.h"
 
-RudderPositionController::RudderPositionController(int pinMotorA, int pinMotorB, int analogPin)
+hw_timer_t*  RudderPositionController::s_timer=nullptr;
+TaskHandle_t RudderPositionController::s_task=nullptr;
+
+RudderPositionController::RudderPositionController(int pinMotorA, int pinMotorB, int analogPin, int currentPin)
  : _pinMotorA(pinMotorA),
    _pinMotorB(pinMotorB),
    _analogPin(analogPin),
-   _currentAngle(0.0f),
-   _targetAngle(0.0f),
-   _kp(1.0f), _ki(0.0f), _kd(0.0f),
-   _integral(0.0f), _lastError(0.0f),
+   _currentPin(currentPin),
+   _sampler(analogPin, _sensor, currentPin, &_currentSensor),
+   _continuous(false),
+   _command{0.0f, 0.0f, 1.0f, 0.0f, 0.0f, false, false, DriveProfile()},
+   _commandBox(_command),
+   _rateHz(DEFAULT_RATE_HZ),
+   _jitter(1000000UL/DEFAULT_RATE_HZ),
    _lastUpdate(0)
 {
 }
@@ -22,62 +28,230 @@ bool RudderPositionController::begin()
     ledcAttachPin(_pinMotorB, 1);
 
     pinMode(_analogPin, INPUT);
-    _lastUpdate=millis();
+    if(_currentPin>=0) {
+        pinMode(_currentPin, INPUT);
+    }
+    _lastUpdate=micros();
 
     Serial.println("[Rudder] Position controller started.");
     return true;
 }
 
+bool RudderPositionController::beginContinuousSampling()
+{
+    _sampler.applyFactoryCalibration(POT_MIN_ANGLE, POT_MAX_ANGLE);
+    _continuous=_sampler.begin();
+    return _continuous;
+}
+
+bool RudderPositionController::startTask(uint32_t rateHz, int core, uint8_t timerNum)
+{
+    if(s_task || rateHz==0) {
+        return false;
+    }
+    _rateHz=rateHz;
+    _jitter=LoopJitter(1000000UL/rateHz);
+
+    // Highest priority on its own core: only the timer ISR can preempt it
+    BaseType_t ok=xTaskCreatePinnedToCore(taskEntry, "rudder", 4096, this,
+                                          configMAX_PRIORITIES-1, &s_task, core);
+    if(ok!=pdPASS) {
+        s_task=nullptr;
+        Serial.println("[Rudder] Could not create servo task.");
+        return false;
+    }
+
+    // 1 MHz timer clock, alarm every period
+    s_timer=timerBegin(timerNum, 80, true);
+    if(!s_timer) {
+        Serial.println("[Rudder] Could not start servo timer.");
+        return false;
+    }
+    timerAttachInterrupt(s_timer, &onTimer, true);
+    timerAlarmWrite(s_timer, 1000000UL/rateHz, true);
+    timerAlarmEnable(s_timer);
+
+    Serial.printf("[Rudder] Servo loop at %u Hz on core %d.\n", (unsigned)rateHz, core);
+    return true;
+}
+
+void IRAM_ATTR RudderPositionController::onTimer()
+{
+    // analogRead and the LEDC driver are not ISR safe, so just wake the task
+    BaseType_t woken=pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    if(woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void RudderPositionController::taskEntry(void* arg)
+{
+    static_cast<RudderPositionController*>(arg)->taskLoop();
+}
+
+void RudderPositionController::taskLoop()
+{
+    uint32_t cycles=0;
+    _lastUpdate=micros();
+    for(;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t start=micros();
+        _jitter.cycleStart(start);
+        step((start-_lastUpdate)*1e-6f);
+        _lastUpdate=start;
+        _jitter.cycleEnd(micros());
+
+        if(++cycles>=_rateHz) {
+            cycles=0;
+            _jitterBox.write(_jitter.stats());
+        }
+    }
+}
+
 void RudderPositionController::setTargetAngle(float angleDeg)
 {
-    _targetAngle=angleDeg;
+    _command.targetAngle=angleDeg;
+    _commandBox.write(_command);
+}
+
+void RudderPositionController::setGains(float kp, float ki, float kd)
+{
+    _command.kp=kp;
+    _command.ki=ki;
+    _command.kd=kd;
+    _commandBox.write(_command);
+}
+
+void RudderPositionController::setEconomyMode(bool enabled)
+{
+    _command.economy=enabled;
+    _commandBox.write(_command);
+}
+
+void RudderPositionController::setSeaState(float seaState)
+{
+    _command.seaState=seaState;
+    _commandBox.write(_command);
+}
+
+void RudderPositionController::setDriveProfile(const DriveProfile& profile)
+{
+    _command.profile=profile;
+    _commandBox.write(_command);
+}
+
+void RudderPositionController::setTrajectoryEnabled(bool enabled)
+{
+    _command.shaped=enabled;
+    _commandBox.write(_command);
+}
+
+ServoActivity RudderPositionController::getActivity() const
+{
+    RudderStatus status;
+    _statusBox.read(status);
+    return status.activity;
+}
+
+LoopJitterStats RudderPositionController::getJitter() const
+{
+    LoopJitterStats stats;
+    _jitterBox.read(stats);
+    return stats;
 }
 
 void RudderPositionController::update()
 {
-    unsigned long now=millis();
-    float dt=(now-_lastUpdate)*0.001f;
-    if(dt<1e-3) dt=1e-3;
+    uint32_t now=micros();
+    float dt=(now-_lastUpdate)*1e-6f;
     _lastUpdate=now;
+    step(dt);
+}
+
+RudderStatus RudderPositionController::getStatus() const
+{
+    RudderStatus status;
+    _statusBox.read(status);
+    return status;
+}
 
-    // Read current angle
-    _currentAngle=readRudderSensor();
+void RudderPositionController::setProtectionConfig(const MotorProtectionConfig& cfg)
+{
+    _protection.setConfig(cfg);
+}
 
-    // PID
-    float error=_targetAngle-_currentAngle;
-    _integral+=error*dt;
-    float derivative=(error-_lastError)/dt;
-    float output= _kp*error + _ki*_integral + _kd*derivative;
-    _lastError=error;
+void RudderPositionController::step(float dt)
+{
+    RudderCommand cmd;
+    _commandBox.read(cmd);
+    _servo.setGains(cmd.kp, cmd.ki, cmd.kd);
+    _servo.setEconomyMode(cmd.economy);
+    _servo.setSeaState(cmd.seaState);
+    _servo.setDriveProfile(cmd.profile);
+    _servo.setTrajectoryEnabled(cmd.shaped);
+    _servo.setTargetAngle(cmd.targetAngle);
 
-    driveMotor(output);
+    RudderStatus status;
+    status.target=cmd.targetAngle;
+    status.angle=readRudderSensor();
+    status.current=readMotorCurrent();
+    float wanted=_servo.update(status.angle, dt);
+    status.command=wanted;
+    if(_currentPin>=0) {
+        status.command=_protection.limit(wanted, status.current, status.angle, dt);
+        if(status.command!=wanted) {
+            // blocked: don't wind up against the stop
+            _servo.clearIntegral();
+        }
+    }
+    driveMotor(status.command);
+
+    status.thermal=_protection.getThermalLoad();
+    status.fault=_protection.getFault();
+    status.trips=_protection.getTripCount();
+    status.economy=_servo.isEconomyMode();
+    status.activity=_servo.getActivity();
+    _statusBox.write(status);
 }
 
 float RudderPositionController::getCurrentAngle() const
 {
-    return _currentAngle;
+    RudderStatus status;
+    _statusBox.read(status);
+    return status.angle;
 }
 
 float RudderPositionController::readRudderSensor()
 {
+    if(_continuous) {
+        return _sensor.getAngle();
+    }
     int raw=analogRead(_analogPin);
-    float fraction=float(raw)/4095.0f;
-    float angleDeg=-25.0f+(fraction*50.0f);
-    return angleDeg;
+    return _sensor.linearizer().apply(float(raw));
 }
 
-void RudderPositionController::driveMotor(float output)
+float RudderPositionController::readMotorCurrent()
 {
-    float absOut=fabs(output);
-    if(absOut>30.0f) absOut=30.0f; // clamp maximum
+    if(_currentPin<0) {
+        return 0.0f;
+    }
+    if(_continuous) {
+        return _currentSensor.getCurrent();
+    }
+    return _currentSensor.toAmps(float(analogRead(_currentPin)));
+}
 
-    int duty=int((absOut/30.0f)*1023);
+void RudderPositionController::driveMotor(float command)
+{
+    int duty=int(fabs(command)*1023);
 
-    if(fabs(output)<0.01f) {
+    if(command==0.0f) {
         // stop
         ledcWrite(0,0);
         ledcWrite(1,0);
-    } else if(output>0) {
+    } else if(command>0) {
         // forward
         ledcWrite(0,duty);
         ledcWrite(1,0);
@@ -0,0 +1,236 @@
+#include "RudderServo.h"
+#include <cmath>
+
+// PID output (degrees of error equivalent) that maps to full duty
+static const float OUTPUT_FULL_SCALE = 30.0f;
+// Below this PID output the motor is stopped
+static const float OUTPUT_DEADBAND   = 0.01f;
+
+static int signOf(float v) {
+    return (v > 0.0f) ? 1 : ((v < 0.0f) ? -1 : 0);
+}
+
+RudderServo::RudderServo()
+ : _targetAngle(0.0f),
+   _heldTarget(0.0f),
+   _reference(0.0f),
+   _shaped(false),
+   _trajectoryPrimed(false),
+   _kp(1.0f), _ki(0.0f), _kd(0.0f),
+   _integral(0.0f), _lastError(0.0f),
+   _output(0.0f),
+   _economy(false),
+   _seaState(0.0f),
+   _moving(false),
+   _stoppedTime(0.0f),
+   _lastDirection(0),
+   _activity()
+{
+}
+
+void RudderServo::setGains(float kp, float ki, float kd)
+{
+    _kp=kp;
+    _ki=ki;
+    _kd=kd;
+}
+
+void RudderServo::setTargetAngle(float angleDeg)
+{
+    _targetAngle=angleDeg;
+}
+
+float RudderServo::getTargetAngle() const
+{
+    return _targetAngle;
+}
+
+void RudderServo::setEconomyMode(bool enabled)
+{
+    if(enabled && !_economy) {
+        _heldTarget=_targetAngle;
+        _moving=false;
+    }
+    _economy=enabled;
+}
+
+void RudderServo::setEconomyConfig(const EconomyConfig& cfg)
+{
+    _eco=cfg;
+}
+
+bool RudderServo::isEconomyMode() const
+{
+    return _economy;
+}
+
+void RudderServo::setTrajectoryEnabled(bool enabled)
+{
+    if(enabled && !_shaped) {
+        _trajectoryPrimed=false;
+    }
+    _shaped=enabled;
+}
+
+bool RudderServo::isTrajectoryEnabled() const
+{
+    return _shaped;
+}
+
+void RudderServo::setDriveProfile(const DriveProfile& profile)
+{
+    _trajectory.setProfile(profile);
+}
+
+float RudderServo::getReference() const
+{
+    return _reference;
+}
+
+void RudderServo::setSeaState(float seaState)
+{
+    _seaState=(seaState>0.0f) ? seaState : 0.0f;
+}
+
+float RudderServo::getDeadband() const
+{
+    float db=_eco.deadbandMin+_eco.deadbandPerSeaState*_seaState;
+    if(db>_eco.deadbandMax) db=_eco.deadbandMax;
+    return db;
+}
+
+float RudderServo::update(float measuredAngle, float dt)
+{
+    if(dt<1e-4f) dt=1e-4f;
+
+    float target=_targetAngle;
+    if(_economy) {
+        // Ignore target changes smaller than the deadband, they are
+        // mostly the heading loop reacting to single waves
+        if(std::fabs(_targetAngle-_heldTarget)>getDeadband()) {
+            _heldTarget=_targetAngle;
+        }
+        target=_heldTarget;
+    }
+
+    // The PID follows the trajectory, economy mode judges the move by
+    // where it ends
+    float reference=target;
+    float feedForward=0.0f;
+    if(_shaped) {
+        if(!_trajectoryPrimed) {
+            _trajectory.reset(measuredAngle);
+            _trajectoryPrimed=true;
+        }
+        reference=_trajectory.update(target, dt);
+        feedForward=_trajectory.getVelocity()/_trajectory.getProfile().fullDutyRate;
+    }
+    _reference=reference;
+
+    float output=pid(reference, measuredAngle, dt, feedForward);
+    if(_economy) {
+        output=economyShape(output, target-measuredAngle, dt);
+    }
+
+    countActivity(output, dt);
+    _stoppedTime=(output==0.0f) ? _stoppedTime+dt : 0.0f;
+    _output=output;
+    return _output;
+}
+
+float RudderServo::pid(float target, float measuredAngle, float dt, float feedForward)
+{
+    float error=target-measuredAngle;
+    _integral+=error*dt;
+    float derivative=(error-_lastError)/dt;
+    float output= _kp*error + _ki*_integral + _kd*derivative;
+    _lastError=error;
+
+    if(std::fabs(output)<OUTPUT_DEADBAND && feedForward==0.0f) {
+        return 0.0f;
+    }
+    float cmd=output/OUTPUT_FULL_SCALE+feedForward;
+    if(cmd>1.0f) cmd=1.0f;
+    if(cmd<-1.0f) cmd=-1.0f;
+    return cmd;
+}
+
+float RudderServo::economyShape(float output, float error, float dt)
+{
+    // Deadband with hysteresis: start only outside the deadband, then
+    // keep going until well inside it
+    float db=getDeadband();
+    float absErr=std::fabs(error);
+    if(_moving) {
+        if(absErr<db*_eco.holdRatio) _moving=false;
+    } else {
+        if(absErr>db) _moving=true;
+    }
+    if(!_moving) {
+        _integral=0.0f;
+        return 0.0f;
+    }
+
+    // Let the drive come to rest before reversing
+    int dir=signOf(output);
+    if(dir!=0 && _lastDirection!=0 && dir!=_lastDirection && _stoppedTime<_eco.reverseDelay) {
+        return 0.0f;
+    }
+
+    // Ramp up the command, stopping is immediate
+    float prev=(signOf(_output)==dir) ? _output : 0.0f;
+    float maxStep=_eco.commandSlew*dt;
+    if(std::fabs(output)>std::fabs(prev)+maxStep) {
+        output=prev+dir*maxStep;
+    }
+    return output;
+}
+
+void RudderServo::countActivity(float output, float dt)
+{
+    _activity.elapsed+=dt;
+    if(output==0.0f) {
+        return;
+    }
+    _activity.motorOnTime+=dt;
+    int dir=signOf(output);
+    if(_lastDirection!=0 && dir!=_lastDirection) {
+        _activity.reversals++;
+    }
+    if(_output==0.0f || dir!=signOf(_output)) {
+        _activity.motorStarts++;
+    }
+    _lastDirection=dir;
+}
+
+float RudderServo::getOutput() const
+{
+    return _output;
+}
+
+void RudderServo::reset()
+{
+    _integral=0.0f;
+    _lastError=0.0f;
+    _output=0.0f;
+    _heldTarget=_targetAngle;
+    _trajectoryPrimed=false;
+    _moving=false;
+    _stoppedTime=0.0f;
+    _lastDirection=0;
+}
+
+void RudderServo::clearIntegral()
+{
+    _integral=0.0f;
+}
+
+const ServoActivity& RudderServo::getActivity() const
+{
+    return _activity;
+}
+
+void RudderServo::resetActivity()
+{
+    _activity=ServoActivity();
+}
@@ -0,0 +1,158 @@
+#include "Scheduler.h"
+#include <cmath>
+
+Scheduler::Scheduler(const ITimeProvider& time, const SchedTask* tasks, TaskStats* stats,
+                     std::size_t count)
+ : _time(time),
+   _tasks(tasks),
+   _stats(stats),
+   _count(count)
+{
+}
+
+bool Scheduler::begin()
+{
+    if(_count==0 || _count>MAX_TASKS) {
+        return false;
+    }
+    for(std::size_t i=0; i<_count; i++) {
+        if(_tasks[i].period==0 || !_tasks[i].run) {
+            return false;
+        }
+    }
+
+    // Rate-monotonic order: period, then declared priority, then table order
+    // (insertion sort, the table is tiny)
+    for(std::size_t i=0; i<_count; i++) {
+        std::size_t j=i;
+        while(j>0) {
+            const SchedTask& a=_tasks[_order[j-1]];
+            const SchedTask& b=_tasks[i];
+            bool before=(b.period<a.period) || (b.period==a.period && b.priority<a.priority);
+            if(!before) break;
+            _order[j]=_order[j-1];
+            j--;
+        }
+        _order[j]=(std::uint8_t)i;
+    }
+
+    std::uint64_t now=_time.getMicros();
+    for(std::size_t i=0; i<_count; i++) {
+        _release[i]=now+_tasks[i].offset;
+    }
+    resetStats();
+    return true;
+}
+
+void Scheduler::resetStats()
+{
+    for(std::size_t i=0; i<_count; i++) {
+        _stats[i]=TaskStats();
+        _stats[i].minExec=UINT32_MAX;
+    }
+}
+
+std::uint32_t Scheduler::deadlineOf(std::size_t i) const
+{
+    return _tasks[i].deadline ? _tasks[i].deadline : _tasks[i].period;
+}
+
+bool Scheduler::runOnce()
+{
+    std::uint64_t now=_time.getMicros();
+
+    // Highest priority released task
+    std::size_t pick=_count;
+    for(std::size_t k=0; k<_count; k++) {
+        std::size_t i=_order[k];
+        if(now>=_release[i]) {
+            pick=i;
+            break;
+        }
+    }
+    if(pick==_count) {
+        return false;
+    }
+
+    const SchedTask& t=_tasks[pick];
+    TaskStats& s=_stats[pick];
+    std::uint64_t release=_release[pick];
+
+    t.run(t.context);
+    std::uint64_t end=_time.getMicros();
+
+    std::uint32_t exec=std::uint32_t(end-now);
+    std::uint32_t lateness=std::uint32_t(now-release);
+    s.runs++;
+    s.totalExec+=exec;
+    if(exec<s.minExec) s.minExec=exec;
+    if(exec>s.maxExec) s.maxExec=exec;
+    if(lateness>s.maxLateness) s.maxLateness=lateness;
+    if(end>release+deadlineOf(pick)) s.overruns++;
+
+    // Next release keeps the phase; releases already in the past are
+    // dropped rather than run back to back
+    std::uint64_t next=release+t.period;
+    if(next<=end) {
+        std::uint64_t behind=(end-next)/t.period+1;
+        s.skipped+=std::uint32_t(behind);
+        next+=behind*t.period;
+    }
+    _release[pick]=next;
+    return true;
+}
+
+std::uint64_t Scheduler::idleTime() const
+{
+    std::uint64_t now=_time.getMicros();
+    std::uint64_t soonest=UINT64_MAX;
+    for(std::size_t i=0; i<_count; i++) {
+        if(_release[i]<=now) {
+            return 0;
+        }
+        if(_release[i]-now<soonest) {
+            soonest=_release[i]-now;
+        }
+    }
+    return (soonest==UINT64_MAX) ? 0 : soonest;
+}
+
+std::size_t Scheduler::size() const
+{
+    return _count;
+}
+
+const SchedTask& Scheduler::task(std::size_t i) const
+{
+    return _tasks[i];
+}
+
+const TaskStats& Scheduler::stats(std::size_t i) const
+{
+    return _stats[i];
+}
+
+float Scheduler::utilization() const
+{
+    float u=0.0f;
+    for(std::size_t i=0; i<_count; i++) {
+        u+=float(_stats[i].maxExec)/float(_tasks[i].period);
+    }
+    return u;
+}
+
+bool Scheduler::isSchedulable() const
+{
+    float n=float(_count);
+    if(utilization()>n*(std::pow(2.0f, 1.0f/n)-1.0f)) {
+        return false;
+    }
+    // Non-preemptive: a running task blocks everything else, so the
+    // longest one has to fit into the tightest deadline
+    std::uint32_t longest=0, tightest=UINT32_MAX;
+    for(std::size_t i=0; i<_count; i++) {
+        if(_stats[i].maxExec>longest) longest=_stats[i].maxExec;
+        if(deadlineOf(i)<tightest) tightest=deadlineOf(i);
+    }
+    return longest<=tightest;
+}
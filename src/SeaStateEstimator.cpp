@@ -0,0 +1,34 @@
+#include "SeaStateEstimator.h"
+#include <cmath>
+
+SeaStateEstimator::SeaStateEstimator(float timeConstant)
+: _tau(timeConstant)
+, _mean(0.f)
+, _variance(0.f)
+, _primed(false)
+{
+}
+
+void SeaStateEstimator::addSample(float yawRate, float dt) {
+    if(!_primed) {
+        _mean = yawRate;
+        _variance = 0.f;
+        _primed = true;
+        return;
+    }
+    float alpha = dt / (_tau + dt);
+    float diff = yawRate - _mean;
+    _mean += alpha * diff;
+    // exponentially weighted variance (West 1979)
+    _variance = (1.f - alpha) * (_variance + alpha * diff * diff);
+}
+
+float SeaStateEstimator::getSeaState() const {
+    return std::sqrt(_variance);
+}
+
+void SeaStateEstimator::reset() {
+    _mean = 0.f;
+    _variance = 0.f;
+    _primed = false;
+}
@@ -0,0 +1,201 @@
+#include "SourceArbiter.h"
+#include <climits>
+#include <cmath>
+
+namespace {
+
+const float         DEG_TO_RAD     = 3.14159265358979f / 180.f;
+const std::uint32_t RATE_WINDOW_MS = 1000;
+
+float wrap360(float deg) {
+    deg = std::fmod(deg, 360.f);
+    return deg < 0.f ? deg + 360.f : deg;
+}
+
+float wrap180(float deg) {
+    deg = wrap360(deg);
+    return deg >= 180.f ? deg - 360.f : deg;
+}
+
+} // namespace
+
+SourceArbiter::SourceArbiter()
+: _count(0)
+, _recoveryMs(5000)
+, _blendMs(2000)
+, _level(-1)
+, _output(0.f)
+, _offset(0.f)
+, _switchMs(0)
+, _switches(0)
+{
+}
+
+int SourceArbiter::addSource(const ArbiterSourceConfig& config) {
+    if(_count >= MAX_SOURCES) {
+        return -1;
+    }
+    Source& s = _sources[_count];
+    s.config = config;
+    s.last.value = 0.f;
+    s.last.quality = 0.f;
+    s.last.timeMs = 0;
+    s.seen = false;
+    s.version = 0;
+    s.ageMs = UINT32_MAX;
+    s.windowStarted = false;
+    s.windowStart = 0;
+    s.windowCount = 0;
+    s.rate = -1.f;
+    s.changedMs = 0;
+    s.stuck = false;
+    s.healthy = false;
+    s.healthySince = 0;
+    return (int)_count++;
+}
+
+const char* SourceArbiter::sourceName(std::size_t source) const {
+    return source < _count ? _sources[source].config.name : "";
+}
+
+void SourceArbiter::publish(std::size_t source, float value, float quality, std::uint32_t nowMs) {
+    if(source >= _count || std::isnan(value)) {
+        return;
+    }
+    Sample s = { value, quality, nowMs };
+    _sources[source].box.write(s);
+}
+
+bool SourceArbiter::isHealthy(Source& s, std::uint32_t nowMs) {
+    std::uint32_t version = s.box.version();
+    if(version != s.version) {
+        s.windowCount += version - s.version;
+        s.version = version;
+        float previous = s.last.value;
+        bool seen = s.seen;
+        s.seen = s.box.read(s.last);
+        if(s.seen && (!seen || s.last.value != previous)) {
+            s.changedMs = s.last.timeMs;
+        }
+    }
+
+    // samples per second over whole windows; unknown (<0) at first
+    if(!s.windowStarted) {
+        s.windowStarted = true;
+        s.windowStart = nowMs;
+    }
+    std::uint32_t elapsed = nowMs - s.windowStart;
+    if(elapsed >= RATE_WINDOW_MS) {
+        s.rate = s.windowCount * 1000.f / elapsed;
+        s.windowStart = nowMs;
+        s.windowCount = 0;
+    }
+
+    std::int32_t age = (std::int32_t)(nowMs - s.last.timeMs);
+    s.ageMs = !s.seen ? UINT32_MAX : (age < 0 ? 0 : (std::uint32_t)age);
+    s.stuck = s.seen && s.config.stuckMs > 0 && s.last.timeMs - s.changedMs > s.config.stuckMs;
+    bool healthy = s.seen
+                && !s.stuck
+                && s.ageMs <= s.config.timeoutMs
+                && s.last.quality >= s.config.minQuality
+                && (s.config.minRate <= 0.f || s.rate < 0.f || s.rate >= s.config.minRate);
+    if(healthy && !s.healthy) {
+        s.healthySince = nowMs;
+    }
+    s.healthy = healthy;
+    return healthy;
+}
+
+bool SourceArbiter::update(std::uint32_t nowMs, ArbitratedAngle& out) {
+    int best = -1;
+    bool levelHealthy = false;
+    for(std::size_t i=0; i<_count; i++) {
+        Source& s = _sources[i];
+        if(!isHealthy(s, nowMs)) continue;
+        int prio = s.config.priority;
+        if(best < 0 || prio < best) best = prio;
+        if(prio == _level) levelHealthy = true;
+    }
+
+    int level = _level;
+    if(!levelHealthy) {
+        // failover, or nothing left
+        level = best;
+    } else if(best < _level) {
+        // back to a better level once it has proven itself
+        for(std::size_t i=0; i<_count; i++) {
+            const Source& s = _sources[i];
+            if(s.healthy && s.config.priority == best && nowMs - s.healthySince >= _recoveryMs) {
+                level = best;
+                break;
+            }
+        }
+    }
+
+    // the sources of the level, a quality weighted circular mean
+    float x = 0.f, y = 0.f, qsum = 0.f, bestQ = -1.f;
+    int fused = 0, source = -1;
+    for(std::size_t i=0; level >= 0 && i<_count; i++) {
+        const Source& s = _sources[i];
+        if(!s.healthy || s.config.priority != level) continue;
+        float w = s.last.quality > 1e-3f ? s.last.quality : 1e-3f;
+        x += w * std::cos(s.last.value * DEG_TO_RAD);
+        y += w * std::sin(s.last.value * DEG_TO_RAD);
+        qsum += s.last.quality;
+        fused++;
+        if(s.last.quality > bestQ) {
+            bestQ = s.last.quality;
+            source = (int)i;
+        }
+    }
+
+    out.switches = _switches;
+    if(fused == 0) {
+        _level = -1;
+        out.value = _output;
+        out.source = -1;
+        out.fused = 0;
+        out.quality = 0.f;
+        _result.write(out);
+        return false;
+    }
+    float raw = (fused == 1) ? wrap360(_sources[source].last.value)
+                             : wrap360(std::atan2(y, x) / DEG_TO_RAD);
+
+    if(level != _level) {
+        // the first fix has nothing to blend from
+        _offset = (_switches > 0) ? wrap180(_output - raw) : 0.f;
+        _switchMs = nowMs;
+        _switches++;
+        _level = level;
+    }
+    float blend = 0.f;
+    std::uint32_t since = nowMs - _switchMs;
+    if(_blendMs > 0 && since < _blendMs) {
+        blend = 1.f - (float)since / (float)_blendMs;
+    }
+    _output = wrap360(raw + _offset * blend);
+
+    out.value = _output;
+    out.source = (std::int8_t)source;
+    out.fused = (std::uint8_t)fused;
+    out.quality = qsum / fused;
+    out.switches = _switches;
+    _result.write(out);
+    return true;
+}
+
+ArbiterSourceHealth SourceArbiter::health(std::size_t source) const {
+    ArbiterSourceHealth h = { false, false, UINT32_MAX, 0.f, 0.f, 0.f };
+    if(source >= _count) {
+        return h;
+    }
+    const Source& s = _sources[source];
+    h.healthy = s.healthy;
+    h.stuck   = s.stuck;
+    h.rate    = s.rate > 0.f ? s.rate : 0.f;
+    h.quality = s.last.quality;
+    h.value   = s.last.value;
+    h.ageMs   = s.ageMs;
+    return h;
+}
@@ -0,0 +1,213 @@
+#include "TaskLayout.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+TaskLayout::TaskLayout(const ITimeProvider& time, const TaskLayoutConfig& cfg,
+                       const SchedTask* controlTasks, std::size_t controlCount,
+                       const SchedTask* uiTasks, std::size_t uiCount)
+ : _time(time),
+   _cfg(cfg),
+   _mergedCount(controlCount+uiCount),
+   _controlScheduler(time, cfg.dualCore ? controlTasks : _merged, _controlStats,
+                     cfg.dualCore ? controlCount : _mergedCount),
+   _uiScheduler(time, uiTasks, _uiStats, cfg.dualCore ? uiCount : 0),
+   _running(false)
+{
+    if(!cfg.dualCore) {
+        // Oversized tables are rejected by Scheduler::begin()
+        std::size_t n=0;
+        for(std::size_t i=0; i<controlCount && n<Scheduler::MAX_TASKS; i++) {
+            _merged[n++]=controlTasks[i];
+        }
+        for(std::size_t i=0; i<uiCount && n<Scheduler::MAX_TASKS; i++) {
+            _merged[n++]=uiTasks[i];
+        }
+    }
+
+    Worker* workers[]={ &_control, &_ui };
+    Scheduler* schedulers[]={ &_controlScheduler, &_uiScheduler };
+    for(int i=0; i<2; i++) {
+        workers[i]->layout=this;
+        workers[i]->scheduler=schedulers[i];
+        workers[i]->resetRequest=false;
+        workers[i]->done=true;
+        workers[i]->handle=nullptr;
+    }
+}
+
+TaskLayout::~TaskLayout()
+{
+    stop();
+}
+
+bool TaskLayout::start()
+{
+    if(_running) {
+        return false;
+    }
+    if(!_controlScheduler.begin()) {
+        return false;
+    }
+    if(_cfg.dualCore && !_uiScheduler.begin()) {
+        return false;
+    }
+
+    _running=true;
+    if(!startWorker(_control, "control", _cfg.controlCore, _cfg.controlPriority, _cfg.controlStack)) {
+        _running=false;
+        return false;
+    }
+    if(_cfg.dualCore && !startWorker(_ui, "ui", _cfg.uiCore, _cfg.uiPriority, _cfg.uiStack)) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void TaskLayout::stop()
+{
+    _running=false;
+    joinWorker(_control);
+    joinWorker(_ui);
+}
+
+bool TaskLayout::isRunning() const
+{
+    return _running;
+}
+
+const TaskLayoutConfig& TaskLayout::config() const
+{
+    return _cfg;
+}
+
+bool TaskLayout::readStats(TaskGroup group, SchedulerSnapshot& out) const
+{
+    const Worker& w=(group==TaskGroup::UI) ? _ui : _control;
+    return w.snapshot.read(out);
+}
+
+void TaskLayout::resetStats()
+{
+    _control.resetRequest=true;
+    _ui.resetRequest=true;
+}
+
+void TaskLayout::entry(void* arg)
+{
+    run(*static_cast<Worker*>(arg));
+#ifdef ARDUINO
+    // FreeRTOS tasks must not return
+    vTaskDelete(nullptr);
+#endif
+}
+
+void TaskLayout::run(Worker& w)
+{
+    const ITimeProvider& time=w.layout->_time;
+    std::uint64_t nextSnapshot=time.getMicros()+SNAPSHOT_PERIOD_US;
+
+    while(w.layout->_running) {
+        if(w.resetRequest.exchange(false)) {
+            w.scheduler->resetStats();
+        }
+        if(w.scheduler->runOnce()) {
+            continue;
+        }
+        // Idle: publish statistics, then sleep until the next release
+        std::uint64_t now=time.getMicros();
+        if(now>=nextSnapshot) {
+            publish(w);
+            nextSnapshot=now+SNAPSHOT_PERIOD_US;
+        }
+        sleepMicros(w.scheduler->idleTime());
+    }
+    publish(w);
+    w.done=true;
+}
+
+void TaskLayout::publish(Worker& w)
+{
+    SchedulerSnapshot snap;
+    const Scheduler& s=*w.scheduler;
+    snap.count=s.size();
+    for(std::size_t i=0; i<snap.count; i++) {
+        snap.names[i]=s.task(i).name;
+        snap.stats[i]=s.stats(i);
+    }
+    snap.utilization=s.utilization();
+    snap.schedulable=s.isSchedulable();
+    w.snapshot.write(snap);
+}
+
+#ifdef ARDUINO
+
+bool TaskLayout::startWorker(Worker& w, const char* name, int core, std::uint8_t priority,
+                             std::uint32_t stack)
+{
+    w.done=false;
+    TaskHandle_t handle=nullptr;
+    BaseType_t ok=xTaskCreatePinnedToCore(entry, name, stack, &w, priority, &handle, core);
+    if(ok!=pdPASS) {
+        w.done=true;
+        Serial.printf("[Tasks] Could not create %s task.\n", name);
+        return false;
+    }
+    w.handle=handle;
+    Serial.printf("[Tasks] %s: %u tasks on core %d, priority %u.\n", name,
+                  (unsigned)w.scheduler->size(), core, (unsigned)priority);
+    return true;
+}
+
+void TaskLayout::joinWorker(Worker& w)
+{
+    // The task deletes itself once run() returns
+    while(!w.done) {
+        vTaskDelay(1);
+    }
+    w.handle=nullptr;
+}
+
+void TaskLayout::sleepMicros(std::uint64_t us)
+{
+    // Shorter waits spin, FreeRTOS cannot sleep less than a tick
+    if(us>=1000) {
+        vTaskDelay(pdMS_TO_TICKS(us/1000));
+    }
+}
+
+#else
+
+bool TaskLayout::startWorker(Worker& w, const char*, int, std::uint8_t, std::uint32_t)
+{
+    // Cores and priorities are left to the host OS
+    w.done=false;
+    w.handle=new std::thread(entry, &w);
+    return true;
+}
+
+void TaskLayout::joinWorker(Worker& w)
+{
+    std::thread* t=static_cast<std::thread*>(w.handle);
+    if(t) {
+        t->join();
+        delete t;
+        w.handle=nullptr;
+    }
+}
+
+void TaskLayout::sleepMicros(std::uint64_t us)
+{
+    if(us>0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+#endif
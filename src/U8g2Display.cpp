@@ -0,0 +1,277 @@
+#include "U8g2Display.h"
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <driver/spi_master.h>
+#include <cstring>
+#include <new>
+#include "Profiler.h"
+
+namespace {
+
+// SPI transactions in flight per frame
+const int QUEUE_DEPTH = 8;
+
+int s_dcPin = -1;
+spi_transaction_t s_trans[QUEUE_DEPTH];    // sender task only
+
+// DC for the transaction about to go out, from the SPI driver's ISR
+void IRAM_ATTR preTransfer(spi_transaction_t* t) {
+    digitalWrite(s_dcPin, (int)(intptr_t)t->user);
+}
+
+// The ST75256 in full buffer mode, on our byte and gpio callbacks
+class U8G2_ST75256_JLX19296_F_DMA : public U8G2 {
+public:
+    U8G2_ST75256_JLX19296_F_DMA(u8x8_msg_cb byteCb, u8x8_msg_cb gpioCb) : U8G2() {
+        u8g2_Setup_st75256_jlx19296_f(&u8g2, U8G2_R0, byteCb, gpioCb);
+    }
+};
+
+} // namespace
+
+U8g2Display* U8g2Display::s_instance = nullptr;
+
+U8g2Display::U8g2Display(int sck, int mosi, int cs, int dc, int reset)
+: _sck(sck)
+, _mosi(mosi)
+, _cs(cs)
+, _dc(dc)
+, _reset(reset)
+, _core(0)
+, _u8g2(nullptr)
+, _spi(nullptr)
+, _task(nullptr)
+, _direct(false)
+, _dcLevel(false)
+{
+    std::memset(&_stats, 0, sizeof(_stats));
+}
+
+U8g2Display::~U8g2Display() {
+    if(s_instance == this) {
+        release();
+    }
+    delete static_cast<U8G2*>(_u8g2);
+    _u8g2 = nullptr;
+}
+
+bool U8g2Display::begin() {
+    if(s_instance) {
+        return false;
+    }
+    spi_bus_config_t bus;
+    std::memset(&bus, 0, sizeof(bus));
+    bus.mosi_io_num = _mosi;
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = _sck;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = DisplayFrame::CAPACITY;
+    if(spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+        Serial.println("[Display] Could not start the SPI bus.");
+        return false;
+    }
+    spi_device_interface_config_t dev;
+    std::memset(&dev, 0, sizeof(dev));
+    dev.clock_speed_hz = SPI_CLOCK_HZ;
+    dev.mode = 0;
+    dev.spics_io_num = _cs;
+    dev.queue_size = QUEUE_DEPTH;
+    dev.pre_cb = preTransfer;
+    spi_device_handle_t spi;
+    if(spi_bus_add_device(SPI2_HOST, &dev, &spi) != ESP_OK) {
+        Serial.println("[Display] Could not add the panel to the SPI bus.");
+        spi_bus_free(SPI2_HOST);
+        return false;
+    }
+    _spi = static_cast<void*>(spi);
+    s_dcPin = _dc;
+    s_instance = this;
+
+    // Above the UI scheduler, it only queues transfers and sleeps
+    TaskHandle_t task;
+    if(xTaskCreatePinnedToCore(taskEntry, "display", 3072, this, 5, &task, _core) != pdPASS) {
+        Serial.println("[Display] Could not create sender task.");
+        release();
+        return false;
+    }
+    _task = static_cast<void*>(task);
+
+    U8G2* u8 = new (std::nothrow) U8G2_ST75256_JLX19296_F_DMA(onByte, onGpio);
+    if(!u8) {
+        Serial.println("[Display] Out of memory.");
+        release();
+        return false;
+    }
+    // the init sequence has delays between its commands: out at once
+    _direct = true;
+    u8->begin();
+    _direct = false;
+    u8->setFont(u8g2_font_6x10_tr);
+    _u8g2 = static_cast<void*>(u8);
+    return true;
+}
+
+void U8g2Display::release() {
+    if(_task) {
+        vTaskDelete(static_cast<TaskHandle_t>(_task));
+        _task = nullptr;
+    }
+    if(_spi) {
+        spi_bus_remove_device(static_cast<spi_device_handle_t>(_spi));
+        _spi = nullptr;
+    }
+    spi_bus_free(SPI2_HOST);
+    s_dcPin = -1;
+    s_instance = nullptr;
+}
+
+void U8g2Display::clearBuffer() {
+    if(_u8g2) static_cast<U8G2*>(_u8g2)->clearBuffer();
+}
+
+void U8g2Display::drawStr(int x, int y, const char* text) {
+    if(_u8g2) static_cast<U8G2*>(_u8g2)->drawStr(x, y, text);
+}
+
+void U8g2Display::sendBuffer() {
+    PROFILE_SCOPE("display.send");
+    if(!_u8g2) return;
+    beginFrame();
+    static_cast<U8G2*>(_u8g2)->sendBuffer();
+    commitFrame();
+}
+
+void U8g2Display::clearTiles(int tx, int ty, int tw, int th) {
+    if(!_u8g2) return;
+    U8G2* u8 = static_cast<U8G2*>(_u8g2);
+    u8->setDrawColor(0);
+    u8->drawBox(tx * 8, ty * 8, tw * 8, th * 8);
+    u8->setDrawColor(1);
+}
+
+void U8g2Display::sendTiles(int tx, int ty, int tw, int th) {
+    PROFILE_SCOPE("display.send");
+    if(!_u8g2) return;
+    beginFrame();
+    static_cast<U8G2*>(_u8g2)->updateDisplayArea(tx, ty, tw, th);
+    commitFrame();
+}
+
+void U8g2Display::beginFrame() {
+    // a whole frame ahead of the bus: wait for the older one to go out
+    while(!_frames.beginFrame()) {
+        vTaskDelay(1);
+    }
+}
+
+void U8g2Display::commitFrame() {
+    _frames.commit(micros());
+    xTaskNotifyGive(static_cast<TaskHandle_t>(_task));
+}
+
+uint8_t U8g2Display::onByte(u8x8_struct*, uint8_t msg, uint8_t arg, void* ptr) {
+    U8g2Display* self = s_instance;
+    switch(msg) {
+        case U8X8_MSG_BYTE_SET_DC:
+            self->_dcLevel = arg != 0;
+            break;
+        case U8X8_MSG_BYTE_SEND:
+            if(self->_direct) {
+                spi_transaction_t t;
+                std::memset(&t, 0, sizeof(t));
+                t.length = (size_t)arg * 8;
+                t.tx_buffer = ptr;
+                t.user = (void*)(intptr_t)(self->_dcLevel ? 1 : 0);
+                spi_device_polling_transmit(static_cast<spi_device_handle_t>(self->_spi), &t);
+            } else {
+                self->_frames.write(self->_dcLevel, static_cast<const uint8_t*>(ptr), arg);
+            }
+            break;
+        default:
+            // the bus and CS belong to the SPI master
+            break;
+    }
+    return 1;
+}
+
+uint8_t U8g2Display::onGpio(u8x8_struct*, uint8_t msg, uint8_t arg, void*) {
+    U8g2Display* self = s_instance;
+    switch(msg) {
+        case U8X8_MSG_GPIO_AND_DELAY_INIT:
+            pinMode(self->_dc, OUTPUT);
+            if(self->_reset >= 0) pinMode(self->_reset, OUTPUT);
+            break;
+        case U8X8_MSG_DELAY_MILLI:
+            delay(arg);
+            break;
+        case U8X8_MSG_DELAY_10MICRO:
+            delayMicroseconds(10 * arg);
+            break;
+        case U8X8_MSG_DELAY_100NANO:
+        case U8X8_MSG_DELAY_NANO:
+            delayMicroseconds(1);
+            break;
+        case U8X8_MSG_GPIO_RESET:
+            if(self->_reset >= 0) digitalWrite(self->_reset, arg);
+            break;
+        default:
+            break;
+    }
+    return 1;
+}
+
+void U8g2Display::taskEntry(void* arg) {
+    static_cast<U8g2Display*>(arg)->taskLoop();
+}
+
+void U8g2Display::taskLoop() {
+    for(;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const DisplayFrame* f;
+        while((f = _frames.next()) != nullptr) {
+            uint32_t start = micros();
+            transmit(*f);
+            uint32_t end = micros();
+
+            uint32_t frameUs = end - f->timeUs;
+            _stats.frames++;
+            for(size_t i=0; i<f->segmentCount; i++) {
+                _stats.bytes += f->segments[i].length;
+            }
+            _stats.lastFrameUs = frameUs;
+            if(frameUs > _stats.maxFrameUs) _stats.maxFrameUs = frameUs;
+            _stats.frameUs += frameUs;
+            _stats.busyUs += end - start;
+            _stats.stalls = _frames.stalls();
+            _stats.truncated = _frames.truncated();
+            _frames.release();
+            _statsBox.write(_stats);
+        }
+    }
+}
+
+void U8g2Display::transmit(const DisplayFrame& f) {
+    spi_device_handle_t spi = static_cast<spi_device_handle_t>(_spi);
+    spi_transaction_t* done;
+    size_t queued = 0, finished = 0;
+    for(size_t i=0; i<f.segmentCount; i++) {
+        // the oldest slot is free again once its transfer is done
+        if(queued - finished == QUEUE_DEPTH) {
+            spi_device_get_trans_result(spi, &done, portMAX_DELAY);
+            finished++;
+        }
+        const DisplaySegment& s = f.segments[i];
+        spi_transaction_t& t = s_trans[queued % QUEUE_DEPTH];
+        std::memset(&t, 0, sizeof(t));
+        t.length = (size_t)s.length * 8;
+        t.tx_buffer = f.bytes + s.offset;
+        t.user = (void*)(intptr_t)(s.data ? 1 : 0);
+        spi_device_queue_trans(spi, &t, portMAX_DELAY);
+        queued++;
+    }
+    while(finished < queued) {
+        spi_device_get_trans_result(spi, &done, portMAX_DELAY);
+        finished++;
+    }
+}
@@ -1,103 +1,108 @@
 #include "UIController.h"
+#include <cmath>
 
 UIController::UIController(UIModel& model,
                            AutoSteeringController& autoSteer,
-                           const IInputDevice& input)
+                           ButtonEvents& buttons)
 : _model(model)
 , _autoSteer(autoSteer)
-, _input(input)
-, _lastAuto(false)
-, _lastMode(false)
+, _buttons(buttons)
+, _windAngle(nullptr)
+, _windCtx(nullptr)
 {}
 
 void UIController::update() {
-    readButtons();
+    ButtonEvent e;
+    while(_buttons.pop(e)) {
+        handle(e);
+    }
 }
 
 void UIController::begin() {
     // Initialize any necessary state
 }
 
-void UIController::readButtons() {
-    bool autoBtn = _input.isPressed(ButtonId::BTN_AUTO);
-    bool modeBtn = _input.isPressed(ButtonId::BTN_MODE);
-    bool incS    = _input.isPressed(ButtonId::BTN_INC_SMALL);
-    bool decS    = _input.isPressed(ButtonId::BTN_DEC_SMALL);
-    bool incL    = _input.isPressed(ButtonId::BTN_INC_LARGE);
-    bool decL    = _input.isPressed(ButtonId::BTN_DEC_LARGE);
-
-    // Toggle STANDBY/AUTO on rising edge
-    if(autoBtn && !_lastAuto) {
-        if(_model.getState().autoMode == UIAutoMode::STANDBY) {
-            _model.setAutoMode(UIAutoMode::AUTO);
-            _autoSteer.setMode(AutoSteeringMode::TRACK_HEADING,
-                               _model.getState().headingSetpoint);
-        } else {
-            _model.setAutoMode(UIAutoMode::STANDBY);
-            _autoSteer.setMode(AutoSteeringMode::OFF);
-        }
-    }
-    _lastAuto = autoBtn;
-
-    // Cycle steering mode on rising edge
-    if(modeBtn && !_lastMode) {
-        cycleSteeringMode();
-    }
-    _lastMode = modeBtn;
+void UIController::handle(const ButtonEvent& e) {
+    bool press = e.type == ButtonEventType::PRESS;
+    bool step  = press || e.type == ButtonEventType::REPEAT;
 
-    if(incS) {
-        _model.incrementSetpointSmall();
-        updateAutoSteerSetpoint();
-    }
-    if(decS) {
-        _model.decrementSetpointSmall();
-        updateAutoSteerSetpoint();
-    }
-    if(incL) {
-        _model.incrementSetpointLarge();
-        updateAutoSteerSetpoint();
-    }
-    if(decL) {
-        _model.decrementSetpointLarge();
-        updateAutoSteerSetpoint();
+    switch(e.button) {
+        case ButtonId::BTN_AUTO:
+            // Toggle STANDBY/AUTO
+            if(!press) break;
+            if(_model.getState().autoMode == UIAutoMode::STANDBY) {
+                _model.setAutoMode(UIAutoMode::AUTO);
+                _autoSteer.setMode(AutoSteeringMode::TRACK_HEADING,
+                                   _model.getState().headingSetpoint);
+            } else {
+                _model.setAutoMode(UIAutoMode::STANDBY);
+                _autoSteer.setMode(AutoSteeringMode::OFF);
+            }
+            break;
+        case ButtonId::BTN_MODE:
+            if(press) cycleSteeringMode();
+            break;
+        case ButtonId::BTN_INC_SMALL:
+            if(!step) break;
+            _model.incrementSetpointSmall();
+            updateAutoSteerSetpoint();
+            break;
+        case ButtonId::BTN_DEC_SMALL:
+            if(!step) break;
+            _model.decrementSetpointSmall();
+            updateAutoSteerSetpoint();
+            break;
+        case ButtonId::BTN_INC_LARGE:
+            if(!step) break;
+            _model.incrementSetpointLarge();
+            updateAutoSteerSetpoint();
+            break;
+        case ButtonId::BTN_DEC_LARGE:
+            if(!step) break;
+            _model.decrementSetpointLarge();
+            updateAutoSteerSetpoint();
+            break;
     }
 }
 
 void UIController::cycleSteeringMode() {
-    static std::string modes[] = {
-        "OFF",
-        "TRACK_HEADING",
-        "TRACK_COURSE",
-        "TRACK_WIND_ANGLE"
-    };
-    static int idx = 0;
-    idx = (idx + 1) % 4;
+    AutoSteeringMode mode = (AutoSteeringMode)((_model.getState().currentSteeringMode + 1)
+                                               % UIModel::STEERING_MODE_COUNT);
 
-    _model.setSteeringMode(modes[idx]);
-    if(modes[idx] == "OFF") {
-        _autoSteer.setMode(AutoSteeringMode::OFF);
-    } else if(modes[idx] == "TRACK_HEADING") {
-        _autoSteer.setMode(AutoSteeringMode::TRACK_HEADING,
-                           _model.getState().headingSetpoint);
-    } else if(modes[idx] == "TRACK_COURSE") {
-        _autoSteer.setMode(AutoSteeringMode::TRACK_COURSE, 120.0f);
-    } else if(modes[idx] == "TRACK_WIND_ANGLE") {
-        _autoSteer.setMode(AutoSteeringMode::TRACK_WIND_ANGLE, 45.0f);
+    // wind mode engages on the wind angle sailed, none: no wind mode
+    float windAngle = 0.f;
+    if(mode == AutoSteeringMode::TRACK_WIND_ANGLE && !(_windAngle && _windAngle(windAngle, _windCtx))) {
+        mode = AutoSteeringMode::OFF;
+    }
+
+    _model.setSteeringMode(mode);
+    switch(mode) {
+        case AutoSteeringMode::OFF:
+            _autoSteer.setMode(AutoSteeringMode::OFF);
+            break;
+        case AutoSteeringMode::TRACK_HEADING:
+            _autoSteer.setMode(AutoSteeringMode::TRACK_HEADING,
+                               _model.getState().headingSetpoint);
+            break;
+        case AutoSteeringMode::TRACK_COURSE:
+            _autoSteer.setMode(AutoSteeringMode::TRACK_COURSE, 120.0f);
+            break;
+        case AutoSteeringMode::TRACK_WIND_ANGLE:
+            windAngle = std::round(windAngle);
+            _model.setHeadingSetpoint(windAngle);
+            _autoSteer.setMode(AutoSteeringMode::TRACK_WIND_ANGLE, windAngle);
+            break;
     }
 }
 
 void UIController::updateAutoSteerSetpoint() {
     if(_model.getState().autoMode == UIAutoMode::AUTO) {
         float sp = _model.getState().headingSetpoint;
-        const std::string& mode = _model.getState().currentSteeringMode;
-        if(mode=="OFF") {
+        AutoSteeringMode mode = _model.getState().currentSteeringMode;
+        if(mode == AutoSteeringMode::OFF) {
             _autoSteer.setMode(AutoSteeringMode::OFF);
-        } else if(mode=="TRACK_HEADING") {
-            _autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, sp);
-        } else if(mode=="TRACK_COURSE") {
-            _autoSteer.setMode(AutoSteeringMode::TRACK_COURSE, sp);
-        } else if(mode=="TRACK_WIND_ANGLE") {
-            _autoSteer.setMode(AutoSteeringMode::TRACK_WIND_ANGLE, sp);
+        } else {
+            _autoSteer.setMode(mode, sp);
         }
     }
 }
@@ -1,12 +1,43 @@
 #include "UIModel.h"
 
-UIModel::UIModel() {
+namespace {
+
+const int FIELD_AUTO_MODE     = 0;
+const int FIELD_STEERING_MODE = 1;
+const int FIELD_SETPOINT      = 2;
+
+} // namespace
+
+constexpr const char* UIModel::AUTO_MODE_NAMES[2];
+constexpr const char* UIModel::STEERING_MODE_NAMES[UIModel::STEERING_MODE_COUNT];
+
+UIModel::UIModel()
+: _version(1)
+{
     // Defaults
     _state.autoMode           = UIAutoMode::STANDBY;
-    _state.currentSteeringMode= "OFF";
+    _state.currentSteeringMode= AutoSteeringMode::OFF;
     _state.headingSetpoint    = 90.0f;
     _state.stepSizeSmall      = 1.0f;
     _state.stepSizeLarge      = 10.0f;
+    for(int i=0; i<FIELD_COUNT; i++) {
+        _changed[i] = _version;
+    }
+}
+
+void UIModel::touch(int field) {
+    _version++;
+    if(_version == 0) _version = 1;
+    _changed[field] = _version;
+}
+
+std::uint32_t UIModel::changedSince(std::uint32_t version) const {
+    std::uint32_t mask = 0;
+    for(int i=0; i<FIELD_COUNT; i++) {
+        // wraps like the millisecond clocks
+        if((std::int32_t)(_changed[i] - version) > 0) mask |= 1u << i;
+    }
+    return mask;
 }
 
 const UIState& UIModel::getState() const {
@@ -14,29 +45,35 @@ const UIState& UIModel::getState() const {
 }
 
 void UIModel::setAutoMode(UIAutoMode mode) {
+    if(mode == _state.autoMode) return;
     _state.autoMode = mode;
+    touch(FIELD_AUTO_MODE);
 }
 
-void UIModel::setSteeringMode(const std::string& modeName) {
-    _state.currentSteeringMode = modeName;
+void UIModel::setSteeringMode(AutoSteeringMode mode) {
+    if(mode == _state.currentSteeringMode) return;
+    _state.currentSteeringMode = mode;
+    touch(FIELD_STEERING_MODE);
 }
 
 void UIModel::setHeadingSetpoint(float val) {
+    if(val == _state.headingSetpoint) return;
     _state.headingSetpoint = val;
+    touch(FIELD_SETPOINT);
 }
 
 void UIModel::incrementSetpointSmall() {
-    _state.headingSetpoint += _state.stepSizeSmall;
+    setHeadingSetpoint(_state.headingSetpoint + _state.stepSizeSmall);
 }
 
 void UIModel::decrementSetpointSmall() {
-    _state.headingSetpoint -= _state.stepSizeSmall;
+    setHeadingSetpoint(_state.headingSetpoint - _state.stepSizeSmall);
 }
 
 void UIModel::incrementSetpointLarge() {
-    _state.headingSetpoint += _state.stepSizeLarge;
+    setHeadingSetpoint(_state.headingSetpoint + _state.stepSizeLarge);
 }
 
 void UIModel::decrementSetpointLarge() {
-    _state.headingSetpoint -= _state.stepSizeLarge;
+    setHeadingSetpoint(_state.headingSetpoint - _state.stepSizeLarge);
 }
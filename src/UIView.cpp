@@ -1,55 +1,124 @@
 #include "UIView.h"
-#include <u8g2lib.h>   // but we do not use Arduino.h
-#include <cstdio>      // for snprintf
+#include <cmath>
 
-UIView::UIView()
-: _u8g2(nullptr)
-{
-}
+namespace {
+
+// 6x10 font: glyphs reach 8 pixels above the baseline and 2 below
+const int FONT_ASCENT  = 8;
+const int FONT_DESCENT = 2;
+const int TILE         = 8;
+
+// One line of text per field, at its baseline
+struct Line {
+    std::uint32_t field;
+    int y;
+};
+const Line LINES[] = {
+    { UI_AUTO_MODE,     10 },
+    { UI_STEERING_MODE, 25 },
+    { UI_SETPOINT,      40 },
+};
+const int LINE_COUNT = sizeof(LINES) / sizeof(LINES[0]);
+
+// A line of text in a fixed buffer, cut off when full
+class LineText {
+public:
+    LineText() : _len(0) { _buf[0] = '\0'; }
 
-UIView::~UIView() {
-    if(_u8g2) {
-        // cast back to U8G2 pointer
-        U8G2* ptr = static_cast<U8G2*>(_u8g2);
-        delete ptr;
-        _u8g2 = nullptr;
+    LineText& put(const char* text) {
+        while(*text && _len < SIZE - 1) _buf[_len++] = *text++;
+        _buf[_len] = '\0';
+        return *this;
     }
-}
 
-bool UIView::begin() {
-    // Create an instance dynamically
-    // Use your actual 128x256 driver. Example:
-    U8G2* u8 = new U8G2_ST75256_JLX19296_2_3W_SW_SPI(U8G2_R0, /* cs=*/ 10, /* dc=*/ 9, /* reset=*/ 8);
-    if(!u8) return false;
-    u8->begin();
-    _u8g2 = static_cast<void*>(u8);
-    return true;
-}
+    // One decimal, rounded; "---" if not a number we can show
+    LineText& putTenths(float value) {
+        float scaled = std::fabs(value) * 10.f + 0.5f;
+        if(!(scaled < 1e9f)) return put("---");
+        std::uint32_t v = (std::uint32_t)scaled;
+        if(value < 0.f && v != 0) put("-");
+        // digits come out backwards
+        char digits[12];
+        int n = 0;
+        do {
+            digits[n++] = (char)('0' + v % 10u);
+            v /= 10u;
+        } while(v != 0 || n < 2);
+        char out[14];
+        int len = 0;
+        while(n > 0) {
+            if(n == 1) out[len++] = '.';
+            out[len++] = digits[--n];
+        }
+        out[len] = '\0';
+        return put(out);
+    }
 
-void UIView::render(const UIModel& model) {
-    if(!_u8g2) return;
-    U8G2* u8 = static_cast<U8G2*>(_u8g2);
+    const char* c_str() const { return _buf; }
 
-    u8->clearBuffer();
-    u8->setFont(u8g2_font_6x10_tr);
+private:
+    static const int SIZE = 32;     // the longest line is 27, 162 px
+    char _buf[SIZE];
+    int  _len;
+};
 
-    // 1) Display auto mode
-    std::string strAuto = "AutoMode: " + autoModeToStr(model.getState().autoMode);
-    u8->drawStr(0, 10, strAuto.c_str());
+} // namespace
 
-    // 2) Steering mode
-    std::string strMode = "SteerMode: " + model.getState().currentSteeringMode;
-    u8->drawStr(0, 25, strMode.c_str());
+UIView::UIView(IDisplay& display)
+: _display(display)
+, _valid(false)
+, _version(0)
+, _skipped(0)
+{
+}
 
-    // 3) Heading setpoint
-    char buf[32];
-    std::snprintf(buf, sizeof(buf), "Setpoint: %.1f deg", model.getState().headingSetpoint);
-    u8->drawStr(0, 40, buf);
+bool UIView::begin() {
+    _valid = false;
+    return _display.begin();
+}
 
-    // 4) final 
-    u8->sendBuffer();
+void UIView::render(const UIModel& model) {
+    std::uint32_t changed = _valid ? model.changedSince(_version) : UI_ALL;
+    if(!changed) {
+        _skipped++;
+        return;
+    }
+
+    if(!_valid) {
+        _display.clearBuffer();
+        for(int i=0; i<LINE_COUNT; i++) {
+            drawLine(i, model);
+        }
+        _display.sendBuffer();
+    } else {
+        // the lines' tile rows, full width: the old text may be longer
+        for(int i=0; i<LINE_COUNT; i++) {
+            if(!(changed & LINES[i].field)) continue;
+            int ty = (LINES[i].y - FONT_ASCENT) / TILE;
+            int th = (LINES[i].y + FONT_DESCENT - 1) / TILE - ty + 1;
+            _display.clearTiles(0, ty, WIDTH / TILE, th);
+            drawLine(i, model);
+            _display.sendTiles(0, ty, WIDTH / TILE, th);
+        }
+    }
+    _version = model.version();
+    _valid = true;
 }
 
-std::string UIView::autoModeToStr(UIAutoMode mode) const {
-    return (mode == UIAutoMode::AUTO) ? "AUTO" : "STANDBY";
+void UIView::drawLine(int line, const UIModel& model) {
+    const UIState& st = model.getState();
+    int y = LINES[line].y;
+    LineText text;
+    switch(LINES[line].field) {
+        case UI_AUTO_MODE:
+            text.put("AutoMode: ").put(UIModel::autoModeName(st.autoMode));
+            break;
+        case UI_STEERING_MODE:
+            text.put("SteerMode: ").put(UIModel::steeringModeName(st.currentSteeringMode));
+            break;
+        case UI_SETPOINT:
+            text.put("Setpoint: ").putTenths(st.headingSetpoint).put(" deg");
+            break;
+    }
+    _display.drawStr(0, y, text.c_str());
 }
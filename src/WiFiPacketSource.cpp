@@ -0,0 +1,91 @@
+#include "WiFiPacketSource.h"
+#include <Arduino.h>
+
+UdpPacketSource::UdpPacketSource(std::uint16_t port)
+: _port(port)
+, _bound(false)
+, _pending(0)
+{
+}
+
+std::size_t UdpPacketSource::receive(char* out, std::size_t len) {
+    if(WiFi.status() != WL_CONNECTED) {
+        if(_bound) {
+            _udp.stop();
+            _bound = false;
+            _pending = 0;
+        }
+        return 0;
+    }
+    if(!_bound) {
+        _bound = _udp.begin(_port) != 0;
+        if(!_bound) {
+            return 0;
+        }
+    }
+    if(_pending == 0) {
+        int size = _udp.parsePacket();
+        if(size <= 0) {
+            return 0;
+        }
+        _pending = (std::size_t)size;
+    }
+    std::size_t want = _pending < len ? _pending : len;
+    int n = _udp.read(reinterpret_cast<std::uint8_t*>(out), want);
+    if(n <= 0) {
+        _pending = 0;
+        return 0;
+    }
+    _pending -= (std::size_t)n;
+    return (std::size_t)n;
+}
+
+UdpPacketSink::UdpPacketSink(const char* host, std::uint16_t port)
+: _host(host)
+, _port(port)
+{
+}
+
+bool UdpPacketSink::send(const char* data, std::size_t len) {
+    if(WiFi.status() != WL_CONNECTED) {
+        return false;
+    }
+    if(!_udp.beginPacket(_host, _port)) {
+        return false;
+    }
+    _udp.write(reinterpret_cast<const std::uint8_t*>(data), len);
+    return _udp.endPacket() != 0;
+}
+
+TcpPacketSource::TcpPacketSource(const char* host, std::uint16_t port)
+: _host(host)
+, _port(port)
+, _tried(false)
+, _lastTryMs(0)
+{
+}
+
+std::size_t TcpPacketSource::receive(char* out, std::size_t len) {
+    if(!_client.connected()) {
+        if(WiFi.status() != WL_CONNECTED) {
+            return 0;
+        }
+        std::uint32_t now = millis();
+        if(_tried && now - _lastTryMs < RETRY_MS) {
+            return 0;
+        }
+        _tried = true;
+        _lastTryMs = now;
+        _client.stop();
+        if(!_client.connect(_host, _port, CONNECT_TIMEOUT_MS)) {
+            return 0;
+        }
+    }
+    int avail = _client.available();
+    if(avail <= 0) {
+        return 0;
+    }
+    std::size_t want = (std::size_t)avail < len ? (std::size_t)avail : len;
+    int n = _client.read(reinterpret_cast<std::uint8_t*>(out), want);
+    return n > 0 ? (std::size_t)n : 0;
+}
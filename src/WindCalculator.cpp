@@ -0,0 +1,126 @@
+#include "WindCalculator.h"
+#include <cmath>
+
+namespace {
+
+const float DEG_TO_RAD = 3.14159265358979f / 180.f;
+const float RAD_TO_DEG = 180.f / 3.14159265358979f;
+// beyond this the anemometer is useless anyway
+const float MAX_HEEL   = 60.f;
+
+float wrap360(float deg) {
+    deg = std::fmod(deg, 360.f);
+    return deg < 0.f ? deg + 360.f : deg;
+}
+
+float wrap180(float deg) {
+    deg = wrap360(deg);
+    return deg >= 180.f ? deg - 360.f : deg;
+}
+
+float alpha(float dt, float tau) {
+    return tau > 0.f ? 1.f - std::exp(-dt / tau) : 1.f;
+}
+
+} // namespace
+
+WindCalculator::WindCalculator(float fastTau, float slowTau)
+: _fastTau(fastTau)
+, _slowTau(slowTau)
+, _shiftDeg(10.f)
+, _shiftHold(20.f)
+{
+    reset();
+}
+
+void WindCalculator::setShiftDetection(float shiftDeg, float holdS) {
+    _shiftDeg = shiftDeg;
+    _shiftHold = holdS;
+}
+
+void WindCalculator::reset() {
+    _primed = false;
+    _fastX = _fastY = 0.f;
+    _slowX = _slowY = 0.f;
+    _fastSpeed = _slowSpeed = 0.f;
+    _shiftSide = 0;
+    _shiftTime = 0.f;
+    _shifts = 0;
+}
+
+void WindCalculator::trueWind(float awa, float aws, float boatSpeed, float heel,
+                              float& twa, float& tws) {
+    if(heel > MAX_HEEL)  heel = MAX_HEEL;
+    if(heel < -MAX_HEEL) heel = -MAX_HEEL;
+    // where the wind comes from, forward and to starboard
+    float fwd = aws * std::cos(awa * DEG_TO_RAD);
+    float stb = aws * std::sin(awa * DEG_TO_RAD) / std::cos(heel * DEG_TO_RAD);
+    fwd -= boatSpeed;
+    tws = std::sqrt(fwd*fwd + stb*stb);
+    twa = std::atan2(stb, fwd) * RAD_TO_DEG;
+}
+
+void WindCalculator::update(float awa, float aws, float boatSpeed, float heel, float heading, float dt) {
+    if(std::isnan(awa) || std::isnan(aws) || std::isnan(heading)) {
+        return;
+    }
+    if(std::isnan(boatSpeed)) boatSpeed = 0.f;
+    if(std::isnan(heel))      heel = 0.f;
+
+    float twa, tws;
+    trueWind(awa, aws, boatSpeed, heel, twa, tws);
+    float dir = (heading + twa) * DEG_TO_RAD;
+    float x = tws * std::cos(dir);
+    float y = tws * std::sin(dir);
+
+    if(!_primed) {
+        _primed = true;
+        _fastX = _slowX = x;
+        _fastY = _slowY = y;
+        _fastSpeed = _slowSpeed = tws;
+        return;
+    }
+    float af = alpha(dt, _fastTau);
+    float as = alpha(dt, _slowTau);
+    _fastX += af * (x - _fastX);
+    _fastY += af * (y - _fastY);
+    _slowX += as * (x - _slowX);
+    _slowY += as * (y - _slowY);
+    _fastSpeed += af * (tws - _fastSpeed);
+    _slowSpeed += as * (tws - _slowSpeed);
+
+    // a shift that stays is followed now, not in slowTau
+    float fastDir = std::atan2(_fastY, _fastX);
+    float diff = wrap180((fastDir - std::atan2(_slowY, _slowX)) * RAD_TO_DEG);
+    int side = (diff > _shiftDeg) ? 1 : (diff < -_shiftDeg ? -1 : 0);
+    if(side == 0 || side != _shiftSide) {
+        _shiftTime = 0.f;
+    } else {
+        _shiftTime += dt;
+    }
+    _shiftSide = side;
+    if(side != 0 && _shiftTime >= _shiftHold) {
+        float mag = std::sqrt(_slowX*_slowX + _slowY*_slowY);
+        _slowX = mag * std::cos(fastDir);
+        _slowY = mag * std::sin(fastDir);
+        _shiftSide = 0;
+        _shiftTime = 0.f;
+        _shifts++;
+    }
+}
+
+float WindCalculator::trueDirection() const {
+    return wrap360(std::atan2(_slowY, _slowX) * RAD_TO_DEG);
+}
+
+float WindCalculator::steeringAngle(float heading) const {
+    return wrap180(trueDirection() - heading);
+}
+
+float WindCalculator::trueAngle(float heading) const {
+    return wrap180(std::atan2(_fastY, _fastX) * RAD_TO_DEG - heading);
+}
+
+float WindCalculator::gustFactor() const {
+    return _slowSpeed > 1e-3f ? _fastSpeed / _slowSpeed : 1.f;
+}
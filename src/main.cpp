@@ -1,16 +1,46 @@
 #include <Arduino.h>
+#include <atomic>
+#include <LittleFS.h>
 #include "IIMUProvider.h"
 #include "MyIMUProvider.h"
 #include "AutoSteeringController.h"
+#include "MPCSteeringController.h"
+#include "RudderPositionController.h"
 #include "IMUFilterAndCalibration.h"
 #include "UIModel.h"
 #include "UIView.h"
+#include "U8g2Display.h"
 #include "UIController.h"
-#include "IInputDevice.h"
+#include "GpioButtons.h"
 #include "ITimeProvider.h"
+#include "GainTable.h"
+#include "SeaStateEstimator.h"
+#include "Scheduler.h"
+#include "TaskLayout.h"
+#include "Profiler.h"
+#include "FlightRecorder.h"
+#include "LittleFSBlockStorage.h"
+#include "MPU9250Decoder.h"
+#include "Mailbox.h"
+#include "NmeaAutopilot.h"
+#include "NmeaInput.h"
+#include "SourceArbiter.h"
+#include "WindCalculator.h"
+#include "WiFiPacketSource.h"
 
-// Pins for UI buttons, etc.
-static const int PIN_BTN_AUTO = 2;
+// Pins for UI buttons, in ButtonId order: auto, mode, +1, -1, +10, -10
+static const int PIN_BUTTONS[ButtonEvents::BUTTON_COUNT] = { 2, 3, 15, 16, 17, 18 };
+// Rudder drive H-bridge and feedback pot (ADC1)
+static const int PIN_MOTOR_A  = 5;
+static const int PIN_MOTOR_B  = 6;
+static const int PIN_RUDDER_POT = 7;
+static const int PIN_MOTOR_CURRENT = 4;
+// LCD on SPI2, 4-wire: DC selects command or data
+static const int PIN_LCD_SCK   = 12;
+static const int PIN_LCD_MOSI  = 11;
+static const int PIN_LCD_CS    = 10;
+static const int PIN_LCD_DC    = 9;
+static const int PIN_LCD_RESET = 13;
 // ... other pins ...
 
 // MyTimeProvider
@@ -19,70 +49,628 @@ public:
     std::uint64_t getMillis() const override {
         return (std::uint64_t)millis();
     }
-};
-
-// MyInputDevice
-class MyInputDevice : public IInputDevice {
-public:
-    bool isPressed(ButtonId btn) const override {
-        // switch/case, digitalRead
-        // ...
-        return false;
+    std::uint64_t getMicros() const override {
+        return (std::uint64_t)esp_timer_get_time();
     }
 };
 
 // Global Instances
 static AutoSteeringController autoSteer;
+#ifdef STEERING_MPC
+// Steers heading and course in place of autoSteer's PID, see headingTask
+static MPCSteeringController mpcSteer;
+#endif
+static RudderPositionController rudderCtrl(PIN_MOTOR_A, PIN_MOTOR_B, PIN_RUDDER_POT, PIN_MOTOR_CURRENT);
 static MyIMUProvider myIMU(0x69, 8); // example address/pin
 static MyTimeProvider timeProv;
 static IMUFilterAndCalibration imuFilter(myIMU, timeProv);
 
 static UIModel uiModel;
-static UIView  uiView;
-static MyInputDevice inputDev;
-static UIController uiController(uiModel, autoSteer, inputDev);
+static U8g2Display display(PIN_LCD_SCK, PIN_LCD_MOSI, PIN_LCD_CS, PIN_LCD_DC, PIN_LCD_RESET);
+static UIView  uiView(display);
+static GpioButtons buttons(PIN_BUTTONS);
+static UIController uiController(uiModel, autoSteer, buttons.events());
+
+// Gains tuned on the host (tools/autotune), stored on LittleFS
+static GainTable gainTable;
+static const GainSet* activeGains = nullptr;
+// Rudder economy mode: -1 as the gain set says, 0 off, 1 on. Set by the
+// console on the UI core, applied by the heading task
+static std::atomic<int> economyOverride(-1);
+static SeaStateEstimator seaState;
+
+// Black box on LittleFS, 256 x 4 KB: the last ~5 minutes at full rate.
+// One queue per producing task: the control tasks share a scheduler.
+static LittleFSBlockStorage recorderStorage("/flight.bin", 256);
+static FlightRecorder recorder(recorderStorage);
+static const size_t REC_CONTROL = 0;
+static const size_t REC_UI      = 1;
+
+// NMEA0183 from the boat's network: build with
+// -DNMEA_WIFI_SSID='"..."' -DNMEA_WIFI_PASS='"..."' to join it
+#ifndef NMEA_UDP_PORT
+#define NMEA_UDP_PORT 10110
+#endif
+static NmeaInput nmeaInput;
+static UdpPacketSource nmeaUdp(NMEA_UDP_PORT);
+
+// Telemetry out to NMEA_OUT_HOST (the whole network by default) and
+// $PXAPC commands in, see NmeaAutopilot
+#ifndef NMEA_OUT_HOST
+#define NMEA_OUT_HOST "255.255.255.255"
+#endif
+static UdpPacketSink nmeaOut(NMEA_OUT_HOST, NMEA_UDP_PORT);
+static NmeaAutopilot nmeaAutopilot(autoSteer);
+static Mailbox<AutopilotTelemetry> telemetryBox;   // heading loop -> nmea task
+
+// What the heading loop steers by: the heading from a compass or the
+// GPS, the apparent wind angle from the wind instrument. The IMU filter
+// does not estimate yaw yet, so it is no heading source. Course mode
+// steers the track made good, so it has its own arbiter of the same
+// sources, COG first.
+static SourceArbiter headingArbiter;
+static SourceArbiter courseArbiter;
+static SourceArbiter windArbiter;
+static int SRC_COMPASS        = -1;
+static int SRC_COG            = -1;
+static int SRC_COURSE_COG     = -1;
+static int SRC_COURSE_COMPASS = -1;
+static int SRC_WIND           = -1;
+
+// The speeds that go with the wind arbiter's angle
+struct WindSpeeds {
+    float apparent;     // [kn]
+    float boat;         // through the water, else over ground [kn], NAN if none
+    std::uint32_t timeMs;   // of the MWV sentence
+};
+static Mailbox<WindSpeeds> windSpeedBox;           // nmea task -> heading loop
+static WindCalculator windCalc;                    // heading loop only
+
+// Load /gains.json if present; otherwise keep the built-in defaults
+static void loadGainTable() {
+    if(!LittleFS.begin()) {
+        return;
+    }
+    File f = LittleFS.open("/gains.json", "r");
+    if(!f) {
+        return;
+    }
+    static char json[2048];
+    size_t n = f.readBytes(json, sizeof(json) - 1);
+    json[n] = '\0';
+    f.close();
+
+    if(!gainTable.loadFromJson(json)) {
+        Serial.println("[Gains] /gains.json invalid, using defaults.");
+        return;
+    }
+    Serial.printf("[Gains] %u sets loaded.\n", (unsigned)gainTable.size());
+}
+
+static void startRecorder() {
+    // IMU samples as counts of the MPU9250's default ranges, for bit-exact replay
+    recorder.setImuResolution(MPU9250Decoder::accelScale(MPU9250AccelRange::ACCEL_RANGE_2G),
+                              MPU9250Decoder::gyroScale(MPU9250GyroRange::GYRO_RANGE_250DPS),
+                              MPU9250Decoder::MAG_SCALE);
+    if(!LittleFS.begin() || !recorderStorage.begin() || !recorder.begin()) {
+        Serial.println("[Rec] No storage, flight recorder off.");
+        return;
+    }
+    Serial.printf("[Rec] Recording to /flight.bin, %u blocks.\n",
+                  (unsigned)recorderStorage.blockCount());
+}
+
+static void sendNmea(const char* data, size_t len, void*) {
+    nmeaOut.send(data, len);
+}
+
+static void startArbiters() {
+    //                             name       prio timeout  rate quality  stuck
+    ArbiterSourceConfig compass = { "compass", 0,  1500, 0.5f, 0.5f, 30000 };
+    ArbiterSourceConfig cog     = { "cog",     1,  3000,  0.f, 0.5f, 30000 };
+    ArbiterSourceConfig wind    = { "wind",    0,  1500, 0.5f, 0.5f, 30000 };
+    SRC_COMPASS = headingArbiter.addSource(compass);
+    SRC_COG     = headingArbiter.addSource(cog);
+    // the other way round for course mode
+    compass.priority = 1;
+    cog.priority = 0;
+    SRC_COURSE_COG     = courseArbiter.addSource(cog);
+    SRC_COURSE_COMPASS = courseArbiter.addSource(compass);
+    SRC_WIND    = windArbiter.addSource(wind);
+}
+
+// A heading sample to both arbiters
+static void publishCompass(float value, float quality, std::uint32_t now) {
+    headingArbiter.publish(SRC_COMPASS, value, quality, now);
+    courseArbiter.publish(SRC_COURSE_COMPASS, value, quality, now);
+}
+
+static void publishCog(float value, float quality, std::uint32_t now) {
+    headingArbiter.publish(SRC_COG, value, quality, now);
+    courseArbiter.publish(SRC_COURSE_COG, value, quality, now);
+}
+
+// COG is only worth something under way: 0 below 1 kn, 1 from 3 kn
+static float cogQuality(float sog) {
+    if(std::isnan(sog)) return 0.f;
+    float q = (sog - 1.f) * 0.5f;
+    return q < 0.f ? 0.f : (q > 1.f ? 1.f : q);
+}
+
+// Heading sources off the network, all magnetic, and the
+// wind with the speeds for the true wind
+static void publishNmeaSources(const NmeaSentence& s) {
+    // speed through the water, over ground without a log for 5 s
+    static float boatSpeed = NAN;
+    static std::uint32_t logMs = 0;
+    std::uint32_t now = (std::uint32_t)timeProv.getMillis();
+    bool noLog = std::isnan(boatSpeed) || now - logMs > 5000;
+    switch(s.type) {
+        case NmeaType::HDG:
+            // not our own $APHDG coming back
+            if(!strcmp(s.talker, "AP")) break;
+            publishCompass(s.hdg.heading + (std::isnan(s.hdg.deviation) ? 0.f : s.hdg.deviation),
+                           1.f, now);
+            break;
+        case NmeaType::RMC:
+            if(s.rmc.valid && !std::isnan(s.rmc.variation)) {
+                publishCog(s.rmc.cog - s.rmc.variation, cogQuality(s.rmc.sog), now);
+            }
+            if(s.rmc.valid && noLog && !std::isnan(s.rmc.sog)) boatSpeed = s.rmc.sog;
+            break;
+        case NmeaType::VTG:
+            publishCog(s.vtg.cogMagnetic, cogQuality(s.vtg.sog), now);
+            if(noLog && !std::isnan(s.vtg.sog)) boatSpeed = s.vtg.sog;
+            break;
+        case NmeaType::VHW:
+            if(!std::isnan(s.vhw.speed)) {
+                boatSpeed = s.vhw.speed;
+                logMs = now;
+            }
+            break;
+        case NmeaType::MWV:
+            if(s.mwv.relative && s.mwv.valid) {
+                WindSpeeds ws = { s.mwv.speed, boatSpeed, now };
+                windSpeedBox.write(ws);
+                windArbiter.publish(SRC_WIND, s.mwv.angle, 1.f, now);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Wind mode from the buttons engages on the wind angle the heading loop
+// last steered by
+static bool currentWindAngle(float& angle, void*) {
+    AutopilotTelemetry t;
+    if(!telemetryBox.read(t) || std::isnan(t.windAngle)) {
+        return false;
+    }
+    angle = t.windAngle;
+    return true;
+}
+
+// Instrument data to the arbiters, remote commands mirrored on the
+// display like a button press
+static void onNmeaSentence(size_t, const NmeaSentence& s, void*) {
+    publishNmeaSources(s);
+    SteeringCommand cmd;
+    if(!nmeaAutopilot.handle(s, cmd)) {
+        return;
+    }
+    uiModel.setAutoMode(cmd.mode == AutoSteeringMode::OFF ? UIAutoMode::STANDBY : UIAutoMode::AUTO);
+    uiModel.setSteeringMode(cmd.mode);
+    if(cmd.mode != AutoSteeringMode::OFF) {
+        uiModel.setHeadingSetpoint(cmd.param);
+    }
+}
+
+static void startNmeaInput() {
+    nmeaInput.setHandler(onNmeaSentence, nullptr);
+    nmeaAutopilot.setOutput(sendNmea, nullptr);
+#ifdef NMEA_WIFI_SSID
+    WiFi.begin(NMEA_WIFI_SSID, NMEA_WIFI_PASS);
+    nmeaInput.addSource(&nmeaUdp, "udp");
+    Serial.printf("[NMEA] Listening on UDP %u.\n", (unsigned)NMEA_UDP_PORT);
+#endif
+}
+
+// Switch to the gain set tuned for the current sea state
+static void applyGainsForSeaState() {
+    const GainSet* g = gainTable.select(seaState.getSeaState());
+    if(!g || g == activeGains) {
+        return;
+    }
+    activeGains = g;
+    autoSteer.setGains(g->steerKp, g->steerKi, g->steerKd);
+    rudderCtrl.setGains(g->rudderKp, g->rudderKi, g->rudderKd);
+}
+
+// Economy mode from the console, else from the gain set in use
+static void applyEconomyMode() {
+    static int applied = -1;
+    int mode = economyOverride.load(std::memory_order_relaxed);
+    int on = mode >= 0 ? mode : (activeGains && activeGains->economy ? 1 : 0);
+    if(on != applied) {
+        rudderCtrl.setEconomyMode(on != 0);
+        applied = on;
+    }
+}
+
+// Economy setting and what the drive has been doing since boot
+static void printEconomy() {
+    static const char* const MODES[] = { "auto", "off", "on" };
+    RudderStatus st = rudderCtrl.getStatus();
+    const ServoActivity& a = st.activity;
+    Serial.printf("[Eco] %s, %s; motor on %.0f s (%.1f %%), %.1f starts/min, %.1f reversals/min\n",
+                  MODES[economyOverride.load(std::memory_order_relaxed) + 1],
+                  st.economy ? "economy" : "normal", a.motorOnTime, a.dutyCycle() * 100.f,
+                  a.startsPerMinute(), a.reversalsPerMinute());
+}
+
+// Servo loop timing, printed every 10 s
+static void reportRudderJitter() {
+    LoopJitterStats j = rudderCtrl.getJitter();
+    Serial.printf("[Rudder] %u cycles, period %.1f us (%u..%u), jitter mean %.1f max %u us, "
+                  "exec mean %.1f max %u us, %u overruns\n",
+                  (unsigned)j.cycles, j.meanPeriod, (unsigned)j.minPeriod, (unsigned)j.maxPeriod,
+                  j.meanJitter, (unsigned)j.maxJitter, j.meanExec, (unsigned)j.maxExec,
+                  (unsigned)j.overruns);
+}
+
+// Display sender: frames, bytes, commit-to-wire time and how busy the
+// bus was since the last call. CPU time spent recording frames is the
+// "display.send" profile site.
+static void reportDisplay() {
+    static DisplayStats last;
+    static std::uint32_t lastUs = 0;
+    DisplayStats st;
+    if(!display.readStats(st)) {
+        return;
+    }
+    std::uint32_t nowUs = micros();
+    std::uint32_t frames = st.frames - last.frames;
+    float seconds = (nowUs - lastUs) * 1e-6f;
+    Serial.printf("[Disp] %u frames, %.0f B/s, frame mean %.2f max %.2f ms, bus %.2f %%, "
+                  "%u stalls, %u truncated\n",
+                  (unsigned)frames, seconds > 0.f ? (st.bytes - last.bytes) / seconds : 0.f,
+                  frames ? (st.frameUs - last.frameUs) * 1e-3f / frames : 0.f,
+                  st.maxFrameUs * 1e-3f,
+                  seconds > 0.f ? (st.busyUs - last.busyUs) * 1e-4f / seconds : 0.f,
+                  (unsigned)st.stalls, (unsigned)st.truncated);
+    last = st;
+    lastUs = nowUs;
+}
+
+// Log drive protection trips as they happen
+static void checkRudderFault(const RudderStatus& st) {
+    static MotorFault lastFault = MotorFault::NONE;
+    if(st.fault != lastFault) {
+        static const char* const NAMES[] = { "cleared", "overcurrent", "stall", "thermal" };
+        Serial.printf("[Rudder] Drive %s at %.1f deg, %.1f A, I2t %.2f\n",
+                      NAMES[(int)st.fault], st.angle, st.current, st.thermal);
+        lastFault = st.fault;
+    }
+}
+
+// ---- Scheduled tasks, see the tables below ----
+// Control and UI tasks run on different cores and only talk through
+// mailboxes: autoSteer.setMode() and the rudderCtrl setters publish
+// commands, rudderCtrl.getStatus()/getJitter() read published copies.
 
-// Timer approach for 100Hz IMU
-hw_timer_t* g_imuTimer=nullptr;
+static void imuTask(void*) {
+    PROFILE_SCOPE("imu.update");
+    // one timestamp for the filter and the records, so a replay
+    // integrates the very same dt
+    std::uint32_t now = (std::uint32_t)timeProv.getMillis();
+    if(imuFilter.update(now)) {
+        recorder.logImu(REC_CONTROL, now, imuFilter.getRawData());
+        recorder.logAttitude(REC_CONTROL, now, imuFilter.getFilteredData());
+    }
+}
+
+// Heading, the course in that mode, or the true wind angle in wind
+// mode, from the arbiters to the loop, and what it steers by to
+// feedback. Returns the heading for the display and the network, NAN
+// with no heading source.
+static float updateFeedback(std::uint32_t now, float& feedback) {
+    // the wind filters step once per MWV, by the time between them
+    static std::uint32_t windMs = 0;
+    static bool windSeen = false;
+    ArbitratedAngle heading, course, wind;
+    headingArbiter.update(now, heading);
+    courseArbiter.update(now, course);
+    WindSpeeds ws;
+    if(windArbiter.update(now, wind) && heading.source >= 0 && windSpeedBox.read(ws)
+       && (!windSeen || ws.timeMs != windMs)) {
+        // no heel correction: the filter's roll is the gyro integrated,
+        // it drifts, until there is a real attitude estimate
+        float dt = windSeen ? (ws.timeMs - windMs) * 0.001f : 0.f;
+        windCalc.update(wind.value, ws.apparent, ws.boat, 0.f, heading.value, dt);
+        windMs = ws.timeMs;
+        windSeen = true;
+    }
+    ArbitratedAngle fb = heading;
+    if(autoSteer.getMode() == AutoSteeringMode::TRACK_COURSE) {
+        fb = course;
+    } else if(autoSteer.getMode() == AutoSteeringMode::TRACK_WIND_ANGLE) {
+        fb = wind;
+        fb.value = windCalc.steeringAngle(heading.value);
+        // the true wind angle is worked out from the heading: with that
+        // held, it is as stale as the heading is
+        if(!windCalc.valid() || heading.source < 0) fb.source = -1;
+    }
+    if(fb.source >= 0) {
+        // as the recorder stores it, so a replay feeds the very same value
+        autoSteer.setFeedback(FlightLog::quantize(FlightRecordType::FEEDBACK, 0, fb.value));
+    }
+    recorder.logFeedback(REC_CONTROL, now, fb.value, fb.source, fb.quality);
+    feedback = fb.value;
+    // the arbiter holds the last value when every source is gone
+    return (heading.source >= 0) ? heading.value : NAN;
+}
+
+static void headingTask(void*) {
+    std::uint32_t now = (std::uint32_t)timeProv.getMillis();
+    float feedback;
+    float heading = updateFeedback(now, feedback);
+    seaState.addSample(imuFilter.getFilteredData().yawRate, 0.1f);
+    applyGainsForSeaState();
+    applyEconomyMode();
+    float rudder;
+    {
+        PROFILE_SCOPE("steer.update");
+        autoSteer.update(0.1f);
+        rudder = autoSteer.getRudderAngle();
+#ifdef STEERING_MPC
+        // autoSteer still takes the mode commands and keeps wind mode;
+        // the MPC runs at its table's period, which is this task's. It
+        // never steers blind either: without fresh feedback it is off,
+        // and the rudder stays centred as autoSteer holds it.
+        AutoSteeringMode mode = autoSteer.hasFeedback() ? autoSteer.getMode() : AutoSteeringMode::OFF;
+        mpcSteer.setMode(mode, autoSteer.getSetpoint());
+        // the IMU's z rate is positive turning to port, the heading grows
+        // to starboard
+        mpcSteer.update(feedback, -imuFilter.getFilteredData().yawRate);
+        if(mode == AutoSteeringMode::TRACK_HEADING || mode == AutoSteeringMode::TRACK_COURSE) {
+            rudder = mpcSteer.getRudderAngle();
+        }
+#endif
+    }
+    rudderCtrl.setSeaState(seaState.getSeaState());
+    rudderCtrl.setTargetAngle(rudder);
+
+    static AutoSteeringMode lastMode = AutoSteeringMode::OFF;
+    static float lastSetpoint = 0.f;
+    if(autoSteer.getMode() != lastMode || autoSteer.getSetpoint() != lastSetpoint) {
+        lastMode = autoSteer.getMode();
+        lastSetpoint = autoSteer.getSetpoint();
+        recorder.logMode(REC_CONTROL, now, (int)lastMode, lastSetpoint);
+    }
+    recorder.logSteering(REC_CONTROL, now, autoSteer.getSetpoint(),
+                         rudder, seaState.getSeaState());
+
+    AutopilotTelemetry t;
+    t.mode = autoSteer.getMode();
+    t.setpoint = autoSteer.getSetpoint();
+    t.heading = heading;
+    t.windAngle = (windCalc.valid() && !std::isnan(heading)) ? windCalc.steeringAngle(heading) : NAN;
+    t.rudderAngle = 0.f;    // the servo's, filled in by nmeaTask
+    telemetryBox.write(t);
+}
+
+// Drive faults and status, the 1 kHz loop itself runs on its own timer
+static void rudderTask(void*) {
+    RudderStatus st = rudderCtrl.getStatus();
+    checkRudderFault(st);
+    recorder.logRudder(REC_UI, (std::uint32_t)timeProv.getMillis(),
+                       st.target, st.angle, st.command, st.current, (int)st.fault);
+}
+
+// Encode queued records and write them to flash, off the control core
+static void recorderTask(void*) {
+    PROFILE_SCOPE("rec.service");
+    recorder.service((std::uint32_t)timeProv.getMillis());
+}
+
+static void inputTask(void*) {
+    PROFILE_SCOPE("ui.update");
+    uiController.update();
+}
+
+static void renderTask(void*) {
+    PROFILE_SCOPE("ui.render");
+    uiView.render(uiModel);
+}
+
+// Read the sockets into the NMEA ring
+static void netTask(void*) {
+    PROFILE_SCOPE("net.poll");
+    nmeaInput.poll();
+}
+
+// Decode what the network task queued (remote commands are applied
+// here, on the UI core like the buttons), publish the telemetry
+static void nmeaTask(void*) {
+    PROFILE_SCOPE("nmea.service");
+    std::uint32_t now = (std::uint32_t)timeProv.getMillis();
+    nmeaInput.service(now);
+
+    AutopilotTelemetry t;
+    if(telemetryBox.read(t)) {
+        t.rudderAngle = rudderCtrl.getStatus().angle;
+        nmeaAutopilot.update(now, t);
+    }
+}
 
-void IRAM_ATTR onIMUTimer(){
-    // call filter update at 100Hz
-    imuFilter.update();
+static void printNmeaStats() {
+    if(nmeaInput.sourceCount() == 0) {
+        Serial.println("[NMEA] No sources.");
+    }
+    for(size_t i=0; i<nmeaInput.sourceCount(); i++) {
+        NmeaSourceStats st = nmeaInput.stats(i);
+        Serial.printf("[NMEA] %-4s %.1f/s, %u sentences, %u bytes, %u dropped, "
+                      "%u checksum errors, %u malformed, %u ignored\n",
+                      nmeaInput.sourceName(i), st.rate, (unsigned)st.sentences,
+                      (unsigned)st.bytes, (unsigned)st.dropped, (unsigned)st.checksumErrors,
+                      (unsigned)st.malformed, (unsigned)st.ignored);
+    }
+    Serial.printf("[NMEA] out %u sentences, %u commands, %u rejected\n",
+                  (unsigned)nmeaAutopilot.sent(), (unsigned)nmeaAutopilot.commands(),
+                  (unsigned)nmeaAutopilot.rejected());
+}
+
+static void printArbiter(const char* label, const SourceArbiter& arb) {
+    ArbitratedAngle a;
+    if(!arb.latest(a)) {
+        Serial.printf("[%s] Not started.\n", label);
+    } else if(a.source < 0) {
+        Serial.printf("[%s] No source, holding %.1f, %u switches\n", label, a.value, (unsigned)a.switches);
+    } else {
+        Serial.printf("[%s] %.1f from %s (%u fused), quality %.2f, %u switches\n", label, a.value,
+                      arb.sourceName((size_t)a.source), (unsigned)a.fused, a.quality, (unsigned)a.switches);
+    }
+}
+
+static void printLine(const char* line, void*) {
+    Serial.println(line);
+}
+
+// Serial commands, one per line:
+//   prof        dump the PROFILE_SCOPE statistics
+//   prof reset  clear them
+//   rec         flight recorder counters, saves the block being filled
+//   nmea        per source NMEA rates and error counters, telemetry and
+//               remote commands
+//   src         heading and wind angle in use, and where from
+//   disp        display frames, throughput and bus time since last asked
+//   eco         rudder economy mode and drive activity
+//   eco on|off|auto  force economy mode, or leave it to the gain table
+static void consoleTask(void*) {
+    static char line[32];
+    static size_t len = 0;
+    while(Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if(c != '\n' && c != '\r') {
+            if(len < sizeof(line) - 1) line[len++] = c;
+            continue;
+        }
+        line[len] = '\0';
+        if(!strcmp(line, "prof")) {
+            Profiler::report(printLine, nullptr);
+        } else if(!strcmp(line, "prof reset")) {
+            Profiler::resetAll();
+            Serial.println("[Prof] Reset.");
+        } else if(!strcmp(line, "rec")) {
+            recorder.flush();
+            Serial.printf("[Rec] %u records, %u dropped, %u blocks written, %u write errors\n",
+                          (unsigned)recorder.recorded(), (unsigned)recorder.dropped(),
+                          (unsigned)recorder.blocksWritten(), (unsigned)recorder.writeErrors());
+        } else if(!strcmp(line, "nmea")) {
+            printNmeaStats();
+        } else if(!strcmp(line, "src")) {
+            printArbiter("Heading", headingArbiter);
+            printArbiter("Course", courseArbiter);
+            printArbiter("Wind", windArbiter);
+        } else if(!strcmp(line, "disp")) {
+            reportDisplay();
+        } else if(!strncmp(line, "eco", 3) && (line[3] == '\0' || line[3] == ' ')) {
+            const char* arg = line[3] ? line + 4 : "";
+            if(!strcmp(arg, "on"))        economyOverride.store(1, std::memory_order_relaxed);
+            else if(!strcmp(arg, "off"))  economyOverride.store(0, std::memory_order_relaxed);
+            else if(!strcmp(arg, "auto")) economyOverride.store(-1, std::memory_order_relaxed);
+            printEconomy();
+        } else if(len > 0) {
+            Serial.printf("Unknown command '%s' (prof, prof reset, rec, nmea, src, disp, eco)\n", line);
+        }
+        len = 0;
+    }
+}
+
+static void logTask(void*);
+
+// Periods and deadlines in microseconds; rate-monotonic order
+static const SchedTask CONTROL_TASKS[] = {
+    // name       function     ctx      period   deadline prio offset
+    { "imu",      imuTask,     nullptr,   10000,     0,    0,   0 },
+    { "heading",  headingTask, nullptr,  100000,  20000,   0, 1500 },
+};
+static const SchedTask UI_TASKS[] = {
+    { "rudder",   rudderTask,  nullptr,   20000,     0,    1, 500 },
+    { "input",    inputTask,   nullptr,   20000,     0,    2, 1000 },
+    { "net",      netTask,     nullptr,   20000,     0,    3, 1500 },
+    { "nmea",     nmeaTask,    nullptr,   50000,     0,    1, 2500 },
+    { "console",  consoleTask, nullptr,   50000,     0,    0, 2000 },
+    { "render",   renderTask,  nullptr,  200000,     0,    0, 3000 },
+    { "recorder", recorderTask, nullptr, 100000,     0,    0, 4000 },
+    { "log",      logTask,     nullptr, 10000000,    0,    0, 5000 },
+};
+
+// Control on core 1 next to the servo task, UI and the network on
+// core 0 with the WiFi stack. TaskLayoutConfig::singleCore() puts
+// everything back into one scheduler.
+static const TaskLayoutConfig LAYOUT_CONFIG;
+static TaskLayout taskLayout(timeProv, LAYOUT_CONFIG,
+                             CONTROL_TASKS, sizeof(CONTROL_TASKS) / sizeof(CONTROL_TASKS[0]),
+                             UI_TASKS, sizeof(UI_TASKS) / sizeof(UI_TASKS[0]));
+
+static void reportSchedulerStats(TaskGroup group, const char* label) {
+    static SchedulerSnapshot snap;
+    if(!taskLayout.readStats(group, snap)) {
+        return;
+    }
+    for(size_t i=0; i<snap.count; i++) {
+        const TaskStats& st = snap.stats[i];
+        Serial.printf("[Sched] %-8s %6u runs, exec %.0f/%u us, late max %u us, %u overruns, %u skipped\n",
+                      snap.names[i], (unsigned)st.runs, st.meanExec(), (unsigned)st.maxExec,
+                      (unsigned)st.maxLateness, (unsigned)st.overruns, (unsigned)st.skipped);
+    }
+    Serial.printf("[Sched] %s utilization %.1f %%%s\n", label, snap.utilization * 100.f,
+                  snap.schedulable ? "" : ", NOT schedulable");
+}
+
+static void logTask(void*) {
+    reportRudderJitter();
+    reportDisplay();
+    reportSchedulerStats(TaskGroup::CONTROL, "control");
+    reportSchedulerStats(TaskGroup::UI, "ui");
 }
 
 void setup() {
     Serial.begin(115200);
 
-    // pinMode for UI
-    pinMode(PIN_BTN_AUTO, INPUT_PULLUP);
+    // Buttons on interrupts, debounced on timer 2 while one is down
+    buttons.begin(2);
 
     // Start IMU
     myIMU.begin(); // references Wire, attachInterrupt, etc.
 
-    // Start UI
+    // Start UI; the display sender next to the UI scheduler
+    display.setCore(LAYOUT_CONFIG.uiCore);
     uiView.begin();
 
-    // Create hardware timer for 100Hz
-    g_imuTimer = timerBegin(0, 80, true);
-    timerAttachInterrupt(g_imuTimer, &onIMUTimer, true);
-    timerAlarmWrite(g_imuTimer, 10000, true);
-    timerAlarmEnable(g_imuTimer);
+    loadGainTable();
+    startRecorder();
+    startArbiters();
+    uiController.setWindAngleSource(currentWindAngle, nullptr);
+    startNmeaInput();
 
-    Serial.println("Setup done.");
-}
+    // Inner rudder loop at 1 kHz on the control core
+    rudderCtrl.begin();
+    rudderCtrl.beginContinuousSampling();
+    rudderCtrl.setDriveProfile(DriveProfile::electricLinear());
+    rudderCtrl.setTrajectoryEnabled(true);
+    rudderCtrl.startTask(1000, LAYOUT_CONFIG.controlCore, 1);
 
-void loop() {
-    // Possibly autopilot update
-    static unsigned long lastAuto=0;
-    unsigned long now=millis();
-    if((now-lastAuto)>100) {
-        lastAuto=now;
-        autoSteer.update(0.1f);
+    if(!taskLayout.start()) {
+        Serial.println("[Tasks] Invalid task table.");
     }
 
-    // UI update
-    uiController.update();
-    uiView.render(uiModel);
+    Serial.println("Setup done.");
+}
 
-    delay(50);
+void loop() {
+    // All work runs in the TaskLayout workers
+    vTaskDelete(nullptr);
 }
@@ -102,7 +102,7 @@ void test_imu_filter_calibration(void) {
 void test_ui_model_default_state(void) {
     const UIState& state = uiModel->getState();
     TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, state.autoMode);
-    TEST_ASSERT_EQUAL_STRING("OFF", state.currentSteeringMode.c_str());
+    TEST_ASSERT_EQUAL(AutoSteeringMode::OFF, state.currentSteeringMode);
     TEST_ASSERT_EQUAL_FLOAT(90.0f, state.headingSetpoint);
 }
 
@@ -17,18 +17,101 @@ void test_off_mode_rudder_zero() {
     TEST_ASSERT_EQUAL_FLOAT(0.f, autoSteer.getRudderAngle());
 }
 
+void test_no_feedback_keeps_rudder_centred() {
+    AutoSteeringController steer;
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    steer.update(0.1f);
+    TEST_ASSERT_FALSE(steer.hasFeedback());
+    TEST_ASSERT_EQUAL_FLOAT(0.f, steer.getRudderAngle());
+}
+
 void test_track_heading_produces_output() {
     autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    autoSteer.setFeedback(0.f);
     autoSteer.update(0.1f);
     float rudder = autoSteer.getRudderAngle();
     TEST_ASSERT_NOT_EQUAL(0.f, rudder);
 }
 
+void test_stale_feedback_centres_rudder() {
+    AutoSteeringController steer;
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    steer.setFeedback(80.f);
+    steer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.f, steer.getRudderAngle());
+    // the heading source goes quiet: it keeps steering for the timeout...
+    int steps = 1;
+    while(steer.getRudderAngle() != 0.f && steps < 100) {
+        steer.update(0.1f);
+        steps++;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, AutoSteeringController::FEEDBACK_TIMEOUT_S, steps * 0.1f);
+    // ...and steers again as soon as it is back
+    steer.setFeedback(85.f);
+    steer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.f, steer.getRudderAngle());
+}
+
+void test_feedback_closes_the_loop() {
+    autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    autoSteer.setFeedback(90.f);
+    autoSteer.update(0.1f);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, autoSteer.getRudderAngle());
+
+    // 350 -> 10 is a small turn to starboard, not a big one to port
+    autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, 10.f);
+    autoSteer.setFeedback(350.f);
+    autoSteer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.f, autoSteer.getRudderAngle());
+    autoSteer.setFeedback(0.f);
+}
+
+void test_set_gains() {
+    autoSteer.setGains(0.5f, 0.f, 0.f);
+    autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, 10.f);
+    autoSteer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.f, autoSteer.getRudderAngle());
+    autoSteer.setGains(1.f, 0.f, 0.f);
+}
+
+void test_mode_change_applies_on_update() {
+    // setMode() may come from the UI task; only update() applies it,
+    // and the latest of several changes wins
+    autoSteer.setFeedback(0.f);
+    autoSteer.setMode(AutoSteeringMode::OFF);
+    autoSteer.update(0.1f);
+    autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, 10.f);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, autoSteer.getRudderAngle());
+    autoSteer.setMode(AutoSteeringMode::TRACK_HEADING, 20.f);
+    autoSteer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.f, autoSteer.getRudderAngle());
+}
+
+void test_wind_angle_steers_the_other_way() {
+    // wind 40 deg on the starboard bow, 50 wanted: bear away, to port
+    autoSteer.setMode(AutoSteeringMode::TRACK_WIND_ANGLE, 50.f);
+    autoSteer.setFeedback(40.f);
+    autoSteer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -10.f, autoSteer.getRudderAngle());
+    // and on port tack to starboard
+    autoSteer.setMode(AutoSteeringMode::TRACK_WIND_ANGLE, -50.f);
+    autoSteer.setFeedback(-40.f);
+    autoSteer.update(0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.f, autoSteer.getRudderAngle());
+    autoSteer.setFeedback(0.f);
+}
+
 #ifdef ARDUINO
 void setup() {
     UNITY_BEGIN();
     RUN_TEST(test_off_mode_rudder_zero);
+    RUN_TEST(test_no_feedback_keeps_rudder_centred);
     RUN_TEST(test_track_heading_produces_output);
+    RUN_TEST(test_stale_feedback_centres_rudder);
+    RUN_TEST(test_feedback_closes_the_loop);
+    RUN_TEST(test_set_gains);
+    RUN_TEST(test_mode_change_applies_on_update);
+    RUN_TEST(test_wind_angle_steers_the_other_way);
     UNITY_END();
 }
 void loop() {}
@@ -36,7 +119,13 @@ void loop() {}
 int main() {
     UNITY_BEGIN();
     RUN_TEST(test_off_mode_rudder_zero);
+    RUN_TEST(test_no_feedback_keeps_rudder_centred);
     RUN_TEST(test_track_heading_produces_output);
+    RUN_TEST(test_stale_feedback_centres_rudder);
+    RUN_TEST(test_feedback_closes_the_loop);
+    RUN_TEST(test_set_gains);
+    RUN_TEST(test_mode_change_applies_on_update);
+    RUN_TEST(test_wind_angle_steers_the_other_way);
     return UNITY_END();
 }
 #endif
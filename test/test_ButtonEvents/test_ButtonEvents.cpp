@@ -0,0 +1,165 @@
+#include <unity.h>
+#include "ButtonEvents.h"
+
+static const std::uint32_t TICK_MS = 5;     // GpioButtons::TICK_US
+
+static std::uint32_t bit(ButtonId b) {
+    return 1u << (int)b;
+}
+
+// The debounce timer: sample every TICK_MS from now, for ms
+struct Panel {
+    ButtonEvents buttons;
+    std::uint32_t now;
+
+    Panel() : now(0) {}
+
+    void hold(std::uint32_t pressed, std::uint32_t ms) {
+        for(std::uint32_t end = now + ms; now < end; now += TICK_MS) {
+            buttons.sample(pressed, now);
+        }
+    }
+
+    int count(ButtonEventType type) {
+        int n = 0;
+        ButtonEvent e;
+        while(buttons.pop(e)) {
+            if(e.type == type) n++;
+        }
+        return n;
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_bounce_is_one_press() {
+    Panel p;
+    std::uint32_t a = bit(ButtonId::BTN_AUTO);
+    // contacts chattering for 15 ms, then closed
+    for(int i=0; i<3; i++) {
+        p.hold(a, TICK_MS);
+        p.hold(0, TICK_MS);
+    }
+    p.hold(a, 100);
+    ButtonEvent e;
+    TEST_ASSERT_TRUE(p.buttons.pop(e));
+    TEST_ASSERT_EQUAL(ButtonId::BTN_AUTO, e.button);
+    TEST_ASSERT_EQUAL(ButtonEventType::PRESS, e.type);
+    TEST_ASSERT_TRUE(p.buttons.isPressed(ButtonId::BTN_AUTO));
+    TEST_ASSERT_FALSE(p.buttons.pop(e));
+
+    // and bouncing open
+    p.hold(0, TICK_MS);
+    p.hold(a, TICK_MS);
+    p.hold(0, 100);
+    TEST_ASSERT_TRUE(p.buttons.pop(e));
+    TEST_ASSERT_EQUAL(ButtonEventType::RELEASE, e.type);
+    TEST_ASSERT_FALSE(p.buttons.pop(e));
+    TEST_ASSERT_FALSE(p.buttons.active());
+}
+
+void test_glitch_is_no_press() {
+    Panel p;
+    p.hold(bit(ButtonId::BTN_MODE), 15);
+    p.hold(0, 100);
+    ButtonEvent e;
+    TEST_ASSERT_FALSE(p.buttons.pop(e));
+    TEST_ASSERT_FALSE(p.buttons.active());
+}
+
+void test_long_press_and_repeat() {
+    Panel p;
+    std::uint32_t inc = bit(ButtonId::BTN_INC_SMALL);
+    p.hold(inc, 2000);
+    p.hold(0, 100);
+
+    ButtonEvent e;
+    TEST_ASSERT_TRUE(p.buttons.pop(e));
+    TEST_ASSERT_EQUAL(ButtonEventType::PRESS, e.type);
+    std::uint32_t pressMs = e.timeMs;
+    TEST_ASSERT_EQUAL_UINT32(20, pressMs);
+
+    TEST_ASSERT_TRUE(p.buttons.pop(e));
+    TEST_ASSERT_EQUAL(ButtonEventType::LONG_PRESS, e.type);
+    TEST_ASSERT_EQUAL_UINT32(pressMs + 700, e.timeMs);
+
+    // every 150 ms from there: 700 + 150 k < 2000 - 20
+    int repeats = 0;
+    std::uint32_t last = e.timeMs;
+    while(p.buttons.pop(e) && e.type == ButtonEventType::REPEAT) {
+        TEST_ASSERT_EQUAL(ButtonId::BTN_INC_SMALL, e.button);
+        TEST_ASSERT_EQUAL_UINT32(last + 150, e.timeMs);
+        last = e.timeMs;
+        repeats++;
+    }
+    TEST_ASSERT_EQUAL(8, repeats);
+    TEST_ASSERT_EQUAL(ButtonEventType::RELEASE, e.type);
+}
+
+void test_buttons_are_independent() {
+    Panel p;
+    p.hold(bit(ButtonId::BTN_INC_LARGE), 100);
+    p.hold(bit(ButtonId::BTN_INC_LARGE) | bit(ButtonId::BTN_DEC_LARGE), 100);
+    p.hold(bit(ButtonId::BTN_DEC_LARGE), 100);
+    p.hold(0, 100);
+    ButtonEvent e;
+    ButtonId order[] = { ButtonId::BTN_INC_LARGE, ButtonId::BTN_DEC_LARGE,
+                         ButtonId::BTN_INC_LARGE, ButtonId::BTN_DEC_LARGE };
+    ButtonEventType types[] = { ButtonEventType::PRESS, ButtonEventType::PRESS,
+                                ButtonEventType::RELEASE, ButtonEventType::RELEASE };
+    for(int i=0; i<4; i++) {
+        TEST_ASSERT_TRUE(p.buttons.pop(e));
+        TEST_ASSERT_EQUAL(order[i], e.button);
+        TEST_ASSERT_EQUAL(types[i], e.type);
+    }
+    TEST_ASSERT_FALSE(p.buttons.pop(e));
+}
+
+void test_late_sample_does_not_burst() {
+    Panel p;
+    std::uint32_t dec = bit(ButtonId::BTN_DEC_SMALL);
+    p.hold(dec, 1000);
+    p.count(ButtonEventType::REPEAT);
+    // the timer ISR held off for a second
+    p.now += 1000;
+    p.hold(dec, TICK_MS);
+    TEST_ASSERT_EQUAL(1, p.count(ButtonEventType::REPEAT));
+}
+
+void test_full_queue_counts_drops() {
+    Panel p;
+    // nobody pops: press, long press and 30 s of repeats
+    p.hold(bit(ButtonId::BTN_INC_SMALL), 30000);
+    TEST_ASSERT_TRUE(p.buttons.dropped() > 150);
+    // the oldest are kept
+    ButtonEvent e;
+    TEST_ASSERT_TRUE(p.buttons.pop(e));
+    TEST_ASSERT_EQUAL(ButtonEventType::PRESS, e.type);
+    TEST_ASSERT_EQUAL(ButtonEvents::QUEUE_SIZE - 2, p.count(ButtonEventType::REPEAT));
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bounce_is_one_press);
+    RUN_TEST(test_glitch_is_no_press);
+    RUN_TEST(test_long_press_and_repeat);
+    RUN_TEST(test_buttons_are_independent);
+    RUN_TEST(test_late_sample_does_not_burst);
+    RUN_TEST(test_full_queue_counts_drops);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bounce_is_one_press);
+    RUN_TEST(test_glitch_is_no_press);
+    RUN_TEST(test_long_press_and_repeat);
+    RUN_TEST(test_buttons_are_independent);
+    RUN_TEST(test_late_sample_does_not_burst);
+    RUN_TEST(test_full_queue_counts_drops);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,88 @@
+#include <unity.h>
+#include <cmath>
+#include "CicDecimator.h"
+#include "SimRandom.h"
+
+static CicDecimator<3, 32> cic;
+
+void setUp() {
+    cic.reset();
+}
+void tearDown() {}
+
+void test_gain_is_ratio_to_the_order() {
+    TEST_ASSERT_EQUAL(32768, (int)cic.gain());
+}
+
+void test_one_output_per_ratio_samples() {
+    int outputs = 0;
+    for(int i=0; i<320; i++) {
+        if(cic.push(100)) outputs++;
+    }
+    TEST_ASSERT_EQUAL(10, outputs);
+}
+
+void test_dc_passes_exactly() {
+    // Full scale 12 bit input, well past the start-up
+    for(int i=0; i<32*10; i++) cic.push(4095);
+    TEST_ASSERT_EQUAL_FLOAT(4095.0f, cic.output());
+}
+
+void test_step_settles_after_order_outputs() {
+    for(int i=0; i<32*5; i++) cic.push(1000);
+    for(int k=0; k<3; k++) {
+        for(int i=0; i<32; i++) cic.push(3000);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(3000.0f, cic.output());
+}
+
+void test_wraparound_is_harmless() {
+    // Long runs wrap the integrators many times over
+    for(int i=0; i<2000000; i++) cic.push(4095);
+    TEST_ASSERT_EQUAL_FLOAT(4095.0f, cic.output());
+}
+
+void test_noise_is_reduced() {
+    SimRandom rng(5);
+    double sumIn = 0, sqIn = 0, sumOut = 0, sqOut = 0;
+    int nIn = 0, nOut = 0;
+    for(int i=0; i<32*2000; i++) {
+        float x = 2000.f + 10.f * rng.gaussian();
+        int s = int(std::lround(x));
+        sumIn += s; sqIn += double(s) * s; nIn++;
+        if(cic.push(s) && i > 32*3) {
+            double y = cic.output();
+            sumOut += y; sqOut += y * y; nOut++;
+        }
+    }
+    double varIn  = sqIn / nIn - (sumIn / nIn) * (sumIn / nIn);
+    double varOut = sqOut / nOut - (sumOut / nOut) * (sumOut / nOut);
+    // white noise through a 3rd order CIC of ratio 32: roughly 5x less std dev
+    TEST_ASSERT_TRUE(std::sqrt(varOut) * 4 < std::sqrt(varIn));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 2000.f, float(sumOut / nOut));
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_gain_is_ratio_to_the_order);
+    RUN_TEST(test_one_output_per_ratio_samples);
+    RUN_TEST(test_dc_passes_exactly);
+    RUN_TEST(test_step_settles_after_order_outputs);
+    RUN_TEST(test_wraparound_is_harmless);
+    RUN_TEST(test_noise_is_reduced);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_gain_is_ratio_to_the_order);
+    RUN_TEST(test_one_output_per_ratio_samples);
+    RUN_TEST(test_dc_passes_exactly);
+    RUN_TEST(test_step_settles_after_order_outputs);
+    RUN_TEST(test_wraparound_is_harmless);
+    RUN_TEST(test_noise_is_reduced);
+    return UNITY_END();
+}
+#endif
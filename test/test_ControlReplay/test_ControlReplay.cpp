@@ -0,0 +1,228 @@
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "AutoSteeringController.h"
+#include "ControlReplay.h"
+#include "FlightLogReader.h"
+#include "FlightRecorder.h"
+#include "IMUFilterAndCalibration.h"
+#include "ReplayProviders.h"
+#include "SeaStateEstimator.h"
+#include "SourceArbiter.h"
+
+static const float ACCEL_LSB = 0.000598755f;   // MPU9250 at 2 g, 250 deg/s
+static const float GYRO_LSB  = 0.000133158f;
+static const float MAG_LSB   = 0.6f;
+
+/** Log blocks in memory, as the recorder writes them to LittleFS. */
+class VectorStorage : public IBlockStorage {
+public:
+    explicit VectorStorage(std::size_t blocks) : data(blocks * FlightLog::BLOCK_SIZE, 0xFF) {}
+
+    std::size_t blockCount() const override { return data.size() / FlightLog::BLOCK_SIZE; }
+
+    bool readBlock(std::size_t index, std::uint8_t* out, std::size_t len) override {
+        std::memcpy(out, &data[index * FlightLog::BLOCK_SIZE], len);
+        return true;
+    }
+
+    bool writeBlock(std::size_t index, const std::uint8_t* block) override {
+        std::memcpy(&data[index * FlightLog::BLOCK_SIZE], block, FlightLog::BLOCK_SIZE);
+        return true;
+    }
+
+    std::vector<std::uint8_t> data;
+};
+
+/** A rolling, yawing boat read as MPU9250 counts. */
+class CountsIMU : public IIMUProvider {
+public:
+    bool getIMUData(IMUData& out) override {
+        float t = _n++ * 0.01f;
+        out.ax = counts(0.5f * std::sin(0.7f * t)) * ACCEL_LSB;
+        out.ay = counts(1.2f * std::sin(1.6f * t)) * ACCEL_LSB;
+        out.az = counts(9.81f) * ACCEL_LSB;
+        out.gx = counts(0.1f * std::cos(1.6f * t)) * GYRO_LSB;
+        out.gy = counts(0.02f * std::sin(0.7f * t)) * GYRO_LSB;
+        out.gz = counts(0.05f * std::sin(0.11f * t) + 0.03f * std::sin(0.9f * t)) * GYRO_LSB;
+        out.mx = counts(17.f) * MAG_LSB;
+        out.my = counts(2.f * std::sin(0.11f * t)) * MAG_LSB;
+        out.mz = counts(-47.f) * MAG_LSB;
+        return true;
+    }
+
+private:
+    static std::int16_t counts(float v) { return (std::int16_t)std::lround(v); }
+
+    std::uint32_t _n = 0;
+};
+
+// What one boot of the firmware records: imuTask at 100 Hz, headingTask
+// at 10 Hz, as in main.cpp
+static void recordBoot(FlightRecorder& rec, float seconds, const GainTable& gains) {
+    CountsIMU imu;
+    ReplayClock clock;
+    IMUFilterAndCalibration filter(imu, clock);
+    SeaStateEstimator seaState;
+    AutoSteeringController steer;
+    // the filter has no yaw yet: a compass off the magnetometer instead,
+    // so the loop steers by a heading that moves
+    SourceArbiter heading;
+    ArbiterSourceConfig compass = { "compass", 0, 250, 20.f, 0.5f };
+    heading.addSource(compass);
+    const GainSet* active = nullptr;
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, 10.f);
+    AutoSteeringMode lastMode = AutoSteeringMode::OFF;
+    float lastSetpoint = 0.f;
+
+    int steps = int(seconds * 100.f);
+    for(int k=0; k<steps; k++) {
+        std::uint32_t now = 10u * (k + 1);
+        clock.set(now);
+        if(filter.update(now)) {
+            rec.logImu(0, now, filter.getRawData());
+            rec.logAttitude(0, now, filter.getFilteredData());
+            IMUData raw = filter.getRawData();
+            heading.publish(0, std::atan2(raw.my, raw.mx) * 57.29578f, 1.f, now);
+        }
+        if(k % 10 == 9) {
+            ArbitratedAngle fb;
+            heading.update(now, fb);
+            if(fb.source >= 0) {
+                steer.setFeedback(FlightLog::quantize(FlightRecordType::FEEDBACK, 0, fb.value));
+            }
+            rec.logFeedback(0, now, fb.value, fb.source, fb.quality);
+            seaState.addSample(filter.getFilteredData().yawRate, 0.1f);
+            const GainSet* g = gains.select(seaState.getSeaState());
+            if(g && g != active) {
+                active = g;
+                steer.setGains(g->steerKp, g->steerKi, g->steerKd);
+            }
+            steer.update(0.1f);
+            if(steer.getMode() != lastMode || steer.getSetpoint() != lastSetpoint) {
+                lastMode = steer.getMode();
+                lastSetpoint = steer.getSetpoint();
+                rec.logMode(0, now, (int)lastMode, lastSetpoint);
+            }
+            rec.logSteering(0, now, steer.getSetpoint(), steer.getRudderAngle(), seaState.getSeaState());
+        }
+        rec.service(now);
+    }
+    rec.flush();
+}
+
+static GainTable twoSeaStates() {
+    GainTable table;
+    GainSet calm  = { 0.5f, 1.5f, 0.02f, 2.f, 2.f, 0.f, 0.05f };
+    GainSet rough = { 1000.f, 0.8f, 0.01f, 3.f, 2.f, 0.f, 0.05f };
+    table.add(calm);
+    table.add(rough);
+    return table;
+}
+
+static void record(VectorStorage& storage, const float* boots, int count, const GainTable& gains) {
+    FlightRecorder rec(storage);
+    rec.setImuResolution(ACCEL_LSB, GYRO_LSB, MAG_LSB);
+    for(int b=0; b<count; b++) {
+        TEST_ASSERT_TRUE(rec.begin());
+        recordBoot(rec, boots[b], gains);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, rec.dropped());
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_replay_reproduces_the_recording() {
+    GainTable gains = twoSeaStates();
+    VectorStorage storage(64);
+    const float boots[] = { 120.f };
+    record(storage, boots, 1, gains);
+
+    FlightLogReader log;
+    TEST_ASSERT_TRUE(log.openMemory(storage.data.data(), storage.data.size()));
+    ControlReplay replay(gains);
+    ReplayResult res = replay.run(log);
+    TEST_ASSERT_EQUAL(12000, res.imuSamples);
+    TEST_ASSERT_EQUAL(1200, res.headingSteps);
+    TEST_ASSERT_EQUAL_UINT32(1, res.boots);
+    TEST_ASSERT_EQUAL(12000 * 4, res.attitude.compared);
+    TEST_ASSERT_EQUAL(0, res.attitude.mismatches);
+    TEST_ASSERT_EQUAL(0, res.steering.mismatches);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, res.steering.maxError);
+}
+
+void test_changed_gains_show_up_as_mismatches() {
+    GainTable gains = twoSeaStates();
+    VectorStorage storage(64);
+    const float boots[] = { 60.f };
+    record(storage, boots, 1, gains);
+
+    GainTable other;
+    GainSet g = { 1000.f, 2.f, 0.02f, 2.f, 2.f, 0.f, 0.05f };
+    other.add(g);
+    FlightLogReader log;
+    log.openMemory(storage.data.data(), storage.data.size());
+    ControlReplay replay(other);
+    ReplayResult res = replay.run(log);
+    TEST_ASSERT_EQUAL(0, res.attitude.mismatches);
+    TEST_ASSERT_TRUE(res.steering.mismatches > 0);
+}
+
+void test_every_boot_starts_fresh() {
+    GainTable gains = twoSeaStates();
+    VectorStorage storage(64);
+    const float boots[] = { 40.f, 30.f, 20.f };
+    record(storage, boots, 3, gains);
+
+    FlightLogReader log;
+    log.openMemory(storage.data.data(), storage.data.size());
+    ControlReplay replay(gains);
+    ReplayResult res = replay.run(log);
+    TEST_ASSERT_EQUAL_UINT32(3, res.boots);
+    TEST_ASSERT_EQUAL(9000, res.imuSamples);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 90.0, res.recordedSeconds);
+    TEST_ASSERT_EQUAL(0, res.attitude.mismatches);
+    TEST_ASSERT_EQUAL(0, res.steering.mismatches);
+}
+
+void test_an_hour_replays_in_well_under_a_second() {
+    GainTable gains = twoSeaStates();
+    VectorStorage storage(2000);
+    const float boots[] = { 3600.f };
+    record(storage, boots, 1, gains);
+
+    FlightLogReader log;
+    log.openMemory(storage.data.data(), storage.data.size());
+    ControlReplay replay(gains);
+    auto t0 = std::chrono::steady_clock::now();
+    ReplayResult res = replay.run(log);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    TEST_ASSERT_EQUAL(360000, res.imuSamples);
+    TEST_ASSERT_EQUAL(0, res.attitude.mismatches + res.steering.mismatches);
+    // a 24 hour passage in seconds
+    TEST_ASSERT_TRUE(wall < 1.0);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_reproduces_the_recording);
+    RUN_TEST(test_changed_gains_show_up_as_mismatches);
+    RUN_TEST(test_every_boot_starts_fresh);
+    RUN_TEST(test_an_hour_replays_in_well_under_a_second);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_reproduces_the_recording);
+    RUN_TEST(test_changed_gains_show_up_as_mismatches);
+    RUN_TEST(test_every_boot_starts_fresh);
+    RUN_TEST(test_an_hour_replays_in_well_under_a_second);
+    return UNITY_END();
+}
+#endif
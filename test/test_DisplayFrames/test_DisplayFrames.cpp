@@ -0,0 +1,161 @@
+#include <unity.h>
+#include "DisplayFrames.h"
+
+static const std::uint8_t CMD[] = { 0x75, 0x00, 0x00, 0x15, 0x00, 0x7f, 0x5c };
+
+// One tile row as the driver sends it: command, then data
+static void writeRow(DisplayFrames& f, std::uint8_t value, std::size_t bytes) {
+    static std::uint8_t data[DisplayFrame::CAPACITY];
+    for(std::size_t i=0; i<bytes; i++) data[i] = value;
+    f.write(false, CMD, sizeof(CMD));
+    f.write(true, data, bytes);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_segments_merge_and_align() {
+    static DisplayFrames f;
+    TEST_ASSERT_TRUE(f.beginFrame());
+    writeRow(f, 0xaa, 64);
+    // the driver sends data in chunks: same kind, one segment
+    const std::uint8_t more[] = { 1, 2, 3 };
+    f.write(true, more, sizeof(more));
+    writeRow(f, 0x55, 128);
+    f.commit(1234);
+
+    const DisplayFrame* fr = f.next();
+    TEST_ASSERT_NOT_NULL(fr);
+    TEST_ASSERT_EQUAL(4, fr->segmentCount);
+    TEST_ASSERT_EQUAL(1234, fr->timeUs);
+    TEST_ASSERT_FALSE(fr->truncated);
+    TEST_ASSERT_FALSE(fr->segments[0].data);
+    TEST_ASSERT_EQUAL(sizeof(CMD), fr->segments[0].length);
+    TEST_ASSERT_TRUE(fr->segments[1].data);
+    TEST_ASSERT_EQUAL(64 + 3, fr->segments[1].length);
+    TEST_ASSERT_EQUAL(3, fr->bytes[fr->segments[1].offset + 66]);
+    TEST_ASSERT_EQUAL(128, fr->segments[3].length);
+    TEST_ASSERT_EQUAL(0x55, fr->bytes[fr->segments[3].offset]);
+    for(std::size_t i=0; i<fr->segmentCount; i++) {
+        TEST_ASSERT_EQUAL(0, fr->segments[i].offset % 4);
+    }
+    f.release();
+    TEST_ASSERT_NULL(f.next());
+}
+
+void test_double_buffer_order_and_stalls() {
+    static DisplayFrames f;
+    // render two frames while the sender is busy with nothing yet
+    TEST_ASSERT_TRUE(f.beginFrame());
+    writeRow(f, 1, 16);
+    f.commit();
+    TEST_ASSERT_TRUE(f.beginFrame());
+    writeRow(f, 2, 16);
+    f.commit();
+    // a third has to wait
+    TEST_ASSERT_FALSE(f.beginFrame());
+    TEST_ASSERT_EQUAL(1, f.stalls());
+
+    // oldest first
+    const DisplayFrame* a = f.next();
+    TEST_ASSERT_EQUAL(1, a->bytes[a->segments[1].offset]);
+    // while it is sent the renderer still waits, then records into it
+    TEST_ASSERT_FALSE(f.beginFrame());
+    f.release();
+    TEST_ASSERT_TRUE(f.beginFrame());
+    writeRow(f, 3, 16);
+
+    // the one recording is not handed out before commit
+    const DisplayFrame* b = f.next();
+    TEST_ASSERT_EQUAL(2, b->bytes[b->segments[1].offset]);
+    f.release();
+    TEST_ASSERT_NULL(f.next());
+    f.commit();
+    const DisplayFrame* c = f.next();
+    TEST_ASSERT_EQUAL(3, c->bytes[c->segments[1].offset]);
+    TEST_ASSERT_TRUE(c->sequence > b->sequence);
+    f.release();
+    TEST_ASSERT_EQUAL(2, f.stalls());
+}
+
+void test_overflow_truncates() {
+    static DisplayFrames f;
+    TEST_ASSERT_TRUE(f.beginFrame());
+    // a whole 192x96 frame fits
+    for(std::size_t row=0; row<DisplayFrame::TILE_ROWS; row++) {
+        writeRow(f, (std::uint8_t)row, 192);
+    }
+    f.commit();
+    const DisplayFrame* fr = f.next();
+    TEST_ASSERT_FALSE(fr->truncated);
+    TEST_ASSERT_EQUAL(2 * DisplayFrame::TILE_ROWS, fr->segmentCount);
+    TEST_ASSERT_EQUAL(DisplayFrame::PANEL_BYTES, fr->size - DisplayFrame::TILE_ROWS * 8);
+    f.release();
+
+    // twice that does not
+    TEST_ASSERT_TRUE(f.beginFrame());
+    for(std::size_t row=0; row<2 * DisplayFrame::TILE_ROWS; row++) {
+        writeRow(f, (std::uint8_t)row, 192);
+    }
+    f.commit();
+    fr = f.next();
+    TEST_ASSERT_TRUE(fr->truncated);
+    TEST_ASSERT_TRUE(fr->size <= DisplayFrame::CAPACITY);
+    TEST_ASSERT_TRUE(fr->segmentCount <= DisplayFrame::MAX_SEGMENTS);
+    f.release();
+    TEST_ASSERT_EQUAL(1, f.truncated());
+}
+
+#ifndef ARDUINO
+#include <thread>
+
+void test_concurrent_render_and_send() {
+    // Every frame arrives whole, once and in order
+    static DisplayFrames f;
+    const int N = 20000;
+    std::thread renderer([&]() {
+        for(int i=0; i<N; i++) {
+            while(!f.beginFrame()) {
+                std::this_thread::yield();
+            }
+            writeRow(f, (std::uint8_t)i, 64 + i % 64);
+            f.commit((std::uint32_t)i);
+        }
+    });
+    int expect = 0, bad = 0;
+    while(expect < N) {
+        const DisplayFrame* fr = f.next();
+        if(!fr) continue;
+        const DisplaySegment& s = fr->segments[1];
+        if((int)fr->timeUs != expect || s.length != 64 + expect % 64) bad++;
+        for(std::size_t i=0; i<s.length; i++) {
+            if(fr->bytes[s.offset + i] != (std::uint8_t)expect) bad++;
+        }
+        f.release();
+        expect++;
+    }
+    renderer.join();
+    TEST_ASSERT_EQUAL(0, bad);
+    TEST_ASSERT_NULL(f.next());
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_segments_merge_and_align);
+    RUN_TEST(test_double_buffer_order_and_stalls);
+    RUN_TEST(test_overflow_truncates);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_segments_merge_and_align);
+    RUN_TEST(test_double_buffer_order_and_stalls);
+    RUN_TEST(test_overflow_truncates);
+    RUN_TEST(test_concurrent_render_and_send);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,189 @@
+#include <unity.h>
+#include <cmath>
+#include "FlightLog.h"
+
+static FlightRecord imuRecord(std::uint32_t t, float phase) {
+    FlightRecord r;
+    r.type = FlightRecordType::IMU;
+    r.timeMs = t;
+    r.value[0] = 0.3f * std::sin(phase);
+    r.value[1] = -0.2f * std::cos(phase);
+    r.value[2] = 9.81f;
+    r.value[3] = 0.01f;
+    r.value[4] = -0.02f;
+    r.value[5] = 0.05f * std::sin(phase);
+    r.value[6] = 17.f;
+    r.value[7] = 3.f * std::cos(phase);
+    r.value[8] = -47.f;
+    return r;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_round_trip_to_fixed_point() {
+    FlightLogEncoder enc;
+    enc.begin(7, 1000);
+    FlightRecord in[3];
+    in[0] = imuRecord(1000, 0.f);
+    in[1].type = FlightRecordType::RUDDER;
+    in[1].timeMs = 1004;
+    in[1].value[0] = 12.5f;
+    in[1].value[1] = -3.217f;
+    in[1].value[2] = -0.75f;
+    in[1].value[3] = 4.2f;
+    in[1].value[4] = 2.f;
+    in[2] = imuRecord(1010, 0.5f);
+    for(const FlightRecord& r : in) {
+        TEST_ASSERT_TRUE(enc.append(r));
+    }
+
+    FlightLogDecoder dec;
+    TEST_ASSERT_TRUE(dec.open(enc.finish(), FlightLog::BLOCK_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(7, dec.sequence());
+    TEST_ASSERT_EQUAL_UINT32(1000, dec.startMs());
+    FlightRecord out;
+    for(const FlightRecord& r : in) {
+        TEST_ASSERT_TRUE(dec.next(out));
+        TEST_ASSERT_EQUAL((int)r.type, (int)out.type);
+        TEST_ASSERT_EQUAL_UINT32(r.timeMs, out.timeMs);
+        for(int i=0; i<FlightLog::fieldCount(r.type); i++) {
+            // within half a fixed point step
+            TEST_ASSERT_FLOAT_WITHIN(0.5f / FlightLog::fieldScale(r.type, i) + 1e-6f,
+                                     r.value[i], out.value[i]);
+        }
+    }
+    TEST_ASSERT_FALSE(dec.next(out));
+}
+
+void test_deltas_keep_records_small() {
+    // 100 Hz IMU samples of a boat rolling gently
+    FlightLogEncoder enc;
+    enc.begin(0, 0);
+    int n = 0;
+    while(enc.append(imuRecord(n * 10, n * 0.02f))) {
+        n++;
+    }
+    float perRecord = float(enc.size() - FlightLog::HEADER_SIZE) / n;
+    TEST_ASSERT_TRUE(perRecord < 18.f);    // 36 bytes as floats
+    TEST_ASSERT_TRUE(enc.size() + FlightLog::MAX_RECORD > FlightLog::BLOCK_SIZE);
+
+    FlightLogDecoder dec;
+    TEST_ASSERT_TRUE(dec.open(enc.finish(), FlightLog::BLOCK_SIZE));
+    FlightRecord out;
+    int decoded = 0;
+    while(dec.next(out)) decoded++;
+    TEST_ASSERT_EQUAL(n, decoded);
+    TEST_ASSERT_EQUAL_UINT32((n - 1) * 10, out.timeMs);
+}
+
+void test_time_may_step_back() {
+    FlightLogEncoder enc;
+    enc.begin(1, 500);
+    FlightRecord r = imuRecord(520, 0.f);
+    enc.append(r);
+    r.type = FlightRecordType::MODE;
+    r.timeMs = 505;    // queued on the other core a bit earlier
+    r.value[0] = 1.f;
+    r.value[1] = 270.f;
+    enc.append(r);
+    FlightLogDecoder dec;
+    TEST_ASSERT_TRUE(dec.open(enc.finish(), FlightLog::BLOCK_SIZE));
+    FlightRecord out;
+    dec.next(out);
+    TEST_ASSERT_EQUAL_UINT32(520, out.timeMs);
+    dec.next(out);
+    TEST_ASSERT_EQUAL_UINT32(505, out.timeMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 270.f, out.value[1]);
+}
+
+void test_rejects_erased_and_corrupt_blocks() {
+    static std::uint8_t erased[FlightLog::BLOCK_SIZE];
+    for(std::uint8_t& b : erased) b = 0xFF;
+    FlightLogDecoder dec;
+    TEST_ASSERT_FALSE(dec.open(erased, sizeof(erased)));
+    std::uint32_t seq, start;
+    TEST_ASSERT_FALSE(FlightLog::readHeader(erased, seq, start));
+
+    FlightLogEncoder enc;
+    enc.begin(3, 0);
+    enc.append(imuRecord(0, 0.f));
+    static std::uint8_t block[FlightLog::BLOCK_SIZE];
+    const std::uint8_t* done = enc.finish();
+    for(std::size_t i=0; i<sizeof(block); i++) block[i] = done[i];
+    TEST_ASSERT_TRUE(dec.open(block, sizeof(block)));
+    block[FlightLog::HEADER_SIZE + 3] ^= 0x10;    // a flipped bit in the payload
+    TEST_ASSERT_FALSE(dec.open(block, sizeof(block)));
+    FlightRecord out;
+    TEST_ASSERT_FALSE(dec.next(out));
+}
+
+void test_imu_counts_round_trip_bit_exact() {
+    // What the MPU9250 driver produces: int16 counts times the LSB
+    const float res[3] = { 0.000598755f, 0.000133158f, 0.6f };
+    FlightLogEncoder enc;
+    enc.setImuResolution(res[0], res[1], res[2]);
+    enc.begin(0, 0);
+    FlightRecord in[20];
+    for(int n=0; n<20; n++) {
+        in[n].type = FlightRecordType::IMU;
+        in[n].timeMs = n * 10;
+        for(int i=0; i<9; i++) {
+            std::int16_t counts = (std::int16_t)(16384 * std::sin(0.3f * n + i) - 700 * i);
+            in[n].value[i] = counts * res[i / 3];
+        }
+        TEST_ASSERT_TRUE(enc.append(in[n]));
+    }
+
+    FlightLogDecoder dec;
+    TEST_ASSERT_TRUE(dec.open(enc.finish(), FlightLog::BLOCK_SIZE));
+    TEST_ASSERT_EQUAL_FLOAT(res[1], dec.resolution(FlightRecordType::IMU, 4));
+    TEST_ASSERT_EQUAL_FLOAT(0.01f, dec.resolution(FlightRecordType::ATTITUDE, 0));
+    FlightRecord out;
+    for(const FlightRecord& r : in) {
+        TEST_ASSERT_TRUE(dec.next(out));
+        TEST_ASSERT_EQUAL_MEMORY(r.value, out.value, 9 * sizeof(float));
+    }
+
+    // The resolution is covered by the CRC
+    static std::uint8_t block[FlightLog::BLOCK_SIZE];
+    const std::uint8_t* done = enc.finish();
+    for(std::size_t i=0; i<sizeof(block); i++) block[i] = done[i];
+    block[14] ^= 0x01;
+    TEST_ASSERT_FALSE(dec.open(block, sizeof(block)));
+}
+
+void test_unknown_type_is_not_encoded() {
+    FlightLogEncoder enc;
+    enc.begin(0, 0);
+    FlightRecord r = imuRecord(0, 0.f);
+    r.type = (FlightRecordType)42;
+    TEST_ASSERT_FALSE(enc.append(r));
+    TEST_ASSERT_TRUE(enc.isEmpty());
+    TEST_ASSERT_EQUAL(0, FlightLog::fieldCount(r.type));
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_to_fixed_point);
+    RUN_TEST(test_deltas_keep_records_small);
+    RUN_TEST(test_time_may_step_back);
+    RUN_TEST(test_rejects_erased_and_corrupt_blocks);
+    RUN_TEST(test_imu_counts_round_trip_bit_exact);
+    RUN_TEST(test_unknown_type_is_not_encoded);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_to_fixed_point);
+    RUN_TEST(test_deltas_keep_records_small);
+    RUN_TEST(test_time_may_step_back);
+    RUN_TEST(test_rejects_erased_and_corrupt_blocks);
+    RUN_TEST(test_imu_counts_round_trip_bit_exact);
+    RUN_TEST(test_unknown_type_is_not_encoded);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <cstring>
+#include "FlightRecorder.h"
+
+// Erased flash in RAM, counting writes
+class RamStorage : public IBlockStorage {
+public:
+    static const std::size_t BLOCKS = 4;
+
+    RamStorage() { std::memset(data, 0xFF, sizeof(data)); }
+
+    std::size_t blockCount() const override { return BLOCKS; }
+
+    bool readBlock(std::size_t index, std::uint8_t* out, std::size_t len) override {
+        std::memcpy(out, data[index], len);
+        return true;
+    }
+
+    bool writeBlock(std::size_t index, const std::uint8_t* block) override {
+        if(failWrites) return false;
+        std::memcpy(data[index], block, FlightLog::BLOCK_SIZE);
+        writes++;
+        return true;
+    }
+
+    std::uint8_t data[BLOCKS][FlightLog::BLOCK_SIZE];
+    int  writes = 0;
+    bool failWrites = false;
+};
+
+static IMUData sample(int i) {
+    IMUData d;
+    d.ax = 0.01f * (i % 50);
+    d.az = 9.81f;
+    d.gz = 0.001f * (i % 20);
+    d.mx = 17.f;
+    d.mz = -47.f;
+    return d;
+}
+
+// Records in all valid blocks, oldest block first
+static int decodeAll(RamStorage& s, std::uint32_t* firstTime, std::uint32_t* lastTime) {
+    int records = 0;
+    std::uint32_t seqs[RamStorage::BLOCKS];
+    int order[RamStorage::BLOCKS];
+    int valid = 0;
+    FlightLogDecoder dec;
+    for(std::size_t b=0; b<RamStorage::BLOCKS; b++) {
+        if(dec.open(s.data[b], FlightLog::BLOCK_SIZE)) {
+            seqs[valid] = dec.sequence();
+            order[valid++] = (int)b;
+        }
+    }
+    for(int i=1; i<valid; i++) {
+        for(int j=i; j>0 && seqs[j-1] > seqs[j]; j--) {
+            std::uint32_t t = seqs[j]; seqs[j] = seqs[j-1]; seqs[j-1] = t;
+            int o = order[j]; order[j] = order[j-1]; order[j-1] = o;
+        }
+    }
+    FlightRecord r;
+    for(int i=0; i<valid; i++) {
+        dec.open(s.data[order[i]], FlightLog::BLOCK_SIZE);
+        while(dec.next(r)) {
+            if(records == 0 && firstTime) *firstTime = r.timeMs;
+            if(lastTime) *lastTime = r.timeMs;
+            records++;
+        }
+    }
+    return records;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_records_reach_storage() {
+    RamStorage storage;
+    FlightRecorder rec(storage);
+    TEST_ASSERT_TRUE(rec.begin());
+    for(int i=0; i<20; i++) {
+        TEST_ASSERT_TRUE(rec.logImu(0, i * 10, sample(i)));
+        rec.logRudder(1, i * 10, 5.f, 4.9f, 0.2f, 1.5f, 0);
+    }
+    rec.logMode(0, 200, 1, 90.f);
+    rec.service(200);
+    TEST_ASSERT_EQUAL_UINT32(41, rec.recorded());
+    TEST_ASSERT_EQUAL(0, storage.writes);    // nothing due yet
+    rec.flush();
+    TEST_ASSERT_EQUAL(1, storage.writes);
+    TEST_ASSERT_EQUAL(41, decodeAll(storage, nullptr, nullptr));
+}
+
+void test_partial_block_saved_periodically() {
+    RamStorage storage;
+    FlightRecorder rec(storage);
+    rec.begin();
+    rec.logImu(0, 0, sample(0));
+    rec.service(FlightRecorder::FLUSH_MS);
+    TEST_ASSERT_EQUAL(1, storage.writes);
+    rec.service(FlightRecorder::FLUSH_MS + 10);    // nothing new
+    TEST_ASSERT_EQUAL(1, storage.writes);
+    rec.logImu(0, 10, sample(1));
+    rec.service(2 * FlightRecorder::FLUSH_MS);
+    TEST_ASSERT_EQUAL(2, storage.writes);
+    TEST_ASSERT_EQUAL(2, decodeAll(storage, nullptr, nullptr));
+}
+
+void test_ring_keeps_the_newest() {
+    RamStorage storage;
+    FlightRecorder rec(storage);
+    rec.begin();
+    // ~10 blocks worth into 4 blocks
+    std::uint32_t t = 0;
+    for(int i=0; i<2000; i++) {
+        for(int k=0; k<10; k++, t+=10) {
+            rec.logImu(0, t, sample(i * 10 + k));
+        }
+        rec.service(t);
+    }
+    rec.flush();
+    TEST_ASSERT_EQUAL_UINT32(0, rec.dropped());
+    TEST_ASSERT_TRUE(rec.blocksWritten() > RamStorage::BLOCKS);
+    std::uint32_t first = 0, last = 0;
+    int n = decodeAll(storage, &first, &last);
+    TEST_ASSERT_EQUAL_UINT32(t - 10, last);
+    TEST_ASSERT_TRUE(first > 0);
+    TEST_ASSERT_EQUAL_UINT32(last - first, (std::uint32_t)(n - 1) * 10);    // contiguous
+}
+
+void test_continues_after_restart() {
+    RamStorage storage;
+    {
+        FlightRecorder rec(storage);
+        rec.begin();
+        for(int i=0; i<600; i++) {
+            rec.logImu(0, i * 10, sample(i));
+            rec.service(i * 10);
+        }
+        rec.flush();
+    }
+    int before = decodeAll(storage, nullptr, nullptr);
+    FlightRecorder rec(storage);
+    TEST_ASSERT_TRUE(rec.begin());
+    rec.logMode(0, 5, 0, 0.f);
+    rec.service(5);
+    rec.flush();
+    std::uint32_t last = 0;
+    TEST_ASSERT_EQUAL(before + 1, decodeAll(storage, nullptr, &last));
+    TEST_ASSERT_EQUAL_UINT32(5, last);    // the new boot comes last
+}
+
+void test_full_queue_drops_without_blocking() {
+    RamStorage storage;
+    FlightRecorder rec(storage);
+    rec.begin();
+    for(std::size_t i=0; i<FlightRecorder::QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(rec.logImu(0, i, sample(0)));
+    }
+    TEST_ASSERT_FALSE(rec.logImu(0, 99, sample(0)));
+    TEST_ASSERT_TRUE(rec.logImu(1, 99, sample(0)));    // the other channel has room
+    TEST_ASSERT_EQUAL_UINT32(1, rec.dropped());
+    TEST_ASSERT_FALSE(rec.logImu(FlightRecorder::CHANNELS, 0, sample(0)));
+}
+
+void test_write_errors_are_counted() {
+    RamStorage storage;
+    storage.failWrites = true;
+    FlightRecorder rec(storage);
+    rec.begin();
+    rec.logImu(0, 0, sample(0));
+    rec.service(0);
+    rec.flush();
+    TEST_ASSERT_EQUAL_UINT32(1, rec.writeErrors());
+    TEST_ASSERT_EQUAL_UINT32(0, rec.blocksWritten());
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_reach_storage);
+    RUN_TEST(test_partial_block_saved_periodically);
+    RUN_TEST(test_ring_keeps_the_newest);
+    RUN_TEST(test_continues_after_restart);
+    RUN_TEST(test_full_queue_drops_without_blocking);
+    RUN_TEST(test_write_errors_are_counted);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_reach_storage);
+    RUN_TEST(test_partial_block_saved_periodically);
+    RUN_TEST(test_ring_keeps_the_newest);
+    RUN_TEST(test_continues_after_restart);
+    RUN_TEST(test_full_queue_drops_without_blocking);
+    RUN_TEST(test_write_errors_are_counted);
+    return UNITY_END();
+}
+#endif
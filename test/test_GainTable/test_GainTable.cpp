@@ -0,0 +1,128 @@
+#include <unity.h>
+#include "GainTable.h"
+#include "../../tools/autotune/GainTableJson.h"
+
+static const char* TABLE_JSON =
+    "{ \"version\": 1, \"sets\": ["
+    "  { \"maxSeaState\": 1000, \"steer\": { \"kP\": 2.0, \"kI\": 0.05, \"kD\": 1.0 },"
+    "                        \"rudder\": { \"kP\": 4.0, \"kI\": 0.0, \"kD\": 0.02 } },"
+    "  { \"maxSeaState\": 0.2, \"steer\": { \"kP\": 3.0, \"kI\": 0.02, \"kD\": 0.5 },"
+    "                        \"rudder\": { \"kP\": 2.0, \"kI\": 0.0, \"kD\": 0.0 } }"
+    "] }";
+
+static GainTable table;
+
+void setUp() {}
+void tearDown() {}
+
+void test_load_and_sort() {
+    TEST_ASSERT_TRUE(table.loadFromJson(TABLE_JSON));
+    TEST_ASSERT_EQUAL(2, (int)table.size());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.2f, table.at(0).maxSeaState);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 3.0f, table.at(0).steerKp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.02f, table.at(1).rudderKd);
+}
+
+void test_select_by_sea_state() {
+    TEST_ASSERT_TRUE(table.loadFromJson(TABLE_JSON));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 3.0f, table.select(0.1f)->steerKp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, table.select(0.5f)->steerKp);
+    // above the last limit the roughest set still applies
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, table.select(5000.f)->steerKp);
+}
+
+void test_bad_json_keeps_table() {
+    TEST_ASSERT_TRUE(table.loadFromJson(TABLE_JSON));
+    TEST_ASSERT_FALSE(table.loadFromJson("{ \"sets\": [ { \"steer\": "));
+    TEST_ASSERT_FALSE(table.loadFromJson("{ \"sets\": [] }"));
+    TEST_ASSERT_EQUAL(2, (int)table.size());
+}
+
+void test_empty_table_selects_nothing() {
+    GainTable empty;
+    TEST_ASSERT_NULL(empty.select(0.f));
+}
+
+void test_add_keeps_order() {
+    GainTable t;
+    GainSet rough = { 1000.f, 2.f, 0.f, 1.f, 4.f, 0.f, 0.f };
+    GainSet calm  = { 0.5f,   3.f, 0.f, 0.f, 2.f, 0.f, 0.f };
+    TEST_ASSERT_TRUE(t.add(rough));
+    TEST_ASSERT_TRUE(t.add(calm));
+    TEST_ASSERT_EQUAL(2, (int)t.size());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 3.0f, t.select(0.1f)->steerKp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, t.select(2.f)->steerKp);
+    for(size_t i=2; i<GainTable::MAX_SETS; i++) TEST_ASSERT_TRUE(t.add(calm));
+    TEST_ASSERT_FALSE(t.add(calm));
+}
+
+void test_economy_per_sea_state() {
+    TEST_ASSERT_TRUE(table.loadFromJson(
+        "{ \"sets\": ["
+        "  { \"maxSeaState\": 0.5, \"steer\": { \"kP\": 3 }, \"rudder\": { \"kP\": 2 } },"
+        "  { \"maxSeaState\": 1000, \"steer\": { \"kP\": 2 }, \"rudder\": { \"kP\": 4 },"
+        "    \"economy\": true }"
+        "] }"));
+    TEST_ASSERT_FALSE(table.select(0.1f)->economy);
+    TEST_ASSERT_TRUE(table.select(2.f)->economy);
+    // tables without it
+    TEST_ASSERT_TRUE(table.loadFromJson(TABLE_JSON));
+    TEST_ASSERT_FALSE(table.select(2.f)->economy);
+}
+
+// What tools/autotune writes, economy per band, loads back
+void test_load_autotune_output() {
+    GainSet tuned[3] = {
+        { 0.116f,  3.f, 0.02f, 0.f, 2.f, 0.f,  0.f,   false },
+        { 0.309f,  2.f, 0.02f, 1.f, 4.f, 0.5f, 0.02f, true  },
+        { 1000.f,  1.5f, 0.f,  2.f, 8.f, 0.f,  0.05f, true  },
+    };
+    float scores[3] = { 6.1116f, 6.1174f, 5.5044f };
+    char json[2048];
+    TEST_ASSERT_TRUE(formatGainTableJson(json, sizeof(json), tuned, scores, 3) > 0);
+    TEST_ASSERT_TRUE(table.loadFromJson(json));
+    TEST_ASSERT_EQUAL(3, (int)table.size());
+    for(int i=0; i<3; i++) {
+        const GainSet& g = table.at(i);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, tuned[i].maxSeaState, g.maxSeaState);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, tuned[i].steerKp, g.steerKp);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, tuned[i].steerKi, g.steerKi);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, tuned[i].steerKd, g.steerKd);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, tuned[i].rudderKp, g.rudderKp);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, tuned[i].rudderKi, g.rudderKi);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, tuned[i].rudderKd, g.rudderKd);
+        TEST_ASSERT_EQUAL(tuned[i].economy, g.economy);
+    }
+    TEST_ASSERT_FALSE(table.select(0.1f)->economy);
+    TEST_ASSERT_TRUE(table.select(2.f)->economy);
+
+    // a buffer too small gives nothing rather than half a table
+    TEST_ASSERT_EQUAL(0, (int)formatGainTableJson(json, 200, tuned, scores, 3));
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_load_and_sort);
+    RUN_TEST(test_select_by_sea_state);
+    RUN_TEST(test_bad_json_keeps_table);
+    RUN_TEST(test_empty_table_selects_nothing);
+    RUN_TEST(test_add_keeps_order);
+    RUN_TEST(test_economy_per_sea_state);
+    RUN_TEST(test_load_autotune_output);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_load_and_sort);
+    RUN_TEST(test_select_by_sea_state);
+    RUN_TEST(test_bad_json_keeps_table);
+    RUN_TEST(test_empty_table_selects_nothing);
+    RUN_TEST(test_add_keeps_order);
+    RUN_TEST(test_economy_per_sea_state);
+    RUN_TEST(test_load_autotune_output);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,158 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "JerkLimitedTrajectory.h"
+#include "RudderServo.h"
+#include "RudderPlant.h"
+
+static const float DT = 0.001f;
+
+struct Limits {
+    float maxVel, maxAcc, maxJerk, overshoot, settle;
+};
+
+static Limits run(JerkLimitedTrajectory& t, float target, float seconds) {
+    Limits l = { 0.f, 0.f, 0.f, 0.f, -1.f };
+    float lastAcc = t.getAcceleration();
+    float start = t.getPosition();
+    float dir = (target > start) ? 1.f : -1.f;
+    for(int i=0; i<int(seconds / DT); i++) {
+        t.update(target, DT);
+        float a = t.getAcceleration();
+        l.maxVel  = std::fmax(l.maxVel, std::fabs(t.getVelocity()));
+        l.maxAcc  = std::fmax(l.maxAcc, std::fabs(a));
+        l.maxJerk = std::fmax(l.maxJerk, std::fabs(a - lastAcc) / DT);
+        l.overshoot = std::fmax(l.overshoot, (t.getPosition() - target) * dir);
+        if(l.settle < 0.f && t.isSettled()) l.settle = (i + 1) * DT;
+        lastAcc = a;
+    }
+    return l;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_limits_hold_for_all_drives() {
+    const DriveProfile profiles[] = {
+        DriveProfile::electricLinear(), DriveProfile::hydraulic(), DriveProfile::wheelDrive()
+    };
+    const float steps[] = { 0.05f, 0.5f, 3.f, 20.f, -35.f };
+    for(const DriveProfile& p : profiles) {
+        for(float s : steps) {
+            JerkLimitedTrajectory t(p);
+            t.reset(0.f);
+            Limits l = run(t, s, 15.f);
+            TEST_ASSERT_TRUE(l.maxVel  <= p.maxRate * 1.0001f);
+            TEST_ASSERT_TRUE(l.maxAcc  <= p.maxAccel * 1.0001f);
+            TEST_ASSERT_TRUE(l.maxJerk <= p.maxJerk * 1.01f);
+            TEST_ASSERT_TRUE(l.overshoot < 0.01f);
+            TEST_ASSERT_TRUE(l.settle > 0.f);
+            TEST_ASSERT_EQUAL_FLOAT(s, t.getPosition());
+        }
+    }
+}
+
+void test_long_move_is_near_time_optimal() {
+    // 30 deg at 6 deg/s cruise: 5 s plus the accel/jerk ramps
+    JerkLimitedTrajectory t(DriveProfile::electricLinear());
+    t.reset(0.f);
+    Limits l = run(t, 30.f, 10.f);
+    float ideal = 30.f / 6.f + 6.f / 30.f + 30.f / 300.f;
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, ideal, l.settle);
+}
+
+void test_target_change_mid_move_stays_smooth() {
+    JerkLimitedTrajectory t(DriveProfile::electricLinear());
+    t.reset(0.f);
+    for(int i=0; i<1000; i++) t.update(20.f, DT);   // 1 s into a 20 deg move
+    TEST_ASSERT_TRUE(t.getVelocity() > 5.f);
+    Limits l = run(t, -5.f, 10.f);                 // reverse
+    TEST_ASSERT_TRUE(l.maxJerk <= 300.f * 1.01f);
+    TEST_ASSERT_TRUE(l.maxAcc <= 30.f * 1.0001f);
+    TEST_ASSERT_EQUAL_FLOAT(-5.f, t.getPosition());
+}
+
+void test_stopping_velocity_inverts_stop_distance() {
+    JerkLimitedTrajectory t(DriveProfile::electricLinear());
+    // triangular region: d = v*sqrt(v/j)
+    float v = t.stoppingVelocity(0.01f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.01f, v * std::sqrt(v / 300.f));
+    // trapezoidal region: d = v/2 * (v/a + a/j)
+    v = t.stoppingVelocity(5.f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 5.f, 0.5f * v * (v / 30.f + 30.f / 300.f));
+}
+
+struct StepStats {
+    float peakCurrent;   // [A]
+    float peakAccel;     // rudder [deg/s^2]
+    float rise90;        // [s]
+    float settle;        // within 0.2 deg [s]
+    float overshoot;     // [deg]
+};
+
+/** 10 deg rudder step at 1 kHz on the plant, stepped or shaped. */
+static StepStats rudderStep(bool shaped) {
+    RudderPlantConfig cfg;
+    cfg.potNoise = 0.f;
+    cfg.currentNoise = 0.f;
+    RudderPlant plant(cfg);
+    RudderServo servo;
+    servo.setGains(30.f, 0.f, 0.f);   // aggressive: full duty at 1 deg error
+    servo.setDriveProfile(DriveProfile::electricLinear());
+    servo.setTrajectoryEnabled(shaped);
+    servo.setTargetAngle(10.f);
+
+    StepStats s = { 0.f, 0.f, -1.f, 0.f, 0.f };
+    float lastRate = 0.f;
+    for(int i=0; i<5000; i++) {
+        float t = i * DT;
+        plant.step(servo.update(plant.getAngle(), DT), DT);
+        s.peakCurrent = std::fmax(s.peakCurrent, plant.getCurrent());
+        s.peakAccel = std::fmax(s.peakAccel, std::fabs(plant.getRate() - lastRate) / DT);
+        lastRate = plant.getRate();
+        if(s.rise90 < 0.f && plant.getAngle() >= 9.f) s.rise90 = t;
+        if(std::fabs(plant.getAngle() - 10.f) > 0.2f) s.settle = t;
+        s.overshoot = std::fmax(s.overshoot, plant.getAngle() - 10.f);
+    }
+    return s;
+}
+
+void test_benchmark_shaped_vs_stepped() {
+    StepStats step = rudderStep(false);
+    StepStats curve = rudderStep(true);
+    char msg[200];
+    std::snprintf(msg, sizeof(msg),
+        "10 deg step: peak current %.1f -> %.1f A, peak accel %.0f -> %.0f deg/s2, "
+        "rise90 %.2f -> %.2f s, settle %.2f -> %.2f s, overshoot %.2f -> %.2f deg",
+        step.peakCurrent, curve.peakCurrent, step.peakAccel, curve.peakAccel,
+        step.rise90, curve.rise90, step.settle, curve.settle, step.overshoot, curve.overshoot);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(curve.peakCurrent < 0.7f * step.peakCurrent);
+    TEST_ASSERT_TRUE(curve.peakAccel < 0.5f * step.peakAccel);
+    // slower by the rate held back for the PID (6 of 8 deg/s), no more
+    TEST_ASSERT_TRUE(curve.settle < step.settle * 1.5f);
+    TEST_ASSERT_TRUE(curve.overshoot < 0.5f);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_limits_hold_for_all_drives);
+    RUN_TEST(test_long_move_is_near_time_optimal);
+    RUN_TEST(test_target_change_mid_move_stays_smooth);
+    RUN_TEST(test_stopping_velocity_inverts_stop_distance);
+    RUN_TEST(test_benchmark_shaped_vs_stepped);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_limits_hold_for_all_drives);
+    RUN_TEST(test_long_move_is_near_time_optimal);
+    RUN_TEST(test_target_change_mid_move_stays_smooth);
+    RUN_TEST(test_stopping_velocity_inverts_stop_distance);
+    RUN_TEST(test_benchmark_shaped_vs_stepped);
+    return UNITY_END();
+}
+#endif
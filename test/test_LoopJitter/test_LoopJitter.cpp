@@ -0,0 +1,74 @@
+#include <unity.h>
+#include "LoopJitter.h"
+
+static LoopJitter jitter(1000);   // 1 kHz
+
+void setUp() {
+    jitter.reset();
+}
+void tearDown() {}
+
+void test_perfect_loop_has_no_jitter() {
+    for(uint32_t i=0; i<100; i++) {
+        jitter.cycleStart(i*1000);
+        jitter.cycleEnd(i*1000 + 50);
+    }
+    const LoopJitterStats& s = jitter.stats();
+    TEST_ASSERT_EQUAL(100, (int)s.cycles);
+    TEST_ASSERT_EQUAL(1000, (int)s.minPeriod);
+    TEST_ASSERT_EQUAL(1000, (int)s.maxPeriod);
+    TEST_ASSERT_EQUAL(0, (int)s.maxJitter);
+    TEST_ASSERT_EQUAL(50, (int)s.maxExec);
+    TEST_ASSERT_EQUAL(0, (int)s.overruns);
+    TEST_ASSERT_EQUAL(99, (int)s.histogram[0]);
+}
+
+void test_late_cycle_is_measured() {
+    jitter.cycleStart(0);
+    jitter.cycleStart(1000);
+    jitter.cycleStart(2030);   // 30 us late
+    jitter.cycleStart(3000);   // 30 us early
+    const LoopJitterStats& s = jitter.stats();
+    TEST_ASSERT_EQUAL(30, (int)s.maxJitter);
+    TEST_ASSERT_EQUAL(970, (int)s.minPeriod);
+    TEST_ASSERT_EQUAL(1030, (int)s.maxPeriod);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, s.meanJitter);
+    TEST_ASSERT_EQUAL(1, (int)s.histogram[0]);   // < 5 us
+    TEST_ASSERT_EQUAL(2, (int)s.histogram[2]);   // 20..50 us
+}
+
+void test_overruns_are_counted() {
+    jitter.cycleStart(0);
+    jitter.cycleEnd(1200);     // body longer than the period
+    jitter.cycleStart(2500);   // missed a tick
+    jitter.cycleEnd(2600);
+    TEST_ASSERT_EQUAL(2, (int)jitter.stats().overruns);
+    TEST_ASSERT_EQUAL(1, (int)jitter.stats().histogram[LoopJitterStats::BUCKETS - 1]);
+}
+
+void test_clock_wraparound() {
+    jitter.cycleStart(0xFFFFFE00u);
+    jitter.cycleStart(0xFFFFFE00u + 1000u);   // wraps past zero
+    TEST_ASSERT_EQUAL(1000, (int)jitter.stats().maxPeriod);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_perfect_loop_has_no_jitter);
+    RUN_TEST(test_late_cycle_is_measured);
+    RUN_TEST(test_overruns_are_counted);
+    RUN_TEST(test_clock_wraparound);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_perfect_loop_has_no_jitter);
+    RUN_TEST(test_late_cycle_is_measured);
+    RUN_TEST(test_overruns_are_counted);
+    RUN_TEST(test_clock_wraparound);
+    return UNITY_END();
+}
+#endif
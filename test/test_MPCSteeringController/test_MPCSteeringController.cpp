@@ -0,0 +1,213 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "MPCSteeringController.h"
+#include "SimHeading.h"
+#include "VesselSim.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+static unsigned long nowMicros() { return micros(); }
+#else
+#include <chrono>
+static unsigned long nowMicros() {
+    using namespace std::chrono;
+    return (unsigned long)duration_cast<microseconds>(
+        steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static MPCSteeringController mpc;
+
+void setUp() {
+    mpc.setMode(AutoSteeringMode::OFF);
+}
+void tearDown() {}
+
+void test_off_mode_rudder_zero() {
+    mpc.update(45.f, 1.f);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, mpc.getRudderAngle());
+}
+
+void test_zero_state_zero_rudder() {
+    float x[MPC_STATE_DIM] = {0.f, 0.f, 0.f};
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.f, MPCSteeringController::evaluate(x));
+}
+
+void test_rudder_opposes_error() {
+    // heading right of the setpoint -> turn back left (negative rudder)
+    mpc.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    mpc.update(95.f, 0.f);
+    TEST_ASSERT_TRUE(mpc.getRudderAngle() < 0.f);
+
+    mpc.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    mpc.update(85.f, 0.f);
+    TEST_ASSERT_TRUE(mpc.getRudderAngle() > 0.f);
+}
+
+void test_heading_wraparound() {
+    // 350 -> 10 is a 20 deg turn to starboard, not 340 to port
+    mpc.setMode(AutoSteeringMode::TRACK_HEADING, 10.f);
+    mpc.update(350.f, 0.f);
+    TEST_ASSERT_TRUE(mpc.getRudderAngle() > 0.f);
+}
+
+void test_large_error_saturates() {
+    float x[MPC_STATE_DIM] = {120.f, 0.f, 0.f};
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -MPC_MODEL.rudderMax, MPCSteeringController::evaluate(x));
+}
+
+void test_yaw_rate_is_anticipated() {
+    // Same heading error, but already turning towards the setpoint:
+    // the MPC should ease off (or counter-steer) instead of pushing on.
+    float still[MPC_STATE_DIM]   = {5.f,  0.f, 0.f};
+    float closing[MPC_STATE_DIM] = {5.f, -3.f, 0.f};
+    float uStill   = MPCSteeringController::evaluate(still);
+    float uClosing = MPCSteeringController::evaluate(closing);
+    TEST_ASSERT_TRUE(uClosing > uStill);
+}
+
+void test_law_is_continuous() {
+    // Explicit MPC is continuous across region borders
+    float last = 0.f;
+    for(int i=0; i<=2400; i++) {
+        float x[MPC_STATE_DIM] = {-120.f + 0.1f*i, 1.5f, -4.f};
+        float u = MPCSteeringController::evaluate(x);
+        if(i > 0) {
+            TEST_ASSERT_FLOAT_WITHIN(1.0f, last, u);
+        }
+        last = u;
+    }
+}
+
+void test_closed_loop_step() {
+    // Nomoto plant matching the table model
+    const float ts = MPC_MODEL.ts;
+    const float a  = std::exp(-ts / MPC_MODEL.nomotoT);
+    float heading = 0.f, yawRate = 0.f;
+    float maxHeading = 0.f;
+
+    mpc.setMode(AutoSteeringMode::TRACK_HEADING, 30.f);
+    for(int k=0; k<300; k++) {   // 30 s
+        mpc.update(heading, yawRate);
+        float u = mpc.getRudderAngle();
+        heading += ts * yawRate;
+        yawRate  = a*yawRate + MPC_MODEL.nomotoK*(1.f - a)*u;
+        if(heading > maxHeading) maxHeading = heading;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 30.f, heading);
+    TEST_ASSERT_TRUE(maxHeading < 33.f);   // < 10% overshoot
+}
+
+// The heading task's loop on the simulated boat: heading from the gyro
+// and compass, the IMU's z rate negated, the MPC at its table's period
+static float steerVessel(VesselSim& boat, float setpoint, float seconds, float* maxHeading) {
+    const float DT = 0.01f;
+    const int every = int(MPC_MODEL.ts / DT + 0.5f);
+    HeadingFilter compass;
+    IMUData d;
+    double sqErr = 0.0;
+    int samples = 0;
+    mpc.setMode(AutoSteeringMode::TRACK_HEADING, setpoint);
+    for(int k=0; k<int(seconds / DT); k++) {
+        boat.readIMU(d);
+        float yawRate = -d.gz * 57.29578f;
+        float heading = compass.update(yawRate, compassHeading(d), DT);
+        if(k % every == 0) mpc.update(heading, yawRate);
+        boat.stepWithRudder(mpc.getRudderAngle(), DT);
+        float err = boat.state().heading - setpoint;
+        while(err > 180.f)   err -= 360.f;
+        while(err <= -180.f) err += 360.f;
+        if(maxHeading && err > *maxHeading) *maxHeading = err;
+        if(k * DT >= seconds / 2) {
+            sqErr += double(err) * err;
+            samples++;
+        }
+    }
+    return float(std::sqrt(sqErr / samples));
+}
+
+void test_closed_loop_on_vessel() {
+    // A 30 deg step in calm water: the boat is the table's Nomoto model
+    VesselConfig cfg;
+    cfg.initialHeading = 0.f;
+    cfg.waves.significantHeight = 0.f;
+    cfg.wind.speed = 0.f;
+    VesselSim boat(cfg);
+    float overshoot = -1e9f;
+    float rms = steerVessel(boat, 30.f, 30.f, &overshoot);
+    TEST_ASSERT_FLOAT_WITHIN(1.f, 30.f, boat.state().heading);
+    TEST_ASSERT_TRUE(rms < 1.f);
+    TEST_ASSERT_TRUE(overshoot < 4.5f);    // < 15%, the compass lags the turn
+
+    // and it holds her in a quartering sea
+    VesselConfig rough;
+    rough.waves.significantHeight = 2.f;
+    rough.waves.direction = rough.initialHeading + 135.f;
+    VesselSim sea(rough);
+    rms = steerVessel(sea, rough.initialHeading, 600.f, nullptr);
+    char msg[64];
+    std::snprintf(msg, sizeof(msg), "MPC on VesselSim: rms heading error %.2f deg", rms);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(rms < 5.f);
+}
+
+void test_benchmark_fits_control_period() {
+    const int N = 2000;
+    unsigned long worst = 0;
+    unsigned long total = 0;
+    float sink = 0.f;
+    unsigned int seed = 12345;
+    for(int i=0; i<N; i++) {
+        seed = seed*1103515245u + 12345u;
+        float x[MPC_STATE_DIM] = {
+            float((seed >> 8) % 240) - 120.f,
+            float((seed >> 4) % 30) - 15.f,
+            float(seed % 60) - 30.f
+        };
+        unsigned long t0 = nowMicros();
+        sink += MPCSteeringController::evaluate(x);
+        unsigned long t = nowMicros() - t0;
+        total += t;
+        if(t > worst) worst = t;
+    }
+    char msg[96];
+    std::snprintf(msg, sizeof(msg), "MPC eval: %d regions, mean %.2f us, worst %lu us (sink %.1f)",
+                  MPC_REGION_COUNT, double(total)/N, worst, sink);
+    TEST_MESSAGE(msg);
+    // 10 ms control period
+    TEST_ASSERT_TRUE(worst < 10000UL);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_off_mode_rudder_zero);
+    RUN_TEST(test_zero_state_zero_rudder);
+    RUN_TEST(test_rudder_opposes_error);
+    RUN_TEST(test_heading_wraparound);
+    RUN_TEST(test_large_error_saturates);
+    RUN_TEST(test_yaw_rate_is_anticipated);
+    RUN_TEST(test_law_is_continuous);
+    RUN_TEST(test_closed_loop_step);
+    RUN_TEST(test_closed_loop_on_vessel);
+    RUN_TEST(test_benchmark_fits_control_period);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_off_mode_rudder_zero);
+    RUN_TEST(test_zero_state_zero_rudder);
+    RUN_TEST(test_rudder_opposes_error);
+    RUN_TEST(test_heading_wraparound);
+    RUN_TEST(test_large_error_saturates);
+    RUN_TEST(test_yaw_rate_is_anticipated);
+    RUN_TEST(test_law_is_continuous);
+    RUN_TEST(test_closed_loop_step);
+    RUN_TEST(test_closed_loop_on_vessel);
+    RUN_TEST(test_benchmark_fits_control_period);
+    return UNITY_END();
+}
+#endif
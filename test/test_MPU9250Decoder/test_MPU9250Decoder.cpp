@@ -0,0 +1,75 @@
+#include <unity.h>
+#include "MPU9250Decoder.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_config_registers() {
+    TEST_ASSERT_EQUAL_HEX8(0x00, MPU9250Decoder::accelConfig(MPU9250AccelRange::ACCEL_RANGE_2G));
+    TEST_ASSERT_EQUAL_HEX8(0x18, MPU9250Decoder::accelConfig(MPU9250AccelRange::ACCEL_RANGE_16G));
+    TEST_ASSERT_EQUAL_HEX8(0x08, MPU9250Decoder::gyroConfig(MPU9250GyroRange::GYRO_RANGE_500DPS));
+}
+
+void test_scales() {
+    // full scale is +-32768 LSB
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 2.f * 9.81f,
+        32768.f * MPU9250Decoder::accelScale(MPU9250AccelRange::ACCEL_RANGE_2G));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 8.f * 9.81f,
+        32768.f * MPU9250Decoder::accelScale(MPU9250AccelRange::ACCEL_RANGE_8G));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 2000.f * 3.14159f / 180.f,
+        32768.f * MPU9250Decoder::gyroScale(MPU9250GyroRange::GYRO_RANGE_2000DPS));
+}
+
+void test_accel_gyro_big_endian_signed() {
+    const std::uint8_t raw[14] = {
+        0x40, 0x00,   // ax = 16384 -> 1 g at 2 g range
+        0xC0, 0x00,   // ay = -16384
+        0x00, 0x01,   // az = 1
+        0x12, 0x34,   // temperature, ignored
+        0x00, 0x83,   // gx = 131
+        0xFF, 0x7D,   // gy = -131
+        0x80, 0x00    // gz = -32768
+    };
+    MPU9250Reading r = {};
+    MPU9250Decoder::decodeAccelGyro(raw, 2.f / 32768.f * 9.81f, 1.f, r);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 9.81f, r.accelX);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -9.81f, r.accelY);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.f / 32768.f * 9.81f, r.accelZ);
+    TEST_ASSERT_EQUAL_FLOAT(131.f, r.gyroX);
+    TEST_ASSERT_EQUAL_FLOAT(-131.f, r.gyroY);
+    TEST_ASSERT_EQUAL_FLOAT(-32768.f, r.gyroZ);
+}
+
+void test_mag_little_endian_and_overflow() {
+    const std::uint8_t raw[7] = { 0x64, 0x00, 0x9C, 0xFF, 0x00, 0x00, 0x10 };
+    MPU9250Reading r = {};
+    TEST_ASSERT_TRUE(MPU9250Decoder::decodeMag(raw, r));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 100.f * MPU9250Decoder::MAG_SCALE, r.magX);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -100.f * MPU9250Decoder::MAG_SCALE, r.magY);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, r.magZ);
+
+    const std::uint8_t overflow[7] = { 0xFF, 0x7F, 0, 0, 0, 0, 0x08 };
+    TEST_ASSERT_FALSE(MPU9250Decoder::decodeMag(overflow, r));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 100.f * MPU9250Decoder::MAG_SCALE, r.magX);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_config_registers);
+    RUN_TEST(test_scales);
+    RUN_TEST(test_accel_gyro_big_endian_signed);
+    RUN_TEST(test_mag_little_endian_and_overflow);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_config_registers);
+    RUN_TEST(test_scales);
+    RUN_TEST(test_accel_gyro_big_endian_signed);
+    RUN_TEST(test_mag_little_endian_and_overflow);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,79 @@
+#include <unity.h>
+#include "Mailbox.h"
+
+struct Sample {
+    float a;
+    float b;
+    int   n;
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty_mailbox_returns_initial() {
+    Mailbox<float> box(7.0f);
+    float v = 0.0f;
+    TEST_ASSERT_FALSE(box.read(v));
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, v);
+    TEST_ASSERT_EQUAL(0, (int)box.version());
+}
+
+void test_read_returns_latest_write() {
+    Mailbox<Sample> box;
+    box.write(Sample{1.0f, 2.0f, 1});
+    box.write(Sample{3.0f, 4.0f, 2});
+    Sample s;
+    TEST_ASSERT_TRUE(box.read(s));
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, s.a);
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, s.b);
+    TEST_ASSERT_EQUAL(2, s.n);
+    TEST_ASSERT_EQUAL(2, (int)box.version());
+}
+
+#ifndef ARDUINO
+#include <thread>
+#include <atomic>
+
+void test_concurrent_reads_are_consistent() {
+    // The writer keeps a == b == n; a torn read would break that
+    Mailbox<Sample> box;
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for(int i=1; i<=200000; i++) {
+            box.write(Sample{float(i), float(i), i});
+        }
+        done = true;
+    });
+
+    int torn = 0, last = 0, backwards = 0;
+    while(!done) {
+        Sample s;
+        if(box.read(s)) {
+            if(s.a != s.b || int(s.a) != s.n) torn++;
+            if(s.n < last) backwards++;
+            last = s.n;
+        }
+    }
+    writer.join();
+    TEST_ASSERT_EQUAL(0, torn);
+    TEST_ASSERT_EQUAL(0, backwards);
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_mailbox_returns_initial);
+    RUN_TEST(test_read_returns_latest_write);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_mailbox_returns_initial);
+    RUN_TEST(test_read_returns_latest_write);
+    RUN_TEST(test_concurrent_reads_are_consistent);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,45 @@
+#include <unity.h>
+#include "MotorCurrentSensor.h"
+
+static MotorCurrentSensor sensor(0.01f, 100.0f);
+
+void setUp() {
+    sensor.setScale(0.01f, 100.0f);
+    sensor.reset();
+}
+void tearDown() {}
+
+void test_scale_and_offset() {
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, sensor.toAmps(600.0f));
+    // below the zero offset reads as no current
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sensor.toAmps(50.0f));
+}
+
+void test_decimated_current_follows_within_two_outputs() {
+    std::uint16_t raw[8];
+    for(auto& r : raw) r = 100;
+    for(int i=0; i<4; i++) sensor.addSamples(raw, 8);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sensor.getCurrent());
+
+    // step to 20 A: settled after ORDER*RATIO samples, i.e. 0.4 ms at 40 kHz
+    for(auto& r : raw) r = 2100;
+    for(int i=0; i<MotorCurrentSensor::CIC_ORDER; i++) sensor.addSamples(raw, 8);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 20.0f, sensor.getCurrent());
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_scale_and_offset);
+    RUN_TEST(test_decimated_current_follows_within_two_outputs);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_scale_and_offset);
+    RUN_TEST(test_decimated_current_follows_within_two_outputs);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,206 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "MotorProtection.h"
+#include "RudderPlant.h"
+#include "RudderServo.h"
+
+static const float DT = 0.001f;   // 1 kHz servo loop
+static MotorProtection prot;
+
+void setUp() {
+    prot.setConfig(MotorProtectionConfig());
+    prot.reset();
+}
+void tearDown() {}
+
+void test_normal_running_passes() {
+    for(int i=0; i<10000; i++) {
+        float angle = 0.004f * i;   // moving at 4 deg/s
+        TEST_ASSERT_EQUAL_FLOAT(0.5f, prot.limit(0.5f, 4.0f, angle, DT));
+    }
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::NONE);
+}
+
+void test_overcurrent_trips_within_two_samples() {
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, prot.limit(1.0f, 40.0f, 0.0f, DT));   // one spike is tolerated
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, prot.limit(1.0f, 40.0f, 0.0f, DT));
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::OVERCURRENT);
+    TEST_ASSERT_EQUAL(1, (int)prot.getTripCount());
+}
+
+void test_single_spike_is_ignored() {
+    prot.limit(1.0f, 40.0f, 0.0f, DT);
+    prot.limit(1.0f, 4.0f, 0.01f, DT);
+    prot.limit(1.0f, 40.0f, 0.02f, DT);
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::NONE);
+}
+
+void test_overcurrent_retries_after_hold() {
+    prot.limit(1.0f, 40.0f, 0.0f, DT);
+    prot.limit(1.0f, 40.0f, 0.0f, DT);
+    int held = 0;
+    while(prot.limit(1.0f, 0.0f, 0.0f, DT) == 0.0f && held < 10000) held++;
+    TEST_ASSERT_INT_WITHIN(2, int(MotorProtectionConfig().overcurrentHold / DT), held);
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::NONE);
+}
+
+void test_stall_blocks_only_that_direction() {
+    int n = 0;
+    while(prot.limit(0.6f, 12.0f, 35.0f, DT) != 0.0f && n < 10000) n++;
+    TEST_ASSERT_INT_WITHIN(2, int(MotorProtectionConfig().stallTime / DT), n);
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::STALL);
+    TEST_ASSERT_EQUAL(1, prot.getBlockedDirection());
+
+    // Off the stop is allowed, and clears the block once it moves
+    TEST_ASSERT_EQUAL_FLOAT(-0.6f, prot.limit(-0.6f, 6.0f, 35.0f, DT));
+    prot.limit(-0.6f, 6.0f, 34.5f, DT);
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::NONE);
+}
+
+void test_start_inrush_is_not_a_stall() {
+    // Plant from standstill at full duty: 20 A at first, falling with speed
+    RudderPlant plant;
+    for(int i=0; i<2000; i++) {
+        float cmd = prot.limit(1.0f, plant.getCurrent(), plant.getAngle(), DT);
+        TEST_ASSERT_EQUAL_FLOAT(1.0f, cmd);
+        plant.step(cmd, DT);
+    }
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::NONE);
+}
+
+void test_thermal_rated_current_never_trips() {
+    for(int i=0; i<600000; i++) {   // 10 min at the rating
+        prot.limit(0.3f, MotorProtectionConfig().ratedCurrent, 0.01f * (i % 100), DT);
+    }
+    TEST_ASSERT_TRUE(prot.getFault() == MotorFault::NONE);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, prot.getThermalLoad());
+}
+
+void test_thermal_overload_trips_and_cools() {
+    // Twice the rating heats to 4x; trips at 1.5x after tau*ln(4/2.5)
+    MotorProtectionConfig cfg;
+    float expected = cfg.thermalTau * std::log(4.0f / (4.0f - cfg.thermalTrip));
+    float t = 0.0f;
+    while(prot.getFault() != MotorFault::THERMAL && t < 100.0f) {
+        prot.limit(0.5f, 2.0f * cfg.ratedCurrent, 0.1f * std::sin(t * 10.f), DT);
+        t += DT;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, expected, t);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, prot.limit(0.5f, 0.0f, 0.0f, DT));
+
+    float cool = 0.0f;
+    while(prot.getFault() == MotorFault::THERMAL && cool < 100.0f) {
+        prot.limit(0.5f, 0.0f, 0.0f, DT);
+        cool += DT;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, cfg.thermalTau * std::log(cfg.thermalTrip / cfg.thermalReset), cool);
+}
+
+struct StallRun {
+    float tripLatency;     // from first contact to drive off [s]
+    float energyAtStop;    // drive energy after contact [Wh]
+    float maxThermal;
+    MotorFault fault;
+};
+
+/**
+ * Aggressive servo (saturates at 1 deg of error) asked for more rudder
+ * than the stop allows, or running into a jam at 10 deg.
+ */
+static StallRun stallRun(bool protect, bool jam) {
+    RudderPlant plant(RudderPlantConfig(), 4);
+    RudderServo servo;
+    servo.setGains(30.f, 5.f, 0.f);
+    servo.setTargetAngle(jam ? 20.f : 40.f);   // stop is at 35
+    MotorProtection p;
+
+    StallRun r = { -1.f, 0.f, 0.f, MotorFault::NONE };
+    float contact = -1.f, energyAtContact = 0.f;
+    for(int i=0; i<30000; i++) {   // 30 s
+        float t = i * DT;
+        if(jam && plant.getAngle() >= 10.f) plant.setJammed(true);
+        float angle = plant.potToAngle(plant.readPot());
+        float current = plant.readCurrent();
+        float cmd = servo.update(angle, DT);
+        if(protect) {
+            float allowed = p.limit(cmd, current, angle, DT);
+            if(allowed != cmd) servo.clearIntegral();
+            cmd = allowed;
+        }
+        plant.step(cmd, DT);
+
+        bool stuck = (plant.getRate() == 0.f && std::fabs(cmd) > 0.f) || plant.getAngle() >= 35.f;
+        if(contact < 0.f && stuck && i > 10) {
+            contact = t;
+            energyAtContact = plant.getEnergyWh();
+        }
+        if(contact >= 0.f && r.tripLatency < 0.f && protect && p.getFault() != MotorFault::NONE) {
+            r.tripLatency = t - contact;
+            r.fault = p.getFault();
+        }
+        if(p.getThermalLoad() > r.maxThermal) r.maxThermal = p.getThermalLoad();
+    }
+    r.energyAtStop = plant.getEnergyWh() - energyAtContact;
+    return r;
+}
+
+void test_rudder_on_stop_trips_fast() {
+    StallRun off = stallRun(false, false);
+    StallRun on  = stallRun(true, false);
+    char msg[160];
+    std::snprintf(msg, sizeof(msg),
+        "end stop: trip after %.0f ms, energy on stop %.3f -> %.3f Wh over 30 s, max I2t %.2f",
+        on.tripLatency * 1000.f, off.energyAtStop, on.energyAtStop, on.maxThermal);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(on.fault == MotorFault::STALL);
+    TEST_ASSERT_TRUE(on.tripLatency >= 0.f && on.tripLatency < 0.25f);
+    TEST_ASSERT_TRUE(on.energyAtStop * 5.f < off.energyAtStop);
+    TEST_ASSERT_TRUE(on.maxThermal < MotorProtectionConfig().thermalTrip);
+}
+
+void test_jammed_rudder_trips_fast() {
+    StallRun off = stallRun(false, true);
+    StallRun on  = stallRun(true, true);
+    char msg[160];
+    std::snprintf(msg, sizeof(msg),
+        "jam: trip after %.0f ms, energy jammed %.3f -> %.3f Wh over 30 s",
+        on.tripLatency * 1000.f, off.energyAtStop, on.energyAtStop);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(on.fault == MotorFault::STALL);
+    TEST_ASSERT_TRUE(on.tripLatency >= 0.f && on.tripLatency < 0.25f);
+    TEST_ASSERT_TRUE(on.energyAtStop * 5.f < off.energyAtStop);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_normal_running_passes);
+    RUN_TEST(test_overcurrent_trips_within_two_samples);
+    RUN_TEST(test_single_spike_is_ignored);
+    RUN_TEST(test_overcurrent_retries_after_hold);
+    RUN_TEST(test_stall_blocks_only_that_direction);
+    RUN_TEST(test_start_inrush_is_not_a_stall);
+    RUN_TEST(test_thermal_rated_current_never_trips);
+    RUN_TEST(test_thermal_overload_trips_and_cools);
+    RUN_TEST(test_rudder_on_stop_trips_fast);
+    RUN_TEST(test_jammed_rudder_trips_fast);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_normal_running_passes);
+    RUN_TEST(test_overcurrent_trips_within_two_samples);
+    RUN_TEST(test_single_spike_is_ignored);
+    RUN_TEST(test_overcurrent_retries_after_hold);
+    RUN_TEST(test_stall_blocks_only_that_direction);
+    RUN_TEST(test_start_inrush_is_not_a_stall);
+    RUN_TEST(test_thermal_rated_current_never_trips);
+    RUN_TEST(test_thermal_overload_trips_and_cools);
+    RUN_TEST(test_rudder_on_stop_trips_fast);
+    RUN_TEST(test_jammed_rudder_trips_fast);
+    return UNITY_END();
+}
+#endif
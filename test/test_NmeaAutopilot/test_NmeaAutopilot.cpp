@@ -0,0 +1,300 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "NmeaAutopilot.h"
+
+// What went out, one string per output call
+static std::string datagrams[16];
+static int outputs;
+
+static void onOutput(const char* data, std::size_t len, void*) {
+    if(outputs < 16) datagrams[outputs] = std::string(data, len);
+    outputs++;
+}
+
+static NmeaSentence parsed;
+static int parsedCount;
+
+static void onSentence(const NmeaSentence& s, void*) {
+    parsed = s;
+    parsedCount++;
+}
+
+// "$<body>*hh\r\n" with the right checksum
+static const char* sentence(const char* body) {
+    static char buf[128];
+    unsigned sum = 0;
+    for(const char* p = body; *p; p++) sum ^= (unsigned char)*p;
+    std::snprintf(buf, sizeof(buf), "$%s*%02X\r\n", body, sum);
+    return buf;
+}
+
+static AutopilotTelemetry telemetry(AutoSteeringMode mode, float setpoint) {
+    AutopilotTelemetry t;
+    t.mode = mode;
+    t.setpoint = setpoint;
+    t.heading = 181.5f;
+    t.windAngle = NAN;
+    t.rudderAngle = -3.2f;
+    return t;
+}
+
+// Parse a command the way it comes off the network
+static NmeaSentence command(const char* body) {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    parsedCount = 0;
+    const char* text = sentence(body);
+    p.feed(text, std::strlen(text));
+    TEST_ASSERT_EQUAL(1, parsedCount);
+    return parsed;
+}
+
+void setUp() {
+    outputs = 0;
+    for(std::string& d : datagrams) d.clear();
+}
+void tearDown() {}
+
+void test_writer_numbers() {
+    char buf[NmeaWriter::MAX_LENGTH + 1];
+    NmeaWriter w(buf, sizeof(buf));
+    w.begin("APXXX");
+    w.field(0.05f, 2);
+    w.field(-0.04f, 1);     // rounds to 0, no "-0.0"
+    w.field(-12.345f, 2);
+    w.field(7.f, 0);
+    w.field(359.96f, 1);
+    w.field(NAN, 1);
+    w.field(1e12f, 1);      // does not fit 32 bits: empty
+    w.field('M');
+    w.field("WP1");
+    std::size_t n = w.finish();
+    TEST_ASSERT_EQUAL_STRING(sentence("APXXX,0.05,0.0,-12.35,7,360.0,,,M,WP1"), buf);
+    TEST_ASSERT_EQUAL(std::strlen(buf), n);
+}
+
+void test_writer_never_overflows() {
+    char buf[20];
+    std::memset(buf, 'x', sizeof(buf));
+    NmeaWriter w(buf, 19);
+    w.begin("APHDG");
+    w.field(123.4f, 1);
+    TEST_ASSERT_EQUAL(17, w.finish());
+    w.begin("APHDG");
+    w.field(1234.5f, 1);
+    w.field(1.f, 0);
+    TEST_ASSERT_EQUAL(0, w.finish());
+    TEST_ASSERT_EQUAL('x', buf[19]);
+
+    // not even the '$' in a buffer too small for any sentence
+    for(std::size_t size=1; size<7; size++) {
+        std::memset(buf, 'x', sizeof(buf));
+        NmeaWriter t(buf, size);
+        t.begin("APHDG");
+        t.empty();
+        TEST_ASSERT_EQUAL(0, t.finish());
+        for(std::size_t i=0; i<sizeof(buf); i++) {
+            TEST_ASSERT_EQUAL('x', buf[i]);
+        }
+    }
+
+    // and not over the standard's 82 characters
+    char big[200];
+    NmeaWriter v(big, sizeof(big));
+    v.begin("APXXX");
+    for(int i=0; i<30; i++) v.field(12.f, 0);
+    TEST_ASSERT_EQUAL(0, v.finish());
+}
+
+void test_sentences_parse_back() {
+    AutopilotTelemetry t = telemetry(AutoSteeringMode::TRACK_HEADING, 185.f);
+    char buf[NmeaWriter::MAX_LENGTH + 1];
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    parsedCount = 0;
+
+    std::size_t n = NmeaAutopilot::format(NmeaAutopilot::HDG, t, buf, sizeof(buf));
+    p.feed(buf, n);
+    TEST_ASSERT_EQUAL(1, parsedCount);
+    TEST_ASSERT_EQUAL((int)NmeaType::HDG, (int)parsed.type);
+    TEST_ASSERT_EQUAL_STRING("AP", parsed.talker);
+    TEST_ASSERT_EQUAL_FLOAT(181.5f, parsed.hdg.heading);
+    TEST_ASSERT_TRUE(std::isnan(parsed.hdg.variation));
+
+    NmeaAutopilot::format(NmeaAutopilot::RSA, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("APRSA,-3.2,A,,V"), buf);
+    NmeaAutopilot::format(NmeaAutopilot::APB, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("APAPB,A,A,,,N,V,V,,,,,,185.0,M,"), buf);
+    NmeaAutopilot::format(NmeaAutopilot::STATUS, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("PXAPS,H,185.0,181.5,-3.2"), buf);
+
+    // off: APB not active, no rudder sensor
+    t = telemetry(AutoSteeringMode::OFF, 0.f);
+    t.rudderAngle = NAN;
+    NmeaAutopilot::format(NmeaAutopilot::APB, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("APAPB,V,V,,,N,V,V,,,,,,,,"), buf);
+    NmeaAutopilot::format(NmeaAutopilot::RSA, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("APRSA,,V,,V"), buf);
+
+    // every heading source lost: no heading rather than the one held
+    t.heading = NAN;
+    NmeaAutopilot::format(NmeaAutopilot::HDG, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("APHDG,,,,,"), buf);
+    NmeaAutopilot::format(NmeaAutopilot::STATUS, t, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(sentence("PXAPS,O,0.0,,"), buf);
+}
+
+void test_sentences_go_out_at_their_rates() {
+    AutoSteeringController steer;
+    NmeaAutopilot ap(steer);
+    ap.setOutput(onOutput, nullptr);
+    ap.setPeriod(NmeaAutopilot::APB, 2000);
+    AutopilotTelemetry t = telemetry(AutoSteeringMode::TRACK_HEADING, 185.f);
+
+    // 10 s of a 100 ms task
+    int hdg = 0, rsa = 0, apb = 0, status = 0;
+    for(std::uint32_t now=5000; now<15000; now+=100) {
+        int before = outputs;
+        ap.update(now, t);
+        if(outputs == before) continue;
+        const std::string& d = datagrams[0];
+        hdg    += d.find("$APHDG") != std::string::npos;
+        rsa    += d.find("$APRSA") != std::string::npos;
+        apb    += d.find("$APAPB") != std::string::npos;
+        status += d.find("$PXAPS") != std::string::npos;
+        outputs = 0;
+    }
+    TEST_ASSERT_EQUAL(10, hdg);
+    TEST_ASSERT_EQUAL(20, rsa);
+    TEST_ASSERT_EQUAL(5, apb);
+    TEST_ASSERT_EQUAL(10, status);
+    TEST_ASSERT_EQUAL_UINT32(45, ap.sent());
+
+    // all due at once: one datagram, sentences back to back
+    NmeaAutopilot all(steer);
+    all.setOutput(onOutput, nullptr);
+    all.setPeriod(NmeaAutopilot::APB, 100);
+    all.update(0, t);
+    TEST_ASSERT_EQUAL(1, outputs);
+    std::string expect = sentence("APHDG,181.5,,,,");
+    expect += sentence("APRSA,-3.2,A,,V");
+    expect += sentence("APAPB,A,A,,,N,V,V,,,,,,185.0,M,");
+    expect += sentence("PXAPS,H,185.0,181.5,-3.2");
+    TEST_ASSERT_EQUAL_STRING(expect.c_str(), datagrams[0].c_str());
+
+    // off is off
+    all.setPeriod(NmeaAutopilot::HDG, 0);
+    all.setPeriod(NmeaAutopilot::RSA, 0);
+    all.setPeriod(NmeaAutopilot::APB, 0);
+    all.setPeriod(NmeaAutopilot::STATUS, 0);
+    all.update(5000, t);
+    TEST_ASSERT_EQUAL(1, outputs);
+}
+
+void test_remote_commands_set_the_mode() {
+    AutoSteeringController steer;
+    NmeaAutopilot ap(steer);
+    SteeringCommand cmd;
+    ap.update(0, telemetry(AutoSteeringMode::OFF, 0.f));
+
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,H,200.5"), cmd));
+    steer.update(0.1f);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_HEADING, steer.getMode());
+    TEST_ASSERT_EQUAL_FLOAT(200.5f, steer.getSetpoint());
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_HEADING, cmd.mode);
+
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,W,-40"), cmd));
+    steer.update(0.1f);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_WIND_ANGLE, steer.getMode());
+    TEST_ASSERT_EQUAL_FLOAT(-40.f, steer.getSetpoint());
+
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,C,-10"), cmd));
+    steer.update(0.1f);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_COURSE, steer.getMode());
+    TEST_ASSERT_EQUAL_FLOAT(350.f, steer.getSetpoint());
+
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,O,"), cmd));
+    steer.update(0.1f);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::OFF, steer.getMode());
+    TEST_ASSERT_EQUAL_UINT32(4, ap.commands());
+}
+
+void test_empty_setpoint_engages_on_the_heading() {
+    AutoSteeringController steer;
+    NmeaAutopilot ap(steer);
+    SteeringCommand cmd;
+    ap.update(0, telemetry(AutoSteeringMode::OFF, 0.f));
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,H"), cmd));
+    TEST_ASSERT_EQUAL_FLOAT(181.5f, cmd.param);
+
+    // heading already held: keep its setpoint
+    ap.update(100, telemetry(AutoSteeringMode::TRACK_HEADING, 190.f));
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,H,"), cmd));
+    TEST_ASSERT_EQUAL_FLOAT(190.f, cmd.param);
+
+    // and wind mode on the wind angle sailed
+    AutopilotTelemetry t = telemetry(AutoSteeringMode::TRACK_HEADING, 190.f);
+    t.windAngle = -52.f;
+    ap.update(200, t);
+    TEST_ASSERT_TRUE(ap.handle(command("PXAPC,W"), cmd));
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_WIND_ANGLE, cmd.mode);
+    TEST_ASSERT_EQUAL_FLOAT(-52.f, cmd.param);
+}
+
+void test_bad_commands_are_rejected() {
+    AutoSteeringController steer;
+    NmeaAutopilot ap(steer);
+    SteeringCommand cmd;
+    ap.update(0, telemetry(AutoSteeringMode::OFF, 0.f));
+    // no course or wind angle to engage on
+    TEST_ASSERT_FALSE(ap.handle(command("PXAPC,C,"), cmd));
+    TEST_ASSERT_FALSE(ap.handle(command("PXAPC,W,"), cmd));
+    TEST_ASSERT_FALSE(ap.handle(command("PXAPC,W,200"), cmd));
+    // nor a heading without a heading source
+    AutopilotTelemetry t = telemetry(AutoSteeringMode::OFF, 0.f);
+    t.heading = NAN;
+    ap.update(100, t);
+    TEST_ASSERT_FALSE(ap.handle(command("PXAPC,H"), cmd));
+    // not a command at all
+    TEST_ASSERT_FALSE(ap.handle(command("HCHDG,98.3,,,,"), cmd));
+    TEST_ASSERT_EQUAL_UINT32(4, ap.rejected());
+    TEST_ASSERT_EQUAL_UINT32(0, ap.commands());
+    steer.update(0.1f);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::OFF, steer.getMode());
+
+    // unknown mode letters do not even parse
+    NmeaParser p;
+    const char* text = sentence("PXAPC,X,10");
+    p.feed(text, std::strlen(text));
+    TEST_ASSERT_EQUAL_UINT32(1, p.malformed());
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_writer_numbers);
+    RUN_TEST(test_writer_never_overflows);
+    RUN_TEST(test_sentences_parse_back);
+    RUN_TEST(test_sentences_go_out_at_their_rates);
+    RUN_TEST(test_remote_commands_set_the_mode);
+    RUN_TEST(test_empty_setpoint_engages_on_the_heading);
+    RUN_TEST(test_bad_commands_are_rejected);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_writer_numbers);
+    RUN_TEST(test_writer_never_overflows);
+    RUN_TEST(test_sentences_parse_back);
+    RUN_TEST(test_sentences_go_out_at_their_rates);
+    RUN_TEST(test_remote_commands_set_the_mode);
+    RUN_TEST(test_empty_setpoint_engages_on_the_heading);
+    RUN_TEST(test_bad_commands_are_rejected);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,295 @@
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include "NmeaInput.h"
+
+// One second of a multiplexer's output, captured off the boat's network:
+// six decoded sentences, satellites and a proprietary one
+static const char CAPTURE[] =
+    "$GPRMC,120000.00,A,5425.120,N,01013.450,E,6.2,184.5,150626,2.8,E*5C\r\n"
+    "$GPVTG,184.5,T,181.7,M,6.2,N,11.5,K,A*15\r\n"
+    "$GPGSV,3,1,10,02,41,287,44,05,17,045,38,12,64,112,47,13,09,321,32*73\r\n"
+    "$HCHDG,179.4,,,2.8,E*28\r\n"
+    "$WIMWV,38.5,R,14.2,N,A*2A\r\n"
+    "$VWVHW,,T,179.4,M,5.9,N,10.9,K*45\r\n"
+    "$GPXTE,A,A,0.03,R,N*73\r\n"
+    "$PSMDST,C,1,2*61\r\n";
+static const int DECODED_PER_SECOND = 6;
+static const int IGNORED_PER_SECOND = 2;
+
+/**
+ * Loopback socket: replays a capture, repeated, at speedup times its
+ * real rate in the test's virtual time. As UDP every sentence is a
+ * datagram; as TCP the stream comes out in segments of any size, so
+ * sentences are split anywhere.
+ */
+class LoopbackSource : public IPacketSource {
+public:
+    LoopbackSource(const std::string& capture, bool datagrams, unsigned speedup)
+    : _capture(capture), _datagrams(datagrams), _speedup(speedup) {}
+
+    // Let ms of virtual time pass
+    void advance(std::uint32_t ms) { _elapsedMs += ms; }
+
+    std::size_t receive(char* out, std::size_t len) override {
+        std::size_t released = (std::size_t)(_capture.size() * _speedup * _elapsedMs / 1000);
+        std::size_t avail = released - _sent;
+        std::size_t n;
+        if(_datagrams) {
+            // the rest of the datagram being read, or the next whole one
+            std::size_t end = _capture.find('\n', _sent % _capture.size()) + 1;
+            n = end - _sent % _capture.size();
+            if(n > avail) return 0;
+        } else {
+            n = 1 + (_lcg = _lcg * 1103515245u + 12345u) % 97;
+            if(n > avail) n = avail;
+        }
+        if(n > len) n = len;
+        for(std::size_t i=0; i<n; i++) {
+            out[i] = _capture[(_sent + i) % _capture.size()];
+        }
+        _sent += n;
+        return n;
+    }
+
+    std::size_t sent() const { return _sent; }
+
+private:
+    std::string  _capture;
+    bool         _datagrams;
+    std::uint64_t _speedup;
+    std::uint64_t _elapsedMs = 0;
+    std::size_t  _sent = 0;
+    std::uint32_t _lcg = 1;
+};
+
+// What the handler saw, by source
+static int received[NmeaInput::MAX_SOURCES];
+static int hdgReceived[NmeaInput::MAX_SOURCES];
+
+static void onSentence(std::size_t source, const NmeaSentence& s, void*) {
+    received[source]++;
+    if(s.type == NmeaType::HDG) {
+        TEST_ASSERT_EQUAL_FLOAT(179.4f, s.hdg.heading);
+        hdgReceived[source]++;
+    }
+}
+
+// The network task every 20 ms, the parser task every 50 ms, as in main.cpp
+static void run(NmeaInput& in, LoopbackSource** srcs, int count, std::uint32_t ms, std::uint32_t& now) {
+    for(std::uint32_t end = now + ms; now < end; ) {
+        now += 10;
+        for(int i=0; i<count; i++) srcs[i]->advance(10);
+        if(now % 20 == 0) in.poll();
+        if(now % 50 == 0) in.service(now);
+    }
+}
+
+void setUp() {
+    std::memset(received, 0, sizeof(received));
+    std::memset(hdgReceived, 0, sizeof(hdgReceived));
+}
+void tearDown() {}
+
+void test_udp_replay_decodes_every_sentence() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    LoopbackSource udp(CAPTURE, true, 20);
+    LoopbackSource* srcs[] = { &udp };
+    TEST_ASSERT_EQUAL(0, in.addSource(&udp, "udp"));
+    TEST_ASSERT_EQUAL_STRING("udp", in.sourceName(0));
+
+    // a minute of capture in 3 s
+    std::uint32_t now = 0;
+    run(in, srcs, 1, 3000, now);
+    NmeaSourceStats st = in.stats(0);
+    TEST_ASSERT_EQUAL(60 * DECODED_PER_SECOND, received[0]);
+    TEST_ASSERT_EQUAL(60, hdgReceived[0]);
+    TEST_ASSERT_EQUAL_UINT32(60 * DECODED_PER_SECOND, st.sentences);
+    TEST_ASSERT_EQUAL_UINT32(60 * IGNORED_PER_SECOND, st.ignored);
+    TEST_ASSERT_EQUAL_UINT32(60 * (sizeof(CAPTURE) - 1), st.bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, st.checksumErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, st.malformed);
+    TEST_ASSERT_FLOAT_WITHIN(3.f, 20.f * DECODED_PER_SECOND, st.rate);
+}
+
+void test_tcp_stream_split_anywhere() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    LoopbackSource tcp(CAPTURE, false, 20);
+    LoopbackSource* srcs[] = { &tcp };
+    in.addSource(&tcp, "tcp");
+
+    std::uint32_t now = 0;
+    run(in, srcs, 1, 3000, now);
+    NmeaSourceStats st = in.stats(0);
+    TEST_ASSERT_EQUAL(60 * DECODED_PER_SECOND, received[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, st.checksumErrors + st.malformed + st.dropped);
+}
+
+void test_sources_are_parsed_separately() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    // both split mid sentence, chunks of the two interleave in the ring
+    LoopbackSource a(CAPTURE, false, 10);
+    LoopbackSource b(CAPTURE, false, 30);
+    LoopbackSource* srcs[] = { &a, &b };
+    TEST_ASSERT_EQUAL(0, in.addSource(&a, "a"));
+    TEST_ASSERT_EQUAL(1, in.addSource(&b, "b"));
+
+    std::uint32_t now = 0;
+    run(in, srcs, 2, 4000, now);
+    TEST_ASSERT_EQUAL(40 * DECODED_PER_SECOND, received[0]);
+    TEST_ASSERT_EQUAL(120 * DECODED_PER_SECOND, received[1]);
+    for(std::size_t i=0; i<2; i++) {
+        NmeaSourceStats st = in.stats(i);
+        TEST_ASSERT_EQUAL_UINT32(0, st.checksumErrors + st.malformed + st.dropped);
+    }
+    TEST_ASSERT_TRUE(in.stats(1).rate > 2.5f * in.stats(0).rate);
+}
+
+void test_sources_are_limited() {
+    NmeaInput in;
+    for(std::size_t i=0; i<NmeaInput::MAX_SOURCES; i++) {
+        TEST_ASSERT_EQUAL((int)i, in.addSource(nullptr, "push"));
+    }
+    TEST_ASSERT_EQUAL(-1, in.addSource(nullptr, "one too many"));
+    TEST_ASSERT_FALSE(in.push(NmeaInput::MAX_SOURCES, CAPTURE, 10));
+}
+
+void test_full_ring_drops_and_recovers() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    LoopbackSource tcp(CAPTURE, false, 20);
+    in.addSource(&tcp, "tcp");
+
+    // the parser task stalls for 10 s: the network task keeps reading
+    tcp.advance(10000);
+    for(int i=0; i<200; i++) in.poll();
+    NmeaSourceStats st = in.stats(0);
+    TEST_ASSERT_EQUAL_UINT32(tcp.sent(), st.bytes);
+    TEST_ASSERT_TRUE(st.dropped > 0);
+    TEST_ASSERT_TRUE(st.bytes - st.dropped <= NmeaInput::RING_SIZE * NmeaInput::CHUNK_SIZE);
+
+    // what made it into the ring decodes, then the live stream again;
+    // nothing on either side of the gap is glued into a sentence
+    in.service(0);
+    int beforeGap = received[0];
+    TEST_ASSERT_TRUE(beforeGap > 0);
+    LoopbackSource* srcs[] = { &tcp };
+    std::uint32_t now = 0;
+    run(in, srcs, 1, 1000, now);
+    st = in.stats(0);
+    TEST_ASSERT_TRUE(received[0] - beforeGap >= 20 * DECODED_PER_SECOND - 1);
+    TEST_ASSERT_EQUAL_UINT32(0, st.checksumErrors);
+    TEST_ASSERT_TRUE(st.malformed <= 1);
+}
+
+void test_a_gap_is_not_glued_over() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    in.addSource(nullptr, "cb");
+    in.addSource(nullptr, "filler");
+    // ",," XORs to 0: without it the sentence still has a valid checksum
+    const char* head = "$HCHDG,179.4,";
+    const char* tail = "2.8,E*28\r\n";
+    TEST_ASSERT_TRUE(in.push(0, head, std::strlen(head)));
+    while(in.push(1, "x", 1)) {}
+    TEST_ASSERT_FALSE(in.push(0, ",,", 2));
+    in.service(0);
+    TEST_ASSERT_TRUE(in.push(0, tail, std::strlen(tail)));
+    in.service(0);
+    NmeaSourceStats st = in.stats(0);
+    TEST_ASSERT_EQUAL(0, received[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, st.checksumErrors + st.malformed);
+
+    TEST_ASSERT_TRUE(in.push(0, CAPTURE, sizeof(CAPTURE) - 1));
+    in.service(0);
+    TEST_ASSERT_EQUAL(DECODED_PER_SECOND, received[0]);
+}
+
+void test_checksum_errors_are_counted_per_source() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    // one bit flipped in the heading of the second source's HDG
+    std::string corrupt(CAPTURE);
+    corrupt[corrupt.find("179.4,,,")] = '0';
+    LoopbackSource good(CAPTURE, true, 10);
+    LoopbackSource bad(corrupt, true, 10);
+    LoopbackSource* srcs[] = { &good, &bad };
+    in.addSource(&good, "good");
+    in.addSource(&bad, "bad");
+
+    std::uint32_t now = 0;
+    run(in, srcs, 2, 2000, now);
+    TEST_ASSERT_EQUAL_UINT32(0, in.stats(0).checksumErrors);
+    TEST_ASSERT_EQUAL_UINT32(20, in.stats(1).checksumErrors);
+    TEST_ASSERT_EQUAL(20, hdgReceived[0]);
+    TEST_ASSERT_EQUAL(0, hdgReceived[1]);
+    TEST_ASSERT_EQUAL(20 * (DECODED_PER_SECOND - 1), received[1]);
+}
+
+void test_pushed_bytes_are_chunked() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    in.addSource(nullptr, "cb");
+    std::string burst;
+    for(int i=0; i<5; i++) burst += CAPTURE;
+    TEST_ASSERT_TRUE(burst.size() > 4 * NmeaInput::CHUNK_SIZE);
+    TEST_ASSERT_TRUE(in.push(0, burst.data(), burst.size()));
+    in.service(0);
+    TEST_ASSERT_EQUAL(5 * DECODED_PER_SECOND, received[0]);
+    TEST_ASSERT_EQUAL_UINT32(burst.size(), in.stats(0).bytes);
+}
+
+void test_an_hour_at_60x_keeps_up() {
+    NmeaInput in;
+    in.setHandler(onSentence, nullptr);
+    LoopbackSource udp(CAPTURE, true, 60);
+    LoopbackSource tcp(CAPTURE, false, 60);
+    LoopbackSource* srcs[] = { &udp, &tcp };
+    in.addSource(&udp, "udp");
+    in.addSource(&tcp, "tcp");
+
+    std::uint32_t now = 0;
+    run(in, srcs, 2, 60000, now);
+    for(std::size_t i=0; i<2; i++) {
+        NmeaSourceStats st = in.stats(i);
+        TEST_ASSERT_EQUAL(3600 * DECODED_PER_SECOND, received[i]);
+        TEST_ASSERT_EQUAL_UINT32(0, st.dropped + st.checksumErrors + st.malformed);
+        TEST_ASSERT_FLOAT_WITHIN(6.f, 60.f * DECODED_PER_SECOND, st.rate);
+    }
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_udp_replay_decodes_every_sentence);
+    RUN_TEST(test_tcp_stream_split_anywhere);
+    RUN_TEST(test_sources_are_parsed_separately);
+    RUN_TEST(test_sources_are_limited);
+    RUN_TEST(test_full_ring_drops_and_recovers);
+    RUN_TEST(test_a_gap_is_not_glued_over);
+    RUN_TEST(test_checksum_errors_are_counted_per_source);
+    RUN_TEST(test_pushed_bytes_are_chunked);
+    RUN_TEST(test_an_hour_at_60x_keeps_up);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_udp_replay_decodes_every_sentence);
+    RUN_TEST(test_tcp_stream_split_anywhere);
+    RUN_TEST(test_sources_are_parsed_separately);
+    RUN_TEST(test_sources_are_limited);
+    RUN_TEST(test_full_ring_drops_and_recovers);
+    RUN_TEST(test_a_gap_is_not_glued_over);
+    RUN_TEST(test_checksum_errors_are_counted_per_source);
+    RUN_TEST(test_pushed_bytes_are_chunked);
+    RUN_TEST(test_an_hour_at_60x_keeps_up);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,217 @@
+#include <unity.h>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "NmeaParser.h"
+
+// What the handler saw
+static NmeaSentence last;
+static int received;
+
+static void onSentence(const NmeaSentence& s, void*) {
+    last = s;
+    received++;
+}
+
+// "$<body>*hh\r\n" with the right checksum
+static const char* sentence(const char* body) {
+    static char buf[128];
+    unsigned sum = 0;
+    for(const char* p = body; *p; p++) sum ^= (unsigned char)*p;
+    std::snprintf(buf, sizeof(buf), "$%s*%02X\r\n", body, sum);
+    return buf;
+}
+
+static void feed(NmeaParser& p, const char* text) {
+    p.feed(text, std::strlen(text));
+}
+
+void setUp() {
+    received = 0;
+    std::memset(&last, 0, sizeof(last));
+}
+void tearDown() {}
+
+void test_rmc() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, sentence("GPRMC,123519.50,A,4807.038,N,01131.000,W,022.4,084.4,230394,003.1,W"));
+    TEST_ASSERT_EQUAL(1, received);
+    TEST_ASSERT_EQUAL((int)NmeaType::RMC, (int)last.type);
+    TEST_ASSERT_EQUAL_STRING("GP", last.talker);
+    TEST_ASSERT_EQUAL_UINT32((12 * 3600 + 35 * 60 + 19) * 1000 + 500, last.rmc.timeMs);
+    TEST_ASSERT_TRUE(last.rmc.valid);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 48.1173, last.rmc.latitude);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, -11.516666667, last.rmc.longitude);
+    TEST_ASSERT_EQUAL_FLOAT(22.4f, last.rmc.sog);
+    TEST_ASSERT_EQUAL_FLOAT(84.4f, last.rmc.cog);
+    TEST_ASSERT_EQUAL_FLOAT(-3.1f, last.rmc.variation);
+    TEST_ASSERT_EQUAL(23, last.rmc.day);
+    TEST_ASSERT_EQUAL(3, last.rmc.month);
+    TEST_ASSERT_EQUAL(1994, last.rmc.year);
+}
+
+void test_rmc_without_fix_has_empty_fields() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, sentence("GPRMC,,V,,,,,,,,,,N"));
+    TEST_ASSERT_EQUAL(1, received);
+    TEST_ASSERT_FALSE(last.rmc.valid);
+    TEST_ASSERT_TRUE(std::isnan(last.rmc.latitude));
+    TEST_ASSERT_TRUE(std::isnan(last.rmc.sog));
+    TEST_ASSERT_TRUE(std::isnan(last.rmc.cog));
+    TEST_ASSERT_EQUAL(0, last.rmc.year);
+}
+
+void test_vtg_hdg_vhw() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, sentence("GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A"));
+    TEST_ASSERT_EQUAL((int)NmeaType::VTG, (int)last.type);
+    TEST_ASSERT_EQUAL_FLOAT(54.7f, last.vtg.cogTrue);
+    TEST_ASSERT_EQUAL_FLOAT(34.4f, last.vtg.cogMagnetic);
+    TEST_ASSERT_EQUAL_FLOAT(5.5f, last.vtg.sog);
+
+    // SOG only in km/h
+    feed(p, sentence("GPVTG,054.7,T,,M,,N,18.52,K"));
+    TEST_ASSERT_TRUE(std::isnan(last.vtg.cogMagnetic));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 10.f, last.vtg.sog);
+
+    feed(p, sentence("HCHDG,98.3,0.5,E,2.1,W"));
+    TEST_ASSERT_EQUAL((int)NmeaType::HDG, (int)last.type);
+    TEST_ASSERT_EQUAL_STRING("HC", last.talker);
+    TEST_ASSERT_EQUAL_FLOAT(98.3f, last.hdg.heading);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, last.hdg.deviation);
+    TEST_ASSERT_EQUAL_FLOAT(-2.1f, last.hdg.variation);
+
+    feed(p, sentence("VWVHW,,T,245.1,M,6.12,N,11.33,K"));
+    TEST_ASSERT_EQUAL((int)NmeaType::VHW, (int)last.type);
+    TEST_ASSERT_TRUE(std::isnan(last.vhw.headingTrue));
+    TEST_ASSERT_EQUAL_FLOAT(245.1f, last.vhw.headingMagnetic);
+    TEST_ASSERT_EQUAL_FLOAT(6.12f, last.vhw.speed);
+    TEST_ASSERT_EQUAL(4, received);
+}
+
+void test_mwv_converts_to_knots() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, sentence("WIMWV,214.8,R,10.0,M,A"));
+    TEST_ASSERT_EQUAL((int)NmeaType::MWV, (int)last.type);
+    TEST_ASSERT_EQUAL_FLOAT(214.8f, last.mwv.angle);
+    TEST_ASSERT_TRUE(last.mwv.relative);
+    TEST_ASSERT_TRUE(last.mwv.valid);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 19.438f, last.mwv.speed);
+
+    feed(p, sentence("WIMWV,45,T,12.5,N,V"));
+    TEST_ASSERT_FALSE(last.mwv.relative);
+    TEST_ASSERT_FALSE(last.mwv.valid);
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, last.mwv.speed);
+}
+
+void test_xte_sign_is_steer_direction() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, sentence("GPXTE,A,A,0.67,L,N"));
+    TEST_ASSERT_EQUAL((int)NmeaType::XTE, (int)last.type);
+    TEST_ASSERT_TRUE(last.xte.valid);
+    TEST_ASSERT_EQUAL_FLOAT(-0.67f, last.xte.error);
+    feed(p, sentence("GPXTE,A,A,0.10,R,N,D"));
+    TEST_ASSERT_EQUAL_FLOAT(0.10f, last.xte.error);
+    feed(p, sentence("GPXTE,V,A,,,N,N"));
+    TEST_ASSERT_FALSE(last.xte.valid);
+}
+
+void test_bad_checksum_is_dropped() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, "$HCHDG,98.3,0.5,E,2.1,W*00\r\n");
+    feed(p, "$HCHDG,98.3,0.5,E,2.1,W\r\n");    // no checksum at all
+    TEST_ASSERT_EQUAL(0, received);
+    TEST_ASSERT_EQUAL_UINT32(1, p.checksumErrors());
+    TEST_ASSERT_EQUAL_UINT32(1, p.malformed());
+    // lower case hex is fine
+    char lower[64];
+    std::strcpy(lower, sentence("HCHDG,98.3,0.5,E,2.1,W"));
+    for(char* c = std::strchr(lower, '*'); *c; c++) *c = (char)std::tolower(*c);
+    feed(p, lower);
+    TEST_ASSERT_EQUAL(1, received);
+}
+
+void test_sentences_split_across_chunks() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    char stream[256];
+    std::strcpy(stream, sentence("WIMWV,214.8,R,10.0,N,A"));
+    std::strcat(stream, sentence("GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A"));
+    std::size_t len = std::strlen(stream);
+    // one byte at a time, then in odd sized pieces
+    for(std::size_t i=0; i<len; i++) p.feed(stream + i, 1);
+    TEST_ASSERT_EQUAL(2, received);
+    for(std::size_t i=0; i<len; i+=7) p.feed(stream + i, (len - i < 7) ? len - i : 7);
+    TEST_ASSERT_EQUAL(4, received);
+    TEST_ASSERT_EQUAL((int)NmeaType::VTG, (int)last.type);
+    TEST_ASSERT_EQUAL_FLOAT(5.5f, last.vtg.sog);
+}
+
+void test_resyncs_on_garbage() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    // a torn sentence, line noise, an overlong line, then good data
+    feed(p, "$GPRMC,1235");
+    feed(p, "\x01\xFF garbage\r\n");
+    char longLine[200] = "$GPGSV";
+    for(int i=0; i<40; i++) std::strcat(longLine, ",12");
+    std::strcat(longLine, "*00\r\n");
+    feed(p, longLine);
+    feed(p, "$GPVTG,054.7,T");
+    feed(p, sentence("HCHDG,98.3,,,,"));
+    TEST_ASSERT_EQUAL(1, received);
+    TEST_ASSERT_EQUAL_FLOAT(98.3f, last.hdg.heading);
+    TEST_ASSERT_TRUE(std::isnan(last.hdg.deviation));
+    TEST_ASSERT_EQUAL_UINT32(3, p.malformed());
+}
+
+void test_unsupported_and_malformed_sentences_are_counted() {
+    NmeaParser p;
+    p.setHandler(onSentence, nullptr);
+    feed(p, sentence("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1"));
+    feed(p, sentence("PSMDST,C,1,2"));
+    feed(p, sentence("HCHDG,98.3"));              // too few fields
+    feed(p, sentence("HCHDG,9x.3,0.5,E,2.1,W"));  // not a number
+    TEST_ASSERT_EQUAL(0, received);
+    TEST_ASSERT_EQUAL_UINT32(2, p.ignored());
+    TEST_ASSERT_EQUAL_UINT32(2, p.malformed());
+    TEST_ASSERT_EQUAL_UINT32(0, p.decoded());
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rmc);
+    RUN_TEST(test_rmc_without_fix_has_empty_fields);
+    RUN_TEST(test_vtg_hdg_vhw);
+    RUN_TEST(test_mwv_converts_to_knots);
+    RUN_TEST(test_xte_sign_is_steer_direction);
+    RUN_TEST(test_bad_checksum_is_dropped);
+    RUN_TEST(test_sentences_split_across_chunks);
+    RUN_TEST(test_resyncs_on_garbage);
+    RUN_TEST(test_unsupported_and_malformed_sentences_are_counted);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rmc);
+    RUN_TEST(test_rmc_without_fix_has_empty_fields);
+    RUN_TEST(test_vtg_hdg_vhw);
+    RUN_TEST(test_mwv_converts_to_knots);
+    RUN_TEST(test_xte_sign_is_steer_direction);
+    RUN_TEST(test_bad_checksum_is_dropped);
+    RUN_TEST(test_sentences_split_across_chunks);
+    RUN_TEST(test_resyncs_on_garbage);
+    RUN_TEST(test_unsupported_and_malformed_sentences_are_counted);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,93 @@
+#include <unity.h>
+#include <cstdio>
+#include "PassageSim.h"
+
+static PassageSim sim;
+
+void setUp() {}
+void tearDown() {}
+
+static PassageConfig shortPassage(uint32_t seed) {
+    PassageConfig cfg;
+    cfg.duration = 120.f;
+    cfg.seed = seed;
+    return cfg;
+}
+
+void test_same_seed_same_result() {
+    GainSet g = { 0.f, 2.f, 0.02f, 1.f, 2.f, 0.f, 0.f };
+    PassageMetrics a = sim.run(shortPassage(7), g);
+    PassageMetrics b = sim.run(shortPassage(7), g);
+    TEST_ASSERT_EQUAL_FLOAT(a.rmsHeadingError, b.rmsHeadingError);
+    TEST_ASSERT_EQUAL_FLOAT(a.energyWh, b.energyWh);
+    TEST_ASSERT_EQUAL(a.motorStarts, b.motorStarts);
+}
+
+void test_controller_holds_course() {
+    GainSet g = { 0.f, 2.f, 0.02f, 1.f, 2.f, 0.f, 0.f };
+    PassageMetrics m = sim.run(shortPassage(3), g);
+    TEST_ASSERT_TRUE(m.rmsHeadingError < 3.f);
+    TEST_ASSERT_TRUE(m.energyWh > 0.f);
+}
+
+void test_sea_state_grows_with_waves() {
+    GainSet g = { 0.f, 2.f, 0.02f, 1.f, 2.f, 0.f, 0.f };
+    PassageConfig calm  = shortPassage(5);
+    PassageConfig rough = shortPassage(5);
+    calm.waveDisturbance  = 1.f;
+    rough.waveDisturbance = 9.f;
+    TEST_ASSERT_TRUE(sim.run(rough, g).yawRateStd > sim.run(calm, g).yawRateStd);
+}
+
+void test_benchmark_economy_mode() {
+    GainSet g = { 0.f, 2.f, 0.02f, 0.f, 2.f, 0.f, 0.f };
+    const float waves[] = { 1.5f, 4.f, 9.f };
+    for(float w : waves) {
+        PassageConfig cfg = shortPassage(11);
+        cfg.duration = 600.f;
+        cfg.waveDisturbance = w;
+        cfg.economy = false;
+        PassageMetrics normal = sim.run(cfg, g);
+        cfg.economy = true;
+        PassageMetrics eco = sim.run(cfg, g);
+
+        float minutes = cfg.duration / 60.f;
+        char msg[160];
+        std::snprintf(msg, sizeof(msg),
+            "waves %.1f: rms %.2f -> %.2f deg, starts %.0f -> %.0f /min, "
+            "reversals %.0f -> %.0f /min, on-time %.0f -> %.0f s, %.2f -> %.2f Wh",
+            w, normal.rmsHeadingError, eco.rmsHeadingError,
+            normal.motorStarts / minutes, eco.motorStarts / minutes,
+            normal.reversals / minutes, eco.reversals / minutes,
+            normal.motorOnTime, eco.motorOnTime, normal.energyWh, eco.energyWh);
+        TEST_MESSAGE(msg);
+
+        TEST_ASSERT_TRUE(eco.motorStarts * 5 < normal.motorStarts);
+        TEST_ASSERT_TRUE(eco.reversals * 10 < normal.reversals);
+        TEST_ASSERT_TRUE(eco.motorOnTime < normal.motorOnTime);
+        // larger moves at full power cost about the same energy
+        TEST_ASSERT_TRUE(eco.energyWh < normal.energyWh * 1.05f);
+        TEST_ASSERT_TRUE(eco.rmsHeadingError < normal.rmsHeadingError + 1.5f);
+    }
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_result);
+    RUN_TEST(test_controller_holds_course);
+    RUN_TEST(test_sea_state_grows_with_waves);
+    RUN_TEST(test_benchmark_economy_mode);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_result);
+    RUN_TEST(test_controller_holds_course);
+    RUN_TEST(test_sea_state_grows_with_waves);
+    RUN_TEST(test_benchmark_economy_mode);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,198 @@
+#define ENABLE_PROFILING
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+#include "Profiler.h"
+#include "AutoSteeringController.h"
+#include "RudderServo.h"
+
+void setUp() {
+    Profiler::resetAll();
+}
+void tearDown() {}
+
+void test_bucket_is_log2() {
+    TEST_ASSERT_EQUAL(0, ProfileSite::bucketOf(0));
+    TEST_ASSERT_EQUAL(0, ProfileSite::bucketOf(1));
+    TEST_ASSERT_EQUAL(1, ProfileSite::bucketOf(2));
+    TEST_ASSERT_EQUAL(1, ProfileSite::bucketOf(3));
+    TEST_ASSERT_EQUAL(10, ProfileSite::bucketOf(1024));
+    TEST_ASSERT_EQUAL(10, ProfileSite::bucketOf(2047));
+    TEST_ASSERT_EQUAL(31, ProfileSite::bucketOf(UINT32_MAX));
+}
+
+void test_site_statistics() {
+    static ProfileSite site("stats");
+    site.record(100);
+    site.record(300);
+    site.record(200);
+    TEST_ASSERT_EQUAL(3, (int)site.count());
+    TEST_ASSERT_EQUAL(100, (int)site.min());
+    TEST_ASSERT_EQUAL(300, (int)site.max());
+    TEST_ASSERT_EQUAL_FLOAT(200.f, site.mean());
+    TEST_ASSERT_EQUAL(1, (int)site.bucket(6));   // 100
+    TEST_ASSERT_EQUAL(1, (int)site.bucket(7));   // 200
+    TEST_ASSERT_EQUAL(1, (int)site.bucket(8));   // 300
+
+    site.reset();
+    TEST_ASSERT_EQUAL(0, (int)site.count());
+    TEST_ASSERT_EQUAL(0, (int)site.min());
+}
+
+static void timedWork() {
+    PROFILE_SCOPE("timed.work");
+    volatile float x = 0.f;
+    for(int i=0; i<1000; i++) x += 1.f;
+}
+
+void test_scope_registers_once_and_records() {
+    for(int i=0; i<5; i++) timedWork();
+    ProfileSite* s = Profiler::find("timed.work");
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL(5, (int)s->count());
+    TEST_ASSERT_TRUE(s->max() >= s->min());
+    TEST_ASSERT_TRUE(s->min() > 0);
+
+    size_t sites = Profiler::siteCount();
+    timedWork();
+    TEST_ASSERT_EQUAL(sites, Profiler::siteCount());
+}
+
+struct Lines {
+    int  count;
+    char last[256];
+};
+
+static void collect(const char* line, void* ctx) {
+    Lines* l = static_cast<Lines*>(ctx);
+    l->count++;
+    std::strncpy(l->last, line, sizeof(l->last) - 1);
+    l->last[sizeof(l->last) - 1] = '\0';
+}
+
+void test_report_lists_every_site() {
+    static ProfileSite site("report.site");
+    site.record(1000);
+    Lines lines = { 0, "" };
+    Profiler::report(collect, &lines);
+    // header + one line per site
+    TEST_ASSERT_EQUAL((int)Profiler::siteCount() + 1, lines.count);
+
+    char buf[256];
+    TEST_ASSERT_TRUE(Profiler::formatSite(site, buf, sizeof(buf)));
+    TEST_ASSERT_NOT_NULL(std::strstr(buf, "report.site"));
+    TEST_ASSERT_NOT_NULL(std::strstr(buf, "2^9:1"));
+}
+
+void test_reset_all_clears_at_next_record() {
+    static ProfileSite site("reset.site");
+    site.record(100);
+    site.record(5000);
+    Profiler::resetAll();
+    // reads as empty before the recording task gets to it
+    TEST_ASSERT_EQUAL(0, (int)site.count());
+    TEST_ASSERT_EQUAL(0, (int)site.max());
+    TEST_ASSERT_EQUAL(0, (int)site.bucket(6));
+    char buf[256];
+    TEST_ASSERT_TRUE(Profiler::formatSite(site, buf, sizeof(buf)));
+    TEST_ASSERT_NULL(std::strstr(buf, "2^"));
+
+    site.record(300);
+    TEST_ASSERT_EQUAL(1, (int)site.count());
+    TEST_ASSERT_EQUAL(300, (int)site.min());
+    TEST_ASSERT_EQUAL(300, (int)site.max());
+    TEST_ASSERT_EQUAL(0, (int)site.bucket(6));
+    TEST_ASSERT_EQUAL(0, (int)site.bucket(12));
+    TEST_ASSERT_EQUAL(1, (int)site.bucket(8));
+}
+
+static void printLine(const char* line, void*) {
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark_control_updates() {
+    // Host equivalent of the on-target numbers: same sites, same report
+    AutoSteeringController steer;
+    RudderServo servo;
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    float heading = 80.f, rudder = 0.f;
+    for(int i=0; i<20000; i++) {
+        steer.setFeedback(heading);
+        {
+            PROFILE_SCOPE("bench.steer");
+            steer.update(0.1f);
+        }
+        servo.setTargetAngle(steer.getRudderAngle());
+        float cmd;
+        {
+            PROFILE_SCOPE("bench.servo");
+            cmd = servo.update(rudder, 0.001f);
+        }
+        rudder += cmd * 0.01f;
+        heading += 0.001f * rudder;
+    }
+    ProfileSite* s = Profiler::find("bench.steer");
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL(20000, (int)s->count());
+    Profiler::report(printLine, nullptr);
+}
+
+#ifndef ARDUINO
+#include <atomic>
+#include <thread>
+
+void test_reset_all_from_another_thread() {
+    // prof reset on the UI core while the servo core records
+    static ProfileSite site("reset.thread");
+    std::atomic<bool> done(false);
+    std::thread recorder([&]() {
+        for(int i=0; i<200000; i++) {
+            site.record(100);
+        }
+        done = true;
+    });
+    while(!done) {
+        Profiler::resetAll();
+        std::this_thread::yield();
+    }
+    recorder.join();
+    // the last generation was recorded whole
+    site.record(100);
+    std::uint32_t inHistogram = 0;
+    for(int k=0; k<ProfileSite::BUCKETS; k++) {
+        inHistogram += site.bucket(k);
+    }
+    TEST_ASSERT_TRUE(site.count() > 0);
+    TEST_ASSERT_EQUAL(site.count(), inHistogram);
+    TEST_ASSERT_EQUAL(site.count(), site.bucket(6));
+    TEST_ASSERT_EQUAL(100ull * site.count(), site.total());
+    TEST_ASSERT_EQUAL(100, (int)site.min());
+    TEST_ASSERT_EQUAL(100, (int)site.max());
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_is_log2);
+    RUN_TEST(test_site_statistics);
+    RUN_TEST(test_scope_registers_once_and_records);
+    RUN_TEST(test_report_lists_every_site);
+    RUN_TEST(test_reset_all_clears_at_next_record);
+    RUN_TEST(test_benchmark_control_updates);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_is_log2);
+    RUN_TEST(test_site_statistics);
+    RUN_TEST(test_scope_registers_once_and_records);
+    RUN_TEST(test_report_lists_every_site);
+    RUN_TEST(test_reset_all_clears_at_next_record);
+    RUN_TEST(test_benchmark_control_updates);
+    RUN_TEST(test_reset_all_from_another_thread);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,114 @@
+#include <unity.h>
+#include <cmath>
+#include "RudderAngleSensor.h"
+#include "RudderPlant.h"
+
+static RudderAngleSensor sensor;
+
+void setUp() {
+    sensor.reset();
+    sensor.linearizer().setLinear(-25.0f, 25.0f);
+}
+void tearDown() {}
+
+void test_default_table_matches_firmware_mapping() {
+    AdcLinearizer lin;
+    const int raws[] = { 0, 1, 1000, 2047, 3000, 4000, 4095 };
+    for(int raw : raws) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, -25.0f + raw / 4095.0f * 50.0f, lin.apply(float(raw)));
+    }
+}
+
+void test_table_interpolates_between_knots() {
+    AdcLinearizer lin(0.0f, 0.0f);
+    lin.setKnot(1, 10.0f);   // at 128 counts
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, lin.apply(64.0f));
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, lin.apply(128.0f));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, lin.apply(192.0f));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, lin.apply(256.0f));
+}
+
+void test_table_corrects_bowed_adc() {
+    // ADC reading = ideal + bow that is zero at both ends
+    AdcLinearizer lin;
+    for(int i=0; i<AdcLinearizer::KNOTS; i++) {
+        // knot at measured counts c -> the true value there
+        float c = AdcLinearizer::knotCounts(i);
+        float x = c / 4095.0f;
+        // invert measured = x + 0.03*sin(pi*x) with a few Newton steps
+        float t = x;
+        for(int k=0; k<5; k++) {
+            t -= (t + 0.03f * std::sin(3.1415927f * t) - x) / (1.0f + 0.03f * 3.1415927f * std::cos(3.1415927f * t));
+        }
+        lin.setKnot(i, -25.0f + 50.0f * t);
+    }
+    float worst = 0.0f;
+    for(float angle = -25.0f; angle <= 25.0f; angle += 0.5f) {
+        float x = (angle + 25.0f) / 50.0f;
+        float measured = (x + 0.03f * std::sin(3.1415927f * x)) * 4095.0f;
+        float err = std::fabs(lin.apply(measured) - angle);
+        if(err > worst) worst = err;
+    }
+    TEST_ASSERT_TRUE(worst < 0.05f);   // uncorrected: 1.5 deg
+}
+
+void test_no_angle_before_filter_is_primed() {
+    std::uint16_t raw[64];
+    for(auto& r : raw) r = 3000;
+    RudderAngleSample s;
+    sensor.addSamples(raw, 32 * (RudderAngleSensor::CIC_ORDER - 1));
+    TEST_ASSERT_FALSE(sensor.getSample(s));
+    sensor.addSamples(raw, 32);
+    TEST_ASSERT_TRUE(sensor.getSample(s));
+    TEST_ASSERT_EQUAL_FLOAT(3000.0f, s.counts);
+}
+
+void test_oversampling_beats_single_reads() {
+    // Noisy pot at 5 deg, sampled at 64 kHz; compare one raw read per
+    // servo cycle with the decimated value the servo would read
+    RudderPlantConfig cfg;
+    cfg.potNoise = 8.0f;
+    RudderPlant plant(cfg, 9);
+    plant.reset(5.0f);
+
+    double sqRaw = 0, sqDec = 0;
+    int n = 0;
+    std::uint16_t frame[64];
+    for(int ms=0; ms<2000; ms++) {
+        for(auto& r : frame) r = (std::uint16_t)plant.readPot();
+        sensor.addSamples(frame, 64);
+        if(ms < 2) continue;
+        float single = sensor.linearizer().apply(frame[0]) - 5.0f;
+        float dec = sensor.getAngle() - 5.0f;
+        sqRaw += single * single;
+        sqDec += dec * dec;
+        n++;
+    }
+    float rmsRaw = float(std::sqrt(sqRaw / n));
+    float rmsDec = float(std::sqrt(sqDec / n));
+    TEST_ASSERT_TRUE(rmsDec * 4 < rmsRaw);
+    TEST_ASSERT_TRUE(rmsDec < 0.05f);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_table_matches_firmware_mapping);
+    RUN_TEST(test_table_interpolates_between_knots);
+    RUN_TEST(test_table_corrects_bowed_adc);
+    RUN_TEST(test_no_angle_before_filter_is_primed);
+    RUN_TEST(test_oversampling_beats_single_reads);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_table_matches_firmware_mapping);
+    RUN_TEST(test_table_interpolates_between_knots);
+    RUN_TEST(test_table_corrects_bowed_adc);
+    RUN_TEST(test_no_angle_before_filter_is_primed);
+    RUN_TEST(test_oversampling_beats_single_reads);
+    return UNITY_END();
+}
+#endif
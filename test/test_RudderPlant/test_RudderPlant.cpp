@@ -0,0 +1,176 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "RudderPlant.h"
+#include "RudderServo.h"
+#include "Mailbox.h"
+#include "LoopJitter.h"
+
+static RudderPlantConfig quietConfig() {
+    RudderPlantConfig cfg;
+    cfg.potNoise = 0.f;
+    return cfg;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_command_reaches_rudder_rate() {
+    RudderPlant plant(quietConfig());
+    for(int i=0; i<1000; i++) plant.step(1.f, 0.001f);   // 10 motor time constants
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, plant.config().rudderRate, plant.getRate());
+    TEST_ASSERT_TRUE(plant.getAngle() > 6.f && plant.getAngle() < 8.f);
+}
+
+void test_hard_stop() {
+    RudderPlant plant(quietConfig());
+    for(int i=0; i<10000; i++) plant.step(-1.f, 0.001f);
+    TEST_ASSERT_EQUAL_FLOAT(-plant.config().rudderLimit, plant.getAngle());
+    TEST_ASSERT_EQUAL_FLOAT(0.f, plant.getRate());
+}
+
+void test_pot_matches_firmware_mapping() {
+    RudderPlant plant(quietConfig());
+    plant.reset(10.f);
+    int counts = plant.readPot();
+    // RudderPositionController: -25 + raw/4095*50
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 10.f, -25.f + counts / 4095.f * 50.f);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 10.f, plant.potToAngle(counts));
+}
+
+void test_backlash_delays_reversal() {
+    RudderPlantConfig cfg = quietConfig();
+    RudderPlant tight(cfg);
+    cfg.backlash = 1.f;
+    RudderPlant loose(cfg);
+    for(int i=0; i<500; i++) {
+        tight.step(1.f, 0.001f);
+        loose.step(1.f, 0.001f);
+    }
+    // Going forward the loose rudder trails by half the backlash...
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.5f, tight.getAngle() - loose.getAngle());
+    for(int i=0; i<1000; i++) {
+        tight.step(-1.f, 0.001f);
+        loose.step(-1.f, 0.001f);
+    }
+    // ...and after reversing it leads by half
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -0.5f, tight.getAngle() - loose.getAngle());
+}
+
+void test_current_peaks_when_stopped() {
+    RudderPlant plant(quietConfig());
+    plant.step(1.f, 0.001f);
+    float inrush = plant.getCurrent();
+    for(int i=0; i<1000; i++) plant.step(1.f, 0.001f);
+    float running = plant.getCurrent();
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, plant.config().stallCurrent, inrush);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, plant.config().runCurrent, running);
+
+    plant.setJammed(true);
+    plant.step(1.f, 0.001f);
+    TEST_ASSERT_EQUAL_FLOAT(plant.config().stallCurrent, plant.getCurrent());
+    float angle = plant.getAngle();
+    for(int i=0; i<100; i++) plant.step(-1.f, 0.001f);
+    TEST_ASSERT_EQUAL_FLOAT(angle, plant.getAngle());
+}
+
+struct StepResult {
+    float settleTime;   // last time outside +-0.5 deg [s]
+    float overshoot;    // [deg]
+    float finalError;   // [deg]
+};
+
+/**
+ * 10 degree step through the same path as the firmware: the target goes
+ * through a Mailbox written at the 10 Hz heading rate, the servo reads the
+ * pot and runs at the given period with random timing jitter.
+ */
+static StepResult stepResponse(float kp, unsigned periodUs, unsigned jitterUs, LoopJitterStats* statsOut) {
+    RudderPlantConfig cfg;
+    RudderPlant plant(cfg, 7);
+    SimRandom rng(3);
+    RudderServo servo;
+    servo.setGains(kp, 0.f, 0.f);
+    Mailbox<float> target(0.f);
+    LoopJitter jitter(periodUs);
+
+    StepResult r = { 0.f, 0.f, 0.f };
+    unsigned now = 0, lastStart = 0, nextHeading = 0;
+    const unsigned END = 5000000;   // 5 s
+    while(now < END) {
+        if(now >= nextHeading) {
+            target.write(10.f);
+            nextHeading += 100000;
+        }
+        // the timer wakes the task a little late now and then
+        unsigned start = now + unsigned(rng.uniform() * jitterUs);
+        jitter.cycleStart(start);
+        float t; target.read(t);
+        servo.setTargetAngle(t);
+        float cmd = servo.update(plant.potToAngle(plant.readPot()), (start - lastStart) * 1e-6f);
+        jitter.cycleEnd(start + 20);
+        lastStart = start;
+
+        plant.step(cmd, periodUs * 1e-6f);
+        now += periodUs;
+
+        float err = plant.getAngle() - 10.f;
+        if(err > r.overshoot) r.overshoot = err;
+        if(std::fabs(err) > 0.5f) r.settleTime = now * 1e-6f;
+        r.finalError = err;
+    }
+    if(statsOut) *statsOut = jitter.stats();
+    return r;
+}
+
+void test_1khz_loop_tracks_step() {
+    LoopJitterStats stats;
+    StepResult r = stepResponse(4.f, 1000, 100, &stats);
+    TEST_ASSERT_TRUE(r.settleTime < 3.f);
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 0.f, r.finalError);
+    TEST_ASSERT_TRUE(stats.maxJitter <= 100);
+    TEST_ASSERT_EQUAL(5000, (int)stats.cycles);
+}
+
+void test_benchmark_loop_rates() {
+    const unsigned periods[] = { 10000, 2000, 1000 };
+    const float gains[] = { 4.f, 60.f };
+    for(float kp : gains) for(unsigned p : periods) {
+        LoopJitterStats stats;
+        StepResult r = stepResponse(kp, p, p / 10, &stats);
+        char msg[128];
+        std::snprintf(msg, sizeof(msg),
+            "kP %2.0f %4u Hz: settle %.3f s, overshoot %.2f deg, final %.3f deg, jitter mean %.0f max %u us",
+            kp, 1000000u / p, r.settleTime, r.overshoot, r.finalError, stats.meanJitter,
+            (unsigned)stats.maxJitter);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_TRUE(r.settleTime < 3.f);
+    }
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_command_reaches_rudder_rate);
+    RUN_TEST(test_hard_stop);
+    RUN_TEST(test_pot_matches_firmware_mapping);
+    RUN_TEST(test_backlash_delays_reversal);
+    RUN_TEST(test_current_peaks_when_stopped);
+    RUN_TEST(test_1khz_loop_tracks_step);
+    RUN_TEST(test_benchmark_loop_rates);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_command_reaches_rudder_rate);
+    RUN_TEST(test_hard_stop);
+    RUN_TEST(test_pot_matches_firmware_mapping);
+    RUN_TEST(test_backlash_delays_reversal);
+    RUN_TEST(test_current_peaks_when_stopped);
+    RUN_TEST(test_1khz_loop_tracks_step);
+    RUN_TEST(test_benchmark_loop_rates);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,126 @@
+#include <unity.h>
+#include "RudderServo.h"
+
+static RudderServo servo;
+
+void setUp() {
+    servo.setGains(1.0f, 0.0f, 0.0f);
+    servo.setEconomyMode(false);
+    servo.setSeaState(0.0f);
+    servo.setTargetAngle(0.0f);
+    servo.reset();
+    servo.resetActivity();
+}
+
+void tearDown() {}
+
+void test_direction_follows_error() {
+    servo.setTargetAngle(10.0f);
+    TEST_ASSERT_TRUE(servo.update(0.0f, 0.01f) > 0.0f);
+    servo.setTargetAngle(-10.0f);
+    TEST_ASSERT_TRUE(servo.update(0.0f, 0.01f) < 0.0f);
+}
+
+void test_output_is_clamped() {
+    servo.setGains(10.0f, 0.0f, 0.0f);
+    servo.setTargetAngle(25.0f);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, servo.update(-25.0f, 0.01f));
+    servo.setTargetAngle(-25.0f);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, servo.update(25.0f, 0.01f));
+}
+
+void test_on_target_stops_motor() {
+    servo.setTargetAngle(5.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, servo.update(5.0f, 0.01f));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, servo.getOutput());
+}
+
+void test_closed_loop_reaches_target() {
+    // Ideal drive: rudder rate proportional to command
+    servo.setGains(4.0f, 0.0f, 0.0f);
+    servo.setTargetAngle(15.0f);
+    float angle = 0.0f;
+    for(int i=0; i<500; i++) {
+        angle += servo.update(angle, 0.01f) * 10.0f * 0.01f; // 10 deg/s full speed
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 15.0f, angle);
+}
+
+void test_economy_ignores_small_errors() {
+    servo.setGains(10.0f, 0.0f, 0.0f);
+    servo.setEconomyMode(true);
+    servo.setTargetAngle(0.5f);   // inside the 1 deg calm deadband
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, servo.update(0.0f, 0.01f));
+    servo.setTargetAngle(3.0f);
+    TEST_ASSERT_TRUE(servo.update(0.0f, 0.01f) > 0.0f);
+}
+
+void test_economy_deadband_follows_sea_state() {
+    servo.setEconomyMode(true);
+    float calm = servo.getDeadband();
+    servo.setSeaState(0.5f);
+    TEST_ASSERT_TRUE(servo.getDeadband() > calm);
+    servo.setSeaState(100.0f);
+    TEST_ASSERT_EQUAL_FLOAT(EconomyConfig().deadbandMax, servo.getDeadband());
+}
+
+void test_economy_pauses_before_reversing() {
+    servo.setGains(10.0f, 0.0f, 0.0f);
+    servo.setEconomyMode(true);
+    servo.setTargetAngle(10.0f);
+    for(int i=0; i<20; i++) servo.update(0.0f, 0.01f);
+    TEST_ASSERT_TRUE(servo.getOutput() > 0.0f);
+
+    servo.setTargetAngle(-10.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, servo.update(0.0f, 0.01f));
+    float t = 0.0f;
+    while(servo.update(0.0f, 0.01f) == 0.0f && t < 1.0f) t += 0.01f;
+    TEST_ASSERT_TRUE(t >= EconomyConfig().reverseDelay - 0.02f);
+    TEST_ASSERT_TRUE(servo.getOutput() < 0.0f);
+}
+
+void test_activity_counters() {
+    servo.setGains(10.0f, 0.0f, 0.0f);
+    servo.setTargetAngle(10.0f);
+    for(int i=0; i<100; i++) servo.update(0.0f, 0.01f);   // 1 s forward
+    servo.setTargetAngle(-10.0f);
+    for(int i=0; i<100; i++) servo.update(0.0f, 0.01f);   // 1 s reverse
+    servo.setTargetAngle(0.0f);
+    for(int i=0; i<100; i++) servo.update(0.0f, 0.01f);   // 1 s stopped
+
+    const ServoActivity& a = servo.getActivity();
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 3.0f, a.elapsed);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 2.0f, a.motorOnTime);
+    TEST_ASSERT_EQUAL(2, (int)a.motorStarts);
+    TEST_ASSERT_EQUAL(1, (int)a.reversals);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 20.0f, a.reversalsPerMinute());
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_direction_follows_error);
+    RUN_TEST(test_output_is_clamped);
+    RUN_TEST(test_on_target_stops_motor);
+    RUN_TEST(test_closed_loop_reaches_target);
+    RUN_TEST(test_economy_ignores_small_errors);
+    RUN_TEST(test_economy_deadband_follows_sea_state);
+    RUN_TEST(test_economy_pauses_before_reversing);
+    RUN_TEST(test_activity_counters);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_direction_follows_error);
+    RUN_TEST(test_output_is_clamped);
+    RUN_TEST(test_on_target_stops_motor);
+    RUN_TEST(test_closed_loop_reaches_target);
+    RUN_TEST(test_economy_ignores_small_errors);
+    RUN_TEST(test_economy_deadband_follows_sea_state);
+    RUN_TEST(test_economy_pauses_before_reversing);
+    RUN_TEST(test_activity_counters);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,110 @@
+#include <unity.h>
+#include "ScenarioSim.h"
+
+// The gains tools/montecarlo falls back on without --gains
+static GainTable defaultGains() {
+    GainTable table;
+    GainSet g = { 1000.f, 2.f, 0.02f, 1.f, 2.f, 0.f, 0.f };
+    table.add(g);
+    return table;
+}
+
+static ScenarioConfig moderateSea() {
+    ScenarioConfig cfg;
+    cfg.duration = 120.f;
+    cfg.vessel.waves.significantHeight = 1.f;
+    cfg.vessel.waves.direction = cfg.desiredHeading + 135.f;
+    cfg.vessel.wind.speed = 6.f;
+    cfg.vessel.wind.direction = cfg.vessel.waves.direction;
+    return cfg;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_same_config_same_metrics() {
+    ScenarioConfig cfg = moderateSea();
+    cfg.faults.imuDropout = 0.1f;
+    ScenarioSim sim;
+    ScenarioMetrics a = sim.run(cfg, defaultGains());
+    ScenarioMetrics b = sim.run(cfg, defaultGains());
+    TEST_ASSERT_EQUAL_FLOAT(a.rmsHeadingError, b.rmsHeadingError);
+    TEST_ASSERT_EQUAL_FLOAT(a.energyWh, b.energyWh);
+    TEST_ASSERT_EQUAL_UINT32(a.motorStarts, b.motorStarts);
+
+    cfg.vessel.seed = 2;
+    ScenarioMetrics c = sim.run(cfg, defaultGains());
+    TEST_ASSERT_TRUE(c.rmsHeadingError != a.rmsHeadingError);
+}
+
+void test_holds_course_without_faults() {
+    ScenarioSim sim;
+    ScenarioMetrics m = sim.run(moderateSea(), defaultGains());
+    TEST_ASSERT_FALSE(m.failed);
+    TEST_ASSERT_TRUE(m.rmsHeadingError < 2.f);
+    TEST_ASSERT_TRUE(m.maxHeadingError < 5.f);
+    TEST_ASSERT_EQUAL_UINT32(0, m.protectionTrips);
+    TEST_ASSERT_TRUE(m.energyWh > 0.f);
+    TEST_ASSERT_TRUE(m.seaState > 0.f);
+}
+
+void test_mag_disturbance_takes_it_off_course() {
+    // Heading north the sideways field shift shows fully as compass error
+    ScenarioConfig cfg = moderateSea();
+    cfg.desiredHeading = cfg.vessel.initialHeading = 0.f;
+    cfg.faults.magDisturbanceAt = 20.f;
+    cfg.faults.magDisturbance = 15.f;    // ~40 deg
+    ScenarioSim sim;
+    ScenarioMetrics m = sim.run(cfg, defaultGains());
+    TEST_ASSERT_TRUE(m.failed);
+    TEST_ASSERT_TRUE(m.failedAt > cfg.faults.magDisturbanceAt + ScenarioSim::FAIL_TIME);
+    TEST_ASSERT_TRUE(m.maxHeadingError > ScenarioSim::FAIL_ERROR);
+}
+
+void test_gain_table_turns_on_economy() {
+    // the default gains with "economy": true, as in /gains.json
+    GainTable eco;
+    GainSet g = { 1000.f, 2.f, 0.02f, 1.f, 2.f, 0.f, 0.f, true };
+    eco.add(g);
+    ScenarioSim sim;
+    ScenarioMetrics normal = sim.run(moderateSea(), defaultGains());
+    ScenarioMetrics saving = sim.run(moderateSea(), eco);
+    TEST_ASSERT_TRUE(saving.motorStarts < normal.motorStarts / 2);
+    TEST_ASSERT_FALSE(saving.failed);
+}
+
+void test_rudder_jam_trips_protection() {
+    // Jams halfway through a course change, with the rudder hard over
+    ScenarioConfig cfg = moderateSea();
+    cfg.desiredHeading = cfg.vessel.initialHeading + 60.f;
+    ScenarioSim sim;
+    ScenarioMetrics clean = sim.run(cfg, defaultGains());
+    cfg.faults.rudderJamAt = 3.f;
+    cfg.faults.rudderJamFor = 20.f;
+    ScenarioMetrics jammed = sim.run(cfg, defaultGains());
+    TEST_ASSERT_TRUE(jammed.protectionTrips > 0);
+    TEST_ASSERT_TRUE(jammed.rmsHeadingError > 2.f * clean.rmsHeadingError);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_config_same_metrics);
+    RUN_TEST(test_holds_course_without_faults);
+    RUN_TEST(test_mag_disturbance_takes_it_off_course);
+    RUN_TEST(test_gain_table_turns_on_economy);
+    RUN_TEST(test_rudder_jam_trips_protection);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_config_same_metrics);
+    RUN_TEST(test_holds_course_without_faults);
+    RUN_TEST(test_mag_disturbance_takes_it_off_course);
+    RUN_TEST(test_gain_table_turns_on_economy);
+    RUN_TEST(test_rudder_jam_trips_protection);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,197 @@
+#include <unity.h>
+#include <cstring>
+#include "Scheduler.h"
+
+// Simulated clock: tasks "take time" by advancing it
+class SimClock : public ITimeProvider {
+public:
+    std::uint64_t us = 0;
+    std::uint64_t getMillis() const override { return us / 1000; }
+    std::uint64_t getMicros() const override { return us; }
+};
+
+static SimClock simClock;
+
+// Each task context: how long it runs, and a trace of who ran
+struct Work {
+    std::uint32_t exec;
+    char id;
+};
+static char trace[256];
+static size_t traceLen;
+
+static void work(void* ctx) {
+    Work* w = static_cast<Work*>(ctx);
+    if(traceLen < sizeof(trace) - 1) trace[traceLen++] = w->id;
+    simClock.us += w->exec;
+}
+
+static void runFor(Scheduler& s, std::uint64_t us) {
+    std::uint64_t end = simClock.us + us;
+    while(simClock.us < end) {
+        if(!s.runOnce()) {
+            std::uint64_t idle = s.idleTime();
+            simClock.us += (idle > 0) ? idle : 1;
+        }
+    }
+}
+
+void setUp() {
+    simClock.us = 0;
+    std::memset(trace, 0, sizeof(trace));
+    traceLen = 0;
+}
+void tearDown() {}
+
+void test_rejects_bad_table() {
+    Work w = { 10, 'a' };
+    SchedTask tasks[] = { { "a", work, &w, 0, 0, 0, 0 } };
+    TaskStats stats[1];
+    Scheduler s(simClock, tasks, stats, 1);
+    TEST_ASSERT_FALSE(s.begin());
+    Scheduler empty(simClock, tasks, stats, 0);
+    TEST_ASSERT_FALSE(empty.begin());
+}
+
+void test_rate_monotonic_order() {
+    // Declared slow first; all released together, the fast one goes first
+    Work slow = { 100, 's' }, mid = { 100, 'm' }, fast = { 100, 'f' };
+    SchedTask tasks[] = {
+        { "slow", work, &slow, 100000, 0, 0, 0 },
+        { "mid",  work, &mid,   20000, 0, 0, 0 },
+        { "fast", work, &fast,  10000, 0, 0, 0 },
+    };
+    TaskStats stats[3];
+    Scheduler s(simClock, tasks, stats, 3);
+    TEST_ASSERT_TRUE(s.begin());
+    runFor(s, 1000);
+    TEST_ASSERT_EQUAL_STRING("fms", trace);
+}
+
+void test_priority_breaks_ties() {
+    Work a = { 10, 'a' }, b = { 10, 'b' };
+    SchedTask tasks[] = {
+        { "a", work, &a, 20000, 0, 5, 0 },
+        { "b", work, &b, 20000, 0, 1, 0 },
+    };
+    TaskStats stats[2];
+    Scheduler s(simClock, tasks, stats, 2);
+    s.begin();
+    runFor(s, 100);
+    TEST_ASSERT_EQUAL_STRING("ba", trace);
+}
+
+void test_periods_are_kept() {
+    Work a = { 500, 'a' }, b = { 2000, 'b' };
+    SchedTask tasks[] = {
+        { "a", work, &a,  10000, 0, 0, 0 },
+        { "b", work, &b, 100000, 0, 0, 0 },
+    };
+    TaskStats stats[2];
+    Scheduler s(simClock, tasks, stats, 2);
+    s.begin();
+    runFor(s, 1000000);
+    TEST_ASSERT_EQUAL(100, (int)s.stats(0).runs);
+    TEST_ASSERT_EQUAL(10, (int)s.stats(1).runs);
+    TEST_ASSERT_EQUAL(0, (int)s.stats(0).overruns);
+    TEST_ASSERT_EQUAL(500, (int)s.stats(0).maxExec);
+    TEST_ASSERT_EQUAL_FLOAT(2000.f, s.stats(1).meanExec());
+    // b shares releases with a, so it always starts 500 us late
+    TEST_ASSERT_EQUAL(500, (int)s.stats(1).maxLateness);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.07f, s.utilization());
+    TEST_ASSERT_TRUE(s.isSchedulable());
+}
+
+void test_offsets_spread_releases() {
+    Work a = { 100, 'a' }, b = { 100, 'b' };
+    SchedTask tasks[] = {
+        { "a", work, &a, 10000, 0, 0, 0 },
+        { "b", work, &b, 10000, 0, 0, 5000 },
+    };
+    TaskStats stats[2];
+    Scheduler s(simClock, tasks, stats, 2);
+    s.begin();
+    runFor(s, 100000);
+    TEST_ASSERT_EQUAL(0, (int)s.stats(1).maxLateness);
+    TEST_ASSERT_EQUAL(0, (int)s.stats(0).maxLateness);
+}
+
+void test_blocking_task_causes_lateness_and_overrun() {
+    // Non-preemptive: a 15 ms render blocks the 10 ms IMU task
+    Work imu = { 200, 'i' }, render = { 15000, 'r' };
+    SchedTask tasks[] = {
+        { "imu",    work, &imu,     10000, 2000, 0, 100 },
+        { "render", work, &render, 200000,    0, 0, 0 },
+    };
+    TaskStats stats[2];
+    Scheduler s(simClock, tasks, stats, 2);
+    s.begin();
+    runFor(s, 1000000);
+    TEST_ASSERT_TRUE(s.stats(0).maxLateness > 10000);
+    TEST_ASSERT_TRUE(s.stats(0).overruns > 0);
+    TEST_ASSERT_TRUE(s.stats(0).skipped > 0);
+    TEST_ASSERT_EQUAL(0, (int)s.stats(1).overruns);
+    TEST_ASSERT_FALSE(s.isSchedulable());
+}
+
+void test_overrun_of_own_deadline() {
+    Work slow = { 12000, 's' };
+    SchedTask tasks[] = { { "slow", work, &slow, 10000, 0, 0, 0 } };
+    TaskStats stats[1];
+    Scheduler s(simClock, tasks, stats, 1);
+    s.begin();
+    runFor(s, 100000);
+    const TaskStats& st = s.stats(0);
+    TEST_ASSERT_EQUAL((int)st.runs, (int)st.overruns);
+    // every run eats the next release: one skipped per run
+    TEST_ASSERT_EQUAL((int)st.runs, (int)st.skipped);
+}
+
+void test_host_runs_are_deterministic() {
+    Work a = { 300, 'a' }, b = { 1700, 'b' }, c = { 4100, 'c' };
+    SchedTask tasks[] = {
+        { "a", work, &a,  5000, 0, 0, 0 },
+        { "b", work, &b, 12000, 0, 0, 0 },
+        { "c", work, &c, 33000, 0, 0, 0 },
+    };
+    TaskStats stats[3];
+    Scheduler s(simClock, tasks, stats, 3);
+    s.begin();
+    runFor(s, 100000);
+    char first[256];
+    std::memcpy(first, trace, sizeof(trace));
+
+    setUp();
+    s.begin();
+    runFor(s, 100000);
+    TEST_ASSERT_EQUAL_STRING(first, trace);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_bad_table);
+    RUN_TEST(test_rate_monotonic_order);
+    RUN_TEST(test_priority_breaks_ties);
+    RUN_TEST(test_periods_are_kept);
+    RUN_TEST(test_offsets_spread_releases);
+    RUN_TEST(test_blocking_task_causes_lateness_and_overrun);
+    RUN_TEST(test_overrun_of_own_deadline);
+    RUN_TEST(test_host_runs_are_deterministic);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_bad_table);
+    RUN_TEST(test_rate_monotonic_order);
+    RUN_TEST(test_priority_breaks_ties);
+    RUN_TEST(test_periods_are_kept);
+    RUN_TEST(test_offsets_spread_releases);
+    RUN_TEST(test_blocking_task_causes_lateness_and_overrun);
+    RUN_TEST(test_overrun_of_own_deadline);
+    RUN_TEST(test_host_runs_are_deterministic);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,43 @@
+#include <unity.h>
+#include <cmath>
+#include "SeaStateEstimator.h"
+
+static SeaStateEstimator estimator(30.0f);
+
+void setUp() {
+    estimator.reset();
+}
+void tearDown() {}
+
+void test_steady_turn_is_calm() {
+    for(int i=0; i<6000; i++) {
+        estimator.addSample(3.0f, 0.01f);   // constant 3 deg/s turn
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, estimator.getSeaState());
+}
+
+void test_wave_yaw_gives_std_dev() {
+    // 2 deg/s amplitude at a 6 s period -> std dev 2/sqrt(2)
+    for(int i=0; i<30000; i++) {
+        float t = i * 0.01f;
+        estimator.addSample(2.0f * std::sin(6.2831853f * t / 6.0f), 0.01f);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 1.414f, estimator.getSeaState());
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_turn_is_calm);
+    RUN_TEST(test_wave_yaw_gives_std_dev);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_turn_is_calm);
+    RUN_TEST(test_wave_yaw_gives_std_dev);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,277 @@
+#include <unity.h>
+#include <cmath>
+#include "SourceArbiter.h"
+
+// A heading arbiter with a fast source (an IMU with a yaw estimate)
+// over main.cpp's compass and COG
+static const ArbiterSourceConfig IMU     = { "imu",     0,  250, 20.f, 0.5f };
+static const ArbiterSourceConfig COMPASS = { "compass", 1, 1500, 0.5f, 0.5f };
+static const ArbiterSourceConfig COG     = { "cog",     2, 3000,  0.f, 0.5f };
+
+static const std::uint32_t UPDATE_MS = 100;     // headingTask
+
+static float angleDiff(float a, float b) {
+    float d = std::fmod(a - b + 540.f, 360.f) - 180.f;
+    return std::fabs(d);
+}
+
+// IMU at 100 Hz and compass at 2 Hz for ms, each if on, the arbiter
+// updated every UPDATE_MS into out
+struct Boat {
+    SourceArbiter arb;
+    int imu, compass, cog;
+    std::uint32_t now;
+    ArbitratedAngle out;
+
+    Boat() : now(0) {
+        imu = arb.addSource(IMU);
+        compass = arb.addSource(COMPASS);
+        cog = arb.addSource(COG);
+    }
+
+    void run(std::uint32_t ms, bool imuOn, bool compassOn, float imuValue = 100.f, float compassValue = 100.f) {
+        for(std::uint32_t end = now + ms; now < end; now += 10) {
+            if(imuOn) arb.publish(imu, imuValue, 1.f, now);
+            if(compassOn && now % 500 == 0) arb.publish(compass, compassValue, 1.f, now);
+            if(now % UPDATE_MS == 0) arb.update(now, out);
+        }
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_no_source_is_no_fix() {
+    SourceArbiter arb;
+    TEST_ASSERT_EQUAL(0, arb.addSource(IMU));
+    ArbitratedAngle out;
+    TEST_ASSERT_FALSE(arb.latest(out));
+    TEST_ASSERT_FALSE(arb.update(0, out));
+    TEST_ASSERT_EQUAL(-1, out.source);
+    TEST_ASSERT_TRUE(arb.latest(out));
+    TEST_ASSERT_EQUAL(-1, out.source);
+
+    arb.publish(0, 42.f, 1.f, 10);
+    TEST_ASSERT_TRUE(arb.update(20, out));
+    TEST_ASSERT_EQUAL(0, out.source);
+    TEST_ASSERT_EQUAL_FLOAT(42.f, out.value);   // the first fix is not blended
+    TEST_ASSERT_EQUAL_UINT32(1, out.switches);
+
+    for(int i=0; i<3; i++) arb.addSource(COG);
+    TEST_ASSERT_EQUAL(-1, arb.addSource(COG));
+}
+
+void test_failover_latency_is_bounded() {
+    Boat b;
+    b.run(10000, true, true);
+    TEST_ASSERT_EQUAL(b.imu, b.out.source);
+
+    // the IMU stops: the compass within its timeout plus one update
+    std::uint32_t lost = b.now - 10;
+    std::uint32_t failover = 0;
+    while(b.now < lost + 2000) {
+        b.run(10, false, true);
+        if(failover == 0 && b.out.source == b.compass) failover = b.now - 10;
+    }
+    TEST_ASSERT_NOT_EQUAL(0, failover);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(IMU.timeoutMs + UPDATE_MS, failover - lost);
+    TEST_ASSERT_GREATER_THAN_UINT32(IMU.timeoutMs, failover - lost);
+    TEST_ASSERT_EQUAL_UINT32(2, b.out.switches);
+
+    // and to the COG when the compass goes too
+    b.arb.publish(b.cog, 100.f, 1.f, b.now);
+    lost = b.now - 500;
+    failover = 0;
+    while(b.now < lost + 3000) {
+        if(b.now % 1000 == 0) b.arb.publish(b.cog, 100.f, 1.f, b.now);
+        b.run(10, false, false);
+        if(failover == 0 && b.out.source == b.cog) failover = b.now - 10;
+    }
+    TEST_ASSERT_NOT_EQUAL(0, failover);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(COMPASS.timeoutMs + UPDATE_MS, failover - lost);
+}
+
+void test_recovery_needs_a_healthy_stretch() {
+    Boat b;
+    b.arb.setRecoveryMs(5000);
+    b.run(5000, false, true);
+    TEST_ASSERT_EQUAL(b.compass, b.out.source);
+
+    // the IMU comes and goes: stays on the compass
+    for(int i=0; i<5; i++) {
+        b.run(3000, true, true);
+        TEST_ASSERT_EQUAL(b.compass, b.out.source);
+        b.run(1000, false, true);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, b.out.switches);
+
+    // healthy for the recovery time: back on the IMU
+    b.run(5000 + 1000 + UPDATE_MS, true, true);
+    TEST_ASSERT_EQUAL(b.imu, b.out.source);
+    TEST_ASSERT_EQUAL_UINT32(2, b.out.switches);
+}
+
+void test_equal_priorities_are_fused() {
+    SourceArbiter arb;
+    ArbiterSourceConfig a = { "a", 0, 1000, 0.f, 0.1f };
+    ArbiterSourceConfig c = { "c", 0, 1000, 0.f, 0.1f };
+    arb.addSource(a);
+    arb.addSource(c);
+    ArbitratedAngle out;
+
+    // across north, and weighted by quality
+    arb.publish(0, 350.f, 1.f, 0);
+    arb.publish(1, 10.f, 1.f, 0);
+    TEST_ASSERT_TRUE(arb.update(0, out));
+    TEST_ASSERT_EQUAL(2, out.fused);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.f, angleDiff(out.value, 0.f));
+
+    arb.setBlendMs(0);
+    arb.publish(0, 80.f, 0.9f, 100);
+    arb.publish(1, 100.f, 0.3f, 100);
+    arb.update(100, out);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 85.f, out.value);
+    TEST_ASSERT_EQUAL(0, out.source);   // the better one
+    TEST_ASSERT_EQUAL_FLOAT(0.6f, out.quality);
+}
+
+void test_quality_and_rate_gate_a_source() {
+    Boat b;
+    b.run(3000, true, true);
+    TEST_ASSERT_EQUAL(b.imu, b.out.source);
+
+    // low quality
+    for(int i=0; i<5; i++) {
+        b.arb.publish(b.imu, 100.f, 0.2f, b.now);
+        b.arb.update(b.now, b.out);
+        b.now += UPDATE_MS;
+    }
+    TEST_ASSERT_EQUAL(b.compass, b.out.source);
+    TEST_ASSERT_FALSE(b.arb.health(b.imu).healthy);
+    TEST_ASSERT_TRUE(b.arb.health(b.compass).healthy);
+
+    // fresh all the time, but at 10 of the 20 Hz it should have
+    Boat slow;
+    for(; slow.now < 5000; slow.now += 10) {
+        if(slow.now % 100 == 0) slow.arb.publish(slow.imu, 100.f, 1.f, slow.now);
+        if(slow.now % 500 == 0) slow.arb.publish(slow.compass, 100.f, 1.f, slow.now);
+        if(slow.now % UPDATE_MS == 0) slow.arb.update(slow.now, slow.out);
+    }
+    TEST_ASSERT_EQUAL(slow.compass, slow.out.source);
+    ArbiterSourceHealth h = slow.arb.health(slow.imu);
+    TEST_ASSERT_FLOAT_WITHIN(1.f, 10.f, h.rate);
+    TEST_ASSERT_LESS_THAN_UINT32(IMU.timeoutMs, h.ageMs);
+}
+
+void test_switch_blends_instead_of_stepping() {
+    Boat b;
+    b.arb.setBlendMs(2000);
+    // the compass reads 10 deg more than the IMU
+    b.run(5000, true, true, 100.f, 110.f);
+    TEST_ASSERT_EQUAL_FLOAT(100.f, b.out.value);
+
+    float prev = b.out.value, maxStep = 0.f;
+    for(int i=0; i<40; i++) {
+        b.run(UPDATE_MS, false, true, 100.f, 110.f);
+        maxStep = std::fmax(maxStep, angleDiff(b.out.value, prev));
+        prev = b.out.value;
+    }
+    TEST_ASSERT_EQUAL(b.compass, b.out.source);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 110.f, b.out.value);
+    // 10 deg over 2 s of 100 ms steps
+    TEST_ASSERT_TRUE(maxStep <= 0.5f + 1e-3f);
+}
+
+void test_stuck_source_loses_to_a_live_one() {
+    // an IMU that sends its placeholder yaw at full rate and quality
+    SourceArbiter arb;
+    arb.setRecoveryMs(5000);
+    ArbiterSourceConfig imu = IMU;
+    imu.stuckMs = 2000;
+    int stuck = arb.addSource(imu);
+    int live = arb.addSource(COMPASS);
+    ArbitratedAngle out;
+    std::uint32_t now = 0, switched = 0;
+    for(; now < 10000; now += 10) {
+        arb.publish(stuck, 0.f, 1.f, now);
+        if(now % 500 == 0) arb.publish(live, 100.f + 0.1f * (now / 500 % 7), 1.f, now);
+        if(now % UPDATE_MS == 0) {
+            arb.update(now, out);
+            if(switched == 0 && out.source == live) switched = now;
+        }
+    }
+    TEST_ASSERT_EQUAL(live, out.source);
+    TEST_ASSERT_TRUE(switched > imu.stuckMs);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(imu.stuckMs + UPDATE_MS, switched);
+    TEST_ASSERT_TRUE(arb.health(stuck).stuck);
+    TEST_ASSERT_FALSE(arb.health(stuck).healthy);
+    TEST_ASSERT_FALSE(arb.health(live).stuck);
+
+    // moving again: back after the recovery time, like any failed source
+    for(std::uint32_t end = now + 6000; now < end; now += 10) {
+        arb.publish(stuck, 0.1f * (now / 10 % 7), 1.f, now);
+        if(now % 500 == 0) arb.publish(live, 100.f, 1.f, now);
+        if(now % UPDATE_MS == 0) arb.update(now, out);
+    }
+    TEST_ASSERT_FALSE(arb.health(stuck).stuck);
+    TEST_ASSERT_EQUAL(stuck, out.source);
+}
+
+#ifndef ARDUINO
+#include <thread>
+#include <atomic>
+
+void test_publish_from_another_task() {
+    SourceArbiter arb;
+    arb.addSource(IMU);
+    std::atomic<int> fixes(0);
+    std::atomic<std::uint32_t> clock(0);
+    std::thread producer([&]() {
+        // until the consumer got a good number of fixes
+        for(std::uint32_t i=0; fixes < 20000; i++) {
+            // value and quality from the same sample, never torn
+            arb.publish(0, (float)(i % 360), 0.5f + (float)(i % 360) / 720.f, i);
+            clock.store(i, std::memory_order_relaxed);
+        }
+    });
+    int torn = 0;
+    ArbitratedAngle out;
+    while(fixes < 20000) {
+        if(arb.update(clock.load(std::memory_order_relaxed), out)) {
+            fixes++;
+            float expect = 0.5f + out.value / 720.f;
+            if(std::fabs(out.quality - expect) > 1e-4f) torn++;
+        }
+    }
+    producer.join();
+    TEST_ASSERT_EQUAL(0, torn);
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_source_is_no_fix);
+    RUN_TEST(test_failover_latency_is_bounded);
+    RUN_TEST(test_recovery_needs_a_healthy_stretch);
+    RUN_TEST(test_equal_priorities_are_fused);
+    RUN_TEST(test_quality_and_rate_gate_a_source);
+    RUN_TEST(test_switch_blends_instead_of_stepping);
+    RUN_TEST(test_stuck_source_loses_to_a_live_one);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_source_is_no_fix);
+    RUN_TEST(test_failover_latency_is_bounded);
+    RUN_TEST(test_recovery_needs_a_healthy_stretch);
+    RUN_TEST(test_equal_priorities_are_fused);
+    RUN_TEST(test_quality_and_rate_gate_a_source);
+    RUN_TEST(test_switch_blends_instead_of_stepping);
+    RUN_TEST(test_stuck_source_loses_to_a_live_one);
+    RUN_TEST(test_publish_from_another_task);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,103 @@
+#include <unity.h>
+#include "SpscQueue.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_fifo_order() {
+    SpscQueue<int, 4> q;
+    TEST_ASSERT_TRUE(q.isEmpty());
+    q.push(1);
+    q.push(2);
+    q.push(3);
+    TEST_ASSERT_EQUAL(3, (int)q.size());
+    int v = 0;
+    TEST_ASSERT_TRUE(q.pop(v));
+    TEST_ASSERT_EQUAL(1, v);
+    TEST_ASSERT_TRUE(q.pop(v));
+    TEST_ASSERT_EQUAL(2, v);
+    TEST_ASSERT_TRUE(q.pop(v));
+    TEST_ASSERT_EQUAL(3, v);
+    TEST_ASSERT_FALSE(q.pop(v));
+}
+
+void test_full_queue_rejects_newest() {
+    // Unlike RingBuffer the oldest items survive
+    SpscQueue<int, 4> q;
+    for(int i=1; i<=4; i++) {
+        TEST_ASSERT_TRUE(q.push(i));
+    }
+    TEST_ASSERT_FALSE(q.push(5));
+    TEST_ASSERT_EQUAL(1, (int)q.dropped());
+    int v = 0;
+    q.pop(v);
+    TEST_ASSERT_EQUAL(1, v);
+    TEST_ASSERT_TRUE(q.push(6));
+    int expected[] = { 2, 3, 4, 6 };
+    for(int e : expected) {
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL(e, v);
+    }
+}
+
+void test_wraps_many_times() {
+    SpscQueue<int, 8> q;
+    int next = 0, expect = 0;
+    for(int round=0; round<1000; round++) {
+        for(int i=0; i<5; i++) q.push(next++);
+        int v;
+        while(q.pop(v)) {
+            TEST_ASSERT_EQUAL(expect++, v);
+        }
+    }
+    TEST_ASSERT_EQUAL(next, expect);
+    TEST_ASSERT_EQUAL(0, (int)q.dropped());
+}
+
+#ifndef ARDUINO
+#include <thread>
+
+void test_concurrent_producer_consumer() {
+    // Every item arrives once and in order, or is counted as dropped
+    SpscQueue<int, 64> q;
+    const int N = 500000;
+    std::thread producer([&]() {
+        for(int i=0; i<N; i++) {
+            while(!q.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int expect = 0, outOfOrder = 0;
+    while(expect < N) {
+        int v;
+        if(q.pop(v)) {
+            if(v != expect) outOfOrder++;
+            expect = v + 1;
+        }
+    }
+    producer.join();
+    TEST_ASSERT_EQUAL(0, outOfOrder);
+    TEST_ASSERT_TRUE(q.isEmpty());
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full_queue_rejects_newest);
+    RUN_TEST(test_wraps_many_times);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full_queue_rejects_newest);
+    RUN_TEST(test_wraps_many_times);
+    RUN_TEST(test_concurrent_producer_consumer);
+    return UNITY_END();
+}
+#endif
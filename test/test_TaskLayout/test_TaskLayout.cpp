@@ -0,0 +1,150 @@
+#include <unity.h>
+#include <atomic>
+#include <cstdio>
+#include "TaskLayout.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+class WallClock : public ITimeProvider {
+public:
+    std::uint64_t getMillis() const override { return millis(); }
+    std::uint64_t getMicros() const override { return (std::uint64_t)esp_timer_get_time(); }
+};
+static void sleepMs(unsigned ms) { delay(ms); }
+static unsigned coreCount() { return 2; }
+#else
+#include <chrono>
+#include <thread>
+class WallClock : public ITimeProvider {
+public:
+    std::uint64_t getMillis() const override { return getMicros() / 1000; }
+    std::uint64_t getMicros() const override {
+        using namespace std::chrono;
+        return (std::uint64_t)duration_cast<microseconds>(
+            steady_clock::now().time_since_epoch()).count();
+    }
+};
+static void sleepMs(unsigned ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+static unsigned coreCount() { return std::thread::hardware_concurrency(); }
+#endif
+
+static WallClock wallClock;
+
+static std::atomic<int> controlRuns;
+static std::atomic<int> uiRuns;
+
+static void countControl(void*) { controlRuns++; }
+static void countUi(void*) { uiRuns++; }
+
+// Stand-in for a full display redraw: keeps its core busy
+static void busyRender(void* ctx) {
+    std::uint32_t busyUs = *static_cast<std::uint32_t*>(ctx);
+    std::uint64_t end = wallClock.getMicros() + busyUs;
+    while(wallClock.getMicros() < end) {
+    }
+    uiRuns++;
+}
+
+void setUp() {
+    controlRuns = 0;
+    uiRuns = 0;
+}
+void tearDown() {}
+
+void test_rejects_bad_table() {
+    SchedTask control[] = { { "ctl", countControl, nullptr, 0, 0, 0, 0 } };
+    SchedTask ui[] = { { "ui", countUi, nullptr, 10000, 0, 0, 0 } };
+    TaskLayout layout(wallClock, TaskLayoutConfig(), control, 1, ui, 1);
+    TEST_ASSERT_FALSE(layout.start());
+    TEST_ASSERT_FALSE(layout.isRunning());
+}
+
+void test_dual_core_runs_both_groups() {
+    SchedTask control[] = { { "ctl", countControl, nullptr, 5000, 0, 0, 0 } };
+    SchedTask ui[] = { { "ui", countUi, nullptr, 10000, 0, 0, 0 } };
+    TaskLayout layout(wallClock, TaskLayoutConfig(), control, 1, ui, 1);
+    TEST_ASSERT_TRUE(layout.start());
+    sleepMs(200);
+    layout.stop();
+
+    TEST_ASSERT_TRUE(controlRuns > 20);
+    TEST_ASSERT_TRUE(uiRuns > 10);
+
+    SchedulerSnapshot snap;
+    TEST_ASSERT_TRUE(layout.readStats(TaskGroup::CONTROL, snap));
+    TEST_ASSERT_EQUAL(1, (int)snap.count);
+    TEST_ASSERT_EQUAL_STRING("ctl", snap.names[0]);
+    TEST_ASSERT_EQUAL(controlRuns.load(), (int)snap.stats[0].runs);
+    TEST_ASSERT_TRUE(layout.readStats(TaskGroup::UI, snap));
+    TEST_ASSERT_EQUAL_STRING("ui", snap.names[0]);
+}
+
+void test_single_core_merges_tables() {
+    SchedTask control[] = { { "ctl", countControl, nullptr, 5000, 0, 0, 0 } };
+    SchedTask ui[] = { { "ui", countUi, nullptr, 10000, 0, 0, 0 } };
+    TaskLayout layout(wallClock, TaskLayoutConfig::singleCore(), control, 1, ui, 1);
+    TEST_ASSERT_TRUE(layout.start());
+    sleepMs(100);
+    layout.stop();
+
+    SchedulerSnapshot snap;
+    TEST_ASSERT_TRUE(layout.readStats(TaskGroup::CONTROL, snap));
+    TEST_ASSERT_EQUAL(2, (int)snap.count);
+    TEST_ASSERT_EQUAL_STRING("ui", snap.names[1]);
+    TEST_ASSERT_FALSE(layout.readStats(TaskGroup::UI, snap));
+    TEST_ASSERT_TRUE(uiRuns > 0);
+}
+
+// Worst start lateness of a 10 ms control task while a 50 ms render
+// keeps its core busy for 20 ms
+static std::uint32_t controlLatenessUnderLoad(const TaskLayoutConfig& cfg) {
+    static std::uint32_t renderUs = 20000;
+    SchedTask control[] = { { "ctl", countControl, nullptr, 10000, 0, 0, 0 } };
+    SchedTask ui[] = { { "render", busyRender, &renderUs, 50000, 0, 0, 3000 } };
+    TaskLayout layout(wallClock, cfg, control, 1, ui, 1);
+    TEST_ASSERT_TRUE(layout.start());
+    sleepMs(1000);
+    layout.stop();
+
+    SchedulerSnapshot snap;
+    TEST_ASSERT_TRUE(layout.readStats(TaskGroup::CONTROL, snap));
+    TEST_ASSERT_EQUAL_STRING("ctl", snap.names[0]);
+    return snap.stats[0].maxLateness;
+}
+
+void test_split_removes_ui_jitter_from_control() {
+    std::uint32_t single = controlLatenessUnderLoad(TaskLayoutConfig::singleCore());
+    std::uint32_t dual   = controlLatenessUnderLoad(TaskLayoutConfig());
+
+    char msg[128];
+    std::snprintf(msg, sizeof(msg), "10 ms control task, 20 ms render: max lateness "
+                  "single core %u us, dual core %u us", (unsigned)single, (unsigned)dual);
+    TEST_MESSAGE(msg);
+    // One core: the render blocks the control task for most of its run
+    TEST_ASSERT_TRUE(single > 8000);
+    // Threads only run side by side with a second core to run on
+    if(coreCount() >= 2) {
+        TEST_ASSERT_TRUE(dual < 5000);
+    }
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_bad_table);
+    RUN_TEST(test_dual_core_runs_both_groups);
+    RUN_TEST(test_single_core_merges_tables);
+    RUN_TEST(test_split_removes_ui_jitter_from_control);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_bad_table);
+    RUN_TEST(test_dual_core_runs_both_groups);
+    RUN_TEST(test_single_core_merges_tables);
+    RUN_TEST(test_split_removes_ui_jitter_from_control);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,213 @@
+#include <unity.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "UIController.h"
+#include "UIModel.h"
+#include "UIView.h"
+#include "NullDisplay.h"
+#include "AutoSteeringController.h"
+
+// Every operator new in this program goes through here and is counted.
+// All the replaceable forms are replaced, so that nothing the library
+// allocates is freed by ours or the other way round.
+static std::atomic<unsigned> allocations(0);
+
+static void* allocate(std::size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// Out of line so the compiler sees new and delete pair, not malloc and free
+__attribute__((noinline)) static void release(void* p) noexcept {
+    std::free(p);
+}
+
+void* operator new(std::size_t size) {
+    void* p = allocate(size);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+void operator delete(void* p) noexcept {
+    release(p);
+}
+void operator delete[](void* p) noexcept {
+    release(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    release(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+    release(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    release(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    release(p);
+}
+
+#if __cpp_aligned_new
+static void* allocateAligned(std::size_t size, std::align_val_t al) noexcept {
+    std::size_t align = static_cast<std::size_t>(al);
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    // aligned_alloc wants a whole, non-zero number of alignments
+    std::size_t rounded = size ? (size + align - 1) / align * align : align;
+    return aligned_alloc(align, rounded);
+}
+
+void* operator new(std::size_t size, std::align_val_t al) {
+    void* p = allocateAligned(size, al);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return operator new(size, al);
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, al);
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, al);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    release(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept {
+    release(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    release(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    release(p);
+}
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(p);
+}
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(p);
+}
+#endif
+
+static const std::uint32_t TICK_MS = 5;     // GpioButtons::TICK_US
+static const std::uint32_t LOOP_MS = 20;    // inputTask
+
+static bool windAngle(float& angle, void*) {
+    angle = -42.f;
+    return true;
+}
+
+// The UI as the firmware runs it: debounce timer, input task, heading
+// loop, render task
+struct Ui {
+    UIModel model;
+    AutoSteeringController autoSteer;
+    ButtonEvents buttons;
+    UIController controller;
+    NullDisplay display;
+    UIView view;
+    std::uint32_t now;
+
+    Ui()
+    : controller(model, autoSteer, buttons)
+    , view(display)
+    , now(0)
+    {
+        controller.setWindAngleSource(windAngle, nullptr);
+        view.begin();
+    }
+
+    void hold(std::uint32_t pressed, std::uint32_t ms) {
+        for(std::uint32_t end = now + ms; now < end; now += TICK_MS) {
+            buttons.sample(pressed, now);
+            if(now % LOOP_MS == 0) {
+                controller.update();
+                autoSteer.update(LOOP_MS / 1000.f);
+                view.render(model);
+            }
+        }
+    }
+
+    void click(ButtonId btn) {
+        hold(1u << (int)btn, 100);
+        hold(0, 100);
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_render_does_not_allocate() {
+    Ui ui;
+    unsigned before = allocations.load();
+    ui.view.render(ui.model);
+    for(int i=0; i<1000; i++) {
+        ui.model.setHeadingSetpoint(float(i % 720) - 360.f);
+        ui.model.setAutoMode(i & 1 ? UIAutoMode::AUTO : UIAutoMode::STANDBY);
+        ui.model.setSteeringMode((AutoSteeringMode)(i % UIModel::STEERING_MODE_COUNT));
+        ui.view.render(ui.model);
+        ui.view.invalidate();
+        ui.view.render(ui.model);
+    }
+    TEST_ASSERT_EQUAL_UINT(0, allocations.load() - before);
+    TEST_ASSERT_TRUE(ui.display.updates > 1000);
+}
+
+void test_update_cycle_does_not_allocate() {
+    Ui ui;
+    unsigned before = allocations.load();
+    // every button, through all the modes, held into auto repeat
+    ui.click(ButtonId::BTN_AUTO);
+    for(int i=0; i<UIModel::STEERING_MODE_COUNT + 1; i++) {
+        ui.click(ButtonId::BTN_MODE);
+        ui.click(ButtonId::BTN_INC_SMALL);
+        ui.click(ButtonId::BTN_DEC_LARGE);
+    }
+    ui.hold(1u << (int)ButtonId::BTN_INC_LARGE, 2000);
+    ui.hold(1u << (int)ButtonId::BTN_DEC_SMALL, 2000);
+    ui.click(ButtonId::BTN_AUTO);
+    ui.hold(0, 1000);
+    TEST_ASSERT_EQUAL_UINT(0, allocations.load() - before);
+    // and it did do something
+    TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, ui.model.getState().autoMode);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_HEADING, ui.model.getState().currentSteeringMode);
+    TEST_ASSERT_TRUE(ui.display.updates > 20);
+}
+
+void test_hook_counts() {
+    unsigned before = allocations.load();
+    int* p = new int(1);
+    delete p;
+    int* q = new (std::nothrow) int[4];
+    delete[] q;
+    TEST_ASSERT_EQUAL_UINT(2, allocations.load() - before);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hook_counts);
+    RUN_TEST(test_render_does_not_allocate);
+    RUN_TEST(test_update_cycle_does_not_allocate);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hook_counts);
+    RUN_TEST(test_render_does_not_allocate);
+    RUN_TEST(test_update_cycle_does_not_allocate);
+    return UNITY_END();
+}
+#endif
@@ -1,88 +1,103 @@
-#include <Arduino.h>
 #include <unity.h>
 #include "UIController.h"
 #include "UIModel.h"
 #include "AutoSteeringController.h"
 
-// We'll mock digitalRead
-extern "C" int digitalRead(uint8_t pin) {
-    // Return high by default
-    return HIGH;
-}
-
-// We can define some special variables to simulate button presses if needed
-static bool g_autoBtn = false;
+static const std::uint32_t TICK_MS = 5;     // GpioButtons::TICK_US
+static const std::uint32_t LOOP_MS = 20;    // inputTask
 
-// Then interpret them in digitalRead logic:
-int customDigitalRead(uint8_t pin) {
-    if(pin==2) return g_autoBtn ? LOW : HIGH;
-    return HIGH;
-}
+static UIModel* model;
+static AutoSteeringController* autoSteer;
+static ButtonEvents* buttons;
+static UIController* controller;
+static std::uint32_t now;
 
-// We'll define a local "AutoSteeringController" stub
-class FakeAutoSteeringController : public AutoSteeringController {
-public:
-    bool modeSet = false;
-    AutoSteeringMode lastMode = AutoSteeringMode::OFF;
-    float lastParam = 0.0f;
-
-    void setMode(AutoSteeringMode mode, float param=0.0f)  {
-        modeSet = true;
-        lastMode = mode;
-        lastParam= param;
+// Buttons held for ms, the debounce timer, the input task and the
+// heading loop (which applies the commands) running
+static void hold(std::uint32_t pressed, std::uint32_t ms) {
+    for(std::uint32_t end = now + ms; now < end; now += TICK_MS) {
+        buttons->sample(pressed, now);
+        if(now % LOOP_MS == 0) {
+            controller->update();
+            autoSteer->update(LOOP_MS / 1000.f);
+        }
     }
-};
-
-class MockInputDevice : public IInputDevice {
-public:
-    bool isPressed(ButtonId id) const override {
-        return false;
-    }
-};
+}
 
-static UIModel model;
-static FakeAutoSteeringController fakeAuto;
-static MockInputDevice input;
-static UIController controller(model, fakeAuto, input);
+static void click(ButtonId btn) {
+    hold(1u << (int)btn, 100);
+    hold(0, 100);
+}
 
 void setUp() {
-    // Overwrite digitalRead with custom function
-    // In real usage, might wrap or do #ifdef for mocking
-    pinMode(2, INPUT_PULLUP);
-    pinMode(3, INPUT_PULLUP);
-    controller.begin();
-    g_autoBtn=false;
+    model = new UIModel();
+    autoSteer = new AutoSteeringController();
+    buttons = new ButtonEvents();
+    controller = new UIController(*model, *autoSteer, *buttons);
+    controller->begin();
+    now = 0;
 }
 
-void tearDown() {}
+void tearDown() {
+    delete controller;
+    delete buttons;
+    delete autoSteer;
+    delete model;
+}
 
 void test_auto_toggle() {
     // Initially STANDBY
-    TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, model.getState().autoMode);
+    TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, model->getState().autoMode);
 
-    // Simulate button press
-    g_autoBtn=true;  
-    controller.update();
-    // Now it should become AUTO
-    TEST_ASSERT_EQUAL(UIAutoMode::AUTO, model.getState().autoMode);
-    TEST_ASSERT_TRUE(fakeAuto.modeSet);
-    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_HEADING, fakeAuto.lastMode);
+    // held for a while: one toggle, on the press
+    hold(1u << (int)ButtonId::BTN_AUTO, 2000);
+    TEST_ASSERT_EQUAL(UIAutoMode::AUTO, model->getState().autoMode);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::TRACK_HEADING, autoSteer->getMode());
+    hold(0, 100);
 
-    // Press again
-    g_autoBtn=false;
-    controller.update(); // button released
-    g_autoBtn=true;
-    controller.update(); 
-    // Should revert to STANDBY
-    TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, model.getState().autoMode);
-    TEST_ASSERT_EQUAL(AutoSteeringMode::OFF, fakeAuto.lastMode);
+    click(ButtonId::BTN_AUTO);
+    TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, model->getState().autoMode);
+    TEST_ASSERT_EQUAL(AutoSteeringMode::OFF, autoSteer->getMode());
+}
+
+void test_held_setpoint_does_not_run_away() {
+    click(ButtonId::BTN_AUTO);
+    float start = model->getState().headingSetpoint;
+
+    // half a second at 50 loops a second: one step, not 25
+    hold(1u << (int)ButtonId::BTN_INC_SMALL, 500);
+    hold(0, 100);
+    TEST_ASSERT_EQUAL_FLOAT(start + 1.f, model->getState().headingSetpoint);
+
+    // held on: auto repeat, 150 ms apart after 700 ms
+    hold(1u << (int)ButtonId::BTN_DEC_LARGE, 2000);
+    hold(0, 100);
+    TEST_ASSERT_EQUAL_FLOAT(start + 1.f - 10.f * 9, model->getState().headingSetpoint);
+}
+
+void test_idle_panel_queues_nothing() {
+    hold(0, 10000);
+    ButtonEvent e;
+    TEST_ASSERT_FALSE(buttons->pop(e));
+    TEST_ASSERT_FALSE(buttons->active());
+    TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, model->getState().autoMode);
 }
 
 #ifdef ARDUINO
 void setup() {
     UNITY_BEGIN();
     RUN_TEST(test_auto_toggle);
+    RUN_TEST(test_held_setpoint_does_not_run_away);
+    RUN_TEST(test_idle_panel_queues_nothing);
     UNITY_END();
 }
 void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_auto_toggle);
+    RUN_TEST(test_held_setpoint_does_not_run_away);
+    RUN_TEST(test_idle_panel_queues_nothing);
+    return UNITY_END();
+}
 #endif
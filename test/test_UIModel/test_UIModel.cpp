@@ -13,7 +13,7 @@ void tearDown() {
 void test_initial_state() {
     auto s = model.getState();
     TEST_ASSERT_EQUAL(UIAutoMode::STANDBY, s.autoMode);
-    TEST_ASSERT_EQUAL_STRING("OFF", s.currentSteeringMode.c_str());
+    TEST_ASSERT_EQUAL(AutoSteeringMode::OFF, s.currentSteeringMode);
     TEST_ASSERT_FLOAT_WITHIN(0.1f, 90.0f, s.headingSetpoint);
 }
 
@@ -23,11 +23,30 @@ void test_increment_small() {
     TEST_ASSERT_FLOAT_WITHIN(0.01f, oldVal+1.0f, model.getState().headingSetpoint);
 }
 
+void test_changed_since() {
+    UIModel m;
+    std::uint32_t v = m.version();
+    TEST_ASSERT_EQUAL_UINT32(0, m.changedSince(v));
+
+    m.setHeadingSetpoint(m.getState().headingSetpoint);
+    m.setSteeringMode(AutoSteeringMode::OFF);
+    TEST_ASSERT_EQUAL_UINT32(v, m.version());
+
+    m.decrementSetpointLarge();
+    m.setAutoMode(UIAutoMode::AUTO);
+    TEST_ASSERT_EQUAL_UINT32(UI_SETPOINT | UI_AUTO_MODE, m.changedSince(v));
+    std::uint32_t v2 = m.version();
+    m.setSteeringMode(AutoSteeringMode::TRACK_HEADING);
+    TEST_ASSERT_EQUAL_UINT32(UI_STEERING_MODE, m.changedSince(v2));
+    TEST_ASSERT_EQUAL_UINT32(UI_ALL, m.changedSince(v));
+}
+
 #ifdef ARDUINO
 void setup() {
     UNITY_BEGIN();
     RUN_TEST(test_initial_state);
     RUN_TEST(test_increment_small);
+    RUN_TEST(test_changed_since);
     UNITY_END();
 }
 void loop() {}
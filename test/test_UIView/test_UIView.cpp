@@ -1,32 +1,207 @@
-#include <Arduino.h>
 #include <unity.h>
+#include <cstdio>
+#include <cstring>
 #include "UIView.h"
 #include "UIModel.h"
+#include "NullDisplay.h"
 
-// We won't do a real I2C test here, but we can check that 'begin()' works.
-static UIView view;
+// Keeps the strings in the buffer, by baseline and extent in the 6x10
+// font, so the tests can check what is on the screen. A string only
+// partly cleared stays: its pixels are still there.
+class RecordingDisplay : public IDisplay {
+public:
+    static const int CHAR_WIDTH = 6;
+
+    bool began = false;
+    int  frames = 0;
+    int  updates = 0;
+    int  drawn = 0;             // strings since the last send
+    int  count = 0;
+    int  xs[8];
+    int  ys[8];
+    char lines[8][64];
+    int  area[4];               // the last sendTiles()
+
+    bool begin() override { began = true; return true; }
+    void clearBuffer() override { count = 0; }
+    void drawStr(int x, int y, const char* text) override {
+        remove(x, (int)(x + std::strlen(text) * CHAR_WIDTH), y, y + 1);
+        if(count < 8) {
+            xs[count] = x;
+            ys[count] = y;
+            std::strncpy(lines[count], text, sizeof(lines[0]) - 1);
+            lines[count][sizeof(lines[0]) - 1] = '\0';
+            count++;
+        }
+        drawn++;
+    }
+    void sendBuffer() override { frames++; drawn = 0; }
+    void clearTiles(int tx, int ty, int tw, int th) override {
+        remove(tx * 8, (tx + tw) * 8, ty * 8, (ty + th) * 8);
+    }
+    void sendTiles(int tx, int ty, int tw, int th) override {
+        updates++;
+        drawn = 0;
+        area[0] = tx; area[1] = ty; area[2] = tw; area[3] = th;
+    }
+
+    bool drew(const char* text) const {
+        for(int i=0; i<count; i++) {
+            if(!std::strcmp(lines[i], text)) return true;
+        }
+        return false;
+    }
+
+    // Right edge [px] of the string drawn as text, -1 if none
+    int rightEdge(const char* text) const {
+        for(int i=0; i<count; i++) {
+            if(!std::strcmp(lines[i], text)) return xs[i] + (int)std::strlen(text) * CHAR_WIDTH;
+        }
+        return -1;
+    }
+
+private:
+    // The strings wholly within x0..x1, baseline y0..y1
+    void remove(int x0, int x1, int y0, int y1) {
+        int n = 0;
+        for(int i=0; i<count; i++) {
+            int right = xs[i] + (int)std::strlen(lines[i]) * CHAR_WIDTH;
+            if(ys[i] >= y0 && ys[i] < y1 && xs[i] >= x0 && right <= x1) continue;
+            xs[n] = xs[i];
+            ys[n] = ys[i];
+            std::memcpy(lines[n], lines[i], sizeof(lines[0]));
+            n++;
+        }
+        count = n;
+    }
+};
+
+static RecordingDisplay display;
+static UIView view(display);
 static UIModel model;
 
 void setUp() {}
 void tearDown() {}
 
 void test_ui_view_begin() {
-    bool ok = view.begin();  // might init the display
+    bool ok = view.begin();
     TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_TRUE(display.began);
 }
 
 void test_ui_view_render() {
-    // We'll set the model to some values
     model.setAutoMode(UIAutoMode::AUTO);
-    model.setSteeringMode("TRACK_HEADING");
+    model.setSteeringMode(AutoSteeringMode::TRACK_HEADING);
     model.setHeadingSetpoint(123.4f);
 
-    // Just call render, ensure no crash
     view.render(model);
 
-    // In a more advanced scenario, we might mock the u8g2 calls
-    // to verify correct strings, etc.
-    TEST_PASS_MESSAGE("UIView render test passed (no crash).");
+    TEST_ASSERT_EQUAL(1, display.frames);
+    TEST_ASSERT_TRUE(display.drew("AutoMode: AUTO"));
+    TEST_ASSERT_TRUE(display.drew("SteerMode: TRACK_HEADING"));
+    TEST_ASSERT_TRUE(display.drew("Setpoint: 123.4 deg"));
+}
+
+void test_unchanged_model_sends_nothing() {
+    RecordingDisplay d;
+    UIView v(d);
+    UIModel m;
+    v.render(m);
+    TEST_ASSERT_EQUAL(1, d.frames);
+
+    // setters that change nothing do not count either
+    m.setAutoMode(UIAutoMode::STANDBY);
+    m.setSteeringMode(AutoSteeringMode::OFF);
+    m.setHeadingSetpoint(90.f);
+    for(int i=0; i<10; i++) v.render(m);
+    TEST_ASSERT_EQUAL(1, d.frames);
+    TEST_ASSERT_EQUAL(0, d.updates);
+    TEST_ASSERT_EQUAL_UINT32(10, v.skipped());
+
+    v.invalidate();
+    v.render(m);
+    TEST_ASSERT_EQUAL(2, d.frames);
+}
+
+void test_changed_line_is_sent_alone() {
+    RecordingDisplay d;
+    UIView v(d);
+    UIModel m;
+    v.render(m);
+
+    m.incrementSetpointSmall();
+    v.render(m);
+    TEST_ASSERT_EQUAL(1, d.frames);
+    TEST_ASSERT_EQUAL(1, d.updates);
+    TEST_ASSERT_EQUAL(0, d.area[0]);
+    TEST_ASSERT_EQUAL(UIView::WIDTH / 8, d.area[2]);
+    // the setpoint line, baseline 40: tile rows 4 and 5
+    TEST_ASSERT_EQUAL(4, d.area[1]);
+    TEST_ASSERT_EQUAL(2, d.area[3]);
+    // the old text went, the others stayed
+    TEST_ASSERT_TRUE(d.drew("Setpoint: 91.0 deg"));
+    TEST_ASSERT_FALSE(d.drew("Setpoint: 90.0 deg"));
+    TEST_ASSERT_TRUE(d.drew("AutoMode: STANDBY"));
+    TEST_ASSERT_TRUE(d.drew("SteerMode: OFF"));
+    TEST_ASSERT_EQUAL(3, d.count);
+
+    m.setAutoMode(UIAutoMode::AUTO);
+    m.setSteeringMode(AutoSteeringMode::TRACK_HEADING);
+    v.render(m);
+    TEST_ASSERT_EQUAL(3, d.updates);
+    TEST_ASSERT_TRUE(d.drew("AutoMode: AUTO"));
+    TEST_ASSERT_TRUE(d.drew("SteerMode: TRACK_HEADING"));
+    TEST_ASSERT_TRUE(d.drew("Setpoint: 91.0 deg"));
+    TEST_ASSERT_EQUAL(3, d.count);
+}
+
+// The longest line is wider than 128 px: it has to go, and the new one
+// be sent, across the panel
+void test_wide_lines_are_cleared_and_sent() {
+    RecordingDisplay d;
+    UIView v(d);
+    UIModel m;
+    m.setSteeringMode(AutoSteeringMode::TRACK_WIND_ANGLE);
+    v.render(m);
+    TEST_ASSERT_EQUAL(162, d.rightEdge("SteerMode: TRACK_WIND_ANGLE"));
+
+    m.setSteeringMode(AutoSteeringMode::OFF);
+    v.render(m);
+    TEST_ASSERT_FALSE(d.drew("SteerMode: TRACK_WIND_ANGLE"));
+    TEST_ASSERT_TRUE(d.drew("SteerMode: OFF"));
+    TEST_ASSERT_EQUAL(3, d.count);
+
+    m.setSteeringMode(AutoSteeringMode::TRACK_WIND_ANGLE);
+    v.render(m);
+    TEST_ASSERT_EQUAL(2, d.updates);
+    TEST_ASSERT_TRUE(d.rightEdge("SteerMode: TRACK_WIND_ANGLE") <= (d.area[0] + d.area[2]) * 8);
+    TEST_ASSERT_EQUAL(192 / 8, d.area[2]);
+}
+
+// Ten minutes on the renderTask period, the setpoint changed every 10 s
+// and the mode twice, whole frames every time (as before) or
+// incremental
+static float bytesPerSecond(bool whole) {
+    const int PERIOD_MS = 200, MINUTES = 10;
+    NullDisplay d(UIView::WIDTH, UIView::HEIGHT);
+    UIView v(d);
+    UIModel m;
+    for(int t=0; t<MINUTES * 60000; t+=PERIOD_MS) {
+        if(t % 10000 == 0) m.incrementSetpointSmall();
+        if(t == 60000)  m.setAutoMode(UIAutoMode::AUTO);
+        if(t == 300000) m.setAutoMode(UIAutoMode::STANDBY);
+        if(whole) v.invalidate();
+        v.render(m);
+    }
+    return d.bytes / (MINUTES * 60.f);
+}
+
+void test_bytes_sent() {
+    float whole = bytesPerSecond(true);
+    float incremental = bytesPerSecond(false);
+    std::printf("  display data: %.0f B/s whole frames, %.1f B/s incremental\n", whole, incremental);
+    TEST_ASSERT_EQUAL_FLOAT(5 * UIView::WIDTH * UIView::HEIGHT / 8, whole);
+    TEST_ASSERT_TRUE(incremental * 100.f < whole);
 }
 
 #ifdef ARDUINO
@@ -34,8 +209,23 @@ void setup() {
     UNITY_BEGIN();
     RUN_TEST(test_ui_view_begin);
     RUN_TEST(test_ui_view_render);
+    RUN_TEST(test_unchanged_model_sends_nothing);
+    RUN_TEST(test_changed_line_is_sent_alone);
+    RUN_TEST(test_wide_lines_are_cleared_and_sent);
+    RUN_TEST(test_bytes_sent);
     UNITY_END();
 }
 
 void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ui_view_begin);
+    RUN_TEST(test_ui_view_render);
+    RUN_TEST(test_unchanged_model_sends_nothing);
+    RUN_TEST(test_changed_line_is_sent_alone);
+    RUN_TEST(test_wide_lines_are_cleared_and_sent);
+    RUN_TEST(test_bytes_sent);
+    return UNITY_END();
+}
 #endif
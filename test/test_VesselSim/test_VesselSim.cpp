@@ -0,0 +1,244 @@
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include "VesselSim.h"
+#include "AutoSteeringController.h"
+#include "RudderServo.h"
+
+static const float DT = 0.01f;
+
+// No waves, no wind, no sensor noise: only what the test puts in
+static VesselConfig calmConfig() {
+    VesselConfig cfg;
+    cfg.waves.significantHeight = 0.f;
+    cfg.wind.speed = 0.f;
+    cfg.imu = ImuNoiseConfig();
+    cfg.imu.gyroNoise = cfg.imu.gyroBias = cfg.imu.accelNoise = cfg.imu.magNoise = 0.f;
+    return cfg;
+}
+
+static float wrap180(float a) {
+    while(a > 180.f)   a -= 360.f;
+    while(a <= -180.f) a += 360.f;
+    return a;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_same_seed_same_path() {
+    VesselConfig cfg;
+    cfg.seed = 4;
+    VesselSim a(cfg), b(cfg);
+    IMUData ia, ib;
+    for(int i=0; i<6000; i++) {
+        a.step(0.3f, DT);
+        b.step(0.3f, DT);
+        a.readIMU(ia);
+        if(i % 2) b.readIMU(ib);    // reading the IMU does not move the boat
+    }
+    TEST_ASSERT_EQUAL_FLOAT(a.state().heading, b.state().heading);
+    TEST_ASSERT_EQUAL_FLOAT(a.state().roll, b.state().roll);
+
+    a.reset();
+    VesselSim c(cfg);
+    for(int i=0; i<100; i++) {
+        a.step(0.f, DT);
+        c.step(0.f, DT);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(c.state().heading, a.state().heading);
+}
+
+void test_spectrum_has_configured_height() {
+    WaveConfig w;
+    w.significantHeight = 2.5f;
+    w.peakPeriod = 7.f;
+    WaveSpectrum sea(w, 9);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.5f, sea.significantHeight());
+
+    // The largest component sits at the peak
+    int peak = 0;
+    for(int i=1; i<WaveSpectrum::COMPONENTS; i++) {
+        if(sea.amplitude(i) > sea.amplitude(peak)) peak = i;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.15f, 2.f * 3.14159f / 7.f, sea.omega(peak));
+
+    // and the time series agrees: std dev of the elevation is Hs / 4
+    double sum = 0.0, sq = 0.0;
+    const int n = 200000;
+    for(int i=0; i<n; i++) {
+        sea.advance(0.05f, 0.f, 0.f);
+        float e = sea.elevation();
+        sum += e;
+        sq  += double(e) * e;
+    }
+    double mean = sum / n;
+    double std = std::sqrt(sq / n - mean * mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.06f, 2.5f / 4.f, (float)std);
+}
+
+void test_rudder_turns_at_nomoto_rate() {
+    VesselSim boat(calmConfig());
+    for(int i=0; i<3000; i++) boat.stepWithRudder(5.f, DT);    // 10 time constants
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.3f * 5.f, boat.state().yawRate);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.f, boat.state().rudder);
+}
+
+void test_level_imu_reads_gravity_and_north() {
+    VesselConfig cfg = calmConfig();
+    cfg.initialHeading = 0.f;
+    VesselSim boat(cfg);
+    IMUData d;
+    boat.readIMU(d);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.f, d.ax);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.f, d.ay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 9.81f, d.az);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.f, d.gz);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, cfg.imu.fieldHorizontal, d.mx);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -cfg.imu.fieldVertical, d.mz);
+}
+
+void test_imu_follows_turn_and_heading() {
+    VesselConfig cfg = calmConfig();
+    cfg.turnHeel = 0.f;
+    VesselSim boat(cfg);
+    for(int i=0; i<3000; i++) boat.stepWithRudder(5.f, DT);
+    IMUData d;
+    boat.readIMU(d);
+    // z up: a turn to starboard is negative
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -boat.state().yawRate * 0.0174533f, d.gz);
+    // centripetal acceleration towards starboard, -y
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -cfg.speed * boat.state().yawRate * 0.0174533f, d.ay);
+    float compass = std::atan2(d.my, d.mx) * 57.29578f;
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.f, wrap180(compass - boat.state().heading));
+}
+
+void test_beam_wind_heels_to_leeward() {
+    VesselConfig cfg = calmConfig();
+    cfg.wind.speed = 8.f;
+    cfg.wind.gustiness = 0.f;
+    cfg.wind.direction = 180.f;    // from the south, on the starboard beam heading east
+    VesselSim boat(cfg);
+    for(int i=0; i<3000; i++) boat.stepWithRudder(0.f, DT);
+    const VesselState& s = boat.state();
+    TEST_ASSERT_TRUE(s.apparentAngle > 0.f && s.apparentAngle < 180.f);
+    TEST_ASSERT_TRUE(s.roll < -5.f);
+    TEST_ASSERT_TRUE(s.sway < 0.f);
+    TEST_ASSERT_TRUE(s.windYaw > 0.f);         // rounds up to starboard
+    IMUData d;
+    boat.readIMU(d);
+    // heeled gravity, less the slow turn the weather helm causes
+    float phi = s.roll * 0.0174533f;
+    float turn = cfg.speed * s.yawRate * 0.0174533f;
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 9.81f * std::sin(phi) - turn * std::cos(phi), d.ay);
+}
+
+void test_roll_rings_at_natural_period() {
+    VesselConfig cfg = calmConfig();
+    cfg.rollDamping = 0.02f;
+    cfg.wind.speed = 10.f;
+    cfg.wind.gustiness = 0.f;
+    cfg.wind.direction = 180.f;
+    VesselSim boat(cfg);
+    // Upward zero crossings of the roll rate once the gust of turning it on has passed
+    int crossings = 0;
+    float first = 0.f, last = 0.f, prev = 0.f;
+    for(int i=0; i<2000; i++) {
+        boat.stepWithRudder(0.f, 0.005f);
+        float p = boat.state().rollRate;
+        if(i > 0 && prev < 0.f && p >= 0.f) {
+            if(crossings == 0) first = boat.state().time;
+            last = boat.state().time;
+            crossings++;
+        }
+        prev = p;
+    }
+    TEST_ASSERT_TRUE(crossings >= 2);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, cfg.rollPeriod, (last - first) / (crossings - 1));
+}
+
+void test_autopilot_holds_course_in_waves() {
+    // The firmware loops on the simulated sensors: compass heading from
+    // the IMU, rudder angle from the pot, wind and a quartering sea
+    VesselConfig cfg;
+    cfg.waves.significantHeight = 2.f;
+    cfg.waves.direction = cfg.initialHeading + 135.f;
+    VesselSim boat(cfg);
+    SimIMUProvider imu(boat);
+
+    AutoSteeringController steer;
+    steer.setGains(2.f, 0.05f, 2.f);
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, cfg.initialHeading);
+    RudderServo servo;
+    servo.setGains(1.f, 0.f, 0.f);
+
+    IMUData d;
+    double sqErr = 0.0;
+    int samples = 0;
+    for(int i=0; i<60000; i++) {           // 10 minutes
+        if(i % 10 == 0) {
+            imu.getIMUData(d);
+            steer.setFeedback(std::atan2(d.my, d.mx) * 57.29578f);
+            steer.update(10 * DT);
+            servo.setTargetAngle(steer.getRudderAngle());
+        }
+        RudderPlant& drive = boat.rudder();
+        boat.step(servo.update(drive.potToAngle(drive.readPot()), DT), DT);
+        if(i >= 6000) {
+            float err = wrap180(boat.state().heading - cfg.initialHeading);
+            sqErr += double(err) * err;
+            samples++;
+        }
+    }
+    float rms = float(std::sqrt(sqErr / samples));
+    std::printf("  rms heading error %.2f deg\n", rms);
+    TEST_ASSERT_TRUE(rms < 5.f);
+}
+
+void test_runs_much_faster_than_real_time() {
+    VesselSim boat;
+    IMUData d;
+    const int steps = 360000;    // an hour at 100 Hz
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i=0; i<steps; i++) {
+        boat.step(((i / 500) & 1) ? 0.5f : -0.5f, DT);
+        boat.readIMU(d);
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double factor = steps * DT / wall;
+    std::printf("  1 h simulated in %.1f ms, %.0fx real time\n", wall * 1e3, factor);
+    TEST_ASSERT_TRUE(std::isfinite(d.gz));
+    TEST_ASSERT_TRUE(factor > 1000.0);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_path);
+    RUN_TEST(test_spectrum_has_configured_height);
+    RUN_TEST(test_rudder_turns_at_nomoto_rate);
+    RUN_TEST(test_level_imu_reads_gravity_and_north);
+    RUN_TEST(test_imu_follows_turn_and_heading);
+    RUN_TEST(test_beam_wind_heels_to_leeward);
+    RUN_TEST(test_roll_rings_at_natural_period);
+    RUN_TEST(test_autopilot_holds_course_in_waves);
+    RUN_TEST(test_runs_much_faster_than_real_time);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_path);
+    RUN_TEST(test_spectrum_has_configured_height);
+    RUN_TEST(test_rudder_turns_at_nomoto_rate);
+    RUN_TEST(test_level_imu_reads_gravity_and_north);
+    RUN_TEST(test_imu_follows_turn_and_heading);
+    RUN_TEST(test_beam_wind_heels_to_leeward);
+    RUN_TEST(test_roll_rings_at_natural_period);
+    RUN_TEST(test_autopilot_holds_course_in_waves);
+    RUN_TEST(test_runs_much_faster_than_real_time);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,218 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "WindCalculator.h"
+#include "AutoSteeringController.h"
+#include "VesselSim.h"
+
+static const float DEG = 3.14159265f / 180.f;
+
+static float wrap180(float a) {
+    while(a > 180.f)   a -= 360.f;
+    while(a <= -180.f) a += 360.f;
+    return a;
+}
+
+// What the masthead instrument reads for a true wind, the mast heeled
+static void apparent(float twa, float tws, float boatSpeed, float heel, float& awa, float& aws) {
+    float fwd = tws * std::cos(twa * DEG) + boatSpeed;
+    float stb = tws * std::sin(twa * DEG) * std::cos(heel * DEG);
+    aws = std::sqrt(fwd*fwd + stb*stb);
+    awa = std::atan2(stb, fwd) / DEG;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_true_wind_from_apparent() {
+    float twa, tws;
+    // 10 kn on the beam at 6 kn: 59 deg apparent at 11.7 kn
+    WindCalculator::trueWind(59.036f, 11.662f, 6.f, 0.f, twa, tws);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 90.f, twa);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.f, tws);
+    // dead downwind the boat takes its speed off the wind
+    WindCalculator::trueWind(180.f, 4.f, 6.f, 0.f, twa, tws);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 180.f, std::fabs(twa));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.f, tws);
+    // port is negative
+    WindCalculator::trueWind(-59.036f, 11.662f, 6.f, 0.f, twa, tws);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -90.f, twa);
+}
+
+void test_heel_is_corrected() {
+    float awa, aws, twa, tws;
+    apparent(-45.f, 15.f, 6.5f, 25.f, awa, aws);
+    WindCalculator::trueWind(awa, aws, 6.5f, 25.f, twa, tws);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -45.f, twa);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 15.f, tws);
+    // uncorrected it reads too close
+    WindCalculator::trueWind(awa, aws, 6.5f, 0.f, twa, tws);
+    TEST_ASSERT_TRUE(twa > -43.f);
+}
+
+void test_own_yaw_is_not_filtered() {
+    WindCalculator wind;
+    float awa, aws;
+    apparent(60.f, 12.f, 6.f, 0.f, awa, aws);
+    for(int i=0; i<100; i++) wind.update(awa, aws, 6.f, 0.f, 100.f, 0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.f, wind.steeringAngle(100.f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 160.f, wind.trueDirection());
+
+    // the boat heads up 20 deg: at once 40 deg, no lag
+    apparent(40.f, 12.f, 6.f, 0.f, awa, aws);
+    wind.update(awa, aws, 6.f, 0.f, 120.f, 0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.f, wind.steeringAngle(120.f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.f, wind.trueAngle(120.f));
+}
+
+void test_puffs_are_ridden_out() {
+    WindCalculator wind;
+    float awa, aws;
+    float maxDev = 0.f, maxGust = 0.f, minGust = 2.f;
+    // 10 kn, a puff of 15 kn veering 10 deg every 20 s, for 8 s
+    for(int i=0; i<6000; i++) {
+        bool puff = (i % 200) < 80;
+        float twa = puff ? 70.f : 60.f;
+        apparent(twa, puff ? 15.f : 10.f, 6.f, 0.f, awa, aws);
+        wind.update(awa, aws, 6.f, 0.f, 100.f, 0.1f);
+        if(i > 3000) {
+            maxDev = std::fmax(maxDev, std::fabs(wind.steeringAngle(100.f) - 65.f));
+            maxGust = std::fmax(maxGust, wind.gustFactor());
+            minGust = std::fmin(minGust, wind.gustFactor());
+        }
+    }
+    // the pilot holds the speed weighted mean, the fast filter sees
+    // every puff
+    TEST_ASSERT_TRUE(maxDev < 1.f);
+    TEST_ASSERT_TRUE(maxGust > 1.2f);
+    TEST_ASSERT_TRUE(minGust < 0.9f);
+    TEST_ASSERT_EQUAL_UINT32(0, wind.shifts());
+}
+
+void test_persistent_shift_is_followed() {
+    float awa, aws;
+    WindCalculator wind, plain;
+    plain.setShiftDetection(180.f, 0.f);    // never
+    float settled = -1.f, plainSettled = -1.f;
+    for(int i=0; i<3000; i++) {
+        float t = i * 0.1f;
+        // 60 deg, from 60 s on 15 deg more
+        float twa = (t < 60.f) ? 60.f : 75.f;
+        apparent(twa, 12.f, 6.f, 0.f, awa, aws);
+        wind.update(awa, aws, 6.f, 0.f, 100.f, 0.1f);
+        plain.update(awa, aws, 6.f, 0.f, 100.f, 0.1f);
+        if(t > 60.f && settled < 0.f && std::fabs(wind.steeringAngle(100.f) - 75.f) < 2.f) settled = t - 60.f;
+        if(t > 60.f && plainSettled < 0.f && std::fabs(plain.steeringAngle(100.f) - 75.f) < 2.f) plainSettled = t - 60.f;
+    }
+    std::printf("  15 deg shift followed in %.1f s (%.1f s without shift detection)\n", settled, plainSettled);
+    TEST_ASSERT_EQUAL_UINT32(1, wind.shifts());
+    TEST_ASSERT_TRUE(settled > 0.f && settled < 30.f);
+    TEST_ASSERT_TRUE(plainSettled > 2.f * settled);
+}
+
+// A reach in a gusty, shifty breeze: 12 kn, gusts of 30 %, veering
+// 8 deg with them, and a 15 deg persistent shift after 10 minutes.
+// The pilot steers by the raw apparent wind angle or by WindCalculator.
+struct GustyResult {
+    float rmsHeading;       // from the heading the mean wind asks for [deg]
+    float rudderActivity;   // mean |rudder rate| [deg/s]
+    float rmsAfterShift;    // the last 5 minutes
+};
+
+static GustyResult sailGusty(bool filtered) {
+    const float DT = 0.01f, TWA = 60.f;
+    VesselConfig cfg;
+    cfg.wind.speed = 6.f;
+    cfg.wind.direction = 45.f;
+    cfg.wind.gustiness = 0.3f;
+    cfg.wind.gustTime = 15.f;
+    cfg.wind.veer = 8.f;
+    cfg.wind.shift = 15.f;
+    cfg.wind.shiftAt = 600.f;
+    cfg.initialHeading = cfg.wind.direction - TWA;
+    cfg.seed = 7;
+    VesselSim boat(cfg);
+
+    AutoSteeringController steer;
+    steer.setGains(2.f, 0.05f, 2.f);
+    WindCalculator wind;
+    float awa0, aws0;
+    apparent(TWA, cfg.wind.speed, cfg.speed, 0.f, awa0, aws0);
+    steer.setMode(AutoSteeringMode::TRACK_WIND_ANGLE, filtered ? TWA : awa0);
+
+    double sqErr = 0.0, sqAfter = 0.0, activity = 0.0;
+    int samples = 0, after = 0;
+    float lastRudder = 0.f;
+    for(int i=0; i<120000; i++) {              // 20 minutes
+        const VesselState& s = boat.state();
+        if(i % 10 == 0) {
+            // the heeled masthead instrument
+            float fwd = s.apparentWind * std::cos(s.apparentAngle * DEG);
+            float stb = s.apparentWind * std::sin(s.apparentAngle * DEG) * std::cos(s.roll * DEG);
+            float awa = std::atan2(stb, fwd) / DEG;
+            float aws = std::sqrt(fwd*fwd + stb*stb);
+            if(filtered) {
+                wind.update(awa, aws, cfg.speed, s.roll, s.heading, 10 * DT);
+                steer.setFeedback(wind.steeringAngle(s.heading));
+            } else {
+                steer.setFeedback(awa);
+            }
+            steer.update(10 * DT);
+            activity += std::fabs(steer.getRudderAngle() - lastRudder);
+            lastRudder = steer.getRudderAngle();
+        }
+        boat.stepWithRudder(steer.getRudderAngle(), DT);
+        if(i >= 6000) {
+            float mean = cfg.wind.direction + (s.time >= cfg.wind.shiftAt ? cfg.wind.shift : 0.f);
+            float err = wrap180(s.heading - (mean - TWA));
+            sqErr += double(err) * err;
+            samples++;
+            if(s.time >= 900.f) {
+                sqAfter += double(err) * err;
+                after++;
+            }
+        }
+    }
+    GustyResult r;
+    r.rmsHeading = float(std::sqrt(sqErr / samples));
+    r.rudderActivity = float(activity / (120000 * DT));
+    r.rmsAfterShift = float(std::sqrt(sqAfter / after));
+    return r;
+}
+
+void test_steers_a_gusty_reach_better_than_the_apparent_wind() {
+    GustyResult raw = sailGusty(false);
+    GustyResult calc = sailGusty(true);
+    std::printf("  apparent wind:   rms heading %.1f deg, rudder %.2f deg/s, after the shift %.1f deg\n",
+                raw.rmsHeading, raw.rudderActivity, raw.rmsAfterShift);
+    std::printf("  WindCalculator:  rms heading %.1f deg, rudder %.2f deg/s, after the shift %.1f deg\n",
+                calc.rmsHeading, calc.rudderActivity, calc.rmsAfterShift);
+    TEST_ASSERT_TRUE(calc.rmsHeading < 0.5f * raw.rmsHeading);
+    TEST_ASSERT_TRUE(calc.rudderActivity < raw.rudderActivity);
+    TEST_ASSERT_TRUE(calc.rmsAfterShift < 5.f);
+}
+
+#ifdef ARDUINO
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(test_true_wind_from_apparent);
+    RUN_TEST(test_heel_is_corrected);
+    RUN_TEST(test_own_yaw_is_not_filtered);
+    RUN_TEST(test_puffs_are_ridden_out);
+    RUN_TEST(test_persistent_shift_is_followed);
+    RUN_TEST(test_steers_a_gusty_reach_better_than_the_apparent_wind);
+    UNITY_END();
+}
+void loop() {}
+#else
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_true_wind_from_apparent);
+    RUN_TEST(test_heel_is_corrected);
+    RUN_TEST(test_own_yaw_is_not_filtered);
+    RUN_TEST(test_puffs_are_ridden_out);
+    RUN_TEST(test_persistent_shift_is_followed);
+    RUN_TEST(test_steers_a_gusty_reach_better_than_the_apparent_wind);
+    return UNITY_END();
+}
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include "GainTable.h"
+
+/**
+ * The autotuner's gain table as JSON, in the format
+ * GainTable::loadFromJson() reads, with each set's score for the
+ * record. Header only, so test_GainTable loads exactly what the tool
+ * writes.
+ *
+ * Returns the length of the text, or 0 if it does not fit in size.
+ */
+inline size_t formatGainTableJson(char* out, size_t size,
+                                  const GainSet* sets, const float* scores, int count) {
+    size_t len = 0;
+    // snprintf()'s result, cut off when out is full
+    auto append = [&](int n) {
+        len = (n < 0 || len + (size_t)n >= size) ? size : len + (size_t)n;
+    };
+    append(std::snprintf(out, size, "{\n  \"version\": 1,\n  \"sets\": [\n"));
+    for(int i=0; i<count && len < size; i++) {
+        const GainSet& g = sets[i];
+        append(std::snprintf(out + len, size - len,
+            "    { \"maxSeaState\": %.3f,\n"
+            "      \"steer\":  { \"kP\": %.4f, \"kI\": %.4f, \"kD\": %.4f },\n"
+            "      \"rudder\": { \"kP\": %.4f, \"kI\": %.4f, \"kD\": %.4f },\n"
+            "      \"economy\": %s,\n"
+            "      \"score\": %.4f }%s\n",
+            g.maxSeaState, g.steerKp, g.steerKi, g.steerKd,
+            g.rudderKp, g.rudderKi, g.rudderKd,
+            g.economy ? "true" : "false",
+            scores[i], (i + 1 < count) ? "," : ""));
+    }
+    if(len < size) append(std::snprintf(out + len, size - len, "  ]\n}\n"));
+    return len < size ? len : 0;
+}
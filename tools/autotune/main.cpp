@@ -0,0 +1,211 @@
+/**
+ * Host tool: tunes AutoSteeringController and RudderServo gains per sea
+ * state by running simulated passages (lib/BoatSim) on all cores, and
+ * writes a gain table that GainTable::loadFromJson() can read.
+ *
+ * For every sea-state band the heading gains are swept first with default
+ * rudder gains, then the rudder gains are swept with the best heading
+ * gains, and last the best set is run with and without the rudder economy
+ * mode: the power and motor start weights decide whether it is on in that
+ * band. All candidates of a band see the same seeds, so they are compared
+ * on identical seas.
+ *
+ * Usage: autotune [--passages N] [--duration S] [--threads N]
+ *                 [--seed N] [--out gains.json]
+ * Run with: pio run -e autotune -t exec
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "PassageSim.h"
+#include "GainTable.h"
+#include "GainTableJson.h"
+#include "../common/ThreadPool.h"
+
+struct SeaBand {
+    const char* name;
+    float waveDisturbance;   // rudder equivalent amplitude [deg]
+    float wavePeriod;        // [s]
+};
+
+static const SeaBand BANDS[] = {
+    { "calm",     1.5f, 5.f },
+    { "moderate", 4.0f, 6.f },
+    { "rough",    9.0f, 7.f },
+};
+static const int BAND_COUNT = sizeof(BANDS) / sizeof(BANDS[0]);
+
+// Score weights: one degree of RMS heading error is worth...
+static const float W_TRAVEL = 0.01f;  // ...100 deg/min of rudder travel
+static const float W_POWER  = 0.1f;   // ...10 W of average drive power
+static const float W_STARTS = 0.02f;  // ...50 motor starts per minute
+// A passage that strays this far off course is a failure
+static const float FAIL_ERROR = 45.f;
+static const float FAIL_PENALTY = 100.f;
+
+static const float STEER_KP[] = { 0.5f, 1.f, 1.5f, 2.f, 3.f, 4.f };
+static const float STEER_KI[] = { 0.f, 0.02f, 0.05f, 0.1f };
+static const float STEER_KD[] = { 0.f, 0.5f, 1.f, 2.f, 4.f };
+static const float RUDDER_KP[] = { 0.5f, 1.f, 2.f, 4.f, 8.f };
+static const float RUDDER_KI[] = { 0.f, 0.5f };
+static const float RUDDER_KD[] = { 0.f, 0.02f, 0.05f };
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+struct Options {
+    int      passages;
+    float    duration;
+    unsigned threads;
+    uint32_t seed;
+    const char* out;
+};
+
+static float score(const PassageMetrics& m, float duration) {
+    float s = m.rmsHeadingError
+            + W_TRAVEL * m.rudderTravel
+            + W_POWER  * (m.energyWh * 3600.f / duration)
+            + W_STARTS * (m.motorStarts * 60.f / duration);
+    if(m.maxHeadingError > FAIL_ERROR) s += FAIL_PENALTY;
+    return s;
+}
+
+/** Evaluate all candidates on the band, return the index of the best. */
+static size_t evaluate(const std::vector<GainSet>& candidates, const SeaBand& band,
+                       int bandIdx, const Options& opt, std::vector<float>& meanScore,
+                       std::vector<float>& meanSeaState) {
+    const size_t jobs = candidates.size() * opt.passages;
+    std::vector<PassageMetrics> results(jobs);
+
+    parallelFor(jobs, opt.threads,
+        []() { return PassageSim(); },
+        [&](PassageSim& sim, size_t i) {
+            PassageConfig cfg;
+            cfg.duration        = opt.duration;
+            cfg.waveDisturbance = band.waveDisturbance;
+            cfg.wavePeriod      = band.wavePeriod;
+            cfg.seed            = opt.seed + 1000003u * bandIdx + (uint32_t)(i % opt.passages);
+            cfg.economy         = candidates[i / opt.passages].economy;
+            results[i] = sim.run(cfg, candidates[i / opt.passages]);
+        });
+
+    meanScore.assign(candidates.size(), 0.f);
+    meanSeaState.assign(candidates.size(), 0.f);
+    size_t best = 0;
+    for(size_t c=0; c<candidates.size(); c++) {
+        for(int p=0; p<opt.passages; p++) {
+            const PassageMetrics& m = results[c * opt.passages + p];
+            meanScore[c]    += score(m, opt.duration) / opt.passages;
+            meanSeaState[c] += m.yawRateStd / opt.passages;
+        }
+        if(meanScore[c] < meanScore[best]) best = c;
+    }
+    return best;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for(int i=1; i<argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if(!std::strcmp(argv[i], "--passages") && hasValue) {
+            opt.passages = std::atoi(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--duration") && hasValue) {
+            opt.duration = (float)std::atof(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--threads") && hasValue) {
+            opt.threads = (unsigned)std::atoi(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--seed") && hasValue) {
+            opt.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if(!std::strcmp(argv[i], "--out") && hasValue) {
+            opt.out = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return opt.passages > 0 && opt.duration > 0.f;
+}
+
+int main(int argc, char** argv) {
+    Options opt = { 16, 300.f, 0, 1, "gains.json" };
+    if(!parseArgs(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: autotune [--passages N] [--duration S] [--threads N] "
+                             "[--seed N] [--out gains.json]\n");
+        return 1;
+    }
+    unsigned threads = opt.threads ? opt.threads : defaultThreadCount();
+    std::printf("autotune: %d passages x %.0f s per candidate, %u threads\n",
+                opt.passages, opt.duration, threads);
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t simulated = 0;
+
+    GainSet tuned[BAND_COUNT];
+    float   seaState[BAND_COUNT];
+    float   bestScore[BAND_COUNT];
+
+    for(int b=0; b<BAND_COUNT; b++) {
+        std::vector<float> scores, seas;
+
+        // Stage 1: heading loop with default rudder gains
+        std::vector<GainSet> candidates;
+        for(float kp : STEER_KP) for(float ki : STEER_KI) for(float kd : STEER_KD) {
+            GainSet g = { 0.f, kp, ki, kd, 2.f, 0.f, 0.f };
+            candidates.push_back(g);
+        }
+        size_t best = evaluate(candidates, BANDS[b], b, opt, scores, seas);
+        simulated += candidates.size() * opt.passages;
+        GainSet steer = candidates[best];
+
+        // Stage 2: rudder loop under the chosen heading gains
+        candidates.clear();
+        for(float kp : RUDDER_KP) for(float ki : RUDDER_KI) for(float kd : RUDDER_KD) {
+            GainSet g = steer;
+            g.rudderKp = kp;
+            g.rudderKi = ki;
+            g.rudderKd = kd;
+            candidates.push_back(g);
+        }
+        best = evaluate(candidates, BANDS[b], b, opt, scores, seas);
+        simulated += candidates.size() * opt.passages;
+
+        // Stage 3: the rudder economy mode, on the same seas
+        GainSet chosen = candidates[best];
+        candidates.assign(2, chosen);
+        candidates[1].economy = true;
+        best = evaluate(candidates, BANDS[b], b, opt, scores, seas);
+        simulated += candidates.size() * opt.passages;
+
+        tuned[b]     = candidates[best];
+        seaState[b]  = seas[best];
+        bestScore[b] = scores[best];
+        std::printf("  %-9s steer %.2f/%.3f/%.2f  rudder %.2f/%.2f/%.3f  economy %-3s  score %.3f (%.3f %s)"
+                    "  yaw rate std %.2f deg/s\n",
+                    BANDS[b].name, tuned[b].steerKp, tuned[b].steerKi, tuned[b].steerKd,
+                    tuned[b].rudderKp, tuned[b].rudderKi, tuned[b].rudderKd,
+                    tuned[b].economy ? "on" : "off", bestScore[b], scores[1 - best],
+                    tuned[b].economy ? "without" : "with", seaState[b]);
+    }
+
+    // Band limits half way between the sea states the bands produced
+    for(int b=0; b<BAND_COUNT; b++) {
+        tuned[b].maxSeaState = (b + 1 < BAND_COUNT) ? 0.5f * (seaState[b] + seaState[b+1]) : 1000.f;
+    }
+
+    char json[2048];
+    size_t len = formatGainTableJson(json, sizeof(json), tuned, bestScore, BAND_COUNT);
+    FILE* f = std::fopen(opt.out, "w");
+    if(!f) {
+        std::fprintf(stderr, "autotune: cannot write %s\n", opt.out);
+        return 1;
+    }
+    bool written = len && std::fwrite(json, 1, len, f) == len;
+    if(std::fclose(f) != 0 || !written) {
+        std::fprintf(stderr, "autotune: cannot write %s\n", opt.out);
+        return 1;
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("autotune: %zu passages (%.0f h simulated) in %.1f s -> %s\n",
+                simulated, simulated * opt.duration / 3600.0, secs, opt.out);
+    return 0;
+}
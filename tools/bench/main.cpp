@@ -0,0 +1,550 @@
+/**
+ * Host microbenchmarks of the hot paths: ring buffers, MPU9250 decoding,
+ * the attitude filter, the heading and rudder loops, NMEA0183 parsing
+ * and formatting (against snprintf), UIView::render() on a NullDisplay
+ * and one step of the VesselSim plant the closed-loop tests run on.
+ *
+ * Every benchmark is reported in ns per operation and relative to a
+ * fixed reference loop run alongside it, which evens out clock speed
+ * and load. Any benchmark whose relative time grew by more than the
+ * tolerance fails the run (exit code 1). The ratios do not even out a
+ * different CPU or compiler as well: another code generator moves them
+ * by up to half. So the baseline records the CPU and compiler it was
+ * taken with; on the same the tolerance is --tolerance (30 %), anywhere
+ * else --other-tolerance (100 %), which still catches a benchmark that
+ * got twice as slow. Take a baseline on the machine the bench runs on
+ * most with --update-baseline. Pairs listed in FASTER (nmea.format against
+ * nmea.snprintf) are compared within the run.
+ *
+ * Usage: bench [--out bench.json] [--baseline tools/bench/baseline.json]
+ *              [--tolerance 0.3] [--other-tolerance 1.0] [--filter name]
+ *              [--update-baseline]
+ * Run with: pio run -e bench -t exec
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "RingBuffer.h"
+#include "SpscQueue.h"
+#include "MPU9250Decoder.h"
+#include "IMUFilterAndCalibration.h"
+#include "AutoSteeringController.h"
+#include "RudderServo.h"
+#include "UIModel.h"
+#include "UIView.h"
+#include "NullDisplay.h"
+#include "NmeaParser.h"
+#include "NmeaAutopilot.h"
+#include "VesselSim.h"
+
+// Keep a value alive without costing more than a register move
+template<typename T>
+static inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+static const int    SAMPLES = 9;
+static const double MIN_SAMPLE_NS = 2e6;   // batch size grows until a sample takes this long
+static const int    CONFIRM_RUNS = 2;      // reruns of a benchmark over the tolerance
+
+struct Result {
+    std::string name;
+    double      nsPerOp;
+    double      relative;   // nsPerOp / reference nsPerOp
+};
+
+struct Options {
+    const char* out;
+    const char* baseline;
+    double      tolerance;          // against a baseline from this CPU and compiler
+    double      otherTolerance;     // against one from elsewhere
+    const char* filter;
+    bool        updateBaseline;
+};
+
+static double nowNs() {
+    using namespace std::chrono;
+    return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/** Median ns per call of op(i) over SAMPLES batches. */
+template<typename Op>
+static double measure(Op op) {
+    std::uint32_t batch = 1;
+    for(;;) {
+        double t0 = nowNs();
+        for(std::uint32_t i=0; i<batch; i++) op(i);
+        if(nowNs() - t0 >= MIN_SAMPLE_NS || batch >= (1u << 30)) break;
+        batch *= 2;
+    }
+    double samples[SAMPLES];
+    for(int s=0; s<SAMPLES; s++) {
+        double t0 = nowNs();
+        for(std::uint32_t i=0; i<batch; i++) op(i);
+        samples[s] = (nowNs() - t0) / batch;
+    }
+    std::sort(samples, samples + SAMPLES);
+    return samples[SAMPLES / 2];
+}
+
+// ---- Fakes for the attitude filter ----
+
+class BenchIMU : public IIMUProvider {
+public:
+    std::uint32_t n = 0;
+    bool getIMUData(IMUData& out) override {
+        n++;
+        out.ax = 0.1f; out.ay = -0.2f; out.az = 9.81f;
+        out.gx = 0.001f * (n & 63); out.gy = 0.f; out.gz = 0.002f * (n & 31);
+        return true;
+    }
+};
+
+class BenchClock : public ITimeProvider {
+public:
+    mutable std::uint64_t ms = 0;
+    std::uint64_t getMillis() const override { return ms += 10; }
+};
+
+// ---- Benchmarks ----
+
+// Fixed integer and float mix, the unit of the relative figures
+static double benchReference() {
+    std::uint32_t x = 2463534242u;
+    float acc = 0.f;
+    return measure([&](std::uint32_t) {
+        for(int k=0; k<16; k++) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            acc = acc * 0.999f + float(x & 0xFF);
+        }
+        keep(acc);
+    });
+}
+
+static double benchRingBuffer() {
+    RingBuffer<IMUData, 16> ring;
+    IMUData in, out;
+    return measure([&](std::uint32_t i) {
+        in.gz = float(i);
+        ring.push(in);
+        ring.pop(out);
+        keep(out.gz);
+    });
+}
+
+static double benchSpscQueue() {
+    SpscQueue<IMUData, 16> queue;
+    IMUData in, out;
+    return measure([&](std::uint32_t i) {
+        in.gz = float(i);
+        queue.push(in);
+        queue.pop(out);
+        keep(out.gz);
+    });
+}
+
+static double benchMpuDecode() {
+    std::uint8_t raw[MPU9250Decoder::ACCEL_GYRO_BYTES];
+    std::uint8_t mag[MPU9250Decoder::MAG_BYTES] = { 0x10, 0x01, 0x20, 0xFF, 0x30, 0x00, 0x10 };
+    for(int k=0; k<MPU9250Decoder::ACCEL_GYRO_BYTES; k++) raw[k] = (std::uint8_t)(k * 37);
+    const float as = MPU9250Decoder::accelScale(MPU9250AccelRange::ACCEL_RANGE_4G);
+    const float gs = MPU9250Decoder::gyroScale(MPU9250GyroRange::GYRO_RANGE_500DPS);
+    MPU9250Reading r = {};
+    return measure([&](std::uint32_t i) {
+        raw[1] = (std::uint8_t)i;
+        mag[0] = (std::uint8_t)i;
+        MPU9250Decoder::decodeAccelGyro(raw, as, gs, r);
+        MPU9250Decoder::decodeMag(mag, r);
+        keep(r);
+    });
+}
+
+static double benchImuFilter() {
+    BenchIMU imu;
+    BenchClock clock;
+    IMUFilterAndCalibration filter(imu, clock);
+    return measure([&](std::uint32_t) {
+        filter.update();
+        keep(filter.getFilteredData().roll);
+    });
+}
+
+static double benchAutoSteer() {
+    AutoSteeringController steer;
+    steer.setGains(1.5f, 0.05f, 1.f);
+    steer.setMode(AutoSteeringMode::TRACK_HEADING, 90.f);
+    return measure([&](std::uint32_t i) {
+        steer.setFeedback(80.f + float(i & 31));
+        steer.update(0.1f);
+        keep(steer.getRudderAngle());
+    });
+}
+
+static double benchRudderPid() {
+    RudderServo servo;
+    servo.setTargetAngle(10.f);
+    float angle = 0.f;
+    return measure([&](std::uint32_t) {
+        float cmd = servo.update(angle, 0.001f);
+        angle += 0.01f * cmd;
+        if(angle > 9.f) angle = 0.f;
+        keep(cmd);
+    });
+}
+
+static double benchRudderShaped() {
+    RudderServo servo;
+    servo.setDriveProfile(DriveProfile::electricLinear());
+    servo.setTrajectoryEnabled(true);
+    float angle = 0.f;
+    return measure([&](std::uint32_t i) {
+        // a new target every 2 s of servo time keeps the trajectory busy
+        if((i % 2000) == 0) servo.setTargetAngle((i / 2000) & 1 ? -10.f : 10.f);
+        float cmd = servo.update(angle, 0.001f);
+        angle += 0.01f * cmd;
+        keep(cmd);
+    });
+}
+
+// One sentence per op, a mix of what GPS, compass and wind instruments
+// send, fed in the 64 byte chunks a socket read returns
+static double benchNmeaParse() {
+    static const char STREAM[] =
+        "$GPRMC,123519.00,A,4807.03812,N,01131.00041,E,6.4,84.4,230394,3.1,W,A*19\r\n"
+        "$GPVTG,84.4,T,87.5,M,6.4,N,11.9,K,A*1A\r\n"
+        "$HCHDG,98.3,0.5,E,2.1,W*64\r\n"
+        "$WIMWV,214.8,R,12.3,N,A*1C\r\n"
+        "$VWVHW,,T,245.1,M,6.12,N,11.33,K*4D\r\n"
+        "$GPXTE,A,A,0.67,L,N,A*02\r\n";
+    static const std::size_t LEN = sizeof(STREAM) - 1;
+    static const int SENTENCES = 6;
+    NmeaParser parser;
+    std::uint32_t decoded = 0;
+    parser.setHandler([](const NmeaSentence& s, void* ctx) {
+        (*(std::uint32_t*)ctx) += (std::uint32_t)s.type + 1;
+    }, &decoded);
+    double ns = measure([&](std::uint32_t) {
+        for(std::size_t off=0; off<LEN; off+=64) {
+            parser.feed(STREAM + off, (LEN - off < 64) ? LEN - off : 64);
+        }
+    }) / SENTENCES;
+    keep(decoded);
+    if(parser.checksumErrors() || parser.malformed()) {
+        std::fprintf(stderr, "bench: nmea.parse stream does not parse\n");
+    }
+    return ns;
+}
+
+// The autopilot's telemetry, one sentence per op, a new heading and
+// rudder angle every round
+static AutopilotTelemetry benchTelemetry(std::uint32_t i) {
+    AutopilotTelemetry t;
+    t.mode = AutoSteeringMode::TRACK_HEADING;
+    t.setpoint = 185.f;
+    t.heading = 0.1f * float(i % 3600);
+    t.windAngle = NAN;
+    t.rudderAngle = 0.1f * float(int(i % 401) - 200);
+    return t;
+}
+
+static double benchNmeaFormat() {
+    char buf[NmeaWriter::MAX_LENGTH + 1];
+    std::size_t total = 0;
+    double ns = measure([&](std::uint32_t i) {
+        AutopilotTelemetry t = benchTelemetry(i);
+        for(int s=0; s<NmeaAutopilot::SENTENCE_COUNT; s++) {
+            total += NmeaAutopilot::format((NmeaAutopilot::Sentence)s, t, buf, sizeof(buf));
+            keep(buf[0]);
+        }
+    }) / NmeaAutopilot::SENTENCE_COUNT;
+    keep(total);
+    return ns;
+}
+
+// The same sentences the usual way, for comparison
+static std::size_t printfSentence(char* buf, std::size_t size, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = std::vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    if(n < 0 || (std::size_t)n + 6 > size) return 0;
+    std::uint8_t sum = 0;
+    for(int k=1; k<n; k++) sum ^= (std::uint8_t)buf[k];
+    return (std::size_t)n + (std::size_t)std::snprintf(buf + n, size - n, "*%02X\r\n", sum);
+}
+
+static double benchNmeaSnprintf() {
+    char buf[NmeaWriter::MAX_LENGTH + 1];
+    std::size_t total = 0;
+    double ns = measure([&](std::uint32_t i) {
+        AutopilotTelemetry t = benchTelemetry(i);
+        total += printfSentence(buf, sizeof(buf), "$APHDG,%.1f,,,,", t.heading);
+        keep(buf[0]);
+        total += printfSentence(buf, sizeof(buf), "$APRSA,%.1f,A,,V", t.rudderAngle);
+        keep(buf[0]);
+        total += printfSentence(buf, sizeof(buf), "$APAPB,A,A,,,N,V,V,,,,,,%.1f,M,", t.setpoint);
+        keep(buf[0]);
+        total += printfSentence(buf, sizeof(buf), "$PXAPS,H,%.1f,%.1f,%.1f", t.setpoint, t.heading, t.rudderAngle);
+        keep(buf[0]);
+    }) / NmeaAutopilot::SENTENCE_COUNT;
+    keep(total);
+    return ns;
+}
+
+static double benchUiRender() {
+    NullDisplay display;
+    UIView view(display);
+    UIModel model;
+    model.setAutoMode(UIAutoMode::AUTO);
+    model.setSteeringMode(AutoSteeringMode::TRACK_HEADING);
+    double ns = measure([&](std::uint32_t i) {
+        model.setHeadingSetpoint(float(i % 360));
+        view.render(model);
+    });
+    keep(display.chars);
+    return ns;
+}
+
+static double benchVesselStep() {
+    VesselSim boat;
+    IMUData d;
+    return measure([&](std::uint32_t i) {
+        boat.step((i & 256) ? 0.5f : -0.5f, 0.01f);
+        boat.readIMU(d);
+        keep(d.gz);
+    });
+}
+
+struct Bench {
+    const char* name;
+    double (*run)();
+    const char* unit;    // what one op is, for a throughput figure
+};
+
+static const Bench BENCHES[] = {
+    { "ringbuffer.push_pop", benchRingBuffer,    nullptr },
+    { "spscqueue.push_pop",  benchSpscQueue,     nullptr },
+    { "mpu9250.decode",      benchMpuDecode,     nullptr },
+    { "imufilter.update",    benchImuFilter,     nullptr },
+    { "autosteer.update",    benchAutoSteer,     nullptr },
+    { "rudder.pid",          benchRudderPid,     nullptr },
+    { "rudder.shaped",       benchRudderShaped,  nullptr },
+    { "nmea.parse",          benchNmeaParse,     "sentences" },
+    { "nmea.format",         benchNmeaFormat,    "sentences" },
+    { "nmea.snprintf",       benchNmeaSnprintf,  "sentences" },
+    { "uiview.render",       benchUiRender,      nullptr },
+    { "vessel.step",         benchVesselStep,    nullptr },
+};
+
+// Claims that hold on any machine: the first is faster than the second,
+// measured in the same run
+struct Faster {
+    const char* name;
+    const char* than;
+};
+
+static const Faster FASTER[] = {
+    { "nmea.format", "nmea.snprintf" },
+};
+
+static const Result* findResult(const std::vector<Result>& results, const char* name) {
+    for(const Result& r : results) {
+        if(r.name == name) return &r;
+    }
+    return nullptr;
+}
+
+// ---- JSON ----
+
+static bool readFile(const char* path, std::string& text) {
+    FILE* f = std::fopen(path, "r");
+    if(!f) return false;
+    char buf[4096];
+    size_t n;
+    while((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+    return true;
+}
+
+// Without the characters JSON would need escaped
+static std::string jsonSafe(std::string text) {
+    text.erase(std::remove_if(text.begin(), text.end(), [](char c) {
+        return c == '"' || c == '\\' || (unsigned char)c < 0x20;
+    }), text.end());
+    return text;
+}
+
+static std::string compilerName() {
+    return jsonSafe(__VERSION__);
+}
+
+// CPU model from /proc/cpuinfo, empty where there is none
+static std::string cpuName() {
+    std::string info;
+    if(!readFile("/proc/cpuinfo", info)) return std::string();
+    size_t at = info.find("model name");
+    if(at == std::string::npos) return std::string();
+    size_t start = info.find_first_not_of(" \t:", info.find(':', at));
+    size_t end = info.find('\n', at);
+    if(start == std::string::npos || start >= end) return std::string();
+    return jsonSafe(info.substr(start, end - start));
+}
+
+static bool writeJson(const char* path, double referenceNs, const std::vector<Result>& results) {
+    FILE* f = std::fopen(path, "w");
+    if(!f) return false;
+    std::fprintf(f, "{\n  \"version\": 2,\n  \"cpu\": \"%s\",\n  \"compiler\": \"%s\",\n"
+                    "  \"reference_ns\": %.3f,\n  \"benchmarks\": {\n",
+                 cpuName().c_str(), compilerName().c_str(), referenceNs);
+    for(size_t i=0; i<results.size(); i++) {
+        std::fprintf(f, "    \"%s\": { \"ns_per_op\": %.3f, \"relative\": %.5f }%s\n",
+                     results[i].name.c_str(), results[i].nsPerOp, results[i].relative,
+                     (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(f, "  }\n}\n");
+    std::fclose(f);
+    return true;
+}
+
+// "relative" of a benchmark in a file written by writeJson(), -1 if absent
+static double baselineRelative(const std::string& json, const std::string& name) {
+    size_t at = json.find("\"" + name + "\"");
+    if(at == std::string::npos) return -1.0;
+    size_t end = json.find('}', at);
+    size_t rel = json.find("\"relative\"", at);
+    if(rel == std::string::npos || rel > end) return -1.0;
+    size_t colon = json.find(':', rel);
+    return std::strtod(json.c_str() + colon + 1, nullptr);
+}
+
+// A top level string of a baseline ("cpu", "compiler"), empty if absent
+static std::string baselineString(const std::string& json, const char* key) {
+    size_t at = json.find("\"" + std::string(key) + "\"");
+    if(at == std::string::npos) return std::string();
+    size_t open = json.find('"', json.find(':', at));
+    size_t close = json.find('"', open + 1);
+    if(open == std::string::npos || close == std::string::npos) return std::string();
+    return json.substr(open + 1, close - open - 1);
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for(int i=1; i<argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if(!std::strcmp(argv[i], "--out") && hasValue) {
+            opt.out = argv[++i];
+        } else if(!std::strcmp(argv[i], "--baseline") && hasValue) {
+            opt.baseline = argv[++i];
+        } else if(!std::strcmp(argv[i], "--tolerance") && hasValue) {
+            opt.tolerance = std::atof(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--other-tolerance") && hasValue) {
+            opt.otherTolerance = std::atof(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--filter") && hasValue) {
+            opt.filter = argv[++i];
+        } else if(!std::strcmp(argv[i], "--update-baseline")) {
+            opt.updateBaseline = true;
+        } else {
+            return false;
+        }
+    }
+    return opt.tolerance >= 0.0 && opt.otherTolerance >= 0.0;
+}
+
+int main(int argc, char** argv) {
+    Options opt = { "bench.json", "tools/bench/baseline.json", 0.3, 1.0, nullptr, false };
+    if(!parseArgs(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: bench [--out bench.json] [--baseline file] [--tolerance 0.3] "
+                             "[--other-tolerance 1.0] [--filter name] [--update-baseline]\n");
+        return 2;
+    }
+
+    std::string baseline;
+    bool haveBaseline = !opt.updateBaseline && readFile(opt.baseline, baseline);
+
+    double referenceNs = benchReference();
+    std::printf("bench: reference %.2f ns%s\n", referenceNs,
+                haveBaseline ? "" : ", no baseline to compare with");
+    double tolerance = opt.tolerance;
+    if(haveBaseline) {
+        std::string cpu = baselineString(baseline, "cpu");
+        std::string compiler = baselineString(baseline, "compiler");
+        if(cpu.empty() || cpu != cpuName() || compiler != compilerName()) {
+            tolerance = std::max(opt.tolerance, opt.otherTolerance);
+            std::printf("bench: baseline taken on '%s' with '%s', tolerance %.0f%%\n",
+                        cpu.c_str(), compiler.c_str(), tolerance * 100.0);
+        }
+    }
+    std::printf("  %-22s %10s %10s %10s %8s\n", "benchmark", "ns/op", "relative", "baseline", "change");
+
+    std::vector<Result> results;
+    int regressions = 0;
+    for(const Bench& b : BENCHES) {
+        if(opt.filter && !std::strstr(b.name, opt.filter)) continue;
+        Result r;
+        r.name     = b.name;
+        r.nsPerOp  = b.run();
+        r.relative = r.nsPerOp / referenceNs;
+
+        double base = haveBaseline ? baselineRelative(baseline, r.name) : -1.0;
+        // The machine's speed drifts under other load: a regression has
+        // to show again, next to a fresh reference, before it counts
+        for(int k=0; k<CONFIRM_RUNS && base > 0.0 && r.relative / base - 1.0 > tolerance; k++) {
+            double ref = benchReference();
+            double ns = b.run();
+            if(ns / ref < r.relative) {
+                r.nsPerOp  = ns;
+                r.relative = ns / ref;
+            }
+        }
+        results.push_back(r);
+
+        if(base <= 0.0) {
+            std::printf("  %-22s %10.2f %10.4f %10s %8s\n", b.name, r.nsPerOp, r.relative, "-", "new");
+        } else {
+            double change = r.relative / base - 1.0;
+            bool regressed = change > tolerance;
+            if(regressed) regressions++;
+            std::printf("  %-22s %10.2f %10.4f %10.4f %+7.0f%%%s\n", b.name, r.nsPerOp, r.relative,
+                        base, change * 100.0, regressed ? "  REGRESSION" : "");
+        }
+        if(b.unit) {
+            std::printf("  %-22s %10.0f %s/s\n", "", 1e9 / r.nsPerOp, b.unit);
+        }
+    }
+
+    int slower = 0;
+    for(const Faster& f : FASTER) {
+        const Result* a = findResult(results, f.name);
+        const Result* b = findResult(results, f.than);
+        if(!a || !b) continue;
+        bool faster = a->nsPerOp < b->nsPerOp;
+        if(!faster) slower++;
+        std::printf("bench: %s %.1fx %s %s\n", f.name,
+                    faster ? b->nsPerOp / a->nsPerOp : a->nsPerOp / b->nsPerOp,
+                    faster ? "faster than" : "SLOWER than", f.than);
+    }
+
+    const char* out = opt.updateBaseline ? opt.baseline : opt.out;
+    if(!writeJson(out, referenceNs, results)) {
+        std::fprintf(stderr, "bench: cannot write %s\n", out);
+        return 2;
+    }
+    std::printf("bench: results -> %s\n", out);
+
+    if(regressions) {
+        std::printf("bench: %d regression(s) beyond %.0f%%\n", regressions, tolerance * 100.0);
+        return 1;
+    }
+    if(slower) {
+        std::printf("bench: %d benchmark(s) not faster than what they replace\n", slower);
+        return 1;
+    }
+    return 0;
+}
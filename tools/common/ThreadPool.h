@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * Host-only helper: run jobs [0..count) on a fixed set of worker threads.
+ *
+ * Each worker gets its own state object, created once by makeState(), and
+ * pulls job indices from a shared atomic counter. The job function must
+ * only touch its worker state and its own output slot, so nothing mutable
+ * is shared between threads except the counter.
+ *
+ *   parallelFor(jobs.size(), threads,
+ *       []{ return PassageSim(); },
+ *       [&](PassageSim& sim, size_t i) { results[i] = sim.run(...); });
+ */
+inline unsigned defaultThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+template<typename MakeState, typename Job>
+void parallelFor(size_t count, unsigned threads, MakeState makeState, Job job) {
+    if(threads == 0) threads = defaultThreadCount();
+    if(threads > count) threads = (unsigned)(count ? count : 1);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        auto state = makeState();
+        for(;;) {
+            size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if(i >= count) break;
+            job(state, i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t=1; t<threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();   // the calling thread works too
+    for(auto& th : pool) {
+        th.join();
+    }
+}
+
+/**
+ * parallelFor() for jobs of very different cost: each worker starts on
+ * its own contiguous share of [0..count) and takes jobs from the front of
+ * it; a worker that runs dry steals the back half of the largest share
+ * left. Same contract as parallelFor(): per-worker state from
+ * makeState(), job(state, i) touches only its own output slot.
+ *
+ * A share is a [begin, end) pair packed into one 64 bit atomic, so the
+ * owner's pop and a thief's split are each a single compare-exchange.
+ */
+template<typename MakeState, typename Job>
+void parallelForStealing(size_t count, unsigned threads, MakeState makeState, Job job) {
+    if(threads == 0) threads = defaultThreadCount();
+    if(threads > count) threads = (unsigned)(count ? count : 1);
+
+    struct alignas(64) Share {
+        std::atomic<std::uint64_t> range;
+    };
+    auto pack = [](std::uint64_t begin, std::uint64_t end) { return (begin << 32) | end; };
+    auto beginOf = [](std::uint64_t r) { return r >> 32; };
+    auto endOf = [](std::uint64_t r) { return r & 0xFFFFFFFFu; };
+
+    std::unique_ptr<Share[]> shares(new Share[threads]);
+    for(unsigned t=0; t<threads; t++) {
+        shares[t].range.store(pack(count * t / threads, count * (t + 1) / threads));
+    }
+
+    auto worker = [&](unsigned self) {
+        auto state = makeState();
+        std::atomic<std::uint64_t>& mine = shares[self].range;
+        for(;;) {
+            // Own share, from the front
+            std::uint64_t r = mine.load();
+            while(beginOf(r) < endOf(r)) {
+                if(mine.compare_exchange_weak(r, pack(beginOf(r) + 1, endOf(r)))) {
+                    job(state, (size_t)beginOf(r));
+                    r = mine.load();
+                }
+            }
+
+            // Steal the back half of the largest share left
+            bool stole = false;
+            for(;;) {
+                unsigned victim = threads;
+                std::uint64_t most = 0, vr = 0;
+                for(unsigned t=0; t<threads; t++) {
+                    std::uint64_t tr = shares[t].range.load();
+                    std::uint64_t left = endOf(tr) - beginOf(tr);
+                    if(t != self && beginOf(tr) < endOf(tr) && left > most) {
+                        most = left;
+                        victim = t;
+                        vr = tr;
+                    }
+                }
+                if(victim == threads) break;   // nothing left anywhere
+                std::uint64_t take = (most + 1) / 2;
+                std::uint64_t split = endOf(vr) - take;
+                if(shares[victim].range.compare_exchange_strong(vr, pack(beginOf(vr), split))) {
+                    mine.store(pack(split, endOf(vr)));
+                    stole = true;
+                    break;
+                }
+            }
+            if(!stole) break;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t=1; t<threads; t++) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for(auto& th : pool) {
+        th.join();
+    }
+}
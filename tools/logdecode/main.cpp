@@ -0,0 +1,170 @@
+/**
+ * Host tool: decodes a flight recorder file (/flight.bin from the
+ * target's LittleFS, see FlightRecorder) to CSV, one file per record
+ * type: <prefix>_imu.csv, <prefix>_attitude.csv, ... with the time in
+ * seconds since boot in the first column.
+ *
+ * Blocks are put back in recording order by their sequence number;
+ * erased, torn or corrupt blocks are skipped and counted. A time that
+ * jumps backwards between blocks is a reboot.
+ *
+ * Usage: logdecode flight.bin [--out flight] [--type imu]
+ *   --out   prefix of the CSV files
+ *   --type  write only this record type, to stdout
+ * Build with: pio run -e logdecode, then .pio/build/logdecode/program flight.bin
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FlightLog.h"
+
+struct Options {
+    const char* in;
+    const char* out;
+    const char* type;
+};
+
+struct Block {
+    std::uint32_t sequence;
+    std::size_t   offset;
+};
+
+static bool readFile(const char* path, std::vector<std::uint8_t>& data) {
+    FILE* f = std::fopen(path, "rb");
+    if(!f) return false;
+    std::uint8_t buf[4096];
+    size_t n;
+    while((n = std::fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    std::fclose(f);
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for(int i=1; i<argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if(!std::strcmp(argv[i], "--out") && hasValue) {
+            opt.out = argv[++i];
+        } else if(!std::strcmp(argv[i], "--type") && hasValue) {
+            opt.type = argv[++i];
+        } else if(argv[i][0] != '-' && !opt.in) {
+            opt.in = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return opt.in != nullptr;
+}
+
+static void writeHeader(FILE* f, FlightRecordType type) {
+    std::fprintf(f, "time_s");
+    for(int i=0; i<FlightLog::fieldCount(type); i++) {
+        std::fprintf(f, ",%s", FlightLog::fieldName(type, i));
+    }
+    std::fprintf(f, "\n");
+}
+
+static void writeRecord(FILE* f, const FlightRecord& r, const FlightLogDecoder& dec) {
+    std::fprintf(f, "%.3f", r.timeMs * 0.001);
+    for(int i=0; i<FlightLog::fieldCount(r.type); i++) {
+        // as many decimals as the fixed point has, IMU counts in full
+        float scale = FlightLog::fieldScale(r.type, i);
+        if(dec.resolution(r.type, i) * scale != 1.f) {
+            std::fprintf(f, ",%.9g", r.value[i]);
+            continue;
+        }
+        int digits = scale >= 10000.f ? 4 : scale >= 1000.f ? 3 : scale >= 100.f ? 2 : 0;
+        std::fprintf(f, ",%.*f", digits, r.value[i]);
+    }
+    std::fprintf(f, "\n");
+}
+
+int main(int argc, char** argv) {
+    Options opt = { nullptr, "flight", nullptr };
+    if(!parseArgs(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: logdecode flight.bin [--out flight] [--type imu]\n");
+        return 1;
+    }
+    int only = 0;
+    if(opt.type) {
+        for(int t=1; t<FlightLog::TYPE_SLOTS; t++) {
+            if(!std::strcmp(opt.type, FlightLog::typeName((FlightRecordType)t))) only = t;
+        }
+        if(!only) {
+            std::fprintf(stderr, "logdecode: unknown type '%s'\n", opt.type);
+            return 1;
+        }
+    }
+
+    std::vector<std::uint8_t> data;
+    if(!readFile(opt.in, data)) {
+        std::fprintf(stderr, "logdecode: cannot read %s\n", opt.in);
+        return 1;
+    }
+
+    // Valid blocks in recording order
+    std::vector<Block> blocks;
+    size_t erased = 0, bad = 0;
+    FlightLogDecoder dec;
+    for(size_t off=0; off + FlightLog::BLOCK_SIZE <= data.size(); off += FlightLog::BLOCK_SIZE) {
+        if(dec.open(&data[off], FlightLog::BLOCK_SIZE)) {
+            blocks.push_back({ dec.sequence(), off });
+        } else if(data[off] == 0xFF) {
+            erased++;
+        } else {
+            bad++;
+        }
+    }
+    std::sort(blocks.begin(), blocks.end(),
+              [](const Block& a, const Block& b) { return (std::int32_t)(a.sequence - b.sequence) < 0; });
+
+    FILE* files[FlightLog::TYPE_SLOTS] = {};
+    for(int t=1; t<FlightLog::TYPE_SLOTS; t++) {
+        if(only && t != only) continue;
+        if(only) {
+            files[t] = stdout;
+        } else {
+            std::string path = std::string(opt.out) + "_" + FlightLog::typeName((FlightRecordType)t) + ".csv";
+            files[t] = std::fopen(path.c_str(), "w");
+            if(!files[t]) {
+                std::fprintf(stderr, "logdecode: cannot write %s\n", path.c_str());
+                return 1;
+            }
+        }
+        writeHeader(files[t], (FlightRecordType)t);
+    }
+
+    size_t counts[FlightLog::TYPE_SLOTS] = {};
+    size_t records = 0, reboots = 0, payload = 0;
+    std::uint32_t last = 0;
+    for(size_t b=0; b<blocks.size(); b++) {
+        dec.open(&data[blocks[b].offset], FlightLog::BLOCK_SIZE);
+        if(b > 0 && dec.startMs() + 1000 < last) reboots++;
+        FlightRecord r;
+        size_t before = records;
+        while(dec.next(r)) {
+            last = r.timeMs;
+            records++;
+            counts[(int)r.type]++;
+            if(files[(int)r.type]) writeRecord(files[(int)r.type], r, dec);
+        }
+        if(records > before) {
+            payload += data[blocks[b].offset + 24] | (data[blocks[b].offset + 25] << 8);
+        }
+    }
+    for(int t=1; t<FlightLog::TYPE_SLOTS; t++) {
+        if(files[t] && files[t] != stdout) std::fclose(files[t]);
+    }
+
+    FILE* info = only ? stderr : stdout;
+    std::fprintf(info, "logdecode: %zu blocks (%zu erased, %zu bad), %zu records, %zu reboots\n",
+                 blocks.size(), erased, bad, records, reboots);
+    for(int t=1; t<FlightLog::TYPE_SLOTS; t++) {
+        if(counts[t]) std::fprintf(info, "  %-9s %8zu\n", FlightLog::typeName((FlightRecordType)t), counts[t]);
+    }
+    if(records) std::fprintf(info, "  %.1f bytes per record\n", (double)payload / records);
+    return 0;
+}
@@ -0,0 +1,321 @@
+/**
+ * Host tool: Monte Carlo runs of the whole sensing and control stack
+ * (lib/BoatSim ScenarioSim) over randomly drawn sea states, wind,
+ * calibration errors and sensor faults, on all cores.
+ *
+ * Every scenario is drawn from its own seed, derived from --seed and the
+ * scenario number, so any scenario of a run can be replayed alone:
+ *   montecarlo --seed 7 --only 1234
+ * prints everything about scenario 1234 of the run with seed 7.
+ *
+ * The report gives heading error percentiles over all scenarios and per
+ * fault class, and lists the failed scenarios (off course for too long)
+ * soonest first. It is printed and written as JSON.
+ *
+ * Usage: montecarlo [--scenarios N] [--duration S] [--threads N] [--seed N]
+ *                   [--gains gains.json] [--out montecarlo.json] [--only K]
+ * Run with: pio run -e montecarlo -t exec
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ScenarioSim.h"
+#include "GainTable.h"
+#include "../common/ThreadPool.h"
+
+static const int   LIST_FAILURES = 20;
+
+struct Options {
+    int         scenarios;
+    float       duration;
+    unsigned    threads;
+    uint32_t    seed;
+    const char* gains;
+    const char* out;
+    long        only;
+};
+
+// What a scenario was drawn with, besides the numbers in ScenarioConfig
+enum FaultClass { CALIBRATION_ONLY, IMU_DROPOUT, MAG_DISTURBANCE, RUDDER_JAM, FAULT_CLASSES };
+static const char* const FAULT_NAMES[FAULT_CLASSES] = {
+    "calibration only", "imu dropout", "mag disturbance", "rudder jam"
+};
+
+struct Scenario {
+    ScenarioConfig cfg;
+    FaultClass     fault;
+};
+
+// splitmix64 of (run seed, scenario), so neighbouring scenarios are unrelated
+static uint32_t scenarioSeed(uint32_t runSeed, size_t index) {
+    uint64_t z = ((uint64_t)runSeed << 32) + index + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)(z ^ (z >> 31));
+}
+
+/**
+ * Draw scenario `index`: sea, wind and course uniformly over what the
+ * boat meets, calibration errors always, and at most one fault.
+ */
+static Scenario drawScenario(const Options& opt, size_t index) {
+    const uint32_t seed = scenarioSeed(opt.seed, index);
+    SimRandom rng(seed);
+    Scenario s;
+    ScenarioConfig& c = s.cfg;
+    c.duration       = opt.duration;
+    c.seed           = seed;
+    c.desiredHeading = rng.uniform(0.f, 360.f);
+    c.economy        = rng.uniform() < 0.5f;
+
+    VesselConfig& v = c.vessel;
+    v.seed           = seed;
+    v.initialHeading = c.desiredHeading;
+    v.speed          = rng.uniform(1.f, 4.f);
+    v.waves.significantHeight = rng.uniform(0.2f, 4.f);
+    // Steeper, younger seas come with short periods
+    v.waves.peakPeriod = 3.5f * std::sqrt(v.waves.significantHeight) + rng.uniform(1.5f, 4.f);
+    v.waves.direction  = rng.uniform(0.f, 360.f);
+    v.wind.speed       = rng.uniform(0.f, 14.f);
+    v.wind.direction   = v.waves.direction + 30.f * rng.gaussian();
+
+    SensorFaults& f = c.faults;
+    f.magOffsetX = 2.f * rng.gaussian();
+    f.magOffsetY = 2.f * rng.gaussian();
+    f.gyroBias   = 0.2f * rng.gaussian();
+    f.potOffset  = 1.f * rng.gaussian();
+    f.potScale   = 1.f + 0.03f * rng.gaussian();
+
+    float pick = rng.uniform();
+    if(pick < 0.1f) {
+        s.fault = IMU_DROPOUT;
+        f.imuDropout = rng.uniform(0.05f, 0.8f);
+    } else if(pick < 0.2f) {
+        s.fault = MAG_DISTURBANCE;
+        f.magDisturbanceAt = rng.uniform(0.f, 0.8f * opt.duration);
+        f.magDisturbance   = rng.uniform(-20.f, 20.f);
+    } else if(pick < 0.25f) {
+        s.fault = RUDDER_JAM;
+        f.rudderJamAt  = rng.uniform(0.f, 0.8f * opt.duration);
+        f.rudderJamFor = rng.uniform(2.f, 60.f);
+    } else {
+        s.fault = CALIBRATION_ONLY;
+    }
+    return s;
+}
+
+static void printScenario(FILE* out, size_t index, const Scenario& s) {
+    const ScenarioConfig& c = s.cfg;
+    const VesselConfig& v = c.vessel;
+    const SensorFaults& f = c.faults;
+    std::fprintf(out, "scenario %zu (seed %u): %s\n", index, (unsigned)c.seed, FAULT_NAMES[s.fault]);
+    std::fprintf(out, "  course %.0f deg at %.1f m/s%s, Hs %.1f m Tp %.1f s from %.0f, wind %.1f m/s from %.0f\n",
+                 c.desiredHeading, v.speed, c.economy ? ", economy" : "",
+                 v.waves.significantHeight, v.waves.peakPeriod, std::fmod(v.waves.direction + 360.f, 360.f),
+                 v.wind.speed, std::fmod(v.wind.direction + 360.f, 360.f));
+    std::fprintf(out, "  mag offset %.1f/%.1f uT, gyro bias %.2f deg/s, pot %.1f deg x %.3f",
+                 f.magOffsetX, f.magOffsetY, f.gyroBias, f.potOffset, f.potScale);
+    if(f.imuDropout > 0.f)        std::fprintf(out, ", %.0f %% IMU samples lost", 100.f * f.imuDropout);
+    if(f.magDisturbanceAt >= 0.f) std::fprintf(out, ", %.1f uT disturbance at %.0f s", f.magDisturbance, f.magDisturbanceAt);
+    if(f.rudderJamAt >= 0.f)      std::fprintf(out, ", rudder jammed at %.0f s for %.0f s", f.rudderJamAt, f.rudderJamFor);
+    std::fprintf(out, "\n");
+}
+
+static void printMetrics(FILE* out, const ScenarioMetrics& m) {
+    std::fprintf(out, "  rms %.2f deg, max %.1f deg, sea state %.2f deg/s, %.2f Wh, %u starts, %u trips",
+                 m.rmsHeadingError, m.maxHeadingError, m.seaState, m.energyWh,
+                 (unsigned)m.motorStarts, (unsigned)m.protectionTrips);
+    if(m.failed) std::fprintf(out, ", FAILED at %.0f s", m.failedAt);
+    std::fprintf(out, "\n");
+}
+
+// Nearest-rank percentile of an unsorted copy
+static float percentile(std::vector<float> v, float p) {
+    if(v.empty()) return 0.f;
+    size_t k = (size_t)std::ceil(p / 100.f * v.size());
+    k = k ? k - 1 : 0;
+    if(k >= v.size()) k = v.size() - 1;
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+struct Summary {
+    size_t count;
+    size_t failed;
+    float  rms[3];    // p50, p90, p99
+    float  max95;     // p95 of the max error
+};
+
+static const float PERCENTILES[3] = { 50.f, 90.f, 99.f };
+
+static Summary summarize(const std::vector<ScenarioMetrics>& results,
+                         const std::vector<Scenario>& scenarios, int faultClass) {
+    std::vector<float> rms, mx;
+    Summary s = {};
+    for(size_t i=0; i<results.size(); i++) {
+        if(faultClass >= 0 && scenarios[i].fault != faultClass) continue;
+        rms.push_back(results[i].rmsHeadingError);
+        mx.push_back(results[i].maxHeadingError);
+        if(results[i].failed) s.failed++;
+    }
+    s.count = rms.size();
+    for(int k=0; k<3; k++) s.rms[k] = percentile(rms, PERCENTILES[k]);
+    s.max95 = percentile(mx, 95.f);
+    return s;
+}
+
+static void printSummary(const char* name, const Summary& s) {
+    std::printf("  %-17s %6zu  %6.2f %6.2f %6.2f  %7.1f  %6zu\n",
+                name, s.count, s.rms[0], s.rms[1], s.rms[2], s.max95, s.failed);
+}
+
+static void jsonSummary(FILE* f, const char* name, const Summary& s, bool last) {
+    std::fprintf(f, "    \"%s\": { \"scenarios\": %zu, \"failed\": %zu, "
+                    "\"rms_p50\": %.3f, \"rms_p90\": %.3f, \"rms_p99\": %.3f, \"max_p95\": %.2f }%s\n",
+                 name, s.count, s.failed, s.rms[0], s.rms[1], s.rms[2], s.max95, last ? "" : ",");
+}
+
+static bool loadGains(const char* path, GainTable& table) {
+    FILE* f = std::fopen(path, "rb");
+    if(!f) return false;
+    std::string text;
+    char buf[512];
+    size_t n;
+    while((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+    return table.loadFromJson(text.c_str());
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for(int i=1; i<argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if(!std::strcmp(argv[i], "--scenarios") && hasValue) {
+            opt.scenarios = std::atoi(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--duration") && hasValue) {
+            opt.duration = (float)std::atof(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--threads") && hasValue) {
+            opt.threads = (unsigned)std::atoi(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--seed") && hasValue) {
+            opt.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if(!std::strcmp(argv[i], "--gains") && hasValue) {
+            opt.gains = argv[++i];
+        } else if(!std::strcmp(argv[i], "--out") && hasValue) {
+            opt.out = argv[++i];
+        } else if(!std::strcmp(argv[i], "--only") && hasValue) {
+            opt.only = std::atol(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return opt.scenarios > 0 && opt.duration > 0.f;
+}
+
+int main(int argc, char** argv) {
+    Options opt = { 2000, 300.f, 0, 1, nullptr, "montecarlo.json", -1 };
+    if(!parseArgs(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: montecarlo [--scenarios N] [--duration S] [--threads N] [--seed N]\n"
+                             "                  [--gains gains.json] [--out montecarlo.json] [--only K]\n");
+        return 1;
+    }
+
+    // The firmware's defaults unless a tuned table is given
+    GainTable gains;
+    if(opt.gains) {
+        if(!loadGains(opt.gains, gains)) {
+            std::fprintf(stderr, "montecarlo: cannot load %s\n", opt.gains);
+            return 1;
+        }
+    } else {
+        GainSet g = { 1000.f, 2.f, 0.02f, 1.f, 2.f, 0.f, 0.f };
+        gains.add(g);
+    }
+
+    if(opt.only >= 0) {
+        Scenario s = drawScenario(opt, (size_t)opt.only);
+        ScenarioSim sim;
+        printScenario(stdout, (size_t)opt.only, s);
+        printMetrics(stdout, sim.run(s.cfg, gains));
+        return 0;
+    }
+
+    unsigned threads = opt.threads ? opt.threads : defaultThreadCount();
+    std::printf("montecarlo: %d scenarios x %.0f s, seed %u, %u threads\n",
+                opt.scenarios, opt.duration, (unsigned)opt.seed, threads);
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<Scenario> scenarios(opt.scenarios);
+    for(size_t i=0; i<scenarios.size(); i++) {
+        scenarios[i] = drawScenario(opt, i);
+    }
+    std::vector<ScenarioMetrics> results(scenarios.size());
+    parallelForStealing(scenarios.size(), threads,
+        []() { return ScenarioSim(); },
+        [&](ScenarioSim& sim, size_t i) { results[i] = sim.run(scenarios[i].cfg, gains); });
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Percentiles, overall and per fault class
+    Summary all = summarize(results, scenarios, -1);
+    Summary byFault[FAULT_CLASSES];
+    std::printf("  %-17s %6s  %6s %6s %6s  %7s  %6s\n", "heading error", "runs",
+                "p50", "p90", "p99", "max p95", "failed");
+    printSummary("all", all);
+    for(int c=0; c<FAULT_CLASSES; c++) {
+        byFault[c] = summarize(results, scenarios, c);
+        printSummary(FAULT_NAMES[c], byFault[c]);
+    }
+
+    // Failures, worst (earliest off course, then largest error) first
+    std::vector<size_t> failed;
+    for(size_t i=0; i<results.size(); i++) {
+        if(results[i].failed) failed.push_back(i);
+    }
+    std::sort(failed.begin(), failed.end(), [&](size_t a, size_t b) {
+        if(results[a].failedAt != results[b].failedAt) return results[a].failedAt < results[b].failedAt;
+        return results[a].maxHeadingError > results[b].maxHeadingError;
+    });
+    if(!failed.empty()) {
+        std::printf("failed scenarios (replay with --seed %u --only K):\n", (unsigned)opt.seed);
+        for(size_t n=0; n<failed.size() && n<(size_t)LIST_FAILURES; n++) {
+            printScenario(stdout, failed[n], scenarios[failed[n]]);
+            printMetrics(stdout, results[failed[n]]);
+        }
+        if(failed.size() > (size_t)LIST_FAILURES) {
+            std::printf("  ... and %zu more in %s\n", failed.size() - LIST_FAILURES, opt.out);
+        }
+    }
+
+    FILE* f = std::fopen(opt.out, "w");
+    if(!f) {
+        std::fprintf(stderr, "montecarlo: cannot write %s\n", opt.out);
+        return 1;
+    }
+    std::fprintf(f, "{\n  \"version\": 1,\n  \"seed\": %u,\n  \"duration\": %.1f,\n",
+                 (unsigned)opt.seed, opt.duration);
+    std::fprintf(f, "  \"summary\": {\n");
+    jsonSummary(f, "all", all, false);
+    for(int c=0; c<FAULT_CLASSES; c++) {
+        jsonSummary(f, FAULT_NAMES[c], byFault[c], c + 1 == FAULT_CLASSES);
+    }
+    std::fprintf(f, "  },\n  \"failed\": [\n");
+    for(size_t n=0; n<failed.size(); n++) {
+        const ScenarioMetrics& m = results[failed[n]];
+        std::fprintf(f, "    { \"scenario\": %zu, \"seed\": %u, \"fault\": \"%s\", \"failed_at\": %.1f, "
+                        "\"rms\": %.2f, \"max\": %.1f }%s\n",
+                     failed[n], (unsigned)scenarios[failed[n]].cfg.seed, FAULT_NAMES[scenarios[failed[n]].fault],
+                     m.failedAt, m.rmsHeadingError, m.maxHeadingError, (n + 1 < failed.size()) ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+
+    std::printf("montecarlo: %zu scenarios (%.0f h simulated) in %.1f s -> %s\n",
+                scenarios.size(), scenarios.size() * opt.duration / 3600.0, secs, opt.out);
+    return 0;
+}
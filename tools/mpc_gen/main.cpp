@@ -0,0 +1,337 @@
+/**
+ * Host tool: solves the heading MPC offline and writes the explicit
+ * (piecewise-affine) solution as src/MPCExplicitTable.cpp.
+ *
+ * Model (first-order Nomoto, zero-order hold, period TS):
+ *     T * r' + r = K * u        e' = r
+ * with state x = [e, r, uPrev], e = heading - desired [deg], r [deg/s],
+ * uPrev = rudder applied in the previous period [deg].
+ *
+ * Cost over HORIZON steps:
+ *     sum Q_E*e^2 + Q_R*r^2 + R_U*u^2 + R_DU*(u_k - u_k-1)^2  (+ terminal)
+ * subject to |u| <= RUDDER_MAX, with move blocking (BLOCKS) so only a few
+ * free moves are optimised.
+ *
+ * For box constraints only, every combination of {free, at upper, at lower}
+ * per move is a candidate active set. We grid the state space, find the
+ * active set that satisfies the KKT conditions at each grid point, and emit
+ * one region (A*x <= b, u0 = K*x + k0) per active set that was hit.
+ *
+ * Usage: mpc_gen [output.cpp]
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "MPCExplicitTable.h"
+
+// ---- Model and tuning -----------------------------------------------------
+static const double TS          = 0.1;   // heading loop runs at 10 Hz
+static const double NOMOTO_K    = 0.3;   // [1/s]
+static const double NOMOTO_T    = 3.0;   // [s]
+static const double RUDDER_MAX  = 30.0;  // [deg]
+static const int    HORIZON     = 40;    // 4 s look-ahead
+static const int    BLOCKS[]    = {1, 3, 36}; // steps held by each free move
+static const int    MOVES       = sizeof(BLOCKS) / sizeof(BLOCKS[0]);
+
+static const double Q_E   = 1.0;
+static const double Q_R   = 2.0;
+static const double Q_E_F = 20.0;   // terminal heading weight
+static const double R_U   = 0.002;
+static const double R_DU  = 0.05;
+
+// ---- Grid used to discover regions ---------------------------------------
+static const double GRID_E_MAX = 120.0;
+static const double GRID_R_MAX = 15.0;
+static const int    GRID_E_N   = 121;
+static const int    GRID_R_N   = 61;
+static const int    GRID_U_N   = 25;
+
+static const double KKT_TOL = 1e-7;
+
+static_assert(MOVES <= MPC_MAX_MOVES, "too many moves for MPC_MAX_MOVES");
+
+static const int NX = MPC_STATE_DIM;
+static const int NZ = NX + MOVES;
+
+typedef double Vec[NZ];
+
+struct Quadratic {
+    double M[NZ][NZ];
+};
+
+// J += w * (v'z)^2
+static void addSquare(Quadratic& q, const Vec v, double w) {
+    for(int i=0; i<NZ; i++) {
+        for(int j=0; j<NZ; j++) {
+            q.M[i][j] += w * v[i] * v[j];
+        }
+    }
+}
+
+// Build the condensed cost J = z' M z over z = [x; U].
+static void buildCost(Quadratic& q) {
+    std::memset(&q, 0, sizeof(q));
+
+    const double a  = std::exp(-TS / NOMOTO_T);
+    // exact ZOH discretisation of the Nomoto model
+    const double re = NOMOTO_T * (1.0 - a);                 // e += re * r
+    const double ue = NOMOTO_K * (TS - NOMOTO_T * (1.0 - a)); // e += ue * u
+    const double ur = NOMOTO_K * (1.0 - a);                 // r = a*r + ur*u
+
+    Vec e, r, uPrev;
+    std::memset(e, 0, sizeof(e));
+    std::memset(r, 0, sizeof(r));
+    std::memset(uPrev, 0, sizeof(uPrev));
+    e[0] = 1.0;
+    r[1] = 1.0;
+    uPrev[2] = 1.0;
+
+    int step = 0;
+    for(int m=0; m<MOVES; m++) {
+        Vec u;
+        std::memset(u, 0, sizeof(u));
+        u[NX + m] = 1.0;
+
+        // Rate penalty only where the move changes
+        Vec du;
+        for(int i=0; i<NZ; i++) du[i] = u[i] - uPrev[i];
+        addSquare(q, du, R_DU);
+
+        for(int k=0; k<BLOCKS[m] && step<HORIZON; k++, step++) {
+            addSquare(q, u, R_U);
+            Vec eNext, rNext;
+            for(int i=0; i<NZ; i++) {
+                eNext[i] = e[i] + re * r[i] + ue * u[i];
+                rNext[i] = a * r[i] + ur * u[i];
+            }
+            std::memcpy(e, eNext, sizeof(e));
+            std::memcpy(r, rNext, sizeof(r));
+            bool terminal = (step == HORIZON - 1);
+            addSquare(q, e, terminal ? Q_E_F : Q_E);
+            addSquare(q, r, Q_R);
+        }
+        std::memcpy(uPrev, u, sizeof(uPrev));
+    }
+}
+
+// Solve A*X = B in place (n <= MOVES, multiple right-hand sides).
+static bool solve(int n, double A[MPC_MAX_MOVES][MPC_MAX_MOVES],
+                  double B[MPC_MAX_MOVES][NX + 1]) {
+    for(int c=0; c<n; c++) {
+        int piv = c;
+        for(int r=c+1; r<n; r++) {
+            if(std::fabs(A[r][c]) > std::fabs(A[piv][c])) piv = r;
+        }
+        if(std::fabs(A[piv][c]) < 1e-12) return false;
+        if(piv != c) {
+            for(int k=0; k<n; k++) std::swap(A[c][k], A[piv][k]);
+            for(int k=0; k<NX+1; k++) std::swap(B[c][k], B[piv][k]);
+        }
+        for(int r=0; r<n; r++) {
+            if(r == c) continue;
+            double f = A[r][c] / A[c][c];
+            for(int k=0; k<n; k++) A[r][k] -= f * A[c][k];
+            for(int k=0; k<NX+1; k++) B[r][k] -= f * B[c][k];
+        }
+    }
+    for(int r=0; r<n; r++) {
+        for(int k=0; k<NX+1; k++) B[r][k] /= A[r][r];
+    }
+    return true;
+}
+
+/**
+ * Affine solution for one active set: the moves U and the cost
+ * gradient g, each row stored as [coef_e, coef_r, coef_uPrev, const].
+ */
+struct ActiveSetLaw {
+    int    set[MPC_MAX_MOVES];   // 0 free, +1 upper, -1 lower
+    double U[MPC_MAX_MOVES][NX + 1];
+    double g[MPC_MAX_MOVES][NX + 1];
+    bool   valid;
+};
+
+static void computeLaw(const Quadratic& q, ActiveSetLaw& law) {
+    // H = M_UU, F = M_Ux (gradient of z'Mz wrt U is 2*(H*U + F*x))
+    int freeIdx[MPC_MAX_MOVES];
+    int nFree = 0;
+    for(int i=0; i<MOVES; i++) {
+        if(law.set[i] == 0) freeIdx[nFree++] = i;
+    }
+
+    // Fixed moves
+    for(int i=0; i<MOVES; i++) {
+        for(int k=0; k<NX+1; k++) law.U[i][k] = 0.0;
+        if(law.set[i] != 0) law.U[i][NX] = law.set[i] * RUDDER_MAX;
+    }
+
+    // H_ff * U_f = -(F_f * x + H_fa * U_a)
+    double A[MPC_MAX_MOVES][MPC_MAX_MOVES];
+    double B[MPC_MAX_MOVES][NX + 1];
+    for(int a=0; a<nFree; a++) {
+        int i = freeIdx[a];
+        for(int b=0; b<nFree; b++) {
+            A[a][b] = q.M[NX + i][NX + freeIdx[b]];
+        }
+        for(int k=0; k<NX; k++) B[a][k] = -q.M[NX + i][k];
+        B[a][NX] = 0.0;
+        for(int j=0; j<MOVES; j++) {
+            if(law.set[j] != 0) B[a][NX] -= q.M[NX + i][NX + j] * law.U[j][NX];
+        }
+    }
+    law.valid = solve(nFree, A, B);
+    if(!law.valid) return;
+    for(int a=0; a<nFree; a++) {
+        for(int k=0; k<NX+1; k++) law.U[freeIdx[a]][k] = B[a][k];
+    }
+
+    // g = H*U + F*x
+    for(int i=0; i<MOVES; i++) {
+        for(int k=0; k<NX; k++) law.g[i][k] = q.M[NX + i][k];
+        law.g[i][NX] = 0.0;
+        for(int j=0; j<MOVES; j++) {
+            for(int k=0; k<NX+1; k++) {
+                law.g[i][k] += q.M[NX + i][NX + j] * law.U[j][k];
+            }
+        }
+    }
+}
+
+// Region rows in the form  a*x <= b, written as [a0 a1 a2 | b].
+static int regionRows(const ActiveSetLaw& law, double rows[MPC_MAX_ROWS][NX + 1]) {
+    int n = 0;
+    for(int i=0; i<MOVES; i++) {
+        if(law.set[i] == 0) {
+            // U_i <= max  and  -U_i <= max
+            for(int k=0; k<NX; k++) {
+                rows[n][k]   =  law.U[i][k];
+                rows[n+1][k] = -law.U[i][k];
+            }
+            rows[n][NX]   = RUDDER_MAX - law.U[i][NX];
+            rows[n+1][NX] = RUDDER_MAX + law.U[i][NX];
+            n += 2;
+        } else {
+            // multiplier sign: at upper bound g_i <= 0, at lower g_i >= 0
+            double s = (law.set[i] > 0) ? 1.0 : -1.0;
+            for(int k=0; k<NX; k++) rows[n][k] = s * law.g[i][k];
+            rows[n][NX] = -s * law.g[i][NX];
+            n += 1;
+        }
+    }
+    return n;
+}
+
+static bool inside(const double rows[MPC_MAX_ROWS][NX + 1], int n, const double x[NX]) {
+    for(int r=0; r<n; r++) {
+        double v = 0.0;
+        for(int k=0; k<NX; k++) v += rows[r][k] * x[k];
+        if(v > rows[r][NX] + KKT_TOL * (1.0 + std::fabs(rows[r][NX]))) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = (argc > 1) ? argv[1] : "src/MPCExplicitTable.cpp";
+
+    Quadratic q;
+    buildCost(q);
+
+    // Enumerate all 3^MOVES active sets
+    std::vector<ActiveSetLaw> laws;
+    int total = 1;
+    for(int i=0; i<MOVES; i++) total *= 3;
+    for(int c=0; c<total; c++) {
+        ActiveSetLaw law;
+        int code = c;
+        for(int i=0; i<MOVES; i++) {
+            law.set[i] = (code % 3) - 1;   // -1, 0, +1
+            code /= 3;
+        }
+        computeLaw(q, law);
+        if(law.valid) laws.push_back(law);
+    }
+
+    // Put the unconstrained law first; it is the usual case near the setpoint
+    std::stable_sort(laws.begin(), laws.end(), [](const ActiveSetLaw& a, const ActiveSetLaw& b) {
+        int na = 0, nb = 0;
+        for(int i=0; i<MOVES; i++) { na += (a.set[i] != 0); nb += (b.set[i] != 0); }
+        return na < nb;
+    });
+
+    std::vector<long> hits(laws.size(), 0);
+    long points = 0, unmatched = 0;
+    for(int ie=0; ie<GRID_E_N; ie++) {
+        for(int ir=0; ir<GRID_R_N; ir++) {
+            for(int iu=0; iu<GRID_U_N; iu++) {
+                double x[NX] = {
+                    -GRID_E_MAX + 2.0 * GRID_E_MAX * ie / (GRID_E_N - 1),
+                    -GRID_R_MAX + 2.0 * GRID_R_MAX * ir / (GRID_R_N - 1),
+                    -RUDDER_MAX + 2.0 * RUDDER_MAX * iu / (GRID_U_N - 1)
+                };
+                points++;
+                bool found = false;
+                for(size_t l=0; l<laws.size() && !found; l++) {
+                    double rows[MPC_MAX_ROWS][NX + 1];
+                    int n = regionRows(laws[l], rows);
+                    if(inside(rows, n, x)) {
+                        hits[l]++;
+                        found = true;
+                    }
+                }
+                if(!found) unmatched++;
+            }
+        }
+    }
+
+    std::vector<size_t> order;
+    for(size_t l=0; l<laws.size(); l++) {
+        if(hits[l] > 0) order.push_back(l);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return hits[a] > hits[b];
+    });
+
+    FILE* f = std::fopen(outPath, "w");
+    if(!f) {
+        std::fprintf(stderr, "mpc_gen: cannot write %s\n", outPath);
+        return 1;
+    }
+    std::fprintf(f, "// Generated by tools/mpc_gen -- do not edit by hand.\n");
+    std::fprintf(f, "// Regenerate with: pio run -e mpc_gen -t exec\n");
+    std::fprintf(f, "// Weights: Q_E=%g Q_R=%g Q_E_F=%g R_U=%g R_DU=%g, blocks:",
+                 Q_E, Q_R, Q_E_F, R_U, R_DU);
+    for(int m=0; m<MOVES; m++) std::fprintf(f, " %d", BLOCKS[m]);
+    std::fprintf(f, "\n#include \"MPCExplicitTable.h\"\n\n");
+    std::fprintf(f, "const MPCModelInfo MPC_MODEL = { %.6ff, %.6ff, %.6ff, %.6ff, %d, %d };\n\n",
+                 TS, NOMOTO_K, NOMOTO_T, RUDDER_MAX, HORIZON, MOVES);
+    std::fprintf(f, "const MPCRegion MPC_REGIONS[] = {\n");
+    for(size_t o=0; o<order.size(); o++) {
+        const ActiveSetLaw& law = laws[order[o]];
+        double rows[MPC_MAX_ROWS][NX + 1];
+        int n = regionRows(law, rows);
+        std::fprintf(f, "    // active set:");
+        for(int i=0; i<MOVES; i++) {
+            std::fprintf(f, " %c", law.set[i] == 0 ? 'f' : (law.set[i] > 0 ? '+' : '-'));
+        }
+        std::fprintf(f, "  (%ld grid hits)\n    { %d,\n      {\n", hits[order[o]], n);
+        for(int r=0; r<MPC_MAX_ROWS; r++) {
+            std::fprintf(f, "        { %.7ef, %.7ef, %.7ef },\n",
+                         r<n ? rows[r][0] : 0.0, r<n ? rows[r][1] : 0.0, r<n ? rows[r][2] : 0.0);
+        }
+        std::fprintf(f, "      },\n      {");
+        for(int r=0; r<MPC_MAX_ROWS; r++) {
+            std::fprintf(f, " %.7ef,", r<n ? rows[r][NX] : 0.0);
+        }
+        std::fprintf(f, " },\n      { %.7ef, %.7ef, %.7ef }, %.7ef },\n",
+                     law.U[0][0], law.U[0][1], law.U[0][2], law.U[0][NX]);
+    }
+    std::fprintf(f, "};\n\nconst int MPC_REGION_COUNT = %d;\n", (int)order.size());
+    std::fclose(f);
+
+    std::printf("mpc_gen: %d active sets, %d regions, %ld grid points (%ld unmatched) -> %s\n",
+                (int)laws.size(), (int)order.size(), points, unmatched, outPath);
+    return unmatched == 0 ? 0 : 2;
+}
@@ -0,0 +1,128 @@
+/**
+ * Host tool: pushes a flight recorder log (/flight.bin, see
+ * FlightRecorder) back through the firmware's control path (lib/FlightReplay
+ * ControlReplay) at host speed and diffs the outputs against the ones
+ * recorded on the boat. Exits with 1 if anything is off by more than
+ * --tolerance steps of the log's resolution, so it can gate a change
+ * on a set of recorded passages.
+ *
+ * A replay is a pure function of the log and the code: --csv writes the
+ * replayed outputs at full float precision, and two builds replaying the
+ * same log must produce identical files.
+ *
+ * Usage: replay flight.bin [--gains gains.json] [--tolerance 0] [--csv replay.csv]
+ * Build with: pio run -e replay, then .pio/build/replay/program flight.bin
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "ControlReplay.h"
+#include "FlightLogReader.h"
+#include "GainTable.h"
+
+struct Options {
+    const char* in;
+    const char* gains;
+    float       tolerance;
+    const char* csv;
+};
+
+static bool loadGains(const char* path, GainTable& table) {
+    FILE* f = std::fopen(path, "rb");
+    if(!f) return false;
+    std::string text;
+    char buf[512];
+    size_t n;
+    while((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+    return table.loadFromJson(text.c_str());
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for(int i=1; i<argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if(!std::strcmp(argv[i], "--gains") && hasValue) {
+            opt.gains = argv[++i];
+        } else if(!std::strcmp(argv[i], "--tolerance") && hasValue) {
+            opt.tolerance = (float)std::atof(argv[++i]);
+        } else if(!std::strcmp(argv[i], "--csv") && hasValue) {
+            opt.csv = argv[++i];
+        } else if(argv[i][0] != '-' && !opt.in) {
+            opt.in = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return opt.in != nullptr && opt.tolerance >= 0.f;
+}
+
+static void writeStep(const FlightRecord& recorded, const FlightRecord& replayed, void* ctx) {
+    FILE* f = (FILE*)ctx;
+    std::fprintf(f, "%.3f,%s", recorded.timeMs * 0.001, FlightLog::typeName(recorded.type));
+    for(int i=0; i<FlightLog::fieldCount(recorded.type); i++) {
+        std::fprintf(f, ",%.9g", replayed.value[i]);
+    }
+    std::fprintf(f, "\n");
+}
+
+static void printDiff(const char* name, const ReplayDiff& d) {
+    std::printf("  %-9s %9zu values, max error %.4f, %zu mismatches", name, d.compared, d.maxError, d.mismatches);
+    if(d.mismatches) {
+        std::printf(", first at %.3f s (boot %u)", d.firstMismatchMs * 0.001, (unsigned)d.firstMismatchBoot);
+    }
+    std::printf("\n");
+}
+
+int main(int argc, char** argv) {
+    Options opt = { nullptr, nullptr, 0.f, nullptr };
+    if(!parseArgs(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: replay flight.bin [--gains gains.json] [--tolerance 0] [--csv replay.csv]\n");
+        return 2;
+    }
+
+    // As on the boat: the built-in gains unless /gains.json was there
+    GainTable gains;
+    if(opt.gains && !loadGains(opt.gains, gains)) {
+        std::fprintf(stderr, "replay: cannot load %s\n", opt.gains);
+        return 2;
+    }
+
+    FlightLogReader log;
+    if(!log.open(opt.in)) {
+        std::fprintf(stderr, "replay: cannot open %s\n", opt.in);
+        return 2;
+    }
+
+    ControlReplay replay(gains, opt.tolerance);
+    FILE* csv = nullptr;
+    if(opt.csv) {
+        csv = std::fopen(opt.csv, "w");
+        if(!csv) {
+            std::fprintf(stderr, "replay: cannot write %s\n", opt.csv);
+            return 2;
+        }
+        std::fprintf(csv, "time_s,type,v0,v1,v2,v3\n");
+        replay.setCallback(writeStep, csv);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    ReplayResult res = replay.run(log);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if(csv) std::fclose(csv);
+
+    std::printf("replay: %zu blocks (%zu bad), %zu records, %u boots, %.1f h recorded\n",
+                log.blockCount(), log.badBlocks(), res.records, (unsigned)res.boots,
+                res.recordedSeconds / 3600.0);
+    std::printf("  %zu IMU samples, %zu heading steps in %.2f s (%.0fx real time)\n",
+                res.imuSamples, res.headingSteps, wall, wall > 0.0 ? res.recordedSeconds / wall : 0.0);
+    printDiff("attitude", res.attitude);
+    printDiff("steering", res.steering);
+
+    bool ok = res.attitude.mismatches == 0 && res.steering.mismatches == 0;
+    std::printf("replay: %s\n", ok ? "outputs match the recording" : "OUTPUTS DIFFER from the recording");
+    return ok ? 0 : 1;
+}